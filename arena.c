@@ -43,6 +43,7 @@ Arena* arena_create(size_t initial_chunk_size) {
     arena->chunk_size = initial_chunk_size;
     arena->total_allocated = initial_chunk_size;
     arena->total_used = 0;
+    arena->peak_used = 0;
 
     return arena;
 }
@@ -71,6 +72,13 @@ void* arena_alloc(Arena *arena, size_t size) {
 
     /* Check if current chunk has space */
     ArenaChunk *chunk = arena->current;
+
+    /* Move on to chunks kept by arena_reset() before allocating new ones */
+    while (chunk->used + size > chunk->size && chunk->next) {
+        chunk = chunk->next;
+        arena->current = chunk;
+    }
+
     if (chunk->used + size > chunk->size) {
         /* Need new chunk */
         size_t new_chunk_size = arena->chunk_size;
@@ -103,6 +111,9 @@ void* arena_alloc(Arena *arena, size_t size) {
     void *ptr = chunk->memory + chunk->used;
     chunk->used += size;
     arena->total_used += size;
+    if (arena->total_used > arena->peak_used) {
+        arena->peak_used = arena->total_used;
+    }
 
     return ptr;
 }
@@ -166,6 +177,11 @@ size_t arena_get_allocated(Arena *arena) {
     return arena->total_allocated;
 }
 
+size_t arena_get_peak(Arena *arena) {
+    if (!arena) return 0;
+    return arena->peak_used;
+}
+
 /* Initialize global arena */
 void arena_init_global(void) {
     if (!global_arena) {
@@ -29,6 +29,7 @@ struct Arena {
     size_t chunk_size;     /* Default size for new chunks */
     size_t total_allocated; /* Total memory allocated */
     size_t total_used;     /* Total memory used */
+    size_t peak_used;      /* Most memory used at once (not cleared by resets) */
 };
 
 /* Create/destroy arena */
@@ -48,6 +49,7 @@ void arena_reset_aggressive(Arena *arena);
 /* Get statistics */
 size_t arena_get_used(Arena *arena);
 size_t arena_get_allocated(Arena *arena);
+size_t arena_get_peak(Arena *arena);
 
 /* Global arena for autograd temporary allocations */
 extern Arena *global_arena;
@@ -10,39 +10,265 @@
  */
 
 #include "ast.h"
+#include "arena.h"
+#include "threadpool.h"
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
 #include <math.h>
+#include <float.h>
+#include <limits.h>
+#include <ctype.h>
 #include <pthread.h>
 #include <time.h>
+#include <stdint.h>
 
 /* Thread-safe RNG - shared with parser.c */
 extern pthread_mutex_t rng_mutex;
 extern bool random_seeded;
 
+/* ============================================================================
+ * PER-THREAD STATE
+ * ============================================================================ */
+
+/* Allocation target and a cache in front of the intern table */
+#define INTERN_CACHE_SIZE 64
+
+typedef struct {
+    ASTArena *current;          /* Where new nodes go (NULL: heap) */
+    const char *intern_cache[INTERN_CACHE_SIZE];
+} ASTThreadState;
+
+#if defined(__GNUC__) && !defined(AST_NO_THREAD_LOCAL)
+#define AST_THREAD_LOCAL __thread
+static AST_THREAD_LOCAL ASTThreadState *ast_tls_state;
+#endif
+
+static pthread_key_t ast_thread_key;
+static pthread_once_t ast_thread_once = PTHREAD_ONCE_INIT;
+
+static void ast_thread_key_init(void) {
+    pthread_key_create(&ast_thread_key, free);
+}
+
+/* The key owns the state (and frees it at thread exit); the thread-local
+ * pointer, where available, only avoids the lookup */
+static ASTThreadState* ast_thread_state(bool create) {
+#ifdef AST_THREAD_LOCAL
+    if (ast_tls_state || !create) return ast_tls_state;
+#endif
+    pthread_once(&ast_thread_once, ast_thread_key_init);
+    ASTThreadState *state = pthread_getspecific(ast_thread_key);
+    if (!state && create) {
+        state = calloc(1, sizeof(ASTThreadState));
+        if (state) pthread_setspecific(ast_thread_key, state);
+    }
+#ifdef AST_THREAD_LOCAL
+    ast_tls_state = state;
+#endif
+    return state;
+}
+
+/* ============================================================================
+ * NAME INTERNING
+ * ============================================================================
+ * Variable and function names are stored once, in an arena that lives for
+ * the process, and looked up through an open-addressing table.
+ */
+
+static pthread_mutex_t intern_mutex = PTHREAD_MUTEX_INITIALIZER;
+static Arena *intern_strings = NULL;
+static const char **intern_slots = NULL;
+static size_t intern_capacity = 0;     /* Power of two */
+static size_t intern_count = 0;
+
+static size_t intern_hash(const char *name) {
+    size_t h = 2166136261u;
+    for (const unsigned char *c = (const unsigned char *)name; *c; c++) {
+        h = (h ^ *c) * 16777619u;
+    }
+    return h;
+}
+
+static bool intern_grow(void) {
+    size_t capacity = intern_capacity ? intern_capacity * 2 : 256;
+    const char **slots = calloc(capacity, sizeof(const char *));
+    if (!slots) return false;
+
+    for (size_t i = 0; i < intern_capacity; i++) {
+        if (!intern_slots[i]) continue;
+        size_t j = intern_hash(intern_slots[i]) & (capacity - 1);
+        while (slots[j]) j = (j + 1) & (capacity - 1);
+        slots[j] = intern_slots[i];
+    }
+    free(intern_slots);
+    intern_slots = slots;
+    intern_capacity = capacity;
+    return true;
+}
+
+const char* ast_intern(const char *name) {
+    if (!name) return NULL;
+
+    size_t h = intern_hash(name);
+    ASTThreadState *state = ast_thread_state(true);
+    const char **cached = state ? &state->intern_cache[h & (INTERN_CACHE_SIZE - 1)] : NULL;
+    if (cached && *cached && strcmp(*cached, name) == 0) return *cached;
+
+    const char *result = NULL;
+
+    pthread_mutex_lock(&intern_mutex);
+    if (!intern_strings) intern_strings = arena_create(16 * 1024);
+
+    if (intern_strings && (intern_count + 1) * 2 <= intern_capacity) {
+        size_t i = h & (intern_capacity - 1);
+        while (intern_slots[i] && strcmp(intern_slots[i], name) != 0) {
+            i = (i + 1) & (intern_capacity - 1);
+        }
+        result = intern_slots[i];
+        if (!result) {
+            size_t len = strlen(name);
+            char *copy = arena_alloc(intern_strings, len + 1);
+            if (copy) {
+                memcpy(copy, name, len + 1);
+                intern_slots[i] = result = copy;
+                intern_count++;
+            }
+        }
+    } else if (intern_strings && intern_grow()) {
+        pthread_mutex_unlock(&intern_mutex);
+        return ast_intern(name);
+    }
+    pthread_mutex_unlock(&intern_mutex);
+
+    if (cached && result) *cached = result;
+    return result;
+}
+
+/* ============================================================================
+ * AST ARENAS
+ * ============================================================================ */
+
+struct ASTArena {
+    Arena *memory;
+    size_t nodes;
+    ASTNode **tensor_nodes;     /* Tensor references released with the arena */
+    int tensor_count;
+    int tensor_capacity;
+};
+
+ASTArena* ast_arena_create(void) {
+    ASTArena *arena = calloc(1, sizeof(ASTArena));
+    if (!arena) return NULL;
+    arena->memory = arena_create(64 * 1024);
+    if (!arena->memory) {
+        free(arena);
+        return NULL;
+    }
+    return arena;
+}
+
+static void ast_arena_release_tensors(ASTArena *arena) {
+    for (int i = 0; i < arena->tensor_count; i++) {
+        tensor_release(arena->tensor_nodes[i]->data.tensor.tensor);
+    }
+    arena->tensor_count = 0;
+}
+
+void ast_arena_destroy(ASTArena *arena) {
+    if (!arena) return;
+    ast_arena_release_tensors(arena);
+    arena_destroy(arena->memory);
+    free(arena->tensor_nodes);
+    free(arena);
+}
+
+void ast_arena_reset(ASTArena *arena) {
+    if (!arena) return;
+    ast_arena_release_tensors(arena);
+    arena_reset(arena->memory);
+    arena->nodes = 0;
+}
+
+ASTArena* ast_arena_push(ASTArena *arena) {
+    ASTThreadState *state = ast_thread_state(true);
+    if (!state) return NULL;
+    ASTArena *previous = state->current;
+    state->current = arena;
+    return previous;
+}
+
+void ast_arena_pop(ASTArena *previous) {
+    ASTThreadState *state = ast_thread_state(previous != NULL);
+    if (state) state->current = previous;
+}
+
+size_t ast_arena_node_count(const ASTArena *arena) {
+    return arena ? arena->nodes : 0;
+}
+
+size_t ast_arena_bytes_used(const ASTArena *arena) {
+    return arena ? arena_get_used(arena->memory) : 0;
+}
+
+static ASTArena* ast_current_arena(void) {
+    ASTThreadState *state = ast_thread_state(false);
+    return state ? state->current : NULL;
+}
+
 /* ============================================================================
  * AST CONSTRUCTION
  * ============================================================================ */
 
+ASTNode* ast_node_alloc(ASTNodeType type) {
+    ASTArena *arena = ast_current_arena();
+    ASTNode *node;
+
+    if (arena) {
+        node = arena_alloc(arena->memory, sizeof(ASTNode));
+        if (!node) return NULL;
+        if (type == AST_TENSOR) {
+            if (arena->tensor_count == arena->tensor_capacity) {
+                int capacity = arena->tensor_capacity ? arena->tensor_capacity * 2 : 16;
+                ASTNode **grown = realloc(arena->tensor_nodes, sizeof(ASTNode *) * capacity);
+                if (!grown) return NULL;
+                arena->tensor_nodes = grown;
+                arena->tensor_capacity = capacity;
+            }
+            arena->tensor_nodes[arena->tensor_count++] = node;
+        }
+        node->in_arena = true;
+        arena->nodes++;
+    } else {
+        node = malloc(sizeof(ASTNode));
+        if (!node) return NULL;
+        node->in_arena = false;
+    }
+
+    node->type = type;
+    node->consed = false;
+    return node;
+}
+
 ASTNode* ast_create_number(double value) {
-    ASTNode *node = malloc(sizeof(ASTNode));
-    node->type = AST_NUMBER;
+    ASTNode *node = ast_node_alloc(AST_NUMBER);
     node->data.number.value = value;
     return node;
 }
 
-ASTNode* ast_create_variable(const char *name) {
-    ASTNode *node = malloc(sizeof(ASTNode));
-    node->type = AST_VARIABLE;
-    strncpy(node->data.variable.name, name, sizeof(node->data.variable.name) - 1);
-    node->data.variable.name[sizeof(node->data.variable.name) - 1] = '\0';
+/* name must already be interned */
+static ASTNode* create_variable_node(const char *name) {
+    ASTNode *node = ast_node_alloc(AST_VARIABLE);
+    node->data.variable.name = name;
     return node;
 }
 
+ASTNode* ast_create_variable(const char *name) {
+    return create_variable_node(ast_intern(name));
+}
+
 ASTNode* ast_create_binary_op(BinaryOp op, ASTNode *left, ASTNode *right) {
-    ASTNode *node = malloc(sizeof(ASTNode));
-    node->type = AST_BINARY_OP;
+    ASTNode *node = ast_node_alloc(AST_BINARY_OP);
     node->data.binary.op = op;
     node->data.binary.left = left;
     node->data.binary.right = right;
@@ -50,28 +276,35 @@ ASTNode* ast_create_binary_op(BinaryOp op, ASTNode *left, ASTNode *right) {
 }
 
 ASTNode* ast_create_unary_op(UnaryOp op, ASTNode *operand) {
-    ASTNode *node = malloc(sizeof(ASTNode));
-    node->type = AST_UNARY_OP;
+    ASTNode *node = ast_node_alloc(AST_UNARY_OP);
     node->data.unary.op = op;
     node->data.unary.operand = operand;
     return node;
 }
 
-ASTNode* ast_create_function_call(const char *name, ASTNode **args, int arg_count) {
-    ASTNode *node = malloc(sizeof(ASTNode));
-    node->type = AST_FUNCTION_CALL;
-    strncpy(node->data.function.name, name, sizeof(node->data.function.name) - 1);
-    node->data.function.name[sizeof(node->data.function.name) - 1] = '\0';
-    node->data.function.args = malloc(sizeof(ASTNode*) * arg_count);
-    for (int i = 0; i < arg_count; i++) {
-        node->data.function.args[i] = args[i];
+/* name must already be interned; the argument array is left to the caller */
+static ASTNode* create_function_node(const char *name, MathFunction id, ASTNode **args, int arg_count) {
+    ASTNode *node = ast_node_alloc(AST_FUNCTION_CALL);
+    node->data.function.name = name;
+    node->data.function.id = id;
+    node->data.function.args = NULL;
+    if (arg_count > 0) {
+        size_t size = sizeof(ASTNode*) * arg_count;
+        node->data.function.args = node->in_arena
+            ? arena_alloc(ast_current_arena()->memory, size) : malloc(size);
+        memcpy(node->data.function.args, args, size);
     }
     node->data.function.arg_count = arg_count;
     return node;
 }
 
+ASTNode* ast_create_function_call(const char *name, ASTNode **args, int arg_count) {
+    const MathFunctionInfo *info = math_function_lookup(name);
+    return create_function_node(ast_intern(name), info ? info->id : FUNC_UNKNOWN, args, arg_count);
+}
+
 void ast_free(ASTNode *node) {
-    if (!node) return;
+    if (!node || node->in_arena) return;
 
     switch (node->type) {
         case AST_BINARY_OP:
@@ -97,6 +330,14 @@ void ast_free(ASTNode *node) {
     free(node);
 }
 
+/* Free one node, leaving its children alone */
+static void ast_free_node(ASTNode *node) {
+    if (!node || node->in_arena) return;
+    if (node->type == AST_FUNCTION_CALL) free(node->data.function.args);
+    if (node->type == AST_TENSOR) tensor_release(node->data.tensor.tensor);
+    free(node);
+}
+
 ASTNode* ast_clone(const ASTNode *node) {
     if (!node) return NULL;
 
@@ -105,7 +346,7 @@ ASTNode* ast_clone(const ASTNode *node) {
             return ast_create_number(node->data.number.value);
 
         case AST_VARIABLE:
-            return ast_create_variable(node->data.variable.name);
+            return create_variable_node(node->data.variable.name);
 
         case AST_BINARY_OP:
             return ast_create_binary_op(
@@ -121,15 +362,16 @@ ASTNode* ast_clone(const ASTNode *node) {
             );
 
         case AST_FUNCTION_CALL: {
-            ASTNode **args = malloc(sizeof(ASTNode*) * node->data.function.arg_count);
-            for (int i = 0; i < node->data.function.arg_count; i++) {
+            ASTNode *local[4];
+            int arg_count = node->data.function.arg_count;
+            ASTNode **args = arg_count <= 4 ? local : malloc(sizeof(ASTNode*) * arg_count);
+            for (int i = 0; i < arg_count; i++) {
                 args[i] = ast_clone(node->data.function.args[i]);
             }
-            return ast_create_function_call(
-                node->data.function.name,
-                args,
-                node->data.function.arg_count
-            );
+            ASTNode *call = create_function_node(node->data.function.name, node->data.function.id,
+                                                 args, arg_count);
+            if (args != local) free(args);
+            return call;
         }
 
         case AST_TENSOR: {
@@ -145,15 +387,16 @@ ASTNode* ast_clone(const ASTNode *node) {
  * AST EVALUATION
  * ============================================================================ */
 
-static double lookup_var(const char *name, VarContext *vars) {
-    if (!vars || !vars->values) return 0.0;
+/* Index into vars->values that a variable name reads, or -1 (reads 0) */
+static int lookup_var_slot(const char *name, const VarContext *vars) {
+    if (!vars || !vars->values) return -1;
 
     if (vars->mappings && vars->mapping_count > 0) {
         for (int i = 0; i < vars->mapping_count; i++) {
             if (strcmp(name, vars->mappings[i].name) == 0) {
                 int idx = vars->mappings[i].index;
                 if (idx >= 0 && idx < vars->count) {
-                    return vars->values[idx];
+                    return idx;
                 }
             }
         }
@@ -162,17 +405,83 @@ static double lookup_var(const char *name, VarContext *vars) {
         if (c >= 'A' && c <= 'Z') {
             int idx = c - 'A';
             if (idx < vars->count) {
-                return vars->values[idx];
+                return idx;
             }
         }
     }
 
-    return 0.0;
+    return -1;
+}
+
+static double lookup_var(const char *name, VarContext *vars) {
+    int slot = lookup_var_slot(name, vars);
+    return slot >= 0 ? vars->values[slot] : 0.0;
+}
+
+/* ============================================================================
+ * MATH FUNCTION TABLE
+ * ============================================================================ */
+
+static double math_sgn(double x) { return (x > 0.0) ? 1.0 : (x < 0.0) ? -1.0 : 0.0; }
+static double math_atan2(double x, double y) { return atan2(y, x); }
+
+/* Indexed by MathFunction - 1 */
+static const MathFunctionInfo math_functions[FUNC_COUNT - 1] = {
+    {"RANDOM", FUNC_RANDOM, 0, NULL, NULL},
+    {"ABS", FUNC_ABS, 1, fabs, NULL},
+    {"ROUND", FUNC_ROUND, 1, round, NULL},
+    {"FLOOR", FUNC_FLOOR, 1, floor, NULL},
+    {"CEIL", FUNC_CEIL, 1, ceil, NULL},
+    {"SQRT", FUNC_SQRT, 1, sqrt, NULL},
+    {"SIN", FUNC_SIN, 1, sin, NULL},
+    {"COS", FUNC_COS, 1, cos, NULL},
+    {"TAN", FUNC_TAN, 1, tan, NULL},
+    {"ASIN", FUNC_ASIN, 1, asin, NULL},
+    {"ACOS", FUNC_ACOS, 1, acos, NULL},
+    {"ATAN", FUNC_ATAN, 1, atan, NULL},
+    {"LOG", FUNC_LOG, 1, log, NULL},
+    {"LOG10", FUNC_LOG10, 1, log10, NULL},
+    {"EXP", FUNC_EXP, 1, exp, NULL},
+    {"INT", FUNC_INT, 1, floor, NULL},  /* BASIC-style INT */
+    {"SGN", FUNC_SGN, 1, math_sgn, NULL},
+    {"MIN", FUNC_MIN, 2, NULL, fmin},
+    {"MAX", FUNC_MAX, 2, NULL, fmax},
+    {"POW", FUNC_POW, 2, NULL, pow},
+    {"ATAN2", FUNC_ATAN2, 2, NULL, math_atan2},
+    {"MOD", FUNC_MOD, 2, NULL, fmod},
+};
+
+static const struct {
+    const char *name;
+    MathFunction id;
+} math_function_aliases[] = {
+    {"RND", FUNC_RANDOM},
+    {"LN", FUNC_LOG},
+};
+
+const MathFunctionInfo* math_function_lookup(const char *name) {
+    if (!name) return NULL;
+
+    for (int i = 0; i < FUNC_COUNT - 1; i++) {
+        if (name[0] == math_functions[i].name[0] && strcmp(name, math_functions[i].name) == 0) {
+            return &math_functions[i];
+        }
+    }
+    for (size_t i = 0; i < sizeof(math_function_aliases) / sizeof(math_function_aliases[0]); i++) {
+        if (strcmp(name, math_function_aliases[i].name) == 0) {
+            return &math_functions[math_function_aliases[i].id - 1];
+        }
+    }
+    return NULL;
+}
+
+const MathFunctionInfo* math_function_info(MathFunction id) {
+    if (id <= FUNC_UNKNOWN || id >= FUNC_COUNT) return NULL;
+    return &math_functions[id - 1];
 }
 
-static double eval_function(const char *name, double *args, int arg_count) {
-    /* Zero-argument */
-    if (strcmp(name, "RANDOM") == 0 || strcmp(name, "RND") == 0) {
+double math_function_eval(MathFunction id, const double *args, int arg_count) {
+    if (id == FUNC_RANDOM) {
         /* Thread-safe RNG with mutex protection */
         pthread_mutex_lock(&rng_mutex);
         if (!random_seeded) {
@@ -184,38 +493,9 @@ static double eval_function(const char *name, double *args, int arg_count) {
         return r;
     }
 
-    /* One-argument */
-    if (arg_count == 1) {
-        double x = args[0];
-        if (strcmp(name, "ABS") == 0) return fabs(x);
-        if (strcmp(name, "ROUND") == 0) return round(x);
-        if (strcmp(name, "FLOOR") == 0) return floor(x);
-        if (strcmp(name, "CEIL") == 0) return ceil(x);
-        if (strcmp(name, "SQRT") == 0) return sqrt(x);
-        if (strcmp(name, "SIN") == 0) return sin(x);
-        if (strcmp(name, "COS") == 0) return cos(x);
-        if (strcmp(name, "TAN") == 0) return tan(x);
-        if (strcmp(name, "ASIN") == 0) return asin(x);
-        if (strcmp(name, "ACOS") == 0) return acos(x);
-        if (strcmp(name, "ATAN") == 0) return atan(x);
-        if (strcmp(name, "LOG") == 0 || strcmp(name, "LN") == 0) return log(x);
-        if (strcmp(name, "LOG10") == 0) return log10(x);
-        if (strcmp(name, "EXP") == 0) return exp(x);
-        if (strcmp(name, "INT") == 0) return floor(x);
-        if (strcmp(name, "SGN") == 0) return (x > 0.0) ? 1.0 : (x < 0.0) ? -1.0 : 0.0;
-    }
-
-    /* Two-argument */
-    if (arg_count == 2) {
-        double x = args[0], y = args[1];
-        if (strcmp(name, "MIN") == 0) return fmin(x, y);
-        if (strcmp(name, "MAX") == 0) return fmax(x, y);
-        if (strcmp(name, "POW") == 0) return pow(x, y);
-        if (strcmp(name, "ATAN2") == 0) return atan2(y, x);
-        if (strcmp(name, "MOD") == 0) return fmod(x, y);
-    }
-
-    return 0.0;
+    const MathFunctionInfo *f = math_function_info(id);
+    if (!f || arg_count != f->arg_count) return 0.0;
+    return arg_count == 1 ? f->fn1(args[0]) : f->fn2(args[0], args[1]);
 }
 
 double ast_evaluate(const ASTNode *node, VarContext *vars) {
@@ -265,7 +545,7 @@ double ast_evaluate(const ASTNode *node, VarContext *vars) {
             for (int i = 0; i < node->data.function.arg_count && i < 10; i++) {
                 args[i] = ast_evaluate(node->data.function.args[i], vars);
             }
-            return eval_function(node->data.function.name, args, node->data.function.arg_count);
+            return math_function_eval(node->data.function.id, args, node->data.function.arg_count);
         }
 
         case AST_TENSOR:
@@ -276,6 +556,191 @@ double ast_evaluate(const ASTNode *node, VarContext *vars) {
     return 0.0;
 }
 
+/* ============================================================================
+ * DUAL-NUMBER EVALUATION
+ * ============================================================================
+ * Operator semantics shared by the evaluators that also carry derivatives
+ * (dual numbers here and in the VM, the reverse-mode tape): the value is
+ * exactly what the VM computes, and the local partial derivatives follow
+ * its conventions.
+ */
+
+/* Division with the VM's convention: dividing by zero gives 0 */
+static double safe_div(double n, double d) {
+    return d != 0.0 ? n / d : 0.0;
+}
+
+/* r = op(x, y), as vm_execute() computes it; func selects a CALL_FUNC */
+static double op_value(BytecodeOp op, MathFunction func, double x, double y) {
+    switch (op) {
+        case BC_ADD: return x + y;
+        case BC_SUBTRACT: return x - y;
+        case BC_MULTIPLY: return x * y;
+        case BC_DIVIDE: return safe_div(x, y);
+        case BC_POWER: return pow(x, y);
+        case BC_NEGATE: return -x;
+        case BC_NOT: return (x == 0.0) ? 1.0 : 0.0;
+        case BC_AND: return (x != 0.0 && y != 0.0) ? 1.0 : 0.0;
+        case BC_OR: return (x != 0.0 || y != 0.0) ? 1.0 : 0.0;
+        case BC_GREATER: return (x > y) ? 1.0 : 0.0;
+        case BC_LESS: return (x < y) ? 1.0 : 0.0;
+        case BC_GREATER_EQ: return (x >= y) ? 1.0 : 0.0;
+        case BC_LESS_EQ: return (x <= y) ? 1.0 : 0.0;
+        case BC_EQUAL: return (fabs(x - y) < 1e-12) ? 1.0 : 0.0;
+        case BC_NOT_EQUAL: return (fabs(x - y) >= 1e-12) ? 1.0 : 0.0;
+        case BC_CALL_FUNC: {
+            double args[2] = {x, y};
+            const MathFunctionInfo *f = math_function_info(func);
+            return math_function_eval(func, args, f ? f->arg_count : 0);
+        }
+        default: return 0.0;
+    }
+}
+
+/* Partial derivatives dr/dx and dr/dy of r = op(x, y). Where the VM
+ * divides by zero the partial is 0; piecewise-constant functions,
+ * comparisons and logic have none; ABS, MIN and MAX follow the branch taken.
+ */
+static void op_partials(BytecodeOp op, MathFunction func, double x, double y, double r,
+                        double *dx, double *dy) {
+    *dx = 0.0;
+    *dy = 0.0;
+    switch (op) {
+        case BC_ADD: *dx = 1.0; *dy = 1.0; break;
+        case BC_SUBTRACT: *dx = 1.0; *dy = -1.0; break;
+        case BC_MULTIPLY: *dx = y; *dy = x; break;
+        case BC_DIVIDE: *dx = safe_div(1.0, y); *dy = -safe_div(r, y); break;
+        case BC_NEGATE: *dx = -1.0; break;
+        case BC_POWER:
+            if (y != 0.0) *dx = y * pow(x, y - 1.0);
+            if (x > 0.0) *dy = r * log(x);
+            break;
+        case BC_CALL_FUNC:
+            switch (func) {
+                case FUNC_ABS: *dx = (x > 0.0) - (x < 0.0); break;
+                case FUNC_SQRT: *dx = safe_div(1.0, 2.0 * r); break;
+                case FUNC_SIN: *dx = cos(x); break;
+                case FUNC_COS: *dx = -sin(x); break;
+                case FUNC_TAN: *dx = safe_div(1.0, cos(x) * cos(x)); break;
+                case FUNC_ASIN: *dx = safe_div(1.0, sqrt(1.0 - x * x)); break;
+                case FUNC_ACOS: *dx = -safe_div(1.0, sqrt(1.0 - x * x)); break;
+                case FUNC_ATAN: *dx = 1.0 / (1.0 + x * x); break;
+                case FUNC_LOG: *dx = safe_div(1.0, x); break;
+                case FUNC_LOG10: *dx = safe_div(1.0, x * M_LN10); break;
+                case FUNC_EXP: *dx = r; break;
+                case FUNC_MIN:
+                case FUNC_MAX:
+                    *dx = (r == x) ? 1.0 : 0.0;
+                    *dy = 1.0 - *dx;
+                    break;
+                case FUNC_POW:
+                    if (y != 0.0) *dx = y * pow(x, y - 1.0);
+                    if (x > 0.0) *dy = r * log(x);
+                    break;
+                case FUNC_ATAN2:  /* ATAN2(x, y) = atan2(y, x) */
+                    *dx = -safe_div(y, x * x + y * y);
+                    *dy = safe_div(x, x * x + y * y);
+                    break;
+                case FUNC_MOD:
+                    *dx = 1.0;
+                    *dy = -trunc(safe_div(x, y));
+                    break;
+                default:
+                    break;  /* Piecewise constant or random */
+            }
+            break;
+        default:
+            break;  /* Comparisons and logic */
+    }
+}
+
+/* Apply op to dual operands. A zero tangent contributes nothing, even
+ * where the partial is infinite (sqrt at 0).
+ */
+static Dual dual_apply(BytecodeOp op, MathFunction func, Dual a, Dual b) {
+    Dual r;
+    double px, py;
+    r.value = op_value(op, func, a.value, b.value);
+    op_partials(op, func, a.value, b.value, r.value, &px, &py);
+    r.deriv = (a.deriv != 0.0 ? px * a.deriv : 0.0) + (b.deriv != 0.0 ? py * b.deriv : 0.0);
+    return r;
+}
+
+/* Dual value of a function call; unknown functions and wrong argument
+ * counts give 0, like math_function_eval()
+ */
+static Dual dual_call(MathFunction id, const Dual *args, int arg_count) {
+    static const Dual zero = {0.0, 0.0};
+    const MathFunctionInfo *f = math_function_info(id);
+    if (id == FUNC_RANDOM) {
+        Dual r = {math_function_eval(FUNC_RANDOM, NULL, 0), 0.0};
+        return r;
+    }
+    if (!f || f->arg_count != arg_count) return zero;
+    return dual_apply(BC_CALL_FUNC, id, args[0], arg_count == 2 ? args[1] : zero);
+}
+
+Dual ast_evaluate_dual(const ASTNode *node, VarContext *vars, int seed_slot) {
+    static const Dual zero = {0.0, 0.0};
+    if (!node) return zero;
+
+    switch (node->type) {
+        case AST_NUMBER: {
+            Dual r = {node->data.number.value, 0.0};
+            return r;
+        }
+
+        case AST_VARIABLE: {
+            int slot = lookup_var_slot(node->data.variable.name, vars);
+            Dual r = {slot >= 0 ? vars->values[slot] : 0.0, (slot >= 0 && slot == seed_slot) ? 1.0 : 0.0};
+            return r;
+        }
+
+        case AST_BINARY_OP: {
+            Dual left = ast_evaluate_dual(node->data.binary.left, vars, seed_slot);
+            Dual right = ast_evaluate_dual(node->data.binary.right, vars, seed_slot);
+            BytecodeOp op = BC_HALT;
+            switch (node->data.binary.op) {
+                case OP_ADD: op = BC_ADD; break;
+                case OP_SUBTRACT: op = BC_SUBTRACT; break;
+                case OP_MULTIPLY: op = BC_MULTIPLY; break;
+                case OP_DIVIDE: op = BC_DIVIDE; break;
+                case OP_POWER: op = BC_POWER; break;
+                case OP_AND: op = BC_AND; break;
+                case OP_OR: op = BC_OR; break;
+                case OP_GREATER: op = BC_GREATER; break;
+                case OP_LESS: op = BC_LESS; break;
+                case OP_GREATER_EQ: op = BC_GREATER_EQ; break;
+                case OP_LESS_EQ: op = BC_LESS_EQ; break;
+                case OP_EQUAL: op = BC_EQUAL; break;
+                case OP_NOT_EQUAL: op = BC_NOT_EQUAL; break;
+            }
+            return dual_apply(op, FUNC_UNKNOWN, left, right);
+        }
+
+        case AST_UNARY_OP: {
+            Dual operand = ast_evaluate_dual(node->data.unary.operand, vars, seed_slot);
+            return dual_apply(node->data.unary.op == OP_NEGATE ? BC_NEGATE : BC_NOT,
+                              FUNC_UNKNOWN, operand, zero);
+        }
+
+        case AST_FUNCTION_CALL: {
+            Dual args[10];
+            for (int i = 0; i < node->data.function.arg_count && i < 10; i++) {
+                args[i] = ast_evaluate_dual(node->data.function.args[i], vars, seed_slot);
+            }
+            return dual_call(node->data.function.id, args, node->data.function.arg_count);
+        }
+
+        case AST_TENSOR: {
+            Dual r = {tensor_mean(node->data.tensor.tensor), 0.0};
+            return r;
+        }
+    }
+
+    return zero;
+}
+
 /* ============================================================================
  * AST PRINTING
  * ============================================================================ */
@@ -548,6 +1013,7 @@ ASTNode* ast_differentiate(const ASTNode *node, const char *var_name) {
                     /* Simplified: d/dx(f^n) = n * f^(n-1) * f' if g is constant */
                     if (!ast_contains_variable(right, var_name)) {
                         /* Power rule: d/dx(f^n) = n * f^(n-1) * f' */
+                        ast_free(dright);  /* Constant exponent: g' = 0 */
                         return ast_create_binary_op(OP_MULTIPLY,
                             ast_create_binary_op(OP_MULTIPLY,
                                 ast_clone(right),
@@ -665,82 +1131,746 @@ ASTNode* ast_differentiate(const ASTNode *node, const char *var_name) {
 }
 
 /* ============================================================================
- * PARTIAL DERIVATIVES & GRADIENT
- * ============================================================================ */
-
-/* Compute partial derivative ∂f/∂var
- * This is just an alias for ast_differentiate for clarity in multi-variable contexts
+ * HASH-CONSED EXPRESSION DAGS
+ * ============================================================================
+ * Nodes live in the DAG's arena and are found again through a table keyed
+ * on their operator and child pointers: children are already canonical, so
+ * one shallow comparison decides structural equality. Rewrites run before
+ * the lookup, so the table only ever holds simplified nodes. A second
+ * table memoizes derivatives by (node, variable) and imports from other
+ * DAGs by source node.
  */
-ASTNode* ast_partial_derivative(const ASTNode *node, const char *var_name) {
-    return ast_differentiate(node, var_name);
-}
-
-/* Compute gradient vector ∇f = [∂f/∂x₁, ∂f/∂x₂, ..., ∂f/∂xₙ] */
-Gradient ast_gradient(const ASTNode *node, const char **var_names, int var_count) {
-    Gradient grad;
-    grad.components = NULL;
-    grad.count = 0;
-    grad.var_names = NULL;
 
-    if (!node || !var_names || var_count <= 0) {
-        return grad;
+static uint64_t cse_mix(uint64_t h, uint64_t v);
+static double bytecode_run(const Bytecode *bc, const VarContext *vars);
+static Bytecode* ast_compile_outputs(const ASTNode *const *roots, int count);
+
+typedef struct {
+    const ASTNode *key;     /* DAG node (derivatives) or source node (imports) */
+    const char *var;        /* Interned variable, NULL for imports */
+    ASTNode *value;
+} DagMemo;
+
+struct ASTDag {
+    ASTArena *arena;
+    ASTNode **nodes;        /* Hash-cons table, open addressing */
+    size_t node_mask;
+    size_t node_count;
+    DagMemo *memo;          /* Open addressing on (key, var) */
+    size_t memo_mask;
+    size_t memo_count;
+};
+
+ASTDag* ast_dag_create(void) {
+    ASTDag *dag = calloc(1, sizeof(ASTDag));
+    if (!dag) return NULL;
+    dag->arena = ast_arena_create();
+    dag->node_mask = 255;
+    dag->nodes = calloc(dag->node_mask + 1, sizeof(ASTNode *));
+    dag->memo_mask = 63;
+    dag->memo = calloc(dag->memo_mask + 1, sizeof(DagMemo));
+    if (!dag->arena || !dag->nodes || !dag->memo) {
+        ast_dag_destroy(dag);
+        return NULL;
     }
+    return dag;
+}
 
-    /* Allocate arrays */
-    grad.components = malloc(sizeof(ASTNode*) * var_count);
-    grad.var_names = malloc(sizeof(char*) * var_count);
-    grad.count = var_count;
+void ast_dag_destroy(ASTDag *dag) {
+    if (!dag) return;
+    ast_arena_destroy(dag->arena);
+    free(dag->nodes);
+    free(dag->memo);
+    free(dag);
+}
 
-    /* Compute partial derivative for each variable */
-    for (int i = 0; i < var_count; i++) {
-        grad.components[i] = ast_partial_derivative(node, var_names[i]);
+size_t ast_dag_node_count(const ASTDag *dag) {
+    return dag ? dag->node_count : 0;
+}
 
-        /* Copy variable name */
-        grad.var_names[i] = malloc(strlen(var_names[i]) + 1);
-        strcpy(grad.var_names[i], var_names[i]);
+/* Hash of a node's own fields; children count by identity */
+static size_t dag_hash(const ASTNode *node) {
+    uint64_t h = cse_mix(0, (uint64_t)node->type);
+    switch (node->type) {
+        case AST_NUMBER: {
+            uint64_t bits;
+            memcpy(&bits, &node->data.number.value, sizeof(bits));
+            h = cse_mix(h, bits);
+            break;
+        }
+        case AST_VARIABLE:
+            h = cse_mix(h, (uint64_t)(uintptr_t)node->data.variable.name);
+            break;
+        case AST_BINARY_OP:
+            h = cse_mix(cse_mix(cse_mix(h, node->data.binary.op),
+                                (uint64_t)(uintptr_t)node->data.binary.left),
+                        (uint64_t)(uintptr_t)node->data.binary.right);
+            break;
+        case AST_UNARY_OP:
+            h = cse_mix(cse_mix(h, node->data.unary.op), (uint64_t)(uintptr_t)node->data.unary.operand);
+            break;
+        case AST_FUNCTION_CALL:
+            h = cse_mix(h, (uint64_t)(uintptr_t)node->data.function.name);
+            for (int i = 0; i < node->data.function.arg_count; i++) {
+                h = cse_mix(h, (uint64_t)(uintptr_t)node->data.function.args[i]);
+            }
+            break;
+        default:
+            h = cse_mix(h, (uint64_t)(uintptr_t)node);
+            break;
     }
+    return (size_t)h;
+}
 
-    return grad;
+static bool dag_same(const ASTNode *a, const ASTNode *b) {
+    if (a->type != b->type) return false;
+    switch (a->type) {
+        case AST_NUMBER:
+            return memcmp(&a->data.number.value, &b->data.number.value, sizeof(double)) == 0;
+        case AST_VARIABLE:
+            return a->data.variable.name == b->data.variable.name;
+        case AST_BINARY_OP:
+            return a->data.binary.op == b->data.binary.op &&
+                   a->data.binary.left == b->data.binary.left &&
+                   a->data.binary.right == b->data.binary.right;
+        case AST_UNARY_OP:
+            return a->data.unary.op == b->data.unary.op &&
+                   a->data.unary.operand == b->data.unary.operand;
+        case AST_FUNCTION_CALL:
+            if (a->data.function.name != b->data.function.name ||
+                a->data.function.arg_count != b->data.function.arg_count) {
+                return false;
+            }
+            for (int i = 0; i < a->data.function.arg_count; i++) {
+                if (a->data.function.args[i] != b->data.function.args[i]) return false;
+            }
+            return true;
+        default:
+            return a == b;
+    }
 }
 
-/* Free gradient structure */
-void gradient_free(Gradient *grad) {
-    if (!grad) return;
+static bool dag_grow_nodes(ASTDag *dag) {
+    size_t mask = dag->node_mask * 2 + 1;
+    ASTNode **nodes = calloc(mask + 1, sizeof(ASTNode *));
+    if (!nodes) return false;
+    for (size_t k = 0; k <= dag->node_mask; k++) {
+        if (!dag->nodes[k]) continue;
+        size_t i = dag_hash(dag->nodes[k]) & mask;
+        while (nodes[i]) i = (i + 1) & mask;
+        nodes[i] = dag->nodes[k];
+    }
+    free(dag->nodes);
+    dag->nodes = nodes;
+    dag->node_mask = mask;
+    return true;
+}
 
-    if (grad->components) {
-        for (int i = 0; i < grad->count; i++) {
-            ast_free(grad->components[i]);
-        }
-        free(grad->components);
+/* The canonical node equal to probe, created from it the first time */
+static ASTNode* dag_intern_node(ASTDag *dag, const ASTNode *probe) {
+    size_t i = dag_hash(probe) & dag->node_mask;
+    for (; dag->nodes[i]; i = (i + 1) & dag->node_mask) {
+        if (dag_same(dag->nodes[i], probe)) return dag->nodes[i];
     }
 
-    if (grad->var_names) {
-        for (int i = 0; i < grad->count; i++) {
-            free(grad->var_names[i]);
-        }
-        free(grad->var_names);
+    if ((dag->node_count + 1) * 2 > dag->node_mask + 1) {
+        if (!dag_grow_nodes(dag)) return NULL;
+        i = dag_hash(probe) & dag->node_mask;
+        while (dag->nodes[i]) i = (i + 1) & dag->node_mask;
     }
 
-    grad->components = NULL;
-    grad->var_names = NULL;
-    grad->count = 0;
+    ASTArena *previous = ast_arena_push(dag->arena);
+    ASTNode *node;
+    if (probe->type == AST_FUNCTION_CALL) {
+        node = create_function_node(probe->data.function.name, probe->data.function.id,
+                                    probe->data.function.args, probe->data.function.arg_count);
+    } else {
+        node = ast_node_alloc(probe->type);
+        if (node) node->data = probe->data;
+    }
+    ast_arena_pop(previous);
+    if (!node) return NULL;
+
+    node->consed = true;
+    dag->nodes[i] = node;
+    dag->node_count++;
+    return node;
 }
 
-/* Evaluate gradient at a point */
-double* gradient_evaluate(const Gradient *grad, VarContext *vars) {
-    if (!grad || grad->count <= 0) return NULL;
+static bool dag_owns(const ASTDag *dag, const ASTNode *node) {
+    if (!node->consed) return false;
+    for (size_t i = dag_hash(node) & dag->node_mask; dag->nodes[i]; i = (i + 1) & dag->node_mask) {
+        if (dag->nodes[i] == node) return true;
+    }
+    return false;
+}
 
-    double *result = malloc(sizeof(double) * grad->count);
+static size_t dag_memo_hash(const ASTNode *key, const char *var) {
+    return (size_t)cse_mix(cse_mix(0, (uint64_t)(uintptr_t)key), (uint64_t)(uintptr_t)var);
+}
 
-    for (int i = 0; i < grad->count; i++) {
-        result[i] = ast_evaluate(grad->components[i], vars);
+static ASTNode* dag_memo_get(const ASTDag *dag, const ASTNode *key, const char *var) {
+    for (size_t i = dag_memo_hash(key, var) & dag->memo_mask; dag->memo[i].key;
+         i = (i + 1) & dag->memo_mask) {
+        if (dag->memo[i].key == key && dag->memo[i].var == var) return dag->memo[i].value;
     }
-
-    return result;
+    return NULL;
 }
 
-/* ============================================================================
- * TAYLOR SERIES EXPANSION
+static ASTNode* dag_memo_put(ASTDag *dag, const ASTNode *key, const char *var, ASTNode *value) {
+    if (!value) return NULL;
+
+    if ((dag->memo_count + 1) * 2 > dag->memo_mask + 1) {
+        size_t mask = dag->memo_mask * 2 + 1;
+        DagMemo *memo = calloc(mask + 1, sizeof(DagMemo));
+        if (!memo) return value;    /* Correct, just not remembered */
+        for (size_t k = 0; k <= dag->memo_mask; k++) {
+            if (!dag->memo[k].key) continue;
+            size_t i = dag_memo_hash(dag->memo[k].key, dag->memo[k].var) & mask;
+            while (memo[i].key) i = (i + 1) & mask;
+            memo[i] = dag->memo[k];
+        }
+        free(dag->memo);
+        dag->memo = memo;
+        dag->memo_mask = mask;
+    }
+
+    size_t i = dag_memo_hash(key, var) & dag->memo_mask;
+    while (dag->memo[i].key) i = (i + 1) & dag->memo_mask;
+    dag->memo[i] = (DagMemo){.key = key, .var = var, .value = value};
+    dag->memo_count++;
+    return value;
+}
+
+static bool dag_is_number(const ASTNode *node, double value) {
+    return node->type == AST_NUMBER && node->data.number.value == value;
+}
+
+ASTNode* ast_dag_number(ASTDag *dag, double value) {
+    if (!dag) return NULL;
+    ASTNode probe = {.type = AST_NUMBER};
+    probe.data.number.value = value;
+    return dag_intern_node(dag, &probe);
+}
+
+/* name must already be interned */
+static ASTNode* dag_variable(ASTDag *dag, const char *name) {
+    ASTNode probe = {.type = AST_VARIABLE};
+    probe.data.variable.name = name;
+    return dag_intern_node(dag, &probe);
+}
+
+ASTNode* ast_dag_variable(ASTDag *dag, const char *name) {
+    if (!dag || !name) return NULL;
+    return dag_variable(dag, ast_intern(name));
+}
+
+/* Split "c * t" or "t * c" into coefficient and term; anything else is 1 * node */
+static ASTNode* dag_term(ASTNode *node, double *coef) {
+    if (node->type == AST_BINARY_OP && node->data.binary.op == OP_MULTIPLY) {
+        if (node->data.binary.left->type == AST_NUMBER) {
+            *coef = node->data.binary.left->data.number.value;
+            return node->data.binary.right;
+        }
+        if (node->data.binary.right->type == AST_NUMBER) {
+            *coef = node->data.binary.right->data.number.value;
+            return node->data.binary.left;
+        }
+    }
+    *coef = 1.0;
+    return node;
+}
+
+ASTNode* ast_dag_binary_op(ASTDag *dag, BinaryOp op, ASTNode *left, ASTNode *right) {
+    if (!dag || !left || !right) return NULL;
+
+    ASTNode probe = {.type = AST_BINARY_OP};
+    probe.data.binary.op = op;
+    probe.data.binary.left = left;
+    probe.data.binary.right = right;
+
+    /* Constant folding, with ast_evaluate()'s semantics */
+    if (left->type == AST_NUMBER && right->type == AST_NUMBER) {
+        return ast_dag_number(dag, ast_evaluate(&probe, NULL));
+    }
+
+    switch (op) {
+        case OP_ADD: {
+            if (dag_is_number(right, 0.0)) return left;
+            if (dag_is_number(left, 0.0)) return right;
+            /* Like terms: a*t + b*t = (a+b)*t */
+            double a, b;
+            ASTNode *term = dag_term(left, &a);
+            if (term == dag_term(right, &b)) {
+                return ast_dag_binary_op(dag, OP_MULTIPLY, ast_dag_number(dag, a + b), term);
+            }
+            break;
+        }
+
+        case OP_SUBTRACT:
+            if (dag_is_number(right, 0.0)) return left;
+            if (dag_is_number(left, 0.0)) return ast_dag_unary_op(dag, OP_NEGATE, right);
+            break;
+
+        case OP_MULTIPLY:
+            if (dag_is_number(left, 0.0) || dag_is_number(right, 0.0)) return ast_dag_number(dag, 0.0);
+            if (dag_is_number(right, 1.0)) return left;
+            if (dag_is_number(left, 1.0)) return right;
+            /* a * (b * t) = (a*b) * t */
+            if (left->type == AST_NUMBER && right->type == AST_BINARY_OP &&
+                right->data.binary.op == OP_MULTIPLY && right->data.binary.left->type == AST_NUMBER) {
+                return ast_dag_binary_op(dag, OP_MULTIPLY,
+                    ast_dag_number(dag, left->data.number.value * right->data.binary.left->data.number.value),
+                    right->data.binary.right);
+            }
+            break;
+
+        case OP_DIVIDE:
+            if (dag_is_number(left, 0.0)) return ast_dag_number(dag, 0.0);
+            if (dag_is_number(right, 1.0)) return left;
+            break;
+
+        case OP_POWER:
+            if (dag_is_number(right, 0.0)) return ast_dag_number(dag, 1.0);
+            if (dag_is_number(right, 1.0)) return left;
+            if (dag_is_number(left, 0.0)) return ast_dag_number(dag, 0.0);
+            if (dag_is_number(left, 1.0)) return ast_dag_number(dag, 1.0);
+            break;
+
+        default:
+            break;
+    }
+
+    return dag_intern_node(dag, &probe);
+}
+
+ASTNode* ast_dag_unary_op(ASTDag *dag, UnaryOp op, ASTNode *operand) {
+    if (!dag || !operand) return NULL;
+
+    ASTNode probe = {.type = AST_UNARY_OP};
+    probe.data.unary.op = op;
+    probe.data.unary.operand = operand;
+
+    if (operand->type == AST_NUMBER) {
+        return ast_dag_number(dag, ast_evaluate(&probe, NULL));
+    }
+    /* --x = x */
+    if (op == OP_NEGATE && operand->type == AST_UNARY_OP && operand->data.unary.op == OP_NEGATE) {
+        return operand->data.unary.operand;
+    }
+    return dag_intern_node(dag, &probe);
+}
+
+/* name must already be interned */
+static ASTNode* dag_function(ASTDag *dag, const char *name, MathFunction id, ASTNode **args, int arg_count) {
+    bool constant = true;
+    for (int i = 0; i < arg_count; i++) {
+        if (!args[i]) return NULL;
+        constant = constant && args[i]->type == AST_NUMBER;
+    }
+
+    ASTNode probe = {.type = AST_FUNCTION_CALL};
+    probe.data.function.name = name;
+    probe.data.function.id = id;
+    probe.data.function.args = args;
+    probe.data.function.arg_count = arg_count;
+
+    /* Fold known, deterministic calls with the right number of arguments */
+    const MathFunctionInfo *f = math_function_info(id);
+    if (constant && f && id != FUNC_RANDOM && f->arg_count == arg_count) {
+        return ast_dag_number(dag, ast_evaluate(&probe, NULL));
+    }
+    return dag_intern_node(dag, &probe);
+}
+
+ASTNode* ast_dag_function_call(ASTDag *dag, const char *name, ASTNode **args, int arg_count) {
+    if (!dag || !name || arg_count < 0 || (arg_count > 0 && !args)) return NULL;
+    const MathFunctionInfo *info = math_function_lookup(name);
+    return dag_function(dag, ast_intern(name), info ? info->id : FUNC_UNKNOWN, args, arg_count);
+}
+
+static ASTNode* dag_import(ASTDag *dag, const ASTNode *node) {
+    if (!node) return NULL;
+    if (dag_owns(dag, node)) return (ASTNode *)node;
+
+    /* Nodes of other DAGs may be reached along many paths */
+    if (node->consed) {
+        ASTNode *known = dag_memo_get(dag, node, NULL);
+        if (known) return known;
+    }
+
+    ASTNode *result = NULL;
+    switch (node->type) {
+        case AST_NUMBER:
+            result = ast_dag_number(dag, node->data.number.value);
+            break;
+
+        case AST_VARIABLE:
+            result = dag_variable(dag, node->data.variable.name);
+            break;
+
+        case AST_BINARY_OP:
+            result = ast_dag_binary_op(dag, node->data.binary.op,
+                                       dag_import(dag, node->data.binary.left),
+                                       dag_import(dag, node->data.binary.right));
+            break;
+
+        case AST_UNARY_OP:
+            result = ast_dag_unary_op(dag, node->data.unary.op, dag_import(dag, node->data.unary.operand));
+            break;
+
+        case AST_FUNCTION_CALL: {
+            ASTNode *local[4];
+            int arg_count = node->data.function.arg_count;
+            ASTNode **args = arg_count <= 4 ? local : malloc(sizeof(ASTNode*) * arg_count);
+            if (!args) return NULL;
+            for (int i = 0; i < arg_count; i++) {
+                args[i] = dag_import(dag, node->data.function.args[i]);
+            }
+            result = dag_function(dag, node->data.function.name, node->data.function.id, args, arg_count);
+            if (args != local) free(args);
+            break;
+        }
+
+        case AST_TENSOR: {
+            /* Shares the tensor; the arena holds the reference */
+            ASTArena *previous = ast_arena_push(dag->arena);
+            result = ast_create_tensor(node->data.tensor.tensor);
+            ast_arena_pop(previous);
+            break;
+        }
+    }
+
+    return node->consed ? dag_memo_put(dag, node, NULL, result) : result;
+}
+
+ASTNode* ast_dag_simplify(ASTDag *dag, const ASTNode *node) {
+    if (!dag) return NULL;
+    return dag_import(dag, node);
+}
+
+/* d(node)/d(var) for a node of this DAG; var is interned */
+static ASTNode* dag_differentiate(ASTDag *dag, ASTNode *node, const char *var) {
+    if (!node) return NULL;
+
+    ASTNode *known = dag_memo_get(dag, node, var);
+    if (known) return known;
+
+    ASTNode *zero = ast_dag_number(dag, 0.0);
+    ASTNode *result = zero;
+
+    switch (node->type) {
+        case AST_VARIABLE:
+            if (node->data.variable.name == var) result = ast_dag_number(dag, 1.0);
+            break;
+
+        case AST_BINARY_OP: {
+            ASTNode *f = node->data.binary.left;
+            ASTNode *g = node->data.binary.right;
+            BinaryOp op = node->data.binary.op;
+            if (op != OP_ADD && op != OP_SUBTRACT && op != OP_MULTIPLY &&
+                op != OP_DIVIDE && op != OP_POWER) {
+                break;  /* Comparison and logical operators have derivative 0 */
+            }
+            ASTNode *df = dag_differentiate(dag, f, var);
+            ASTNode *dg = dag_differentiate(dag, g, var);
+
+            switch (op) {
+                case OP_ADD:
+                case OP_SUBTRACT:
+                    result = ast_dag_binary_op(dag, op, df, dg);
+                    break;
+
+                case OP_MULTIPLY:
+                    /* f' * g + f * g' */
+                    result = ast_dag_binary_op(dag, OP_ADD,
+                        ast_dag_binary_op(dag, OP_MULTIPLY, df, g),
+                        ast_dag_binary_op(dag, OP_MULTIPLY, f, dg));
+                    break;
+
+                case OP_DIVIDE:
+                    /* (f' * g - f * g') / g^2 */
+                    result = ast_dag_binary_op(dag, OP_DIVIDE,
+                        ast_dag_binary_op(dag, OP_SUBTRACT,
+                            ast_dag_binary_op(dag, OP_MULTIPLY, df, g),
+                            ast_dag_binary_op(dag, OP_MULTIPLY, f, dg)),
+                        ast_dag_binary_op(dag, OP_POWER, g, ast_dag_number(dag, 2.0)));
+                    break;
+
+                default:
+                    if (dg == zero) {
+                        /* Power rule: g * f^(g-1) * f' */
+                        result = ast_dag_binary_op(dag, OP_MULTIPLY,
+                            ast_dag_binary_op(dag, OP_MULTIPLY, g,
+                                ast_dag_binary_op(dag, OP_POWER, f,
+                                    ast_dag_binary_op(dag, OP_SUBTRACT, g, ast_dag_number(dag, 1.0)))),
+                            df);
+                    } else {
+                        /* f^g * (g' * ln(f) + g * f' / f) */
+                        ASTNode *ln_f = ast_dag_function_call(dag, "LN", &f, 1);
+                        result = ast_dag_binary_op(dag, OP_MULTIPLY, node,
+                            ast_dag_binary_op(dag, OP_ADD,
+                                ast_dag_binary_op(dag, OP_MULTIPLY, dg, ln_f),
+                                ast_dag_binary_op(dag, OP_DIVIDE,
+                                    ast_dag_binary_op(dag, OP_MULTIPLY, g, df), f)));
+                    }
+                    break;
+            }
+            break;
+        }
+
+        case AST_UNARY_OP:
+            if (node->data.unary.op == OP_NEGATE) {
+                result = ast_dag_unary_op(dag, OP_NEGATE,
+                                          dag_differentiate(dag, node->data.unary.operand, var));
+            }
+            break;
+
+        case AST_FUNCTION_CALL: {
+            if (node->data.function.arg_count != 1) break;  /* Not implemented */
+            ASTNode *arg = node->data.function.args[0];
+            ASTNode *darg = dag_differentiate(dag, arg, var);
+            if (darg == zero) break;
+
+            /* Chain rule: f'(g) * g' */
+            switch (node->data.function.id) {
+                case FUNC_SIN:
+                    result = ast_dag_binary_op(dag, OP_MULTIPLY,
+                        ast_dag_function_call(dag, "COS", &arg, 1), darg);
+                    break;
+                case FUNC_COS:
+                    result = ast_dag_binary_op(dag, OP_MULTIPLY,
+                        ast_dag_unary_op(dag, OP_NEGATE, ast_dag_function_call(dag, "SIN", &arg, 1)), darg);
+                    break;
+                case FUNC_TAN:
+                    result = ast_dag_binary_op(dag, OP_MULTIPLY,
+                        ast_dag_binary_op(dag, OP_DIVIDE, ast_dag_number(dag, 1.0),
+                            ast_dag_binary_op(dag, OP_POWER,
+                                ast_dag_function_call(dag, "COS", &arg, 1), ast_dag_number(dag, 2.0))),
+                        darg);
+                    break;
+                case FUNC_LOG:
+                    result = ast_dag_binary_op(dag, OP_DIVIDE, darg, arg);
+                    break;
+                case FUNC_EXP:
+                    result = ast_dag_binary_op(dag, OP_MULTIPLY, node, darg);
+                    break;
+                case FUNC_SQRT:
+                    result = ast_dag_binary_op(dag, OP_DIVIDE, darg,
+                        ast_dag_binary_op(dag, OP_MULTIPLY, ast_dag_number(dag, 2.0), node));
+                    break;
+                default:
+                    break;  /* Unknown function - derivative is 0 */
+            }
+            break;
+        }
+
+        default:
+            break;  /* Numbers and tensors are constant */
+    }
+
+    return dag_memo_put(dag, node, var, result);
+}
+
+ASTNode* ast_dag_differentiate(ASTDag *dag, const ASTNode *node, const char *var_name) {
+    if (!dag || !var_name) return NULL;
+    return dag_differentiate(dag, dag_import(dag, node), ast_intern(var_name));
+}
+
+/* Evaluate DAG nodes with one compiled program. ast_evaluate() would walk
+ * every path through shared nodes; the program computes each node once,
+ * even when several outputs share it. Results are NaN if it fails to compile. */
+static void dag_evaluate_all(ASTNode *const *nodes, int count, VarContext *vars, double *results) {
+    Bytecode *bc = ast_compile_outputs((const ASTNode *const *)nodes, count);
+    VM *vm = bc ? vm_create(vars) : NULL;
+    if (vm) {
+        bytecode_bind(bc, vars);
+        vm_execute_stack(vm, bc);
+    }
+    for (int i = 0; i < count; i++) {
+        results[i] = vm && vm->stack_pointer == count ? vm->stack[i] : NAN;
+    }
+    vm_free(vm);
+    bytecode_free(bc);
+}
+
+/* ============================================================================
+ * PARTIAL DERIVATIVES & GRADIENT
+ * ============================================================================ */
+
+/* Compute partial derivative ∂f/∂var
+ * This is just an alias for ast_differentiate for clarity in multi-variable contexts
+ */
+ASTNode* ast_partial_derivative(const ASTNode *node, const char *var_name) {
+    return ast_differentiate(node, var_name);
+}
+
+/* Compiled components: every program reads slot i as symbols[i] */
+struct GradientCode {
+    Bytecode **bytecode;
+    const char **symbols;       /* Interned names of the variables read */
+    int symbol_count;
+};
+
+static void gradient_code_free(GradientCode *code, int count) {
+    if (!code) return;
+    for (int i = 0; code->bytecode && i < count; i++) {
+        bytecode_free(code->bytecode[i]);
+    }
+    free(code->bytecode);
+    free(code->symbols);
+    free(code);
+}
+
+/* Compile each component, keeping the DAG's sharing, and bind all of them
+ * to one slot layout so gradient_evaluate() looks each variable up once */
+static GradientCode* gradient_compile(const Gradient *grad) {
+    GradientCode *code = calloc(1, sizeof(GradientCode));
+    if (!code) return NULL;
+    code->bytecode = calloc(grad->count, sizeof(Bytecode *));
+    if (!code->bytecode) goto fail;
+
+    int capacity = 0;
+    for (int i = 0; i < grad->count; i++) {
+        Bytecode *bc = code->bytecode[i] = ast_compile(grad->components[i]);
+        if (!bc) goto fail;
+        for (int s = 0; s < bc->var_count; s++) {
+            const char *name = ast_intern(bc->var_names[s]);
+            int k = 0;
+            while (k < code->symbol_count && code->symbols[k] != name) k++;
+            if (k < code->symbol_count) continue;
+            if (code->symbol_count == capacity) {
+                capacity = capacity ? capacity * 2 : 8;
+                const char **grown = realloc(code->symbols, sizeof(char *) * capacity);
+                if (!grown) goto fail;
+                code->symbols = grown;
+            }
+            code->symbols[code->symbol_count++] = name;
+        }
+    }
+
+    VarMapping *mappings = malloc(sizeof(VarMapping) * (code->symbol_count > 0 ? code->symbol_count : 1));
+    if (!mappings) goto fail;
+    for (int k = 0; k < code->symbol_count; k++) {
+        mappings[k].name = code->symbols[k];
+        mappings[k].index = k;
+    }
+    VarContext layout = {.values = NULL, .count = code->symbol_count,
+                         .mappings = mappings, .mapping_count = code->symbol_count};
+    for (int i = 0; i < grad->count; i++) {
+        bytecode_bind(code->bytecode[i], &layout);
+    }
+    free(mappings);
+    return code;
+
+fail:
+    gradient_code_free(code, grad->count);
+    return NULL;
+}
+
+/* Compute gradient vector ∇f = [∂f/∂x₁, ∂f/∂x₂, ..., ∂f/∂xₙ]
+ * All partials come from one DAG: f is shared between them and each
+ * derivative of a subexpression is computed once.
+ */
+Gradient ast_gradient(const ASTNode *node, const char **var_names, int var_count) {
+    Gradient grad;
+    grad.components = NULL;
+    grad.count = 0;
+    grad.var_names = NULL;
+    grad.dag = NULL;
+    grad.code = NULL;
+
+    if (!node || !var_names || var_count <= 0) {
+        return grad;
+    }
+
+    grad.dag = ast_dag_create();
+    if (!grad.dag) return grad;
+    ASTNode *f = ast_dag_simplify(grad.dag, node);
+
+    /* Allocate arrays */
+    grad.components = malloc(sizeof(ASTNode*) * var_count);
+    grad.var_names = malloc(sizeof(char*) * var_count);
+    grad.count = var_count;
+
+    /* Compute partial derivative for each variable */
+    for (int i = 0; i < var_count; i++) {
+        grad.components[i] = ast_dag_differentiate(grad.dag, f, var_names[i]);
+
+        /* Copy variable name */
+        grad.var_names[i] = malloc(strlen(var_names[i]) + 1);
+        strcpy(grad.var_names[i], var_names[i]);
+    }
+
+    grad.code = gradient_compile(&grad);
+    return grad;
+}
+
+/* Free gradient structure */
+void gradient_free(Gradient *grad) {
+    if (!grad) return;
+
+    gradient_code_free(grad->code, grad->count);
+
+    if (grad->components) {
+        for (int i = 0; i < grad->count; i++) {
+            ast_free(grad->components[i]);
+        }
+        free(grad->components);
+    }
+
+    if (grad->var_names) {
+        for (int i = 0; i < grad->count; i++) {
+            free(grad->var_names[i]);
+        }
+        free(grad->var_names);
+    }
+
+    ast_dag_destroy(grad->dag);
+
+    grad->components = NULL;
+    grad->var_names = NULL;
+    grad->dag = NULL;
+    grad->code = NULL;
+    grad->count = 0;
+}
+
+/* Evaluate gradient at a point */
+double* gradient_evaluate(const Gradient *grad, VarContext *vars) {
+    if (!grad || grad->count <= 0) return NULL;
+
+    double *result = malloc(sizeof(double) * grad->count);
+    const GradientCode *code = grad->code;
+
+    if (!code) {
+        for (int i = 0; i < grad->count; i++) {
+            result[i] = ast_evaluate(grad->components[i], vars);
+        }
+        return result;
+    }
+
+    /* Gather the variables once, in the programs' slot order */
+    double local[16];
+    double *values = code->symbol_count <= 16 ? local : malloc(sizeof(double) * code->symbol_count);
+    if (!values) {
+        free(result);
+        return NULL;
+    }
+    for (int k = 0; k < code->symbol_count; k++) {
+        values[k] = lookup_var(code->symbols[k], vars);
+    }
+    VarContext slots = {.values = values, .count = code->symbol_count};
+
+    for (int i = 0; i < grad->count; i++) {
+        result[i] = bytecode_run(code->bytecode[i], &slots);
+    }
+
+    if (values != local) free(values);
+    return result;
+}
+
+/* ============================================================================
+ * TAYLOR SERIES EXPANSION
  * ============================================================================ */
 
 /* Helper: Compute factorial */
@@ -764,9 +1894,26 @@ ASTNode* ast_taylor_series(
 ) {
     if (!expr || order < 0) return NULL;
 
-    /* Build the Taylor series term by term */
-    ASTNode *series = NULL;
-    ASTNode *current_derivative = ast_clone(expr);
+    /* Successive derivatives share most of their nodes: build them in a DAG */
+    ASTDag *dag = ast_dag_create();
+    if (!dag) return NULL;
+
+    /* f, f', ..., f⁽ⁿ⁾, stopping early if differentiation fails */
+    ASTNode **derivatives = malloc(sizeof(ASTNode *) * (order + 1));
+    double *at_center = malloc(sizeof(double) * (order + 1));
+    if (!derivatives || !at_center) {
+        free(derivatives);
+        free(at_center);
+        ast_dag_destroy(dag);
+        return NULL;
+    }
+    int count = 0;
+    derivatives[count] = ast_dag_simplify(dag, expr);
+    while (derivatives[count] && count < order) {
+        derivatives[count + 1] = ast_dag_differentiate(dag, derivatives[count], var_name);
+        count++;
+    }
+    if (derivatives[count]) count++;
 
     /* Variable mapping for evaluating derivatives at center */
     VarMapping mapping = {.name = var_name, .index = 0};
@@ -791,9 +1938,13 @@ ASTNode* ast_taylor_series(
         );
     }
 
-    for (int n = 0; n <= order; n++) {
-        /* Evaluate nth derivative at center point */
-        double deriv_at_center = ast_evaluate(current_derivative, &ctx);
+    /* One program evaluates every derivative */
+    dag_evaluate_all(derivatives, count, &ctx, at_center);
+
+    /* Build the Taylor series term by term */
+    ASTNode *series = NULL;
+    for (int n = 0; n < count; n++) {
+        double deriv_at_center = at_center[n];
 
         /* Check for NaN or inf - can happen with unsimplified expressions containing x^(-1) at x=0 */
         if (isnan(deriv_at_center) || isinf(deriv_at_center)) {
@@ -845,30 +1996,19 @@ ASTNode* ast_taylor_series(
             }
         }
 
-        /* Compute next derivative for next iteration */
-        if (n < order) {
-            ASTNode *next_derivative = ast_differentiate(current_derivative, var_name);
-            ast_free(current_derivative);
-            current_derivative = next_derivative;
-
-            /* If differentiation failed, stop here */
-            if (!current_derivative) {
-                break;
-            }
-        }
     }
 
     /* Clean up */
-    if (current_derivative) {
-        ast_free(current_derivative);
-    }
+    free(derivatives);
+    free(at_center);
+    ast_dag_destroy(dag);
     if (x_minus_c) {
         ast_free(x_minus_c);
     }
 
     /* If series is NULL (all terms were zero), return 0 */
     if (series == NULL) {
-        return ast_create_number(0.0);
+        series = ast_create_number(0.0);
     }
 
     /* Return the unsimplified series
@@ -888,6 +2028,7 @@ OptimizerConfig optimizer_config_default(OptimizerType type) {
     config.tolerance = 1e-6;
     config.max_iterations = 1000;
     config.verbose = false;
+    config.symbolic_gradient = false;
 
     switch (type) {
         case OPTIMIZER_GRADIENT_DESCENT:
@@ -989,9 +2130,48 @@ double line_search_backtracking(
     return alpha;  /* Return smallest tried value */
 }
 
-/* Gradient Descent optimizer */
-static OptimizationResult optimize_gradient_descent(
-    const ASTNode *expr,
+/* Gradient of the objective: reverse-mode AD over the compiled expression,
+ * or the symbolic ast_gradient() components when the config asks for them
+ * (or the expression does not compile).
+ */
+typedef struct {
+    GradientProgram *program;
+    Gradient symbolic;
+    int var_count;
+} ObjectiveGradient;
+
+static ObjectiveGradient objective_gradient_create(const ASTNode *expr, const char **var_names,
+                                                   int var_count, const OptimizerConfig *config) {
+    ObjectiveGradient g = {.program = NULL, .var_count = var_count};
+    if (!config->symbolic_gradient) {
+        g.program = gradient_program_create(expr, var_names, var_count);
+    }
+    if (!g.program) {
+        g.symbolic = ast_gradient(expr, var_names, var_count);
+    }
+    return g;
+}
+
+/* Gradient at ctx->values; caller frees, as with gradient_evaluate() */
+static double* objective_gradient_evaluate(const ObjectiveGradient *g, VarContext *ctx) {
+    if (!g->program) return gradient_evaluate(&g->symbolic, ctx);
+    double *values = malloc(sizeof(double) * (g->var_count > 0 ? g->var_count : 1));
+    if (values) gradient_program_evaluate(g->program, ctx->values, values);
+    return values;
+}
+
+static void objective_gradient_free(ObjectiveGradient *g) {
+    if (g->program) {
+        gradient_program_free(g->program);
+        g->program = NULL;
+    } else {
+        gradient_free(&g->symbolic);
+    }
+}
+
+/* Gradient Descent optimizer */
+static OptimizationResult optimize_gradient_descent(
+    const ASTNode *expr,
     const char **var_names,
     int var_count,
     const double *initial_guess,
@@ -1011,7 +2191,7 @@ static OptimizationResult optimize_gradient_descent(
     }
 
     /* Compute gradient */
-    Gradient grad = ast_gradient(expr, var_names, var_count);
+    ObjectiveGradient grad = objective_gradient_create(expr, var_names, var_count, config);
 
     /* Setup variable context */
     VarMapping *mappings = malloc(sizeof(VarMapping) * var_count);
@@ -1030,7 +2210,7 @@ static OptimizationResult optimize_gradient_descent(
     /* Optimization loop */
     for (int iter = 0; iter < config->max_iterations; iter++) {
         /* Evaluate gradient at current position */
-        double *grad_values = gradient_evaluate(&grad, &ctx);
+        double *grad_values = objective_gradient_evaluate(&grad, &ctx);
 
         /* Compute gradient norm */
         double grad_norm = 0.0;
@@ -1066,7 +2246,7 @@ static OptimizationResult optimize_gradient_descent(
     result.final_value = ast_evaluate(expr, &ctx);
 
     /* Cleanup */
-    gradient_free(&grad);
+    objective_gradient_free(&grad);
     free(mappings);
 
     if (!result.converged && result.iterations >= config->max_iterations) {
@@ -1101,7 +2281,7 @@ static OptimizationResult optimize_gradient_descent_momentum(
     double *velocity = calloc(var_count, sizeof(double));  /* Initialize to zero */
 
     /* Compute gradient */
-    Gradient grad = ast_gradient(expr, var_names, var_count);
+    ObjectiveGradient grad = objective_gradient_create(expr, var_names, var_count, config);
 
     /* Setup variable context */
     VarMapping *mappings = malloc(sizeof(VarMapping) * var_count);
@@ -1120,7 +2300,7 @@ static OptimizationResult optimize_gradient_descent_momentum(
     /* Optimization loop */
     for (int iter = 0; iter < config->max_iterations; iter++) {
         /* Evaluate gradient at current position */
-        double *grad_values = gradient_evaluate(&grad, &ctx);
+        double *grad_values = objective_gradient_evaluate(&grad, &ctx);
 
         /* Compute gradient norm */
         double grad_norm = 0.0;
@@ -1159,7 +2339,7 @@ static OptimizationResult optimize_gradient_descent_momentum(
 
     /* Cleanup */
     free(velocity);
-    gradient_free(&grad);
+    objective_gradient_free(&grad);
     free(mappings);
 
     if (!result.converged && result.iterations >= config->max_iterations) {
@@ -1196,7 +2376,7 @@ static OptimizationResult optimize_adam(
     double *v = calloc(var_count, sizeof(double));  /* Second moment */
 
     /* Compute gradient */
-    Gradient grad = ast_gradient(expr, var_names, var_count);
+    ObjectiveGradient grad = objective_gradient_create(expr, var_names, var_count, config);
 
     /* Setup variable context */
     VarMapping *mappings = malloc(sizeof(VarMapping) * var_count);
@@ -1217,7 +2397,7 @@ static OptimizationResult optimize_adam(
         int t = iter + 1;  /* Time step (starts at 1) */
 
         /* Evaluate gradient at current position */
-        double *grad_values = gradient_evaluate(&grad, &ctx);
+        double *grad_values = objective_gradient_evaluate(&grad, &ctx);
 
         /* Compute gradient norm */
         double grad_norm = 0.0;
@@ -1268,7 +2448,7 @@ static OptimizationResult optimize_adam(
     /* Cleanup */
     free(m);
     free(v);
-    gradient_free(&grad);
+    objective_gradient_free(&grad);
     free(mappings);
 
     if (!result.converged && result.iterations >= config->max_iterations) {
@@ -1304,7 +2484,7 @@ static OptimizationResult optimize_conjugate_gradient(
     double *grad_old = calloc(var_count, sizeof(double));
 
     /* Compute gradient */
-    Gradient grad = ast_gradient(expr, var_names, var_count);
+    ObjectiveGradient grad = objective_gradient_create(expr, var_names, var_count, config);
 
     /* Setup variable context */
     VarMapping *mappings = malloc(sizeof(VarMapping) * var_count);
@@ -1325,7 +2505,7 @@ static OptimizationResult optimize_conjugate_gradient(
     /* Optimization loop */
     for (int iter = 0; iter < config->max_iterations; iter++) {
         /* Evaluate gradient at current position */
-        double *grad_values = gradient_evaluate(&grad, &ctx);
+        double *grad_values = objective_gradient_evaluate(&grad, &ctx);
 
         /* Compute gradient norm */
         double grad_norm = 0.0;
@@ -1394,7 +2574,7 @@ static OptimizationResult optimize_conjugate_gradient(
     /* Cleanup */
     free(direction);
     free(grad_old);
-    gradient_free(&grad);
+    objective_gradient_free(&grad);
     free(mappings);
 
     if (!result.converged && result.iterations >= config->max_iterations) {
@@ -1496,7 +2676,7 @@ static bool ast_nodes_equal(const ASTNode *a, const ASTNode *b) {
             return fabs(a->data.number.value - b->data.number.value) < 1e-12;
 
         case AST_VARIABLE:
-            return strcmp(a->data.variable.name, b->data.variable.name) == 0;
+            return a->data.variable.name == b->data.variable.name;  /* Interned */
 
         case AST_BINARY_OP:
             return a->data.binary.op == b->data.binary.op &&
@@ -1508,7 +2688,7 @@ static bool ast_nodes_equal(const ASTNode *a, const ASTNode *b) {
                    ast_nodes_equal(a->data.unary.operand, b->data.unary.operand);
 
         case AST_FUNCTION_CALL:
-            if (strcmp(a->data.function.name, b->data.function.name) != 0 ||
+            if (a->data.function.name != b->data.function.name ||
                 a->data.function.arg_count != b->data.function.arg_count) {
                 return false;
             }
@@ -1643,22 +2823,22 @@ ASTNode* ast_simplify(ASTNode *node) {
                 /* x + 0 = x */
                 if (right->type == AST_NUMBER && right->data.number.value == 0.0) {
                     ASTNode *result = left;
-                    free(right);
-                    free(node);
+                    ast_free_node(right);
+                    ast_free_node(node);
                     return result;
                 }
                 /* 0 + x = x */
                 if (left->type == AST_NUMBER && left->data.number.value == 0.0) {
                     ASTNode *result = right;
-                    free(left);
-                    free(node);
+                    ast_free_node(left);
+                    ast_free_node(node);
                     return result;
                 }
                 /* Try to combine like terms: x + x = 2*x, 3*x + 2*x = 5*x */
                 {
                     ASTNode *combined = try_combine_like_terms(left, right);
                     if (combined) {
-                        free(node);
+                        ast_free_node(node);
                         return combined;
                     }
                 }
@@ -1668,8 +2848,8 @@ ASTNode* ast_simplify(ASTNode *node) {
                 /* x - 0 = x */
                 if (right->type == AST_NUMBER && right->data.number.value == 0.0) {
                     ASTNode *result = left;
-                    free(right);
-                    free(node);
+                    ast_free_node(right);
+                    ast_free_node(node);
                     return result;
                 }
                 break;
@@ -1684,15 +2864,15 @@ ASTNode* ast_simplify(ASTNode *node) {
                 /* x * 1 = x */
                 if (right->type == AST_NUMBER && right->data.number.value == 1.0) {
                     ASTNode *result = left;
-                    free(right);
-                    free(node);
+                    ast_free_node(right);
+                    ast_free_node(node);
                     return result;
                 }
                 /* 1 * x = x */
                 if (left->type == AST_NUMBER && left->data.number.value == 1.0) {
                     ASTNode *result = right;
-                    free(left);
-                    free(node);
+                    ast_free_node(left);
+                    ast_free_node(node);
                     return result;
                 }
                 break;
@@ -1706,8 +2886,8 @@ ASTNode* ast_simplify(ASTNode *node) {
                 /* x / 1 = x */
                 if (right->type == AST_NUMBER && right->data.number.value == 1.0) {
                     ASTNode *result = left;
-                    free(right);
-                    free(node);
+                    ast_free_node(right);
+                    ast_free_node(node);
                     return result;
                 }
                 break;
@@ -1721,8 +2901,8 @@ ASTNode* ast_simplify(ASTNode *node) {
                 /* x^1 = x */
                 if (right->type == AST_NUMBER && right->data.number.value == 1.0) {
                     ASTNode *result = left;
-                    free(right);
-                    free(node);
+                    ast_free_node(right);
+                    ast_free_node(node);
                     return result;
                 }
                 /* 0^x = 0 (for x != 0) */
@@ -1759,8 +2939,8 @@ ASTNode* ast_simplify(ASTNode *node) {
             operand->type == AST_UNARY_OP &&
             operand->data.unary.op == OP_NEGATE) {
             ASTNode *result = operand->data.unary.operand;
-            free(operand);
-            free(node);
+            ast_free_node(operand);
+            ast_free_node(node);
             return result;
         }
     }
@@ -2166,7 +3346,104 @@ ASTNode* ast_integrate(const ASTNode *node, const char *var_name) {
 
 /* ============================================================================
  * NUMERICAL INTEGRATION
- * ============================================================================ */
+ * ============================================================================
+ * The integrand is compiled once with the integration variables in slots
+ * 0..dims-1, and sample points are evaluated in columns through
+ * vm_execute_batch(). Large sample sets are cut into fixed chunks that run
+ * on the shared thread pool; chunk results are combined in chunk order, so
+ * the answer does not depend on the number of threads.
+ */
+
+/* Points per chunk of work handed to a thread */
+#define INTEGRATE_CHUNK (8 * VM_BATCH_BLOCK)
+
+typedef struct {
+    const ASTNode *expr;
+    Bytecode *bc;           /* NULL if the integrand did not compile */
+    VarMapping mappings[INTEGRATE_MAX_DIMS];
+    int dims;
+} Integrand;
+
+static void integrand_init(Integrand *f, const ASTNode *expr, const char *const *var_names, int dims) {
+    f->expr = expr;
+    f->dims = dims;
+    for (int d = 0; d < dims; d++) {
+        f->mappings[d].name = var_names[d];
+        f->mappings[d].index = d;
+    }
+    f->bc = ast_compile(expr);
+    if (f->bc) {
+        VarContext layout = {.values = NULL, .count = dims, .mappings = f->mappings, .mapping_count = dims};
+        bytecode_bind(f->bc, &layout);
+    }
+}
+
+/* y[i] = f(columns[0][i], ..., columns[dims-1][i]) for n points */
+static void integrand_eval(const Integrand *f, const double *const *columns, double *y, size_t n) {
+    if (f->bc && vm_execute_batch(f->bc, columns, f->dims, n, y) == 0) return;
+
+    double values[INTEGRATE_MAX_DIMS];
+    VarMapping mappings[INTEGRATE_MAX_DIMS];
+    memcpy(mappings, f->mappings, sizeof(VarMapping) * f->dims);
+    VarContext ctx = {.values = values, .count = f->dims, .mappings = mappings, .mapping_count = f->dims};
+    for (size_t i = 0; i < n; i++) {
+        for (int d = 0; d < f->dims; d++) values[d] = columns[d][i];
+        y[i] = ast_evaluate(f->expr, &ctx);
+    }
+}
+
+/* Newton-Cotes sums: sum of w(i) * f(a + i*h) for i in [0, steps] */
+typedef struct {
+    const Integrand *f;
+    double a, b, h;         /* The last sample is exactly b */
+    int steps;
+    bool simpson;           /* Weights 1 4 2 4 ... 4 1, else 1 2 2 ... 2 1 */
+    double *partial;        /* One sum per chunk */
+} NewtonCotesJob;
+
+static void newton_cotes_chunk(void *arg, size_t chunk) {
+    const NewtonCotesJob *job = arg;
+    double x[INTEGRATE_CHUNK], y[INTEGRATE_CHUNK];
+    int first = (int)(chunk * INTEGRATE_CHUNK);
+    int n = job->steps + 1 - first < INTEGRATE_CHUNK ? job->steps + 1 - first : INTEGRATE_CHUNK;
+    if (n <= 0) {
+        job->partial[chunk] = 0.0;
+        return;
+    }
+
+    for (int k = 0; k < n; k++) {
+        int i = first + k;
+        x[k] = (i == job->steps) ? job->b : job->a + i * job->h;
+    }
+    const double *column = x;
+    integrand_eval(job->f, &column, y, n);
+
+    double sum = 0.0;
+    for (int k = 0; k < n; k++) {
+        int i = first + k;
+        double w = (i == 0 || i == job->steps) ? 1.0 : job->simpson ? ((i % 2 == 0) ? 2.0 : 4.0) : 2.0;
+        sum += w * y[k];
+    }
+    job->partial[chunk] = sum;
+}
+
+static double newton_cotes_sum(const ASTNode *expr, const char *var_name, double a, double b,
+                               int steps, bool simpson) {
+    Integrand f;
+    integrand_init(&f, expr, &var_name, 1);
+
+    size_t chunks = ((size_t)steps + 1 + INTEGRATE_CHUNK - 1) / INTEGRATE_CHUNK;
+    NewtonCotesJob job = {.f = &f, .a = a, .b = b, .h = (b - a) / steps, .steps = steps, .simpson = simpson,
+                          .partial = malloc(sizeof(double) * chunks)};
+    double sum = 0.0;
+    if (job.partial) {
+        thread_pool_for(chunks > 1 ? thread_pool_shared() : NULL, chunks, newton_cotes_chunk, &job);
+        for (size_t c = 0; c < chunks; c++) sum += job.partial[c];
+        free(job.partial);
+    }
+    bytecode_free(f.bc);
+    return sum;
+}
 
 /* Trapezoidal rule for numerical integration
  * Approximates ∫[a,b] f(x)dx using trapezoids
@@ -2182,35 +3459,9 @@ double ast_integrate_numerical_trapezoidal(
     if (!expr || steps <= 0) return 0.0;
 
     double h = (b - a) / steps;  /* Step size */
-    double sum = 0.0;
-
-    /* Variable mapping for evaluation */
-    VarMapping mapping = {.name = var_name, .index = 0};
-    double x_val;
-    VarContext ctx = {
-        .values = &x_val,
-        .count = 1,
-        .mappings = &mapping,
-        .mapping_count = 1
-    };
 
     /* Trapezoidal rule: (h/2) * [f(a) + 2*f(x₁) + 2*f(x₂) + ... + 2*f(xₙ₋₁) + f(b)] */
-
-    /* First point f(a) */
-    x_val = a;
-    sum += ast_evaluate(expr, &ctx);
-
-    /* Middle points: 2*f(xᵢ) for i=1 to n-1 */
-    for (int i = 1; i < steps; i++) {
-        x_val = a + i * h;
-        sum += 2.0 * ast_evaluate(expr, &ctx);
-    }
-
-    /* Last point f(b) */
-    x_val = b;
-    sum += ast_evaluate(expr, &ctx);
-
-    return (h / 2.0) * sum;
+    return (h / 2.0) * newton_cotes_sum(expr, var_name, a, b, steps, false);
 }
 
 /* Simpson's rule for numerical integration
@@ -2233,36 +3484,204 @@ double ast_integrate_numerical_simpson(
     }
 
     double h = (b - a) / steps;  /* Step size */
-    double sum = 0.0;
-
-    /* Variable mapping for evaluation */
-    VarMapping mapping = {.name = var_name, .index = 0};
-    double x_val;
-    VarContext ctx = {
-        .values = &x_val,
-        .count = 1,
-        .mappings = &mapping,
-        .mapping_count = 1
-    };
 
     /* Simpson's rule: (h/3) * [f(a) + 4*f(x₁) + 2*f(x₂) + 4*f(x₃) + ... + f(b)] */
+    return (h / 3.0) * newton_cotes_sum(expr, var_name, a, b, steps, true);
+}
+
+/* Gauss-Kronrod 7/15 rule on [-1, 1] (QUADPACK qk15): Kronrod nodes
+ * xgk[0..7] (odd entries are the Gauss nodes, xgk[7] = 0) with weights wgk,
+ * and the 7-point Gauss weights wg for xgk[1], xgk[3], xgk[5], xgk[7].
+ */
+static const double gk15_xgk[8] = {
+    0.991455371120812639206854697526329, 0.949107912342758524526189684047851,
+    0.864864423359769072789712788640926, 0.741531185599394439863864773280788,
+    0.586087235467691130294144845693013, 0.405845151377397166906606412076961,
+    0.207784955007898467600689403773245, 0.000000000000000000000000000000000,
+};
+static const double gk15_wgk[8] = {
+    0.022935322010529224963732008058970, 0.063092092629978553290700663189204,
+    0.104790010322250183839876322541518, 0.140653259715525918745189590510238,
+    0.169004726639267902826583426598550, 0.190350578064785409913256402421014,
+    0.204432940075298892414161999234649, 0.209482141084727828012999174891714,
+};
+static const double gk15_wg[4] = {
+    0.129484966168869693270611432679082, 0.279705391489276667901467771423780,
+    0.381830050505118944950369775488975, 0.417959183673469387755102040816327,
+};
+
+#define GK15_POINTS 15
+
+typedef struct {
+    double a, b;
+    double value;
+    double error;
+} GKInterval;
+
+/* Sample points of interval iv, in the order gk15_apply() expects */
+static void gk15_points(const GKInterval *iv, double *x) {
+    double center = 0.5 * (iv->a + iv->b);
+    double half = 0.5 * (iv->b - iv->a);
+    x[0] = center;
+    for (int j = 0; j < 7; j++) {
+        x[1 + 2 * j] = center - half * gk15_xgk[j];
+        x[2 + 2 * j] = center + half * gk15_xgk[j];
+    }
+}
+
+/* Kronrod value and QUADPACK's error estimate from the 15 samples y */
+static void gk15_apply(GKInterval *iv, const double *y) {
+    double half = 0.5 * (iv->b - iv->a);
+    double abs_half = fabs(half);
+    double fc = y[0];
+    double resk = fc * gk15_wgk[7];
+    double resg = fc * gk15_wg[3];
+    double resabs = fabs(resk);
+
+    for (int j = 0; j < 7; j++) {
+        double f1 = y[1 + 2 * j], f2 = y[2 + 2 * j];
+        resk += gk15_wgk[j] * (f1 + f2);
+        resabs += gk15_wgk[j] * (fabs(f1) + fabs(f2));
+        if (j % 2 == 1) resg += gk15_wg[j / 2] * (f1 + f2);
+    }
+
+    double mean = resk * 0.5;
+    double resasc = gk15_wgk[7] * fabs(fc - mean);
+    for (int j = 0; j < 7; j++) {
+        resasc += gk15_wgk[j] * (fabs(y[1 + 2 * j] - mean) + fabs(y[2 + 2 * j] - mean));
+    }
+
+    double error = fabs((resk - resg) * half);
+    resasc *= abs_half;
+    resabs *= abs_half;
+    if (resasc != 0.0 && error != 0.0) {
+        error = resasc * fmin(1.0, pow(200.0 * error / resasc, 1.5));
+    }
+    if (resabs > DBL_MIN / (50.0 * DBL_EPSILON)) {
+        error = fmax(50.0 * DBL_EPSILON * resabs, error);
+    }
+
+    iv->value = resk * half;
+    iv->error = error;
+}
+
+/* Evaluate the rule on a block of intervals, one chunk per thread */
+typedef struct {
+    const Integrand *f;
+    GKInterval *intervals;
+    size_t count;
+} GKJob;
+
+#define GK_CHUNK_INTERVALS (INTEGRATE_CHUNK / GK15_POINTS)
+
+static void gk15_chunk(void *arg, size_t chunk) {
+    const GKJob *job = arg;
+    double x[GK_CHUNK_INTERVALS * GK15_POINTS], y[GK_CHUNK_INTERVALS * GK15_POINTS];
+    size_t first = chunk * GK_CHUNK_INTERVALS;
+    size_t n = job->count - first < GK_CHUNK_INTERVALS ? job->count - first : GK_CHUNK_INTERVALS;
+    if (n == 0) return;
+
+    for (size_t i = 0; i < n; i++) gk15_points(&job->intervals[first + i], x + i * GK15_POINTS);
+    const double *column = x;
+    integrand_eval(job->f, &column, y, n * GK15_POINTS);
+    for (size_t i = 0; i < n; i++) gk15_apply(&job->intervals[first + i], y + i * GK15_POINTS);
+}
+
+static void gk15_evaluate(const Integrand *f, GKInterval *intervals, size_t count) {
+    GKJob job = {.f = f, .intervals = intervals, .count = count};
+    size_t chunks = (count + GK_CHUNK_INTERVALS - 1) / GK_CHUNK_INTERVALS;
+    thread_pool_for(chunks > 1 ? thread_pool_shared() : NULL, chunks, gk15_chunk, &job);
+}
+
+/* Largest error first; ties by position so the order is reproducible */
+static int gk_by_error(const void *p, const void *q) {
+    const GKInterval *x = p, *y = q;
+    if (x->error != y->error) return x->error < y->error ? 1 : -1;
+    return (x->a > y->a) - (x->a < y->a);
+}
+
+static int gk_by_position(const void *p, const void *q) {
+    const GKInterval *x = p, *y = q;
+    return (x->a > y->a) - (x->a < y->a);
+}
 
-    /* First point f(a) */
-    x_val = a;
-    sum += ast_evaluate(expr, &ctx);
+IntegrationResult ast_integrate_adaptive(const ASTNode *expr, const char *var_name, double a, double b,
+                                         double abs_tol, double rel_tol, int max_intervals) {
+    IntegrationResult result = {0.0, 0.0, 0, 0, false};
+    if (!expr || !var_name || a == b) {
+        result.converged = expr && var_name;
+        return result;
+    }
+    if (max_intervals <= 0) max_intervals = 1000;
+
+    GKInterval *intervals = malloc(sizeof(GKInterval) * max_intervals);
+    GKInterval *halves = malloc(sizeof(GKInterval) * max_intervals);
+    if (!intervals || !halves) {
+        free(intervals);
+        free(halves);
+        return result;
+    }
+
+    Integrand f;
+    integrand_init(&f, expr, &var_name, 1);
+
+    intervals[0].a = a;
+    intervals[0].b = b;
+    gk15_evaluate(&f, intervals, 1);
+    size_t count = 1;
+    result.evaluations = GK15_POINTS;
+
+    /* Each round bisects the worst intervals that together hold at least
+     * half the estimated error, and evaluates all the halves as one batch.
+     */
+    for (;;) {
+        double value = 0.0, error = 0.0;
+        for (size_t i = 0; i < count; i++) {
+            value += intervals[i].value;
+            error += intervals[i].error;
+        }
+        result.value = value;
+        result.error_estimate = error;
+        double tolerance = fmax(abs_tol, rel_tol * fabs(value));
+        result.converged = error <= tolerance;
+        if (result.converged || !isfinite(error) || count >= (size_t)max_intervals) break;
+
+        qsort(intervals, count, sizeof(GKInterval), gk_by_error);
+        size_t split = 0;
+        double covered = 0.0;
+        while (split < count && split + count < (size_t)max_intervals &&
+               (split == 0 || covered < 0.5 * (error - tolerance))) {
+            covered += intervals[split].error;
+            split++;
+        }
 
-    /* Middle points with alternating coefficients */
-    for (int i = 1; i < steps; i++) {
-        x_val = a + i * h;
-        double coeff = (i % 2 == 0) ? 2.0 : 4.0;  /* Even indices: 2, odd indices: 4 */
-        sum += coeff * ast_evaluate(expr, &ctx);
+        /* Left halves replace the originals, right halves are appended */
+        for (size_t i = 0; i < split; i++) {
+            double mid = 0.5 * (intervals[i].a + intervals[i].b);
+            halves[2 * i].a = intervals[i].a;
+            halves[2 * i].b = mid;
+            halves[2 * i + 1].a = mid;
+            halves[2 * i + 1].b = intervals[i].b;
+        }
+        gk15_evaluate(&f, halves, 2 * split);
+        for (size_t i = 0; i < split; i++) {
+            intervals[i] = halves[2 * i];
+            intervals[count + i] = halves[2 * i + 1];
+        }
+        count += split;
+        result.evaluations += 2 * (int)split * GK15_POINTS;
     }
 
-    /* Last point f(b) */
-    x_val = b;
-    sum += ast_evaluate(expr, &ctx);
+    /* Sum in order along the interval, for a reproducible total */
+    qsort(intervals, count, sizeof(GKInterval), gk_by_position);
+    result.value = 0.0;
+    for (size_t i = 0; i < count; i++) result.value += intervals[i].value;
+    result.intervals = (int)count;
 
-    return (h / 3.0) * sum;
+    bytecode_free(f.bc);
+    free(intervals);
+    free(halves);
+    return result;
 }
 
 /* General numerical integration with method selection */
@@ -2279,11 +3698,457 @@ double ast_integrate_numerical(
             return ast_integrate_numerical_trapezoidal(expr, var_name, a, b, steps);
         case INTEGRATE_SIMPSON:
             return ast_integrate_numerical_simpson(expr, var_name, a, b, steps);
+        case INTEGRATE_GAUSS_KRONROD:
+            return ast_integrate_adaptive(expr, var_name, a, b, 1e-10, 1e-10, steps).value;
         default:
             return 0.0;
     }
 }
 
+/* Multi-dimensional integration: adaptive Genz-Malik cubature and
+ * randomly shifted Sobol sequences. A region is a box given by its center
+ * and half-widths; points are laid out in columns, one per variable.
+ */
+typedef struct {
+    double center[INTEGRATE_MAX_DIMS];
+    double half[INTEGRATE_MAX_DIMS];
+    double value;
+    double error;
+    int axis;                   /* Where to bisect next */
+} CubatureRegion;
+
+/* Genz-Malik degree-7 rule (Genz & Malik 1980, weights as in HIntLib) */
+#define GM_LAMBDA2 0.358568582800318091990645153907    /* sqrt(9/70) */
+#define GM_LAMBDA4 0.948683298050513799599668063329    /* sqrt(9/10) */
+#define GM_LAMBDA5 0.688247201611685297721628734293    /* sqrt(9/19) */
+
+static size_t genz_malik_count(int dims) {
+    return 1 + 4 * (size_t)dims + 2 * (size_t)dims * (dims - 1) + ((size_t)1 << dims);
+}
+
+/* Write the rule's points for region r into columns[d][at...] */
+static void genz_malik_points(const CubatureRegion *r, int dims, double *const *columns, size_t at) {
+    size_t k = at;
+    for (int d = 0; d < dims; d++) columns[d][k] = r->center[d];
+    k++;
+
+    /* ±lambda2, then ±lambda4, on each axis */
+    static const double axis_lambda[2] = {GM_LAMBDA2, GM_LAMBDA4};
+    for (int l = 0; l < 2; l++) {
+        for (int i = 0; i < dims; i++) {
+            for (int s = -1; s <= 1; s += 2) {
+                for (int d = 0; d < dims; d++) columns[d][k] = r->center[d];
+                columns[i][k] += s * axis_lambda[l] * r->half[i];
+                k++;
+            }
+        }
+    }
+
+    /* ±lambda4 on every pair of axes */
+    for (int i = 0; i < dims; i++) {
+        for (int j = i + 1; j < dims; j++) {
+            for (int s = 0; s < 4; s++) {
+                for (int d = 0; d < dims; d++) columns[d][k] = r->center[d];
+                columns[i][k] += (s & 1 ? GM_LAMBDA4 : -GM_LAMBDA4) * r->half[i];
+                columns[j][k] += (s & 2 ? GM_LAMBDA4 : -GM_LAMBDA4) * r->half[j];
+                k++;
+            }
+        }
+    }
+
+    /* ±lambda5 on all axes: the 2^dims corners */
+    for (size_t corner = 0; corner < ((size_t)1 << dims); corner++) {
+        for (int d = 0; d < dims; d++) {
+            columns[d][k] = r->center[d] + ((corner >> d) & 1 ? GM_LAMBDA5 : -GM_LAMBDA5) * r->half[d];
+        }
+        k++;
+    }
+}
+
+/* Value, error and split axis from the samples y, in genz_malik_points() order */
+static void genz_malik_apply(CubatureRegion *r, int dims, const double *y) {
+    double n = dims;
+    double volume = 1.0;
+    for (int d = 0; d < dims; d++) volume *= 2.0 * r->half[d];
+
+    double f0 = y[0];
+    const double *axis2 = y + 1, *axis4 = y + 1 + 2 * dims, *pairs = y + 1 + 4 * dims;
+    size_t pair_count = 2 * (size_t)dims * (dims - 1);
+    size_t corner_count = (size_t)1 << dims;
+
+    double sum2 = 0.0, sum3 = 0.0, sum4 = 0.0, sum5 = 0.0;
+    double best_diff = -1.0;
+    r->axis = 0;
+    for (int i = 0; i < dims; i++) {
+        double s2 = axis2[2 * i] + axis2[2 * i + 1];
+        double s3 = axis4[2 * i] + axis4[2 * i + 1];
+        sum2 += s2;
+        sum3 += s3;
+
+        /* Fourth difference along axis i: where the integrand bends most */
+        double diff = fabs(s2 - 2.0 * f0 - (s3 - 2.0 * f0) / 7.0);
+        if (diff > best_diff * (1.0 + 1e-10) ||
+            (diff >= best_diff * (1.0 - 1e-10) && r->half[i] > r->half[r->axis])) {
+            best_diff = fmax(best_diff, diff);
+            r->axis = i;
+        }
+    }
+    for (size_t k = 0; k < pair_count; k++) sum4 += pairs[k];
+    for (size_t k = 0; k < corner_count; k++) sum5 += pairs[pair_count + k];
+
+    double degree7 = (12824.0 - 9120.0 * n + 400.0 * n * n) / 19683.0 * f0 + 980.0 / 6561.0 * sum2 +
+                     (1820.0 - 400.0 * n) / 19683.0 * sum3 + 200.0 / 19683.0 * sum4 +
+                     6859.0 / 19683.0 / corner_count * sum5;
+    double degree5 = (729.0 - 950.0 * n + 50.0 * n * n) / 729.0 * f0 + 245.0 / 486.0 * sum2 +
+                     (265.0 - 100.0 * n) / 1458.0 * sum3 + 25.0 / 729.0 * sum4;
+
+    r->value = volume * degree7;
+    r->error = fabs(volume * (degree7 - degree5));
+}
+
+/* Apply the rule to a block of regions, a chunk of whole regions per task */
+typedef struct {
+    const Integrand *f;
+    CubatureRegion *regions;
+    size_t count;
+    size_t per_chunk;
+} CubatureJob;
+
+static void cubature_chunk(void *arg, size_t chunk) {
+    const CubatureJob *job = arg;
+    int dims = job->f->dims;
+    size_t points = genz_malik_count(dims);
+    size_t first = chunk * job->per_chunk;
+    size_t n = job->count - first < job->per_chunk ? job->count - first : job->per_chunk;
+    if (n == 0) return;
+
+    double *buffer = malloc(sizeof(double) * n * points * (dims + 1));
+    if (!buffer) {
+        for (size_t i = 0; i < n; i++) job->regions[first + i].error = NAN;
+        return;
+    }
+    double *columns[INTEGRATE_MAX_DIMS];
+    for (int d = 0; d < dims; d++) columns[d] = buffer + d * n * points;
+    double *y = buffer + dims * n * points;
+
+    for (size_t i = 0; i < n; i++) genz_malik_points(&job->regions[first + i], dims, columns, i * points);
+    integrand_eval(job->f, (const double *const *)columns, y, n * points);
+    for (size_t i = 0; i < n; i++) genz_malik_apply(&job->regions[first + i], dims, y + i * points);
+    free(buffer);
+}
+
+static void cubature_evaluate(const Integrand *f, CubatureRegion *regions, size_t count) {
+    size_t points = genz_malik_count(f->dims);
+    CubatureJob job = {.f = f, .regions = regions, .count = count,
+                       .per_chunk = points < INTEGRATE_CHUNK ? INTEGRATE_CHUNK / points : 1};
+    size_t chunks = (count + job.per_chunk - 1) / job.per_chunk;
+    thread_pool_for(chunks > 1 ? thread_pool_shared() : NULL, chunks, cubature_chunk, &job);
+}
+
+/* Largest error first; ties by position so the order is reproducible */
+static int cubature_by_error(const void *p, const void *q) {
+    const CubatureRegion *x = p, *y = q;
+    if (x->error != y->error) return x->error < y->error ? 1 : -1;
+    for (int d = 0; d < INTEGRATE_MAX_DIMS; d++) {
+        if (x->center[d] != y->center[d]) return x->center[d] < y->center[d] ? -1 : 1;
+    }
+    return 0;
+}
+
+static IntegrationResult cubature_adaptive(const Integrand *f, const double *lower, const double *upper,
+                                           double abs_tol, double rel_tol, int max_evaluations) {
+    IntegrationResult result = {0.0, 0.0, 0, 0, false};
+    int points = (int)genz_malik_count(f->dims);
+    size_t max_regions = max_evaluations / points > 1 ? (size_t)(max_evaluations / points) : 1;
+
+    /* Each split costs two regions' points and adds one region */
+    CubatureRegion *regions = malloc(sizeof(CubatureRegion) * max_regions);
+    CubatureRegion *halves = malloc(sizeof(CubatureRegion) * max_regions);
+    if (!regions || !halves) {
+        free(regions);
+        free(halves);
+        return result;
+    }
+
+    memset(&regions[0], 0, sizeof(CubatureRegion));
+    for (int d = 0; d < f->dims; d++) {
+        regions[0].center[d] = 0.5 * (lower[d] + upper[d]);
+        regions[0].half[d] = 0.5 * (upper[d] - lower[d]);
+    }
+    cubature_evaluate(f, regions, 1);
+    size_t count = 1;
+    result.evaluations = points;
+
+    /* Same refinement as ast_integrate_adaptive(): bisect the worst regions
+     * holding half the excess error, and evaluate the halves as one batch.
+     */
+    for (;;) {
+        double value = 0.0, error = 0.0;
+        for (size_t i = 0; i < count; i++) {
+            value += regions[i].value;
+            error += regions[i].error;
+        }
+        result.value = value;
+        result.error_estimate = error;
+        double tolerance = fmax(abs_tol, rel_tol * fabs(value));
+        result.converged = error <= tolerance;
+        size_t budget = result.evaluations < max_evaluations ?
+                        (size_t)(max_evaluations - result.evaluations) / (2 * (size_t)points) : 0;
+        if (result.converged || !isfinite(error) || budget == 0) break;
+
+        qsort(regions, count, sizeof(CubatureRegion), cubature_by_error);
+        size_t split = 0;
+        double covered = 0.0;
+        while (split < count && split < budget && (split == 0 || covered < 0.5 * (error - tolerance))) {
+            covered += regions[split].error;
+            split++;
+        }
+
+        for (size_t i = 0; i < split; i++) {
+            int axis = regions[i].axis;
+            double quarter = 0.5 * regions[i].half[axis];
+            halves[2 * i] = halves[2 * i + 1] = regions[i];
+            halves[2 * i].half[axis] = halves[2 * i + 1].half[axis] = quarter;
+            halves[2 * i].center[axis] -= quarter;
+            halves[2 * i + 1].center[axis] += quarter;
+        }
+        cubature_evaluate(f, halves, 2 * split);
+        for (size_t i = 0; i < split; i++) {
+            regions[i] = halves[2 * i];
+            regions[count + i] = halves[2 * i + 1];
+        }
+        count += split;
+        result.evaluations += 2 * (int)split * points;
+    }
+    result.intervals = (int)count;
+
+    free(regions);
+    free(halves);
+    return result;
+}
+
+/* Sobol sequences from Joe & Kuo's direction numbers (new-joe-kuo-6.21201):
+ * degree s and coefficients a of each dimension's primitive polynomial and
+ * its initial m values. The first dimension is the van der Corput sequence.
+ */
+static const struct {
+    int s, a;
+    unsigned m[5];
+} sobol_polynomials[INTEGRATE_MAX_DIMS] = {
+    {0, 0, {0}},
+    {1, 0, {1}},
+    {2, 1, {1, 3}},
+    {3, 1, {1, 3, 1}},
+    {3, 2, {1, 1, 1}},
+    {4, 1, {1, 1, 3, 3}},
+    {4, 4, {1, 3, 5, 13}},
+    {5, 2, {1, 1, 5, 5, 17}},
+    {5, 4, {1, 1, 5, 5, 5}},
+    {5, 7, {1, 1, 7, 11, 19}},
+};
+
+#define SOBOL_BITS 32
+
+static void sobol_directions(int dims, uint32_t directions[][SOBOL_BITS]) {
+    for (int d = 0; d < dims; d++) {
+        uint32_t *v = directions[d];
+        int s = sobol_polynomials[d].s, a = sobol_polynomials[d].a;
+        if (s == 0) {
+            for (int k = 0; k < SOBOL_BITS; k++) v[k] = (uint32_t)1 << (31 - k);
+            continue;
+        }
+        for (int k = 0; k < s; k++) v[k] = (uint32_t)sobol_polynomials[d].m[k] << (31 - k);
+        for (int k = s; k < SOBOL_BITS; k++) {
+            v[k] = v[k - s] ^ (v[k - s] >> s);
+            for (int j = 1; j < s; j++) {
+                if ((a >> (s - 1 - j)) & 1) v[k] ^= v[k - j];
+            }
+        }
+    }
+}
+
+/* splitmix64: the fixed-seed source of the scrambles */
+static uint64_t sobol_random_next(uint64_t *state) {
+    uint64_t z = (*state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+/* Linear matrix scramble: digit j (bit 31 - j) of the result mixes digits
+ * 0..j of v through a random unit lower-triangular matrix. Applied to the
+ * direction numbers, it scrambles every point of the sequence.
+ */
+static void sobol_scramble(uint32_t directions[SOBOL_BITS], uint64_t *seed) {
+    uint32_t rows[SOBOL_BITS];
+    for (int j = 0; j < SOBOL_BITS; j++) {
+        uint32_t above = j == 0 ? 0 : ~(uint32_t)0 << (32 - j);     /* Digits 0..j-1 */
+        rows[j] = ((uint32_t)(sobol_random_next(seed) >> 32) & above) | ((uint32_t)1 << (31 - j));
+    }
+    for (int k = 0; k < SOBOL_BITS; k++) {
+        uint32_t v = directions[k], out = 0;
+        for (int j = 0; j < SOBOL_BITS; j++) {
+            if (__builtin_parity(rows[j] & v)) out |= (uint32_t)1 << (31 - j);
+        }
+        directions[k] = out;
+    }
+}
+
+/* A randomized copy of the sequence: scrambled directions, then a digital shift */
+typedef struct {
+    uint32_t directions[INTEGRATE_MAX_DIMS][SOBOL_BITS];
+    uint32_t shift[INTEGRATE_MAX_DIMS];
+} SobolReplicate;
+
+/* Point sums over [first, first + count) of each replicate */
+typedef struct {
+    const Integrand *f;
+    const SobolReplicate *replicates;
+    const double *lower, *width;
+    uint32_t first;
+    uint32_t count;
+    double *partial;            /* [replicate * chunks + chunk] */
+    size_t chunks;
+} SobolJob;
+
+#define SOBOL_CHUNK INTEGRATE_CHUNK
+
+static void sobol_chunk(void *arg, size_t task) {
+    const SobolJob *job = arg;
+    int dims = job->f->dims;
+    const SobolReplicate *rep = &job->replicates[task / job->chunks];
+    uint32_t index = job->first + (uint32_t)((task % job->chunks) * SOBOL_CHUNK);
+    uint32_t end = job->first + job->count;
+    if (end - index > SOBOL_CHUNK) end = index + SOBOL_CHUNK;
+
+    /* This task's own sequence state: the Gray-code point at index */
+    uint32_t state[INTEGRATE_MAX_DIMS];
+    uint32_t gray = index ^ (index >> 1);
+    for (int d = 0; d < dims; d++) {
+        state[d] = rep->shift[d];
+        for (int k = 0; k < SOBOL_BITS; k++) {
+            if ((gray >> k) & 1) state[d] ^= rep->directions[d][k];
+        }
+    }
+
+    double columns[INTEGRATE_MAX_DIMS][VM_BATCH_BLOCK], y[VM_BATCH_BLOCK];
+    const double *column_ptrs[INTEGRATE_MAX_DIMS];
+    for (int d = 0; d < dims; d++) column_ptrs[d] = columns[d];
+
+    double sum = 0.0;
+    while (index < end) {
+        size_t n = end - index < VM_BATCH_BLOCK ? end - index : VM_BATCH_BLOCK;
+        for (size_t k = 0; k < n; k++) {
+            for (int d = 0; d < dims; d++) {
+                columns[d][k] = job->lower[d] + (state[d] + 0.5) * (1.0 / 4294967296.0) * job->width[d];
+            }
+            /* Next point: flip the direction of the lowest zero bit */
+            int bit = __builtin_ctz(~index);
+            for (int d = 0; d < dims; d++) state[d] ^= rep->directions[d][bit];
+            index++;
+        }
+        integrand_eval(job->f, column_ptrs, y, n);
+        for (size_t k = 0; k < n; k++) sum += y[k];
+    }
+    job->partial[task] = sum;
+}
+
+static IntegrationResult cubature_sobol(const Integrand *f, const double *lower, const double *upper,
+                                        double abs_tol, double rel_tol, int max_evaluations) {
+    IntegrationResult result = {0.0, 0.0, 0, 0, false};
+    int dims = f->dims;
+    SobolReplicate *replicates = malloc(sizeof(SobolReplicate) * CUBATURE_SOBOL_REPLICATES);
+    if (!replicates) return result;
+
+    uint64_t seed = 0x5EED5EED5EED5EEDULL;
+    for (int r = 0; r < CUBATURE_SOBOL_REPLICATES; r++) {
+        sobol_directions(dims, replicates[r].directions);
+        for (int d = 0; d < dims; d++) {
+            sobol_scramble(replicates[r].directions[d], &seed);
+            replicates[r].shift[d] = (uint32_t)(sobol_random_next(&seed) >> 32);
+        }
+    }
+    double width[INTEGRATE_MAX_DIMS], volume = 1.0;
+    for (int d = 0; d < dims; d++) {
+        width[d] = upper[d] - lower[d];
+        volume *= width[d];
+    }
+
+    /* Double the points per replicate each round; the first round is one chunk */
+    double sums[CUBATURE_SOBOL_REPLICATES] = {0.0};
+    uint32_t done = 0, round = SOBOL_CHUNK;
+    for (;;) {
+        SobolJob job = {.f = f, .replicates = replicates, .lower = lower, .width = width,
+                        .first = done, .count = round, .chunks = (round + SOBOL_CHUNK - 1) / SOBOL_CHUNK};
+        size_t tasks = CUBATURE_SOBOL_REPLICATES * job.chunks;
+        job.partial = malloc(sizeof(double) * tasks);
+        if (!job.partial) break;
+        thread_pool_for(thread_pool_shared(), tasks, sobol_chunk, &job);
+        for (int r = 0; r < CUBATURE_SOBOL_REPLICATES; r++) {
+            for (size_t c = 0; c < job.chunks; c++) sums[r] += job.partial[r * job.chunks + c];
+        }
+        free(job.partial);
+        done += round;
+        result.evaluations += CUBATURE_SOBOL_REPLICATES * (int)round;
+
+        /* Mean of the replicate estimates and its standard error */
+        double mean = 0.0, variance = 0.0;
+        for (int r = 0; r < CUBATURE_SOBOL_REPLICATES; r++) mean += sums[r];
+        mean *= volume / ((double)done * CUBATURE_SOBOL_REPLICATES);
+        for (int r = 0; r < CUBATURE_SOBOL_REPLICATES; r++) {
+            double e = volume * sums[r] / done - mean;
+            variance += e * e;
+        }
+        variance /= (CUBATURE_SOBOL_REPLICATES - 1);
+
+        result.value = mean;
+        result.error_estimate = sqrt(variance / CUBATURE_SOBOL_REPLICATES);
+        result.intervals = (int)done;
+        result.converged = result.error_estimate <= fmax(abs_tol, rel_tol * fabs(mean));
+        round = done;
+        if (result.converged || !isfinite(result.error_estimate) ||
+            (double)result.evaluations + (double)CUBATURE_SOBOL_REPLICATES * round > max_evaluations) {
+            break;
+        }
+    }
+    free(replicates);
+    return result;
+}
+
+IntegrationResult ast_integrate_multi(const ASTNode *expr, const char *const *var_names,
+                                      const double *lower, const double *upper, int dims,
+                                      double abs_tol, double rel_tol, int max_evaluations,
+                                      CubatureMethod method) {
+    IntegrationResult result = {0.0, 0.0, 0, 0, false};
+    if (!expr || !var_names || !lower || !upper || dims < 1 || dims > INTEGRATE_MAX_DIMS) return result;
+    for (int d = 0; d < dims; d++) {
+        if (!var_names[d]) return result;
+        if (lower[d] == upper[d]) {
+            result.converged = true;
+            return result;
+        }
+    }
+    if (max_evaluations <= 0) max_evaluations = 1000000;
+
+    if (method == CUBATURE_ADAPTIVE && dims == 1) {
+        return ast_integrate_adaptive(expr, var_names[0], lower[0], upper[0], abs_tol, rel_tol,
+                                      max_evaluations / GK15_POINTS);
+    }
+
+    Integrand f;
+    integrand_init(&f, expr, var_names, dims);
+    switch (method) {
+        case CUBATURE_ADAPTIVE:
+            result = cubature_adaptive(&f, lower, upper, abs_tol, rel_tol, max_evaluations);
+            break;
+        case CUBATURE_SOBOL:
+            result = cubature_sobol(&f, lower, upper, abs_tol, rel_tol, max_evaluations);
+            break;
+    }
+    bytecode_free(f.bc);
+    return result;
+}
+
 /* ============================================================================
  * EQUATION SOLVING
  * ============================================================================ */
@@ -2471,15 +4336,92 @@ void solve_result_free(SolveResult *result) {
  * NUMERICAL EQUATION SOLVING (Newton-Raphson)
  * ============================================================================ */
 
+static int bytecode_stack_depth(const Bytecode *bc);
+static void vm_dual_lanes(const Bytecode *bc, const double *values, int value_count, int seed_slot,
+                          int n, Dual *stack, Dual *temps, Dual *out);
+
+/* One Newton-Raphson step at x, given f(x) and f'(x). Returns true when the
+ * solve is over (result is final), otherwise stores the next iterate in *x.
+ */
+static bool newton_step(NumericalSolveResult *result, double *x, double f_x, double fp_x,
+                        int iter, double tolerance) {
+    result->iterations = iter + 1;
+
+    /* Check for convergence */
+    result->final_error = fabs(f_x);
+    if (result->final_error < tolerance) {
+        result->solution = *x;
+        result->converged = true;
+        return true;
+    }
+
+    /* Check for zero derivative (would cause division by zero) */
+    if (fabs(fp_x) < 1e-15) {
+        snprintf(result->error_message, sizeof(result->error_message),
+                 "Derivative is zero at x=%.6f, cannot continue", *x);
+        result->solution = *x;
+        return true;
+    }
+
+    /* Newton-Raphson update */
+    double x_new = *x - f_x / fp_x;
+
+    /* Check for divergence (going to infinity) */
+    if (!isfinite(x_new) || fabs(x_new) > 1e10) {
+        snprintf(result->error_message, sizeof(result->error_message),
+                 "Solution diverged (x -> infinity)");
+        result->solution = *x;
+        return true;
+    }
+
+    /* Check for oscillation or very slow convergence */
+    if (iter > 10 && fabs(x_new - *x) < 1e-15) {
+        /* Converged to machine precision */
+        result->solution = x_new;
+        result->converged = true;
+        result->final_error = fabs(f_x);
+        return true;
+    }
+
+    *x = x_new;
+    return false;
+}
+
+static void newton_init(NumericalSolveResult *result) {
+    result->solution = 0.0;
+    result->converged = false;
+    result->iterations = 0;
+    result->final_error = INFINITY;
+    result->error_message[0] = '\0';
+}
+
+static void newton_give_up(NumericalSolveResult *result, double x, int max_iterations) {
+    /* Max iterations reached without convergence */
+    snprintf(result->error_message, sizeof(result->error_message),
+             "Max iterations (%d) reached, error=%.6e", max_iterations, result->final_error);
+    result->solution = x;
+}
+
+/* Compile the equation with var_name bound to slot 0 and, if given,
+ * param_name to slot 1
+ */
+static Bytecode* newton_compile(const ASTNode *equation, const char *var_name, const char *param_name) {
+    Bytecode *bc = ast_compile(equation);
+    if (!bc || bytecode_stack_depth(bc) < 0) {
+        bytecode_free(bc);
+        return NULL;
+    }
+    VarMapping mappings[2] = {{.name = var_name, .index = 0}, {.name = param_name, .index = 1}};
+    VarContext layout = {.values = NULL, .count = param_name ? 2 : 1,
+                         .mappings = mappings, .mapping_count = param_name ? 2 : 1};
+    bytecode_bind(bc, &layout);
+    return bc;
+}
+
 NumericalSolveResult ast_solve_numerical(ASTNode *equation, const char *var_name,
                                           double initial_guess, double tolerance, int max_iterations) {
-    NumericalSolveResult result = {
-        .solution = 0.0,
-        .converged = false,
-        .iterations = 0,
-        .final_error = INFINITY,
-        .error_message = {0}
-    };
+    NumericalSolveResult result;
+    newton_init(&result);
 
     if (!equation || !var_name) {
         snprintf(result.error_message, sizeof(result.error_message),
@@ -2487,85 +4429,99 @@ NumericalSolveResult ast_solve_numerical(ASTNode *equation, const char *var_name
         return result;
     }
 
-    /* Compute derivative symbolically using our differentiation engine */
-    ASTNode *derivative = ast_differentiate(equation, var_name);
-    if (!derivative) {
-        snprintf(result.error_message, sizeof(result.error_message),
-                 "Failed to compute derivative");
-        return result;
-    }
-
-    /* Simplify derivative for better performance */
-    ASTNode *derivative_simplified = ast_simplify(derivative);
+    /* f and f' come from one dual-number pass over the compiled equation
+     * (or over the tree if it does not compile)
+     */
+    Bytecode *bc = newton_compile(equation, var_name, NULL);
 
     /* Set up variable context for evaluation */
     VarMapping mapping = {.name = var_name, .index = 0};
     double x = initial_guess;
+    VarContext ctx = {
+        .values = &x,
+        .count = 1,
+        .mappings = &mapping,
+        .mapping_count = 1
+    };
 
     /* Newton-Raphson iteration: x_{n+1} = x_n - f(x_n)/f'(x_n) */
     for (int iter = 0; iter < max_iterations; iter++) {
-        result.iterations = iter + 1;
-
-        /* Evaluate f(x) and f'(x) at current x */
-        VarContext ctx = {
-            .values = &x,
-            .count = 1,
-            .mappings = &mapping,
-            .mapping_count = 1
-        };
-
-        double f_x = ast_evaluate(equation, &ctx);
-        double fp_x = ast_evaluate(derivative_simplified, &ctx);
-
-        /* Check for convergence */
-        result.final_error = fabs(f_x);
-        if (result.final_error < tolerance) {
-            result.solution = x;
-            result.converged = true;
-            ast_free(derivative_simplified);
-            return result;
-        }
-
-        /* Check for zero derivative (would cause division by zero) */
-        if (fabs(fp_x) < 1e-15) {
-            snprintf(result.error_message, sizeof(result.error_message),
-                     "Derivative is zero at x=%.6f, cannot continue", x);
-            result.solution = x;
-            ast_free(derivative_simplified);
+        Dual f = bc ? vm_execute_dual(bc, &ctx, 0) : ast_evaluate_dual(equation, &ctx, 0);
+        if (newton_step(&result, &x, f.value, f.deriv, iter, tolerance)) {
+            bytecode_free(bc);
             return result;
         }
+    }
 
-        /* Newton-Raphson update */
-        double x_new = x - f_x / fp_x;
+    newton_give_up(&result, x, max_iterations);
+    bytecode_free(bc);
+    return result;
+}
 
-        /* Check for divergence (going to infinity) */
-        if (!isfinite(x_new) || fabs(x_new) > 1e10) {
-            snprintf(result.error_message, sizeof(result.error_message),
-                     "Solution diverged (x -> infinity)");
-            result.solution = x;
-            ast_free(derivative_simplified);
-            return result;
+int ast_solve_numerical_batch(const ASTNode *equation, const char *var_name,
+                              const char *param_name, const double *params,
+                              const double *initial_guesses, size_t count,
+                              double tolerance, int max_iterations,
+                              NumericalSolveResult *results) {
+    if (!equation || !var_name || !initial_guesses || !results || (param_name && !params)) return -1;
+
+    Bytecode *bc = newton_compile(equation, var_name, param_name);
+    int depth = bc ? bytecode_stack_depth(bc) : -1;
+    const int B = VM_BATCH_BLOCK;
+    Dual *scratch = depth >= 0 ? malloc(sizeof(Dual) * ((size_t)depth + bc->temp_count + 1) * B) : NULL;
+    double *values = malloc(sizeof(double) * 2 * B);
+    double *x = malloc(sizeof(double) * B);
+    int *lane = malloc(sizeof(int) * B);
+    if (!scratch || !values || !x || !lane) {
+        bytecode_free(bc);
+        free(scratch);
+        free(values);
+        free(x);
+        free(lane);
+        return -1;
+    }
+    Dual *temps = scratch + (size_t)depth * B;
+    Dual *f = temps + (size_t)bc->temp_count * B;
+    int stride = param_name ? 2 : 1;
+
+    /* Blocks of problems iterate in lockstep; finished ones drop out */
+    for (size_t start = 0; start < count; start += B) {
+        int active = count - start < (size_t)B ? (int)(count - start) : B;
+        for (int l = 0; l < active; l++) {
+            lane[l] = l;
+            x[l] = initial_guesses[start + l];
+            newton_init(&results[start + l]);
         }
 
-        /* Check for oscillation or very slow convergence */
-        if (iter > 10 && fabs(x_new - x) < 1e-15) {
-            /* Converged to machine precision */
-            result.solution = x_new;
-            result.converged = true;
-            result.final_error = fabs(f_x);
-            ast_free(derivative_simplified);
-            return result;
+        for (int iter = 0; iter < max_iterations && active > 0; iter++) {
+            for (int l = 0; l < active; l++) {
+                values[l * stride] = x[l];
+                if (param_name) values[l * stride + 1] = params[start + lane[l]];
+            }
+            vm_dual_lanes(bc, values, stride, 0, active, scratch, temps, f);
+
+            int kept = 0;
+            for (int l = 0; l < active; l++) {
+                if (!newton_step(&results[start + lane[l]], &x[l], f[l].value, f[l].deriv, iter, tolerance)) {
+                    lane[kept] = lane[l];
+                    x[kept] = x[l];
+                    kept++;
+                }
+            }
+            active = kept;
         }
 
-        x = x_new;
+        for (int l = 0; l < active; l++) {
+            newton_give_up(&results[start + lane[l]], x[l], max_iterations);
+        }
     }
 
-    /* Max iterations reached without convergence */
-    snprintf(result.error_message, sizeof(result.error_message),
-             "Max iterations (%d) reached, error=%.6e", max_iterations, result.final_error);
-    result.solution = x;
-    ast_free(derivative_simplified);
-    return result;
+    bytecode_free(bc);
+    free(scratch);
+    free(values);
+    free(x);
+    free(lane);
+    return 0;
 }
 
 /* ============================================================================
@@ -2580,9 +4536,497 @@ static void bytecode_add_instruction(Bytecode *bc, BytecodeInstruction inst) {
     bc->instructions[bc->count++] = inst;
 }
 
-static void compile_node(const ASTNode *node, Bytecode *bc) {
+/* Symbol table index for a variable name, adding it on first use */
+static int bytecode_add_symbol(Bytecode *bc, const char *name) {
+    for (int i = 0; i < bc->var_count; i++) {
+        if (strcmp(bc->var_names[i], name) == 0) return i;
+    }
+    bc->var_names = realloc(bc->var_names, sizeof(char *) * (bc->var_count + 1));
+    size_t len = strlen(name);
+    bc->var_names[bc->var_count] = malloc(len + 1);
+    memcpy(bc->var_names[bc->var_count], name, len + 1);
+    return bc->var_count++;
+}
+
+/* Default binding: single letters A-Z to slots 0-25 (like lookup_var without mappings) */
+static int default_var_slot(const char *name) {
+    if (name[0] >= 'A' && name[0] <= 'Z' && name[1] == '\0') {
+        return name[0] - 'A';
+    }
+    return -1;
+}
+
+/* ============================================================================
+ * BYTECODE OPTIMIZATION
+ * ============================================================================
+ * ast_compile() works on a copy of the tree and runs three passes before
+ * emitting code. None of them changes a result:
+ *   1. Constant folding with the VM's semantics (division by zero gives 0,
+ *      == compares within 1e-12). RANDOM and unknown calls are left alone.
+ *   2. Strength reduction: x^2 and POW(x, 2) become x*x. x^1, x*1, 1*x,
+ *      x/1, x-0 and --x become x. Each rewrite is exact in IEEE arithmetic.
+ *   3. Common subexpressions: structurally equal subtrees are put in one
+ *      class, so the tree is evaluated as a DAG. A class used more than
+ *      once is stored in a temporary the first time (STORE_TEMP) and loaded
+ *      afterwards (LOAD_TEMP). The register translation gives each
+ *      temporary its own register, so a reuse costs no instruction.
+ */
+
+typedef struct {
+    int folded;     /* Constant subtrees replaced by numbers */
+    int reduced;    /* Strength reductions */
+    int shared;     /* Subexpressions computed once and reused */
+} OptStats;
+
+/* Binary operator with the VM's semantics (see vm_run_registers) */
+static double opt_binary_value(BinaryOp op, double a, double b) {
+    switch (op) {
+        case OP_ADD: return a + b;
+        case OP_SUBTRACT: return a - b;
+        case OP_MULTIPLY: return a * b;
+        case OP_DIVIDE: return b != 0.0 ? a / b : 0.0;
+        case OP_POWER: return pow(a, b);
+        case OP_AND: return (a != 0.0 && b != 0.0) ? 1.0 : 0.0;
+        case OP_OR: return (a != 0.0 || b != 0.0) ? 1.0 : 0.0;
+        case OP_GREATER: return (a > b) ? 1.0 : 0.0;
+        case OP_LESS: return (a < b) ? 1.0 : 0.0;
+        case OP_GREATER_EQ: return (a >= b) ? 1.0 : 0.0;
+        case OP_LESS_EQ: return (a <= b) ? 1.0 : 0.0;
+        case OP_EQUAL: return (fabs(a - b) < 1e-12) ? 1.0 : 0.0;
+        case OP_NOT_EQUAL: return (fabs(a - b) >= 1e-12) ? 1.0 : 0.0;
+    }
+    return 0.0;
+}
+
+static bool opt_is_number(const ASTNode *node, double value) {
+    return node->type == AST_NUMBER && node->data.number.value == value;
+}
+
+/* Turn node into a number, freeing its children */
+static ASTNode* opt_make_number(ASTNode *node, double value) {
+    ast_free(node);
+    return ast_create_number(value);
+}
+
+/* Replace a binary node by one of its operands */
+static ASTNode* opt_keep_left(ASTNode *node) {
+    ASTNode *keep = node->data.binary.left;
+    node->data.binary.left = NULL;
+    ast_free(node);
+    return keep;
+}
+
+static ASTNode* opt_keep_right(ASTNode *node) {
+    ASTNode *keep = node->data.binary.right;
+    node->data.binary.right = NULL;
+    ast_free(node);
+    return keep;
+}
+
+/* Whether a call may be evaluated any number of times: RANDOM and unknown
+ * functions may not (shared with pass 3, which only reuses pure values) */
+static bool opt_call_is_pure(const ASTNode *node) {
+    const MathFunctionInfo *f = math_function_info(node->data.function.id);
+    return f && f->id != FUNC_RANDOM;
+}
+
+/* No RANDOM or unknown calls inside: duplicating the subtree keeps its value */
+static bool opt_is_pure(const ASTNode *node) {
+    switch (node->type) {
+        case AST_NUMBER:
+        case AST_VARIABLE:
+            return true;
+        case AST_BINARY_OP:
+            return opt_is_pure(node->data.binary.left) && opt_is_pure(node->data.binary.right);
+        case AST_UNARY_OP:
+            return opt_is_pure(node->data.unary.operand);
+        case AST_FUNCTION_CALL:
+            if (!opt_call_is_pure(node)) return false;
+            for (int i = 0; i < node->data.function.arg_count; i++) {
+                if (!opt_is_pure(node->data.function.args[i])) return false;
+            }
+            return true;
+        default:
+            return false;
+    }
+}
+
+/* Passes 1 and 2, bottom-up; takes ownership of node */
+static ASTNode* opt_fold(ASTNode *node, OptStats *stats) {
+    switch (node->type) {
+        case AST_BINARY_OP: {
+            node->data.binary.left = opt_fold(node->data.binary.left, stats);
+            node->data.binary.right = opt_fold(node->data.binary.right, stats);
+            ASTNode *left = node->data.binary.left;
+            ASTNode *right = node->data.binary.right;
+            BinaryOp op = node->data.binary.op;
+
+            if (left->type == AST_NUMBER && right->type == AST_NUMBER) {
+                stats->folded++;
+                return opt_make_number(node, opt_binary_value(op, left->data.number.value,
+                                                              right->data.number.value));
+            }
+
+            if (op == OP_POWER && opt_is_number(right, 2.0) && opt_is_pure(left)) {
+                ast_free(right);
+                node->data.binary.op = OP_MULTIPLY;
+                node->data.binary.right = ast_clone(left);
+                stats->reduced++;
+            } else if ((op == OP_POWER || op == OP_MULTIPLY || op == OP_DIVIDE) && opt_is_number(right, 1.0)) {
+                stats->reduced++;
+                return opt_keep_left(node);
+            } else if (op == OP_SUBTRACT && opt_is_number(right, 0.0) && !signbit(right->data.number.value)) {
+                stats->reduced++;
+                return opt_keep_left(node);
+            } else if (op == OP_MULTIPLY && opt_is_number(left, 1.0)) {
+                stats->reduced++;
+                return opt_keep_right(node);
+            }
+            return node;
+        }
+
+        case AST_UNARY_OP: {
+            node->data.unary.operand = opt_fold(node->data.unary.operand, stats);
+            ASTNode *operand = node->data.unary.operand;
+
+            if (operand->type == AST_NUMBER) {
+                double v = operand->data.number.value;
+                stats->folded++;
+                return opt_make_number(node, node->data.unary.op == OP_NEGATE ? -v : (v == 0.0 ? 1.0 : 0.0));
+            }
+            if (node->data.unary.op == OP_NEGATE && operand->type == AST_UNARY_OP &&
+                operand->data.unary.op == OP_NEGATE) {
+                ASTNode *keep = operand->data.unary.operand;
+                operand->data.unary.operand = NULL;
+                ast_free(node);
+                stats->reduced++;
+                return keep;
+            }
+            return node;
+        }
+
+        case AST_FUNCTION_CALL: {
+            int arg_count = node->data.function.arg_count;
+            bool constant = true;
+            for (int i = 0; i < arg_count; i++) {
+                node->data.function.args[i] = opt_fold(node->data.function.args[i], stats);
+                constant = constant && node->data.function.args[i]->type == AST_NUMBER;
+            }
+
+            const MathFunctionInfo *f = math_function_info(node->data.function.id);
+            if (!f || f->id == FUNC_RANDOM || f->arg_count != arg_count) return node;
+
+            if (constant) {
+                double args[2];
+                for (int i = 0; i < arg_count; i++) args[i] = node->data.function.args[i]->data.number.value;
+                stats->folded++;
+                return opt_make_number(node, math_function_eval(f->id, args, arg_count));
+            }
+
+            if (f->id == FUNC_POW && opt_is_number(node->data.function.args[1], 2.0) &&
+                opt_is_pure(node->data.function.args[0])) {
+                ASTNode *base = node->data.function.args[0];
+                node->data.function.args[0] = NULL;
+                ast_free(node);
+                stats->reduced++;
+                return ast_create_binary_op(OP_MULTIPLY, base, ast_clone(base));
+            }
+            return node;
+        }
+
+        default:
+            return node;
+    }
+}
+
+/* Pass 3 state: classes of equal subtrees and a node-to-class map */
+typedef struct {
+    const ASTNode *node;    /* First subtree of the class */
+    uint64_t hash;
+    int uses;               /* Evaluations when the tree is run as a DAG */
+    int temp;               /* Temporary holding the value, -1 until emitted */
+    bool pure;              /* No RANDOM or unknown calls inside */
+} CseClass;
+
+typedef struct {
+    CseClass *classes;
+    int class_count;
+    int node_count;         /* Distinct nodes classified */
+    int *class_slots;       /* hash -> class, open addressing (-1 empty) */
+    const ASTNode **node_keys;
+    int *node_classes;      /* node pointer -> class, open addressing */
+    size_t mask;
+} CseTable;
+
+static uint64_t cse_mix(uint64_t h, uint64_t v) {
+    h ^= v + 0x9E3779B97F4A7C15ULL + (h << 6) + (h >> 2);
+    return h;
+}
+
+static size_t cse_pointer_hash(const ASTNode *node) {
+    uintptr_t p = (uintptr_t)node;
+    return (size_t)((p >> 4) * 0x9E3779B97F4A7C15ULL);
+}
+
+static int cse_class_of(const CseTable *t, const ASTNode *node) {
+    for (size_t i = cse_pointer_hash(node) & t->mask; t->node_keys[i]; i = (i + 1) & t->mask) {
+        if (t->node_keys[i] == node) return t->node_classes[i];
+    }
+    return -1;
+}
+
+/* Same operator and operands in the same classes (children are classified first) */
+static bool cse_same(const CseTable *t, const ASTNode *a, const ASTNode *b) {
+    if (a->type != b->type) return false;
+    switch (a->type) {
+        case AST_NUMBER:
+            return memcmp(&a->data.number.value, &b->data.number.value, sizeof(double)) == 0;
+        case AST_VARIABLE:
+            return a->data.variable.name == b->data.variable.name;  /* Interned */
+        case AST_BINARY_OP:
+            return a->data.binary.op == b->data.binary.op &&
+                   cse_class_of(t, a->data.binary.left) == cse_class_of(t, b->data.binary.left) &&
+                   cse_class_of(t, a->data.binary.right) == cse_class_of(t, b->data.binary.right);
+        case AST_UNARY_OP:
+            return a->data.unary.op == b->data.unary.op &&
+                   cse_class_of(t, a->data.unary.operand) == cse_class_of(t, b->data.unary.operand);
+        case AST_FUNCTION_CALL:
+            if (a->data.function.id != b->data.function.id ||
+                a->data.function.arg_count != b->data.function.arg_count ||
+                a->data.function.name != b->data.function.name) {
+                return false;
+            }
+            for (int i = 0; i < a->data.function.arg_count; i++) {
+                if (cse_class_of(t, a->data.function.args[i]) != cse_class_of(t, b->data.function.args[i])) {
+                    return false;
+                }
+            }
+            return true;
+        default:
+            return a == b;  /* Tensors are never merged */
+    }
+}
+
+/* Double both tables; a DAG's distinct node count is not known up front */
+static bool cse_grow(CseTable *t) {
+    size_t size = (t->mask + 1) * 2;
+    size_t mask = size - 1;
+    CseClass *classes = realloc(t->classes, sizeof(CseClass) * (size / 2));
+    if (!classes) return false;
+    t->classes = classes;
+
+    int *class_slots = malloc(sizeof(int) * size);
+    const ASTNode **node_keys = calloc(size, sizeof(const ASTNode *));
+    int *node_classes = malloc(sizeof(int) * size);
+    if (!class_slots || !node_keys || !node_classes) {
+        free(class_slots);
+        free(node_keys);
+        free(node_classes);
+        return false;
+    }
+
+    memset(class_slots, 0xFF, sizeof(int) * size);
+    for (int c = 0; c < t->class_count; c++) {
+        size_t i = classes[c].hash & mask;
+        while (class_slots[i] >= 0) i = (i + 1) & mask;
+        class_slots[i] = c;
+    }
+    for (size_t k = 0; k <= t->mask; k++) {
+        if (!t->node_keys[k]) continue;
+        size_t i = cse_pointer_hash(t->node_keys[k]) & mask;
+        while (node_keys[i]) i = (i + 1) & mask;
+        node_keys[i] = t->node_keys[k];
+        node_classes[i] = t->node_classes[k];
+    }
+
+    free(t->class_slots);
+    free(t->node_keys);
+    free(t->node_classes);
+    t->class_slots = class_slots;
+    t->node_keys = node_keys;
+    t->node_classes = node_classes;
+    t->mask = mask;
+    return true;
+}
+
+/* Bottom-up: assign every node to a class of equal subtrees (-1: out of memory).
+ * Only DAG nodes can be reached twice; they are classified once. */
+static int cse_classify(CseTable *t, const ASTNode *node) {
+    if (node->consed) {
+        int known = cse_class_of(t, node);
+        if (known >= 0) return known;
+    }
+
+    uint64_t h = cse_mix(0, (uint64_t)node->type);
+    bool pure = true;
+
+    switch (node->type) {
+        case AST_NUMBER: {
+            uint64_t bits;
+            memcpy(&bits, &node->data.number.value, sizeof(bits));
+            h = cse_mix(h, bits);
+            break;
+        }
+        case AST_VARIABLE:
+            h = cse_mix(h, (uint64_t)(uintptr_t)node->data.variable.name);
+            break;
+        case AST_BINARY_OP: {
+            int l = cse_classify(t, node->data.binary.left);
+            int r = cse_classify(t, node->data.binary.right);
+            if (l < 0 || r < 0) return -1;
+            h = cse_mix(cse_mix(cse_mix(h, node->data.binary.op), t->classes[l].hash), t->classes[r].hash);
+            pure = t->classes[l].pure && t->classes[r].pure;
+            break;
+        }
+        case AST_UNARY_OP: {
+            int o = cse_classify(t, node->data.unary.operand);
+            if (o < 0) return -1;
+            h = cse_mix(cse_mix(h, node->data.unary.op), t->classes[o].hash);
+            pure = t->classes[o].pure;
+            break;
+        }
+        case AST_FUNCTION_CALL: {
+            h = cse_mix(h, node->data.function.id);
+            pure = opt_call_is_pure(node);
+            for (int i = 0; i < node->data.function.arg_count; i++) {
+                int a = cse_classify(t, node->data.function.args[i]);
+                if (a < 0) return -1;
+                h = cse_mix(h, t->classes[a].hash);
+                pure = pure && t->classes[a].pure;
+            }
+            break;
+        }
+        default:
+            h = cse_mix(h, (uint64_t)(uintptr_t)node);
+            pure = false;
+            break;
+    }
+
+    if ((size_t)(t->node_count + 1) * 2 > t->mask + 1 && !cse_grow(t)) return -1;
+    t->node_count++;
+
+    size_t i = h & t->mask;
+    int c;
+    for (;; i = (i + 1) & t->mask) {
+        c = t->class_slots[i];
+        if (c < 0) {
+            c = t->class_count++;
+            t->classes[c] = (CseClass){.node = node, .hash = h, .uses = 0, .temp = -1, .pure = pure};
+            t->class_slots[i] = c;
+            break;
+        }
+        if (t->classes[c].hash == h && cse_same(t, t->classes[c].node, node)) break;
+    }
+
+    size_t k = cse_pointer_hash(node) & t->mask;
+    while (t->node_keys[k]) k = (k + 1) & t->mask;
+    t->node_keys[k] = node;
+    t->node_classes[k] = c;
+    return c;
+}
+
+/* Top-down: count evaluations, not descending into repeats (they reuse a temporary) */
+static void cse_count(CseTable *t, const ASTNode *node) {
+    CseClass *c = &t->classes[cse_class_of(t, node)];
+    if (c->uses++ > 0) return;
+
+    switch (node->type) {
+        case AST_BINARY_OP:
+            cse_count(t, node->data.binary.left);
+            cse_count(t, node->data.binary.right);
+            break;
+        case AST_UNARY_OP:
+            cse_count(t, node->data.unary.operand);
+            break;
+        case AST_FUNCTION_CALL:
+            for (int i = 0; i < node->data.function.arg_count; i++) {
+                cse_count(t, node->data.function.args[i]);
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+static int ast_count_nodes(const ASTNode *node) {
+    switch (node->type) {
+        case AST_BINARY_OP:
+            return 1 + ast_count_nodes(node->data.binary.left) + ast_count_nodes(node->data.binary.right);
+        case AST_UNARY_OP:
+            return 1 + ast_count_nodes(node->data.unary.operand);
+        case AST_FUNCTION_CALL: {
+            int n = 1;
+            for (int i = 0; i < node->data.function.arg_count; i++) {
+                n += ast_count_nodes(node->data.function.args[i]);
+            }
+            return n;
+        }
+        default:
+            return 1;
+    }
+}
+
+/* Classify and count all roots in one table, so nodes shared between
+ * them are shared in the program as well */
+static bool cse_init_roots(CseTable *t, const ASTNode *const *roots, int count) {
+    /* Counting a DAG's nodes as a tree would walk every path */
+    int nodes = 0;
+    for (int i = 0; i < count; i++) {
+        nodes += roots[i]->consed ? 64 : ast_count_nodes(roots[i]);
+    }
+    size_t size = 16;
+    while (size < (size_t)nodes * 2) size <<= 1;
+
+    t->classes = malloc(sizeof(CseClass) * (size / 2));
+    t->class_slots = malloc(sizeof(int) * size);
+    t->node_keys = calloc(size, sizeof(const ASTNode *));
+    t->node_classes = malloc(sizeof(int) * size);
+    t->class_count = 0;
+    t->node_count = 0;
+    t->mask = size - 1;
+    if (!t->classes || !t->class_slots || !t->node_keys || !t->node_classes) return false;
+
+    memset(t->class_slots, 0xFF, sizeof(int) * size);
+    for (int i = 0; i < count; i++) {
+        if (cse_classify(t, roots[i]) < 0) return false;
+    }
+    for (int i = 0; i < count; i++) {
+        cse_count(t, roots[i]);
+    }
+    return true;
+}
+
+static bool cse_init(CseTable *t, const ASTNode *root) {
+    return cse_init_roots(t, &root, 1);
+}
+
+static void cse_free(CseTable *t) {
+    free(t->classes);
+    free(t->class_slots);
+    free(t->node_keys);
+    free(t->node_classes);
+}
+
+/* Class to keep in a temporary, or NULL: repeated, pure, and not a leaf */
+static CseClass* cse_shared_class(const CseTable *t, const ASTNode *node) {
+    if (!t || node->type == AST_NUMBER || node->type == AST_VARIABLE || node->type == AST_TENSOR) {
+        return NULL;
+    }
+    CseClass *c = &t->classes[cse_class_of(t, node)];
+    return c->uses > 1 && c->pure ? c : NULL;
+}
+
+static void compile_node(const ASTNode *node, Bytecode *bc, CseTable *cse) {
     if (!node) return;
 
+    CseClass *shared = cse_shared_class(cse, node);
+    if (shared && shared->temp >= 0) {
+        BytecodeInstruction inst = {.op = BC_LOAD_TEMP};
+        inst.data.temp = shared->temp;
+        bytecode_add_instruction(bc, inst);
+        return;
+    }
+
     switch (node->type) {
         case AST_NUMBER: {
             BytecodeInstruction inst = {.op = BC_PUSH_NUM};
@@ -2593,25 +5037,16 @@ static void compile_node(const ASTNode *node, Bytecode *bc) {
 
         case AST_VARIABLE: {
             BytecodeInstruction inst = {.op = BC_PUSH_VAR};
-            /* Map variable name to index (A=0, B=1, etc.) */
-            if (strlen(node->data.variable.name) == 1) {
-                char c = node->data.variable.name[0];
-                if (c >= 'A' && c <= 'Z') {
-                    inst.data.var_index = c - 'A';
-                } else {
-                    inst.data.var_index = 0;
-                }
-            } else {
-                inst.data.var_index = 0;
-            }
+            inst.data.var.symbol = bytecode_add_symbol(bc, node->data.variable.name);
+            inst.data.var.index = default_var_slot(node->data.variable.name);
             bytecode_add_instruction(bc, inst);
             break;
         }
 
         case AST_BINARY_OP: {
             /* Compile operands first (postfix order) */
-            compile_node(node->data.binary.left, bc);
-            compile_node(node->data.binary.right, bc);
+            compile_node(node->data.binary.left, bc, cse);
+            compile_node(node->data.binary.right, bc, cse);
 
             /* Then the operator */
             BytecodeInstruction inst;
@@ -2635,7 +5070,7 @@ static void compile_node(const ASTNode *node, Bytecode *bc) {
         }
 
         case AST_UNARY_OP: {
-            compile_node(node->data.unary.operand, bc);
+            compile_node(node->data.unary.operand, bc, cse);
 
             BytecodeInstruction inst;
             switch (node->data.unary.op) {
@@ -2649,13 +5084,12 @@ static void compile_node(const ASTNode *node, Bytecode *bc) {
         case AST_FUNCTION_CALL: {
             /* Compile arguments */
             for (int i = 0; i < node->data.function.arg_count; i++) {
-                compile_node(node->data.function.args[i], bc);
+                compile_node(node->data.function.args[i], bc, cse);
             }
 
             /* Function call instruction */
             BytecodeInstruction inst = {.op = BC_CALL_FUNC};
-            strncpy(inst.data.func.name, node->data.function.name, 31);
-            inst.data.func.name[31] = '\0';
+            inst.data.func.id = node->data.function.id;
             inst.data.func.arg_count = node->data.function.arg_count;
             bytecode_add_instruction(bc, inst);
             break;
@@ -2669,29 +5103,156 @@ static void compile_node(const ASTNode *node, Bytecode *bc) {
             break;
         }
     }
+
+    if (shared) {
+        BytecodeInstruction inst = {.op = BC_STORE_TEMP};
+        inst.data.temp = shared->temp = bc->temp_count++;
+        bytecode_add_instruction(bc, inst);
+    }
 }
 
-Bytecode* ast_compile(const ASTNode *node) {
+static void bytecode_build_registers(Bytecode *bc);
+
+static Bytecode* bytecode_create(void) {
     Bytecode *bc = malloc(sizeof(Bytecode));
     bc->capacity = 64;
     bc->count = 0;
     bc->instructions = malloc(sizeof(BytecodeInstruction) * bc->capacity);
+    bc->reg_code = NULL;
+    bc->reg_count = 0;
+    bc->register_count = 0;
+    bc->var_names = NULL;
+    bc->var_count = 0;
+    bc->temp_count = 0;
+    return bc;
+}
 
-    compile_node(node, bc);
-
+static void bytecode_finish(Bytecode *bc) {
     /* Add HALT instruction */
     BytecodeInstruction halt = {.op = BC_HALT};
     bytecode_add_instruction(bc, halt);
 
+    bytecode_build_registers(bc);
+}
+
+Bytecode* ast_compile(const ASTNode *node) {
+    if (!node) return ast_compile_unoptimized(node);
+
+    /* DAG nodes were simplified as they were built, and copying one as a
+     * tree would expand its shared nodes */
+    OptStats stats = {0};
+    ASTNode *tree = node->consed ? (ASTNode *)node : opt_fold(ast_clone(node), &stats);
+
+    CseTable cse;
+    bool have_cse = cse_init(&cse, tree);
+    if (!have_cse && tree->consed) {
+        cse_free(&cse);
+        return NULL;
+    }
+
+    Bytecode *bc = bytecode_create();
+    compile_node(tree, bc, have_cse ? &cse : NULL);
+    bytecode_finish(bc);
+
+    for (int c = 0; have_cse && c < cse.class_count; c++) {
+        if (cse.classes[c].temp >= 0) stats.shared++;
+    }
+    parser_debug_log(DEBUG_OPTIMIZE, "[OPTIMIZE] %d -> %d instructions (%d folded, %d reduced, %d shared)\n",
+                     (node->consed ? cse.node_count : ast_count_nodes(node)) + 1, bc->count,
+                     stats.folded, stats.reduced, stats.shared);
+
+    cse_free(&cse);
+    if (tree != node) ast_free(tree);
+    return bc;
+}
+
+/* Compile DAG nodes into one stack program that leaves roots[i] in stack
+ * slot i. There is no register form: it returns a single value. */
+static Bytecode* ast_compile_outputs(const ASTNode *const *roots, int count) {
+    CseTable cse;
+    if (!cse_init_roots(&cse, roots, count)) {
+        cse_free(&cse);
+        return NULL;
+    }
+
+    Bytecode *bc = bytecode_create();
+    for (int i = 0; i < count; i++) {
+        compile_node(roots[i], bc, &cse);
+    }
+    BytecodeInstruction halt = {.op = BC_HALT};
+    bytecode_add_instruction(bc, halt);
+
+    cse_free(&cse);
+    return bc;
+}
+
+Bytecode* ast_compile_unoptimized(const ASTNode *node) {
+    Bytecode *bc = bytecode_create();
+    compile_node(node, bc, NULL);
+    bytecode_finish(bc);
     return bc;
 }
 
 void bytecode_free(Bytecode *bc) {
     if (!bc) return;
     free(bc->instructions);
+    free(bc->reg_code);
+    for (int i = 0; i < bc->var_count; i++) {
+        free(bc->var_names[i]);
+    }
+    free(bc->var_names);
     free(bc);
 }
 
+int bytecode_bind(Bytecode *bc, const VarContext *layout) {
+    if (!bc) return -1;
+
+    int unbound = 0;
+    int *slots = malloc(sizeof(int) * (bc->var_count > 0 ? bc->var_count : 1));
+    if (!slots) return -1;
+
+    /* Resolve each name once, with the same rules as lookup_var() */
+    for (int s = 0; s < bc->var_count; s++) {
+        const char *name = bc->var_names[s];
+        int slot = -1;
+
+        if (!layout) {
+            slot = default_var_slot(name);
+        } else if (layout->mappings && layout->mapping_count > 0) {
+            for (int i = 0; i < layout->mapping_count; i++) {
+                if (strcmp(name, layout->mappings[i].name) == 0) {
+                    int idx = layout->mappings[i].index;
+                    if (idx >= 0 && idx < layout->count) slot = idx;
+                    break;
+                }
+            }
+        } else {
+            slot = default_var_slot(name);
+            if (slot >= layout->count) slot = -1;
+        }
+
+        slots[s] = slot;
+        if (slot < 0) unbound++;
+    }
+
+    /* Rewrite the loads in both program forms */
+    for (int pc = 0; pc < bc->count; pc++) {
+        BytecodeInstruction *inst = &bc->instructions[pc];
+        if (inst->op == BC_PUSH_VAR && inst->data.var.symbol >= 0 && inst->data.var.symbol < bc->var_count) {
+            inst->data.var.index = slots[inst->data.var.symbol];
+        }
+    }
+    for (int pc = 0; bc->reg_code && pc < bc->reg_count; pc++) {
+        RegInstruction *inst = &bc->reg_code[pc];
+        if (inst->op == REG_LOAD_VAR && inst->b < bc->var_count) {
+            inst->data.var_index = slots[inst->b];
+        }
+    }
+
+    free(slots);
+    return unbound;
+}
+
 void bytecode_print(const Bytecode *bc) {
     if (!bc) return;
 
@@ -2702,7 +5263,13 @@ void bytecode_print(const Bytecode *bc) {
 
         switch (inst.op) {
             case BC_PUSH_NUM: printf("PUSH_NUM %.2f\n", inst.data.num); break;
-            case BC_PUSH_VAR: printf("PUSH_VAR %d\n", inst.data.var_index); break;
+            case BC_PUSH_VAR:
+                if (inst.data.var.symbol >= 0 && inst.data.var.symbol < bc->var_count) {
+                    printf("PUSH_VAR %d (%s)\n", inst.data.var.index, bc->var_names[inst.data.var.symbol]);
+                } else {
+                    printf("PUSH_VAR %d\n", inst.data.var.index);
+                }
+                break;
             case BC_ADD: printf("ADD\n"); break;
             case BC_SUBTRACT: printf("SUBTRACT\n"); break;
             case BC_MULTIPLY: printf("MULTIPLY\n"); break;
@@ -2718,7 +5285,13 @@ void bytecode_print(const Bytecode *bc) {
             case BC_LESS_EQ: printf("LESS_EQ\n"); break;
             case BC_EQUAL: printf("EQUAL\n"); break;
             case BC_NOT_EQUAL: printf("NOT_EQUAL\n"); break;
-            case BC_CALL_FUNC: printf("CALL_FUNC %s(%d)\n", inst.data.func.name, inst.data.func.arg_count); break;
+            case BC_CALL_FUNC: {
+                const MathFunctionInfo *f = math_function_info(inst.data.func.id);
+                printf("CALL_FUNC %s(%d)\n", f ? f->name : "?", inst.data.func.arg_count);
+                break;
+            }
+            case BC_STORE_TEMP: printf("STORE_TEMP t%d\n", inst.data.temp); break;
+            case BC_LOAD_TEMP: printf("LOAD_TEMP t%d\n", inst.data.temp); break;
             case BC_HALT: printf("HALT\n"); break;
         }
     }
@@ -2756,60 +5329,18 @@ static double vm_pop(VM *vm) {
     return vm->stack[--vm->stack_pointer];
 }
 
-static double vm_eval_function(const char *name, double *args, int arg_count) {
-    /* Reuse the same function evaluation as AST */
-    /* Zero-argument */
-    if (strcmp(name, "RANDOM") == 0 || strcmp(name, "RND") == 0) {
-        /* Thread-safe RNG with mutex protection */
-        pthread_mutex_lock(&rng_mutex);
-        if (!random_seeded) {
-            srand(time(NULL));
-            random_seeded = true;
-        }
-        double r = (double)rand() / (double)RAND_MAX;
-        pthread_mutex_unlock(&rng_mutex);
-        return r;
-    }
-
-    /* One-argument */
-    if (arg_count == 1) {
-        double x = args[0];
-        if (strcmp(name, "ABS") == 0) return fabs(x);
-        if (strcmp(name, "ROUND") == 0) return round(x);
-        if (strcmp(name, "FLOOR") == 0) return floor(x);
-        if (strcmp(name, "CEIL") == 0) return ceil(x);
-        if (strcmp(name, "SQRT") == 0) return sqrt(x);
-        if (strcmp(name, "SIN") == 0) return sin(x);
-        if (strcmp(name, "COS") == 0) return cos(x);
-        if (strcmp(name, "TAN") == 0) return tan(x);
-        if (strcmp(name, "ASIN") == 0) return asin(x);
-        if (strcmp(name, "ACOS") == 0) return acos(x);
-        if (strcmp(name, "ATAN") == 0) return atan(x);
-        if (strcmp(name, "LOG") == 0 || strcmp(name, "LN") == 0) return log(x);
-        if (strcmp(name, "LOG10") == 0) return log10(x);
-        if (strcmp(name, "EXP") == 0) return exp(x);
-        if (strcmp(name, "INT") == 0) return floor(x);
-        if (strcmp(name, "SGN") == 0) return (x > 0.0) ? 1.0 : (x < 0.0) ? -1.0 : 0.0;
-    }
-
-    /* Two-argument */
-    if (arg_count == 2) {
-        double x = args[0], y = args[1];
-        if (strcmp(name, "MIN") == 0) return fmin(x, y);
-        if (strcmp(name, "MAX") == 0) return fmax(x, y);
-        if (strcmp(name, "POW") == 0) return pow(x, y);
-        if (strcmp(name, "ATAN2") == 0) return atan2(y, x);
-        if (strcmp(name, "MOD") == 0) return fmod(x, y);
-    }
-
-    return 0.0;
-}
-
-double vm_execute(VM *vm, const Bytecode *bc) {
+double vm_execute_stack(VM *vm, const Bytecode *bc) {
     if (!vm || !bc) return 0.0;
 
     vm->stack_pointer = 0;  /* Reset stack */
 
+    double local_temps[16];
+    double *temps = local_temps;
+    if (bc->temp_count > 16) {
+        temps = malloc(sizeof(double) * bc->temp_count);
+        if (!temps) return 0.0;
+    }
+
     for (int pc = 0; pc < bc->count; pc++) {
         BytecodeInstruction inst = bc->instructions[pc];
 
@@ -2820,8 +5351,9 @@ double vm_execute(VM *vm, const Bytecode *bc) {
 
             case BC_PUSH_VAR: {
                 double value = 0.0;
-                if (vm->vars && inst.data.var_index < vm->vars->count) {
-                    value = vm->vars->values[inst.data.var_index];
+                int idx = inst.data.var.index;
+                if (vm->vars && idx >= 0 && idx < vm->vars->count) {
+                    value = vm->vars->values[idx];
                 }
                 vm_push(vm, value);
                 break;
@@ -2937,29 +5469,861 @@ double vm_execute(VM *vm, const Bytecode *bc) {
                 for (int i = arg_count - 1; i >= 0; i--) {
                     args[i] = vm_pop(vm);
                 }
-                double result = vm_eval_function(inst.data.func.name, args, arg_count);
+                double result = math_function_eval(inst.data.func.id, args, arg_count);
                 vm_push(vm, result);
                 break;
             }
 
+            case BC_STORE_TEMP:
+                if ((unsigned)inst.data.temp < (unsigned)bc->temp_count) {
+                    temps[inst.data.temp] = vm->stack_pointer > 0 ? vm->stack[vm->stack_pointer - 1] : 0.0;
+                }
+                break;
+
+            case BC_LOAD_TEMP:
+                vm_push(vm, (unsigned)inst.data.temp < (unsigned)bc->temp_count ? temps[inst.data.temp] : 0.0);
+                break;
+
             case BC_HALT:
-                /* Return top of stack */
-                return vm->stack_pointer > 0 ? vm->stack[vm->stack_pointer - 1] : 0.0;
+                pc = bc->count;
+                break;
         }
     }
 
+    if (temps != local_temps) free(temps);
+
+    /* Return top of stack */
     return vm->stack_pointer > 0 ? vm->stack[vm->stack_pointer - 1] : 0.0;
 }
 
 /* ============================================================================
- * HIGH-LEVEL API
- * ============================================================================ */
+ * EVALUATION BUDGETS
+ * ============================================================================
+ * eval_budget_charge() counts down the operations left in the current
+ * window; only when the window runs out does eval_budget_refill() add it
+ * to the total, compare against the limits and read the clock.
+ */
 
-CompiledExpression* compile_expression(const char *expr) {
-    (void)expr;  /* Suppress unused parameter warning */
-    /* This would require integrating with the parser - placeholder for now */
-    /* In a full implementation, we'd parse expr to AST, then compile to bytecode */
-    return NULL;
+static long long monotonic_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+/* Operations until the next check */
+static unsigned long eval_budget_window(const EvalBudget *budget) {
+    if (budget->max_operations == 0) {
+        return budget->deadline_ns ? budget->check_interval : ULONG_MAX;
+    }
+    unsigned long left = budget->max_operations - budget->spent;
+    if (budget->deadline_ns && left > budget->check_interval) return budget->check_interval;
+    return left;
+}
+
+void eval_budget_init_interval(EvalBudget *budget, long timeout_ms, unsigned long max_operations,
+                               unsigned long check_interval) {
+    budget->max_operations = max_operations;
+    budget->deadline_ns = timeout_ms > 0 ? monotonic_ns() + timeout_ms * 1000000LL : 0;
+    budget->spent = 0;
+    budget->check_interval = check_interval > 0 ? check_interval : 1;
+    budget->status = EVAL_BUDGET_OK;
+    budget->window = budget->remaining = eval_budget_window(budget);
+}
+
+void eval_budget_init(EvalBudget *budget, long timeout_ms, unsigned long max_operations) {
+    eval_budget_init_interval(budget, timeout_ms, max_operations, EVAL_BUDGET_CHECK_INTERVAL);
+}
+
+bool eval_budget_refill(EvalBudget *budget, unsigned long operations) {
+    if (budget->status != EVAL_BUDGET_OK) return false;
+
+    budget->spent += budget->window - budget->remaining;
+    budget->window = budget->remaining = 0;
+    if (budget->max_operations && operations > budget->max_operations - budget->spent) {
+        budget->status = EVAL_BUDGET_OPERATIONS;
+        return false;
+    }
+    if (budget->deadline_ns && monotonic_ns() >= budget->deadline_ns) {
+        budget->status = EVAL_BUDGET_TIMEOUT;
+        return false;
+    }
+
+    budget->spent += operations;
+    budget->window = budget->remaining = eval_budget_window(budget);
+    return true;
+}
+
+unsigned long eval_budget_operations(const EvalBudget *budget) {
+    return budget->spent + (budget->window - budget->remaining);
+}
+
+/* ============================================================================
+ * BATCHED COLUMNAR EXECUTION
+ * ============================================================================
+ * Runs one program over many rows. The stack holds a block of
+ * VM_BATCH_BLOCK lanes per slot, so each instruction is dispatched once per
+ * block and its body is a plain loop over lanes that the compiler can
+ * vectorize. Results match vm_execute() row by row.
+ */
+
+/* Maximum stack depth of a program, or -1 if it would underflow */
+static int bytecode_stack_depth(const Bytecode *bc) {
+    int depth = 0, max_depth = 0;
+
+    for (int pc = 0; pc < bc->count; pc++) {
+        switch (bc->instructions[pc].op) {
+            case BC_PUSH_NUM:
+            case BC_PUSH_VAR:
+                depth++;
+                break;
+            case BC_LOAD_TEMP:
+                if (bc->instructions[pc].data.temp < 0 || bc->instructions[pc].data.temp >= bc->temp_count) return -1;
+                depth++;
+                break;
+            case BC_STORE_TEMP:
+                if (bc->instructions[pc].data.temp < 0 || bc->instructions[pc].data.temp >= bc->temp_count) return -1;
+                if (depth < 1) return -1;
+                break;
+            case BC_NEGATE:
+            case BC_NOT:
+                if (depth < 1) return -1;
+                break;
+            case BC_CALL_FUNC:
+                depth -= bc->instructions[pc].data.func.arg_count;
+                if (depth < 0) return -1;
+                depth++;
+                break;
+            case BC_HALT:
+                return max_depth;
+            default:  /* Binary operators */
+                if (depth < 2) return -1;
+                depth--;
+                break;
+        }
+        if (depth > max_depth) max_depth = depth;
+    }
+    return max_depth;
+}
+
+/* Combine the top two stack blocks lane by lane */
+#define BATCH_BINARY(result) do {                                        \
+        double *restrict a = stack + (size_t)(sp - 2) * VM_BATCH_BLOCK;  \
+        const double *restrict b = a + VM_BATCH_BLOCK;                   \
+        for (size_t i = 0; i < n; i++) {                                 \
+            double x = a[i], y = b[i];                                   \
+            a[i] = (result);                                             \
+        }                                                                \
+        sp--;                                                            \
+    } while (0)
+
+int vm_execute_batch(const Bytecode *bc, const double *const *columns, int column_count,
+                     size_t row_count, double *out) {
+    return vm_execute_batch_budget(bc, columns, column_count, row_count, out, NULL, NULL) == 0 ? 0 : -1;
+}
+
+int vm_execute_batch_budget(const Bytecode *bc, const double *const *columns, int column_count,
+                            size_t row_count, double *out, EvalBudget *budget, size_t *rows_done) {
+    if (rows_done) *rows_done = 0;
+    if (!bc || (!out && row_count > 0)) return -1;
+
+    int depth = bytecode_stack_depth(bc);
+    if (depth < 0) return -1;
+    if (depth == 0) {
+        for (size_t i = 0; i < row_count; i++) out[i] = 0.0;
+        if (rows_done) *rows_done = row_count;
+        return 0;
+    }
+
+    /* Temporaries live after the stack blocks */
+    double *stack = malloc(sizeof(double) * VM_BATCH_BLOCK * ((size_t)depth + bc->temp_count));
+    if (!stack) return -1;
+    double *temps = stack + (size_t)depth * VM_BATCH_BLOCK;
+
+    for (size_t base = 0; base < row_count; base += VM_BATCH_BLOCK) {
+        size_t n = row_count - base < VM_BATCH_BLOCK ? row_count - base : VM_BATCH_BLOCK;
+        int sp = 0;
+
+        /* Each block is charged up front: one operation per instruction per row */
+        if (budget && !eval_budget_charge(budget, n * (unsigned long)bc->count)) {
+            free(stack);
+            return 1;
+        }
+
+        for (int pc = 0; pc < bc->count; pc++) {
+            const BytecodeInstruction *inst = &bc->instructions[pc];
+            double *top = stack + (size_t)sp * VM_BATCH_BLOCK;
+
+            switch (inst->op) {
+                case BC_PUSH_NUM: {
+                    double value = inst->data.num;
+                    for (size_t i = 0; i < n; i++) top[i] = value;
+                    sp++;
+                    break;
+                }
+
+                case BC_PUSH_VAR: {
+                    int idx = inst->data.var.index;
+                    if (columns && idx >= 0 && idx < column_count && columns[idx]) {
+                        memcpy(top, columns[idx] + base, sizeof(double) * n);
+                    } else {
+                        for (size_t i = 0; i < n; i++) top[i] = 0.0;
+                    }
+                    sp++;
+                    break;
+                }
+
+                case BC_ADD: BATCH_BINARY(x + y); break;
+                case BC_SUBTRACT: BATCH_BINARY(x - y); break;
+                case BC_MULTIPLY: BATCH_BINARY(x * y); break;
+                case BC_DIVIDE: BATCH_BINARY(y != 0.0 ? x / y : 0.0); break;
+                case BC_POWER: BATCH_BINARY(pow(x, y)); break;
+                case BC_AND: BATCH_BINARY((x != 0.0 && y != 0.0) ? 1.0 : 0.0); break;
+                case BC_OR: BATCH_BINARY((x != 0.0 || y != 0.0) ? 1.0 : 0.0); break;
+                case BC_GREATER: BATCH_BINARY((x > y) ? 1.0 : 0.0); break;
+                case BC_LESS: BATCH_BINARY((x < y) ? 1.0 : 0.0); break;
+                case BC_GREATER_EQ: BATCH_BINARY((x >= y) ? 1.0 : 0.0); break;
+                case BC_LESS_EQ: BATCH_BINARY((x <= y) ? 1.0 : 0.0); break;
+                case BC_EQUAL: BATCH_BINARY((fabs(x - y) < 1e-12) ? 1.0 : 0.0); break;
+                case BC_NOT_EQUAL: BATCH_BINARY((fabs(x - y) >= 1e-12) ? 1.0 : 0.0); break;
+
+                case BC_NEGATE: {
+                    double *a = top - VM_BATCH_BLOCK;
+                    for (size_t i = 0; i < n; i++) a[i] = -a[i];
+                    break;
+                }
+
+                case BC_NOT: {
+                    double *a = top - VM_BATCH_BLOCK;
+                    for (size_t i = 0; i < n; i++) a[i] = (a[i] == 0.0) ? 1.0 : 0.0;
+                    break;
+                }
+
+                case BC_CALL_FUNC: {
+                    int arg_count = inst->data.func.arg_count;
+                    double *a = top - (size_t)arg_count * VM_BATCH_BLOCK;
+                    const MathFunctionInfo *f = math_function_info(inst->data.func.id);
+
+                    /* Kernels are resolved at compile time; RANDOM and unknown ids go per row */
+                    if (f && arg_count == 1 && f->arg_count == 1) {
+                        for (size_t i = 0; i < n; i++) a[i] = f->fn1(a[i]);
+                    } else if (f && arg_count == 2 && f->arg_count == 2) {
+                        const double *b = a + VM_BATCH_BLOCK;
+                        for (size_t i = 0; i < n; i++) a[i] = f->fn2(a[i], b[i]);
+                    } else {
+                        double args[10];
+                        for (size_t i = 0; i < n; i++) {
+                            for (int k = 0; k < arg_count && k < 10; k++) {
+                                args[k] = a[(size_t)k * VM_BATCH_BLOCK + i];
+                            }
+                            a[i] = math_function_eval(inst->data.func.id, args, arg_count);
+                        }
+                    }
+                    sp = sp - arg_count + 1;
+                    break;
+                }
+
+                case BC_STORE_TEMP:
+                    memcpy(temps + (size_t)inst->data.temp * VM_BATCH_BLOCK, top - VM_BATCH_BLOCK,
+                           sizeof(double) * n);
+                    break;
+
+                case BC_LOAD_TEMP:
+                    memcpy(top, temps + (size_t)inst->data.temp * VM_BATCH_BLOCK, sizeof(double) * n);
+                    sp++;
+                    break;
+
+                case BC_HALT:
+                    pc = bc->count;
+                    break;
+            }
+        }
+
+        if (sp > 0) {
+            memcpy(out + base, stack + (size_t)(sp - 1) * VM_BATCH_BLOCK, sizeof(double) * n);
+        } else {
+            for (size_t i = 0; i < n; i++) out[base + i] = 0.0;
+        }
+        if (rows_done) *rows_done = base + n;
+    }
+
+    free(stack);
+    return 0;
+}
+
+#undef BATCH_BINARY
+
+/* ============================================================================
+ * REGISTER VM
+ * ============================================================================
+ * The stack program is translated once into register code: stack slot i
+ * becomes register i, so every operand index is fixed at compile time and
+ * execution needs no push/pop or bounds checks. Dispatch uses computed goto
+ * where the compiler supports it (GCC/Clang), a switch otherwise.
+ */
+
+#if defined(__GNUC__) && !defined(VM_NO_COMPUTED_GOTO)
+#define VM_COMPUTED_GOTO 1
+#endif
+
+/* Register form taking a constant right operand, or -1 */
+static int reg_constant_form(RegOp op) {
+    switch (op) {
+        case REG_ADD: return REG_ADD_K;
+        case REG_SUBTRACT: return REG_SUBTRACT_K;
+        case REG_MULTIPLY: return REG_MULTIPLY_K;
+        case REG_DIVIDE: return REG_DIVIDE_K;
+        case REG_POWER: return REG_POWER_K;
+        default: return -1;
+    }
+}
+
+static void bytecode_build_registers(Bytecode *bc) {
+    /* Temporary t is register t and stack slot i is register temp_count + i.
+     * reg_of[i] is where slot i's value currently lives: its own register,
+     * or a temporary's after LOAD_TEMP, which therefore emits nothing.
+     * Each stack instruction yields at most one register instruction, plus
+     * one move for each argument slot that still points at a temporary. */
+    int depth = bytecode_stack_depth(bc);
+    if (depth < 0) return;
+
+    RegInstruction *code = malloc(sizeof(RegInstruction) * (2 * (size_t)bc->count + 2));
+    int *reg_of = malloc(sizeof(int) * (depth + 1));
+    if (!code || !reg_of) goto fail;
+
+    const int t0 = bc->temp_count;
+    int n = 0, sp = 0, max_sp = 0;
+    bool halted = false;
+
+    for (int pc = 0; pc < bc->count && !halted; pc++) {
+        const BytecodeInstruction *inst = &bc->instructions[pc];
+        RegInstruction r = {0};
+
+        switch (inst->op) {
+            case BC_PUSH_NUM:
+                r.op = REG_LOAD_K;
+                r.dst = t0 + sp;
+                reg_of[sp++] = r.dst;
+                r.data.k = inst->data.num;
+                break;
+
+            case BC_PUSH_VAR:
+                r.op = REG_LOAD_VAR;
+                r.dst = t0 + sp;
+                reg_of[sp++] = r.dst;
+                r.data.var_index = inst->data.var.index;
+                r.b = inst->data.var.symbol;  /* Kept so bytecode_bind() can rewrite the slot */
+                break;
+
+            case BC_LOAD_TEMP:
+                reg_of[sp++] = inst->data.temp;
+                if (sp > max_sp) max_sp = sp;
+                continue;
+
+            case BC_STORE_TEMP: {
+                /* Retarget the instruction that produced the value, else copy it */
+                RegInstruction *prev = n > 0 ? &code[n - 1] : NULL;
+                if (prev && reg_of[sp - 1] == t0 + sp - 1 && prev->dst == reg_of[sp - 1]) {
+                    prev->dst = inst->data.temp;
+                    reg_of[sp - 1] = inst->data.temp;
+                    continue;
+                }
+                r.op = REG_MOVE;
+                r.dst = inst->data.temp;
+                r.a = reg_of[sp - 1];
+                reg_of[sp - 1] = r.dst;
+                break;
+            }
+
+            case BC_NEGATE:
+            case BC_NOT:
+                r.op = inst->op == BC_NEGATE ? REG_NEGATE : REG_NOT;
+                r.a = reg_of[sp - 1];
+                r.dst = reg_of[sp - 1] = t0 + sp - 1;
+                break;
+
+            case BC_CALL_FUNC: {
+                int arg_count = inst->data.func.arg_count;
+                if (arg_count < 0) goto fail;
+                int base = sp - arg_count;
+
+                /* Arguments are read from consecutive registers */
+                for (int i = base; i < sp; i++) {
+                    if (reg_of[i] != t0 + i) {
+                        RegInstruction move = {.op = REG_MOVE, .dst = t0 + i, .a = reg_of[i]};
+                        code[n++] = move;
+                        reg_of[i] = t0 + i;
+                    }
+                }
+                r.dst = r.a = t0 + base;
+
+                const MathFunctionInfo *f = math_function_info(inst->data.func.id);
+                if (f && arg_count == 1 && f->arg_count == 1) {
+                    r.op = REG_CALL1;
+                    r.data.fn1 = f->fn1;
+                } else if (f && arg_count == 2 && f->arg_count == 2) {
+                    r.op = REG_CALL2;
+                    r.data.fn2 = f->fn2;
+                } else {
+                    r.op = REG_CALLN;
+                    r.b = arg_count;
+                    r.data.func = inst->data.func.id;
+                }
+                reg_of[base] = r.dst;
+                sp = base + 1;
+                break;
+            }
+
+            case BC_HALT:
+                halted = true;
+                continue;
+
+            default: {
+                RegOp op;
+                switch (inst->op) {
+                    case BC_ADD: op = REG_ADD; break;
+                    case BC_SUBTRACT: op = REG_SUBTRACT; break;
+                    case BC_MULTIPLY: op = REG_MULTIPLY; break;
+                    case BC_DIVIDE: op = REG_DIVIDE; break;
+                    case BC_POWER: op = REG_POWER; break;
+                    case BC_AND: op = REG_AND; break;
+                    case BC_OR: op = REG_OR; break;
+                    case BC_GREATER: op = REG_GREATER; break;
+                    case BC_LESS: op = REG_LESS; break;
+                    case BC_GREATER_EQ: op = REG_GREATER_EQ; break;
+                    case BC_LESS_EQ: op = REG_LESS_EQ; break;
+                    case BC_EQUAL: op = REG_EQUAL; break;
+                    case BC_NOT_EQUAL: op = REG_NOT_EQUAL; break;
+                    default: goto fail;
+                }
+                r.a = reg_of[sp - 2];
+                r.b = reg_of[sp - 1];
+                r.dst = t0 + sp - 2;
+
+                /* A constant right operand was loaded by the previous instruction */
+                int k_form = reg_constant_form(op);
+                RegInstruction *prev = n > 0 ? &code[n - 1] : NULL;
+                if (k_form >= 0 && prev && prev->op == REG_LOAD_K && prev->dst == t0 + sp - 1 &&
+                    reg_of[sp - 1] == prev->dst && !(op == REG_DIVIDE && prev->data.k == 0.0)) {
+                    r.data.k = prev->data.k;
+                    op = (RegOp)k_form;
+                    n--;
+                }
+                r.op = op;
+                reg_of[sp - 2] = r.dst;
+                sp--;
+                break;
+            }
+        }
+
+        code[n++] = r;
+        if (sp > max_sp) max_sp = sp;
+    }
+
+    /* Result is the top of the stack (0 if empty, like the stack VM) */
+    RegInstruction halt = {.op = REG_HALT};
+    if (sp == 0) {
+        RegInstruction zero = {.op = REG_LOAD_K, .dst = t0, .data.k = 0.0};
+        code[n++] = zero;
+        halt.a = t0;
+        if (max_sp < 1) max_sp = 1;
+    } else {
+        halt.a = reg_of[sp - 1];
+    }
+    code[n++] = halt;
+
+    if (t0 + max_sp > 65535) goto fail;  /* Register indices are 16-bit */
+
+    free(reg_of);
+    bc->reg_code = code;
+    bc->reg_count = n;
+    bc->register_count = t0 + max_sp;
+    return;
+
+fail:
+    free(reg_of);
+    free(code);
+}
+
+static double vm_run_registers(const Bytecode *bc, const VarContext *vars) {
+    double local[VM_MAX_REGISTERS];
+    double *r = local;
+    if (bc->register_count > VM_MAX_REGISTERS) {
+        r = malloc(sizeof(double) * bc->register_count);
+        if (!r) return 0.0;
+    }
+
+    const double *values = vars ? vars->values : NULL;
+    int value_count = values ? vars->count : 0;
+    const RegInstruction *ip = bc->reg_code;
+    double result;
+
+#ifdef VM_COMPUTED_GOTO
+    static const void *dispatch[] = {
+        [REG_LOAD_K] = &&op_REG_LOAD_K,
+        [REG_LOAD_VAR] = &&op_REG_LOAD_VAR,
+        [REG_MOVE] = &&op_REG_MOVE,
+        [REG_ADD] = &&op_REG_ADD,
+        [REG_SUBTRACT] = &&op_REG_SUBTRACT,
+        [REG_MULTIPLY] = &&op_REG_MULTIPLY,
+        [REG_DIVIDE] = &&op_REG_DIVIDE,
+        [REG_POWER] = &&op_REG_POWER,
+        [REG_AND] = &&op_REG_AND,
+        [REG_OR] = &&op_REG_OR,
+        [REG_GREATER] = &&op_REG_GREATER,
+        [REG_LESS] = &&op_REG_LESS,
+        [REG_GREATER_EQ] = &&op_REG_GREATER_EQ,
+        [REG_LESS_EQ] = &&op_REG_LESS_EQ,
+        [REG_EQUAL] = &&op_REG_EQUAL,
+        [REG_NOT_EQUAL] = &&op_REG_NOT_EQUAL,
+        [REG_ADD_K] = &&op_REG_ADD_K,
+        [REG_SUBTRACT_K] = &&op_REG_SUBTRACT_K,
+        [REG_MULTIPLY_K] = &&op_REG_MULTIPLY_K,
+        [REG_DIVIDE_K] = &&op_REG_DIVIDE_K,
+        [REG_POWER_K] = &&op_REG_POWER_K,
+        [REG_NEGATE] = &&op_REG_NEGATE,
+        [REG_NOT] = &&op_REG_NOT,
+        [REG_CALL1] = &&op_REG_CALL1,
+        [REG_CALL2] = &&op_REG_CALL2,
+        [REG_CALLN] = &&op_REG_CALLN,
+        [REG_HALT] = &&op_REG_HALT,
+    };
+#define VM_OP(op) op_##op:
+#define VM_NEXT() do { ip++; goto *dispatch[ip->op]; } while (0)
+    goto *dispatch[ip->op];
+#else
+#define VM_OP(op) case op:
+#define VM_NEXT() ip++; continue  /* continue must reach the for loop */
+    for (;;) switch (ip->op) {
+#endif
+
+    VM_OP(REG_LOAD_K)
+        r[ip->dst] = ip->data.k;
+        VM_NEXT();
+    VM_OP(REG_LOAD_VAR)
+        r[ip->dst] = (unsigned)ip->data.var_index < (unsigned)value_count
+                     ? values[ip->data.var_index] : 0.0;
+        VM_NEXT();
+    VM_OP(REG_MOVE)
+        r[ip->dst] = r[ip->a];
+        VM_NEXT();
+    VM_OP(REG_ADD)
+        r[ip->dst] = r[ip->a] + r[ip->b];
+        VM_NEXT();
+    VM_OP(REG_SUBTRACT)
+        r[ip->dst] = r[ip->a] - r[ip->b];
+        VM_NEXT();
+    VM_OP(REG_MULTIPLY)
+        r[ip->dst] = r[ip->a] * r[ip->b];
+        VM_NEXT();
+    VM_OP(REG_DIVIDE)
+        r[ip->dst] = r[ip->b] != 0.0 ? r[ip->a] / r[ip->b] : 0.0;
+        VM_NEXT();
+    VM_OP(REG_POWER)
+        r[ip->dst] = pow(r[ip->a], r[ip->b]);
+        VM_NEXT();
+    VM_OP(REG_AND)
+        r[ip->dst] = (r[ip->a] != 0.0 && r[ip->b] != 0.0) ? 1.0 : 0.0;
+        VM_NEXT();
+    VM_OP(REG_OR)
+        r[ip->dst] = (r[ip->a] != 0.0 || r[ip->b] != 0.0) ? 1.0 : 0.0;
+        VM_NEXT();
+    VM_OP(REG_GREATER)
+        r[ip->dst] = (r[ip->a] > r[ip->b]) ? 1.0 : 0.0;
+        VM_NEXT();
+    VM_OP(REG_LESS)
+        r[ip->dst] = (r[ip->a] < r[ip->b]) ? 1.0 : 0.0;
+        VM_NEXT();
+    VM_OP(REG_GREATER_EQ)
+        r[ip->dst] = (r[ip->a] >= r[ip->b]) ? 1.0 : 0.0;
+        VM_NEXT();
+    VM_OP(REG_LESS_EQ)
+        r[ip->dst] = (r[ip->a] <= r[ip->b]) ? 1.0 : 0.0;
+        VM_NEXT();
+    VM_OP(REG_EQUAL)
+        r[ip->dst] = (fabs(r[ip->a] - r[ip->b]) < 1e-12) ? 1.0 : 0.0;
+        VM_NEXT();
+    VM_OP(REG_NOT_EQUAL)
+        r[ip->dst] = (fabs(r[ip->a] - r[ip->b]) >= 1e-12) ? 1.0 : 0.0;
+        VM_NEXT();
+    VM_OP(REG_ADD_K)
+        r[ip->dst] = r[ip->a] + ip->data.k;
+        VM_NEXT();
+    VM_OP(REG_SUBTRACT_K)
+        r[ip->dst] = r[ip->a] - ip->data.k;
+        VM_NEXT();
+    VM_OP(REG_MULTIPLY_K)
+        r[ip->dst] = r[ip->a] * ip->data.k;
+        VM_NEXT();
+    VM_OP(REG_DIVIDE_K)
+        r[ip->dst] = r[ip->a] / ip->data.k;  /* k != 0 by construction */
+        VM_NEXT();
+    VM_OP(REG_POWER_K)
+        r[ip->dst] = pow(r[ip->a], ip->data.k);
+        VM_NEXT();
+    VM_OP(REG_NEGATE)
+        r[ip->dst] = -r[ip->a];
+        VM_NEXT();
+    VM_OP(REG_NOT)
+        r[ip->dst] = (r[ip->a] == 0.0) ? 1.0 : 0.0;
+        VM_NEXT();
+    VM_OP(REG_CALL1)
+        r[ip->dst] = ip->data.fn1(r[ip->a]);
+        VM_NEXT();
+    VM_OP(REG_CALL2)
+        r[ip->dst] = ip->data.fn2(r[ip->a], r[ip->a + 1]);
+        VM_NEXT();
+    VM_OP(REG_CALLN)
+        r[ip->dst] = math_function_eval(ip->data.func, &r[ip->a], ip->b);
+        VM_NEXT();
+    VM_OP(REG_HALT)
+        result = r[ip->a];
+        if (r != local) free(r);
+        return result;
+
+#ifndef VM_COMPUTED_GOTO
+    }
+#endif
+#undef VM_OP
+#undef VM_NEXT
+}
+
+double vm_execute(VM *vm, const Bytecode *bc) {
+    if (!vm || !bc) return 0.0;
+    if (!bc->reg_code) return vm_execute_stack(vm, bc);
+    return vm_run_registers(bc, vm->vars);
+}
+
+/* Programs are straight-line code: the instruction count is the cost */
+static unsigned long bytecode_cost(const Bytecode *bc) {
+    return bc->reg_code ? (unsigned long)bc->reg_count : (unsigned long)bc->count;
+}
+
+bool vm_execute_budget(VM *vm, const Bytecode *bc, EvalBudget *budget, double *result) {
+    if (!vm || !bc || !result) return false;
+    if (budget && !eval_budget_charge(budget, bytecode_cost(bc))) return false;
+
+    *result = vm_execute(vm, bc);
+    return true;
+}
+
+/* Run bytecode against a context, allocating a VM only for the stack form */
+static double bytecode_run(const Bytecode *bc, const VarContext *vars) {
+    if (bc->reg_code) return vm_run_registers(bc, vars);
+    VM *vm = vm_create((VarContext *)vars);
+    double result = vm_execute_stack(vm, bc);
+    vm_free(vm);
+    return result;
+}
+
+/* Run bc on dual numbers for n lanes at once. Lane l reads slot s from
+ * values[l * value_count + s] (slots outside 0..value_count-1 read 0), and
+ * slot seed_slot carries derivative 1. stack holds depth * n entries and
+ * temps temp_count * n; out receives n results.
+ */
+static void vm_dual_lanes(const Bytecode *bc, const double *values, int value_count, int seed_slot,
+                          int n, Dual *stack, Dual *temps, Dual *out) {
+    static const Dual zero = {0.0, 0.0};
+    int sp = 0;
+
+    for (int pc = 0; pc < bc->count; pc++) {
+        const BytecodeInstruction *inst = &bc->instructions[pc];
+        Dual *top = stack + (size_t)sp * n;
+
+        switch (inst->op) {
+            case BC_PUSH_NUM:
+                for (int l = 0; l < n; l++) {
+                    top[l].value = inst->data.num;
+                    top[l].deriv = 0.0;
+                }
+                sp++;
+                break;
+
+            case BC_PUSH_VAR: {
+                int idx = inst->data.var.index;
+                bool bound = values && idx >= 0 && idx < value_count;
+                for (int l = 0; l < n; l++) {
+                    top[l].value = bound ? values[(size_t)l * value_count + idx] : 0.0;
+                    top[l].deriv = (bound && idx == seed_slot) ? 1.0 : 0.0;
+                }
+                sp++;
+                break;
+            }
+
+            case BC_STORE_TEMP:
+                memcpy(temps + (size_t)inst->data.temp * n, top - n, sizeof(Dual) * n);
+                break;
+
+            case BC_LOAD_TEMP:
+                memcpy(top, temps + (size_t)inst->data.temp * n, sizeof(Dual) * n);
+                sp++;
+                break;
+
+            case BC_NEGATE:
+            case BC_NOT:
+                for (int l = 0; l < n; l++) {
+                    top[l - n] = dual_apply(inst->op, FUNC_UNKNOWN, top[l - n], zero);
+                }
+                break;
+
+            case BC_CALL_FUNC: {
+                int argc = inst->data.func.arg_count;
+                sp -= argc;
+                Dual *base = stack + (size_t)sp * n;
+                for (int l = 0; l < n; l++) {
+                    /* Known functions take at most two arguments */
+                    Dual args[2] = {zero, zero};
+                    for (int k = 0; k < argc && k < 2; k++) args[k] = base[(size_t)k * n + l];
+                    base[l] = dual_call(inst->data.func.id, args, argc);
+                }
+                sp++;
+                break;
+            }
+
+            case BC_HALT:
+                pc = bc->count;
+                break;
+
+            default:  /* Binary operators */
+                sp--;
+                for (int l = 0; l < n; l++) {
+                    top[l - 2 * n] = dual_apply(inst->op, FUNC_UNKNOWN, top[l - 2 * n], top[l - n]);
+                }
+                break;
+        }
+    }
+
+    for (int l = 0; l < n; l++) {
+        out[l] = sp > 0 ? stack[(size_t)(sp - 1) * n + l] : zero;
+    }
+}
+
+Dual vm_execute_dual(const Bytecode *bc, const VarContext *vars, int seed_slot) {
+    Dual result = {0.0, 0.0};
+    int depth = bc ? bytecode_stack_depth(bc) : -1;
+    if (depth < 0) return result;
+
+    Dual local[VM_MAX_REGISTERS];
+    size_t needed = (size_t)depth + bc->temp_count;
+    Dual *stack = needed <= VM_MAX_REGISTERS ? local : malloc(sizeof(Dual) * needed);
+    if (!stack) return result;
+
+    vm_dual_lanes(bc, vars ? vars->values : NULL, vars ? vars->count : 0, seed_slot, 1,
+                  stack, stack + depth, &result);
+
+    if (stack != local) free(stack);
+    return result;
+}
+
+/* ============================================================================
+ * HIGH-LEVEL API
+ * ============================================================================ */
+
+CompiledExpression* compiled_expression_from_ast(const char *expr, ASTNode *ast) {
+    CompiledExpression *ce = malloc(sizeof(CompiledExpression));
+    ce->ast = ast;
+    ce->bytecode = ast_compile(ast);
+    ce->slot_count = 26;  /* Default binding: A-Z */
+    ce->jit = NULL;
+
+    size_t len = strlen(expr);
+    ce->original_expr = malloc(len + 1);
+    memcpy(ce->original_expr, expr, len + 1);
+
+    return ce;
+}
+
+CompiledExpression* compile_expression(const char *expr) {
+    ASTNode *ast = parse_expression_ast(expr, NULL);
+    if (!ast) return NULL;
+    return compiled_expression_from_ast(expr, ast);
+}
+
+CompiledExpression* prepare_expression(const char *expr, const char *const *var_names,
+                                       int var_count, ParserErrorInfo *error) {
+    ParserErrorInfo local_error;
+    if (!error) error = &local_error;
+
+    ASTNode *ast = parse_expression_ast(expr, error);
+    if (!ast) return NULL;
+
+    if (var_count < 0 || (var_count > 0 && !var_names)) {
+        ast_free(ast);
+        error->code = PARSER_ERROR_UNKNOWN_VAR;
+        error->position = 0;
+        snprintf(error->message, sizeof(error->message), "Invalid variable list");
+        return NULL;
+    }
+
+    CompiledExpression *ce = compiled_expression_from_ast(expr, ast);
+
+    /* Upper-case the names the way the tokenizer does, then bind by mapping */
+    char (*names)[32] = malloc(sizeof(*names) * (var_count > 0 ? var_count : 1));
+    VarMapping *mappings = malloc(sizeof(VarMapping) * (var_count > 0 ? var_count : 1));
+    for (int i = 0; i < var_count; i++) {
+        size_t k = 0;
+        for (; var_names[i] && var_names[i][k] && k < sizeof(names[i]) - 1; k++) {
+            names[i][k] = toupper((unsigned char)var_names[i][k]);
+        }
+        names[i][k] = '\0';
+        mappings[i].name = names[i];
+        mappings[i].index = i;
+    }
+    VarContext layout = {.values = NULL, .count = var_count,
+                         .mappings = mappings, .mapping_count = var_count};
+
+    /* With no names, count 0 leaves every variable unbound */
+    int unbound = bytecode_bind(ce->bytecode, &layout);
+    ce->slot_count = var_count;
+
+    if (unbound != 0) {
+        const char *missing = "?";
+        for (int s = 0; s < ce->bytecode->var_count; s++) {
+            bool found = false;
+            for (int i = 0; i < var_count; i++) {
+                if (strcmp(ce->bytecode->var_names[s], names[i]) == 0) found = true;
+            }
+            if (!found) {
+                missing = ce->bytecode->var_names[s];
+                break;
+            }
+        }
+        error->code = PARSER_ERROR_UNKNOWN_VAR;
+        error->position = 0;
+        snprintf(error->message, sizeof(error->message), "Unknown variable '%s'", missing);
+        compiled_expression_free(ce);
+        ce = NULL;
+    }
+
+    free(names);
+    free(mappings);
+    return ce;
+}
+
+double prepared_expression_evaluate(const CompiledExpression *ce, const double *values) {
+    if (!ce || !ce->bytecode) return 0.0;
+    VarContext vars = {.values = (double *)values, .count = values ? ce->slot_count : 0};
+    double result;
+    if (jit_execute(ce->jit, &vars, &result)) return result;
+    return bytecode_run(ce->bytecode, &vars);
+}
+
+int compiled_expression_bind(CompiledExpression *ce, const VarContext *layout) {
+    if (!ce || !ce->bytecode) return -1;
+    ce->slot_count = layout ? layout->count : 26;
+    int unbound = bytecode_bind(ce->bytecode, layout);
+
+    /* Slots are baked into native code: regenerate it */
+    if (ce->jit) {
+        jit_free(ce->jit);
+        ce->jit = jit_compile(ce->bytecode);
+    }
+    return unbound;
+}
+
+int compiled_expression_jit(CompiledExpression *ce) {
+    if (!ce || !ce->bytecode) return -1;
+    if (!ce->jit) ce->jit = jit_compile(ce->bytecode);
+    return ce->jit ? 0 : -1;
 }
 
 void compiled_expression_free(CompiledExpression *ce) {
@@ -2967,19 +6331,233 @@ void compiled_expression_free(CompiledExpression *ce) {
     ast_free(ce->ast);
     bytecode_free(ce->bytecode);
     free(ce->original_expr);
+    jit_free(ce->jit);
     free(ce);
 }
 
 double compiled_expression_evaluate(CompiledExpression *ce, VarContext *vars) {
     if (!ce || !ce->bytecode) return 0.0;
 
+    double result;
+    if (jit_execute(ce->jit, vars, &result)) return result;
+
+    /* Register code runs on a local register file: no allocation */
+    if (ce->bytecode->reg_code) {
+        return vm_run_registers(ce->bytecode, vars);
+    }
+
     VM *vm = vm_create(vars);
-    double result = vm_execute(vm, ce->bytecode);
+    result = vm_execute(vm, ce->bytecode);
     vm_free(vm);
 
     return result;
 }
 
+int compiled_expression_evaluate_batch(CompiledExpression *ce, const double *const *columns,
+                                       int column_count, size_t row_count, double *out) {
+    if (!ce || !ce->bytecode) return -1;
+    return vm_execute_batch(ce->bytecode, columns, column_count, row_count, out);
+}
+
+bool compiled_expression_evaluate_budget(CompiledExpression *ce, VarContext *vars, EvalBudget *budget,
+                                         double *result) {
+    if (!ce || !ce->bytecode || !result) return false;
+    if (budget && !eval_budget_charge(budget, bytecode_cost(ce->bytecode))) return false;
+
+    *result = compiled_expression_evaluate(ce, vars);
+    return true;
+}
+
+int compiled_expression_evaluate_batch_budget(CompiledExpression *ce, const double *const *columns,
+                                              int column_count, size_t row_count, double *out,
+                                              EvalBudget *budget, size_t *rows_done) {
+    if (rows_done) *rows_done = 0;
+    if (!ce || !ce->bytecode) return -1;
+    return vm_execute_batch_budget(ce->bytecode, columns, column_count, row_count, out, budget, rows_done);
+}
+
+/* ============================================================================
+ * REVERSE-MODE DIFFERENTIATION
+ * ============================================================================
+ * The optimized stack program is flattened into a tape: one entry per
+ * value it computes, with operands naming earlier entries. LOAD_TEMP
+ * refers back to the stored entry, so a shared subexpression is one entry
+ * whose adjoint collects every use. The forward sweep fills in values; the
+ * backward sweep visits each entry once, pushing its adjoint to its
+ * operands with the local partial derivatives.
+ */
+
+typedef struct {
+    BytecodeOp op;          /* PUSH_NUM, PUSH_VAR, an operator or CALL_FUNC */
+    int a, b;               /* Operand entries (-1 if unused) */
+    union {
+        double num;
+        int slot;           /* PUSH_VAR: index into values[], -1 if unbound */
+        MathFunction func;  /* CALL_FUNC with a matching argument count */
+    } data;
+} TapeEntry;
+
+struct GradientProgram {
+    TapeEntry *tape;
+    int count;
+    int result;             /* Entry holding f */
+    int var_count;
+};
+
+GradientProgram* gradient_program_create(const ASTNode *expr, const char *const *var_names, int var_count) {
+    if (!expr || var_count < 0 || (var_count > 0 && !var_names)) return NULL;
+
+    Bytecode *bc = ast_compile(expr);
+    if (!bc || bytecode_stack_depth(bc) < 0) {
+        bytecode_free(bc);
+        return NULL;
+    }
+
+    VarMapping *mappings = malloc(sizeof(VarMapping) * (var_count > 0 ? var_count : 1));
+    GradientProgram *gp = calloc(1, sizeof(GradientProgram));
+    int *stack = malloc(sizeof(int) * (bc->count + 1));
+    int *temps = malloc(sizeof(int) * (bc->temp_count + 1));
+    if (gp) gp->tape = malloc(sizeof(TapeEntry) * (bc->count + 1));
+    if (!mappings || !gp || !gp->tape || !stack || !temps) goto fail;
+
+    for (int i = 0; i < var_count; i++) {
+        mappings[i].name = var_names[i];
+        mappings[i].index = i;
+    }
+    VarContext layout = {.values = NULL, .count = var_count, .mappings = mappings, .mapping_count = var_count};
+    bytecode_bind(bc, &layout);
+    gp->var_count = var_count;
+
+    int sp = 0;
+    for (int pc = 0; pc < bc->count; pc++) {
+        const BytecodeInstruction *inst = &bc->instructions[pc];
+        TapeEntry e = {.op = inst->op, .a = -1, .b = -1};
+
+        switch (inst->op) {
+            case BC_HALT:
+                pc = bc->count;
+                continue;
+            case BC_STORE_TEMP:
+                temps[inst->data.temp] = stack[sp - 1];
+                continue;
+            case BC_LOAD_TEMP:
+                stack[sp++] = temps[inst->data.temp];
+                continue;
+            case BC_PUSH_NUM:
+                e.data.num = inst->data.num;
+                break;
+            case BC_PUSH_VAR:
+                e.data.slot = inst->data.var.index;
+                break;
+            case BC_NEGATE:
+            case BC_NOT:
+                e.a = stack[--sp];
+                break;
+            case BC_CALL_FUNC: {
+                int argc = inst->data.func.arg_count;
+                const MathFunctionInfo *f = math_function_info(inst->data.func.id);
+                sp -= argc;
+                if (inst->data.func.id == FUNC_RANDOM) {
+                    e.data.func = FUNC_RANDOM;
+                } else if (!f || f->arg_count != argc) {
+                    /* Unknown calls and wrong argument counts evaluate to 0 */
+                    e.op = BC_PUSH_NUM;
+                    e.data.num = 0.0;
+                } else {
+                    e.data.func = f->id;
+                    e.a = stack[sp];
+                    if (argc == 2) e.b = stack[sp + 1];
+                }
+                break;
+            }
+            default:  /* Binary operators */
+                sp -= 2;
+                e.a = stack[sp];
+                e.b = stack[sp + 1];
+                break;
+        }
+
+        gp->tape[gp->count] = e;
+        stack[sp++] = gp->count++;
+    }
+    gp->result = sp > 0 ? stack[sp - 1] : -1;
+
+    free(mappings);
+    free(stack);
+    free(temps);
+    bytecode_free(bc);
+    return gp;
+
+fail:
+    free(mappings);
+    free(stack);
+    free(temps);
+    gradient_program_free(gp);
+    bytecode_free(bc);
+    return NULL;
+}
+
+void gradient_program_free(GradientProgram *program) {
+    if (!program) return;
+    free(program->tape);
+    free(program);
+}
+
+int gradient_program_size(const GradientProgram *program) {
+    return program ? program->count : 0;
+}
+
+static double ad_forward(const TapeEntry *e, const double *v, const double *values, int var_count) {
+    switch (e->op) {
+        case BC_PUSH_NUM: return e->data.num;
+        case BC_PUSH_VAR:
+            return (e->data.slot >= 0 && e->data.slot < var_count) ? values[e->data.slot] : 0.0;
+        default:
+            return op_value(e->op, e->data.func, e->a >= 0 ? v[e->a] : 0.0, e->b >= 0 ? v[e->b] : 0.0);
+    }
+}
+
+double gradient_program_evaluate(const GradientProgram *program, const double *values, double *gradient) {
+    if (!program) return 0.0;
+    if (gradient) {
+        for (int i = 0; i < program->var_count; i++) gradient[i] = 0.0;
+    }
+    if (program->result < 0) return 0.0;
+
+    int n = program->count;
+    double local[1024];
+    double *v = (size_t)n * 2 <= sizeof(local) / sizeof(local[0]) ? local : malloc(sizeof(double) * 2 * n);
+    if (!v) return 0.0;
+    double *adj = v + n;
+    const TapeEntry *tape = program->tape;
+
+    for (int i = 0; i < n; i++) {
+        v[i] = ad_forward(&tape[i], v, values, program->var_count);
+    }
+    double result = v[program->result];
+
+    if (gradient) {
+        memset(adj, 0, sizeof(double) * n);
+        adj[program->result] = 1.0;
+        for (int i = program->result; i >= 0; i--) {
+            if (adj[i] == 0.0) continue;
+            if (tape[i].op == BC_PUSH_VAR) {
+                int slot = tape[i].data.slot;
+                if (slot >= 0 && slot < program->var_count) gradient[slot] += adj[i];
+            } else if (tape[i].a >= 0) {
+                double dx, dy;
+                op_partials(tape[i].op, tape[i].data.func, v[tape[i].a],
+                            tape[i].b >= 0 ? v[tape[i].b] : 0.0, v[i], &dx, &dy);
+                adj[tape[i].a] += adj[i] * dx;
+                if (tape[i].b >= 0) adj[tape[i].b] += adj[i] * dy;
+            }
+        }
+    }
+
+    if (v != local) free(v);
+    return result;
+}
+
 /* ============================================================================
  * SYMBOLIC OPERATIONS API
  * ============================================================================ */
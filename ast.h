@@ -13,6 +13,7 @@
 #define AST_H
 
 #include <stdbool.h>
+#include <stddef.h>
 #include "parser.h"
 
 /* AST Node Types */
@@ -71,12 +72,66 @@ typedef enum {
     OP_BROADCAST_MULTIPLY   /* Broadcasting multiplication */
 } MatrixOp;
 
+/* Built-in math functions, resolved from their names once when a call node
+ * is created so evaluators dispatch on an id instead of comparing strings.
+ */
+typedef enum {
+    FUNC_UNKNOWN = 0,
+    FUNC_RANDOM,            /* RANDOM(), RND() */
+    FUNC_ABS,
+    FUNC_ROUND,
+    FUNC_FLOOR,
+    FUNC_CEIL,
+    FUNC_SQRT,
+    FUNC_SIN,
+    FUNC_COS,
+    FUNC_TAN,
+    FUNC_ASIN,
+    FUNC_ACOS,
+    FUNC_ATAN,
+    FUNC_LOG,               /* LOG(), LN() */
+    FUNC_LOG10,
+    FUNC_EXP,
+    FUNC_INT,
+    FUNC_SGN,
+    FUNC_MIN,
+    FUNC_MAX,
+    FUNC_POW,
+    FUNC_ATAN2,
+    FUNC_MOD,
+    FUNC_COUNT
+} MathFunction;
+
+typedef struct {
+    const char *name;               /* Canonical upper-case name */
+    MathFunction id;
+    int arg_count;                  /* Required number of arguments */
+    double (*fn1)(double);          /* Kernel for one-argument functions */
+    double (*fn2)(double, double);  /* Kernel for two-argument functions */
+} MathFunctionInfo;
+
+/* Look up a function by upper-case name (aliases included); NULL if unknown */
+const MathFunctionInfo* math_function_lookup(const char *name);
+
+/* Table entry for an id; NULL for FUNC_UNKNOWN */
+const MathFunctionInfo* math_function_info(MathFunction id);
+
+/* Evaluate with ast_evaluate() semantics: domain errors give NaN/inf,
+ * unknown functions or a wrong argument count give 0.
+ */
+double math_function_eval(MathFunction id, const double *args, int arg_count);
+
 /* Forward declaration */
 typedef struct ASTNode ASTNode;
 
-/* AST Node structure */
+/* AST Node structure
+ * Names are interned (see ast_intern), so equal names share one pointer and
+ * a node is 32 bytes on 64-bit targets.
+ */
 struct ASTNode {
     ASTNodeType type;
+    bool in_arena;              /* Owned by an ASTArena: ast_free() leaves it alone */
+    bool consed;                /* Canonical node of an ASTDag: may have several parents */
     union {
         /* NUMBER */
         struct {
@@ -85,7 +140,7 @@ struct ASTNode {
 
         /* VARIABLE */
         struct {
-            char name[32];
+            const char *name;
         } variable;
 
         /* BINARY_OP */
@@ -103,9 +158,10 @@ struct ASTNode {
 
         /* FUNCTION_CALL */
         struct {
-            char name[32];
+            const char *name;
             ASTNode **args;
             int arg_count;
+            MathFunction id;    /* Resolved from name (FUNC_UNKNOWN if not built in) */
         } function;
 
         /* TENSOR */
@@ -126,9 +182,58 @@ ASTNode* ast_create_function_call(const char *name, ASTNode **args, int arg_coun
 void ast_free(ASTNode *node);
 ASTNode* ast_clone(const ASTNode *node);
 
+/* Uninitialized node of the given type, from the current arena or the heap
+ * (for node constructors outside ast.c) */
+ASTNode* ast_node_alloc(ASTNodeType type);
+
+/* Canonical copy of a name, valid for the life of the process. Equal
+ * strings give the same pointer. Thread-safe. */
+const char* ast_intern(const char *name);
+
+/* AST Arenas
+ * While an arena is pushed on a thread, every node that thread creates
+ * (ast_create_*, ast_clone, the parser, symbolic operations) is carved out
+ * of it instead of malloc'd, and ast_free() on those nodes does nothing.
+ * Destroying or resetting the arena frees all of its trees at once, in
+ * time proportional to the number of memory chunks, not nodes. A tree
+ * built in an arena must not link nodes owned by anything else.
+ *
+ *   ASTArena *arena = ast_arena_create();
+ *   ASTArena *previous = ast_arena_push(arena);
+ *   ASTNode *d = ast_simplify(ast_differentiate(f, "X"));
+ *   ...
+ *   ast_arena_pop(previous);
+ *   ast_arena_destroy(arena);     // frees d and all intermediates
+ */
+typedef struct ASTArena ASTArena;
+
+ASTArena* ast_arena_create(void);
+void ast_arena_destroy(ASTArena *arena);
+void ast_arena_reset(ASTArena *arena);          /* Free all trees, keep the memory */
+
+/* Make arena current for this thread; returns the previously current one */
+ASTArena* ast_arena_push(ASTArena *arena);
+void ast_arena_pop(ASTArena *previous);         /* Restore what push returned */
+
+size_t ast_arena_node_count(const ASTArena *arena);
+size_t ast_arena_bytes_used(const ASTArena *arena);
+
 /* AST Evaluation */
 double ast_evaluate(const ASTNode *node, VarContext *vars);
 
+/* Dual numbers: a value with its derivative along one variable, so one
+ * evaluation gives f and df/dx. The variable is the vars->values slot
+ * seed_slot (as the name resolves through vars); other variables are
+ * constants. Values match ast_evaluate(); derivatives follow the same
+ * conventions as gradient_program_evaluate().
+ */
+typedef struct {
+    double value;
+    double deriv;
+} Dual;
+
+Dual ast_evaluate_dual(const ASTNode *node, VarContext *vars, int seed_slot);
+
 /* AST Printing */
 void ast_print(const ASTNode *node);
 char* ast_to_string(const ASTNode *node);
@@ -146,7 +251,8 @@ ASTNode* ast_integrate(const ASTNode *node, const char *var_name);
 /* Numerical Integration */
 typedef enum {
     INTEGRATE_TRAPEZOIDAL,
-    INTEGRATE_SIMPSON
+    INTEGRATE_SIMPSON,
+    INTEGRATE_GAUSS_KRONROD     /* Adaptive, tolerance 1e-10; steps caps the subintervals */
 } IntegrationMethod;
 
 /* Numerical integration using trapezoidal rule */
@@ -167,6 +273,28 @@ double ast_integrate_numerical_simpson(
     int steps
 );
 
+/* Adaptive Gauss-Kronrod integration
+ * Integrates with the 15-point Kronrod rule, using the embedded 7-point
+ * Gauss rule for each subinterval's error estimate, and bisects the
+ * subintervals with the largest errors until the total estimate is within
+ * max(abs_tol, rel_tol * |value|) or max_intervals (<= 0: 1000) is reached.
+ * Smooth integrands usually converge on a handful of subintervals.
+ *
+ * All numerical integrators compile the integrand once, evaluate sample
+ * points in batches (vm_execute_batch) and spread large batches over the
+ * shared thread pool. Results do not depend on the number of threads.
+ */
+typedef struct {
+    double value;
+    double error_estimate;      /* Estimated absolute error */
+    int evaluations;            /* Integrand evaluations */
+    int intervals;              /* Subintervals in the final partition */
+    bool converged;             /* error_estimate met the tolerance */
+} IntegrationResult;
+
+IntegrationResult ast_integrate_adaptive(const ASTNode *expr, const char *var_name, double a, double b,
+                                         double abs_tol, double rel_tol, int max_intervals);
+
 /* General numerical integration with method selection */
 double ast_integrate_numerical(
     const ASTNode *expr,
@@ -177,19 +305,94 @@ double ast_integrate_numerical(
     IntegrationMethod method
 );
 
+/* Multi-dimensional integration over the box lower[d] <= var_names[d] <= upper[d]
+ * for 1 <= dims <= INTEGRATE_MAX_DIMS, stopping once the error estimate is
+ * within max(abs_tol, rel_tol * |value|) or the next step would exceed
+ * max_evaluations (<= 0: 1000000).
+ *
+ * CUBATURE_ADAPTIVE applies the degree-7 Genz-Malik rule (2^dims + 2dims^2
+ * + 2dims + 1 points, error from its embedded degree-5 rule) and bisects
+ * the worst regions along the axis with the largest fourth difference;
+ * intervals is the final number of regions. Best for smooth integrands in
+ * up to about 6 dimensions. With dims == 1 it is ast_integrate_adaptive().
+ *
+ * CUBATURE_SOBOL averages CUBATURE_SOBOL_REPLICATES randomly shifted Sobol
+ * sequences, doubling the points until the replicates' standard error is
+ * small enough; intervals is the points per replicate. Its error shrinks
+ * close to 1/N whatever the dimension, so prefer it in high dimensions or
+ * for non-smooth integrands. The shifts come from a fixed seed: results
+ * are reproducible.
+ *
+ * Both evaluate in batches on the shared thread pool and do not depend on
+ * the number of threads.
+ */
+#define INTEGRATE_MAX_DIMS 10
+#define CUBATURE_SOBOL_REPLICATES 8
+
+typedef enum {
+    CUBATURE_ADAPTIVE,
+    CUBATURE_SOBOL
+} CubatureMethod;
+
+IntegrationResult ast_integrate_multi(const ASTNode *expr, const char *const *var_names,
+                                      const double *lower, const double *upper, int dims,
+                                      double abs_tol, double rel_tol, int max_evaluations,
+                                      CubatureMethod method);
+
+/* Hash-Consed Expression DAGs
+ * An ASTDag builds every node through a hash-consing factory, so
+ * structurally identical subexpressions are a single shared node and equal
+ * nodes compare equal by pointer. The factory also applies ast_simplify()'s
+ * local rules as nodes are built (constant folding, x+0, x*1, x*0, x^1,
+ * a*t + b*t, --x, ...). Derivatives are memoized per (node, variable), so
+ * repeated and higher-order differentiation reuses earlier results and
+ * derivative DAGs grow linearly where trees grow exponentially.
+ *
+ * DAG nodes belong to the DAG: ast_free() ignores them, they must not be
+ * modified (ast_simplify() works in place: clone first), and they live
+ * until ast_dag_destroy(). ast_compile() keeps the sharing, computing each
+ * shared node once into a temporary; ast_evaluate() and ast_to_string()
+ * still see the expanded tree.
+ */
+typedef struct ASTDag ASTDag;
+
+ASTDag* ast_dag_create(void);
+void ast_dag_destroy(ASTDag *dag);
+
+ASTNode* ast_dag_number(ASTDag *dag, double value);
+ASTNode* ast_dag_variable(ASTDag *dag, const char *name);
+ASTNode* ast_dag_binary_op(ASTDag *dag, BinaryOp op, ASTNode *left, ASTNode *right);
+ASTNode* ast_dag_unary_op(ASTDag *dag, UnaryOp op, ASTNode *operand);
+ASTNode* ast_dag_function_call(ASTDag *dag, const char *name, ASTNode **args, int arg_count);
+
+/* Canonical, simplified copy of a tree (or of another DAG's nodes) */
+ASTNode* ast_dag_simplify(ASTDag *dag, const ASTNode *node);
+
+/* d(node)/d(var_name), memoized; node may be a tree or from any DAG */
+ASTNode* ast_dag_differentiate(ASTDag *dag, const ASTNode *node, const char *var_name);
+
+size_t ast_dag_node_count(const ASTDag *dag);
+
 /* Partial Derivatives & Gradient */
 
 /* Compute partial derivative ∂f/∂var (alias for ast_differentiate for clarity) */
 ASTNode* ast_partial_derivative(const ASTNode *node, const char *var_name);
 
+typedef struct GradientCode GradientCode;
+
 /* Gradient vector structure */
 typedef struct {
     ASTNode **components;  /* Array of partial derivatives */
     int count;             /* Number of components */
     char **var_names;      /* Variable names for reference */
+    ASTDag *dag;           /* Owns the components, which share subexpressions */
+    GradientCode *code;    /* Components compiled for gradient_evaluate() */
 } Gradient;
 
-/* Compute gradient vector ∇f = [∂f/∂x₁, ∂f/∂x₂, ...] */
+/* Compute gradient vector ∇f = [∂f/∂x₁, ∂f/∂x₂, ...]
+ * The components are simplified nodes of one ASTDag (see above), so they
+ * share f's subexpressions and each other's; gradient_free() releases them.
+ */
 Gradient ast_gradient(const ASTNode *node, const char **var_names, int var_count);
 
 /* Free gradient structure */
@@ -240,9 +443,25 @@ typedef struct {
     char error_message[256];
 } NumericalSolveResult;
 
+/* f and f' come from one dual-number evaluation of the compiled equation
+ * per step, so any built-in function can appear in it.
+ */
 NumericalSolveResult ast_solve_numerical(ASTNode *equation, const char *var_name,
                                           double initial_guess, double tolerance, int max_iterations);
 
+/* Solve count problems at once: problem i starts from initial_guesses[i]
+ * and, when param_name is not NULL, binds param_name to params[i]. The
+ * equation is compiled once and problems step in lockstep blocks of
+ * VM_BATCH_BLOCK, each evaluation covering the whole block. results[i]
+ * gets what ast_solve_numerical() would give for problem i.
+ * Returns 0, or -1 on invalid input or allocation failure.
+ */
+int ast_solve_numerical_batch(const ASTNode *equation, const char *var_name,
+                              const char *param_name, const double *params,
+                              const double *initial_guesses, size_t count,
+                              double tolerance, int max_iterations,
+                              NumericalSolveResult *results);
+
 /* ============================================================================
  * OPTIMIZATION ENGINE
  * ============================================================================ */
@@ -272,6 +491,12 @@ typedef struct {
 
     /* Conjugate gradient specific */
     int restart_iterations;    /* Restart CG every N iterations (0 = no restart) */
+
+    /* Gradients come from reverse-mode AD over the compiled objective
+     * (see gradient_program_create); set this to evaluate the symbolic
+     * ast_gradient() components instead.
+     */
+    bool symbolic_gradient;
 } OptimizerConfig;
 
 /* Optimization result */
@@ -404,6 +629,8 @@ typedef enum {
     BC_EQUAL,
     BC_NOT_EQUAL,
     BC_CALL_FUNC,     /* Call function with N args */
+    BC_STORE_TEMP,    /* Copy top of stack into a temporary (stays on the stack) */
+    BC_LOAD_TEMP,     /* Push a temporary */
     BC_HALT
 } BytecodeOp;
 
@@ -411,23 +638,102 @@ typedef struct {
     BytecodeOp op;
     union {
         double num;
-        int var_index;
+        int temp;           /* Temporary for STORE_TEMP/LOAD_TEMP */
+        struct {
+            int index;      /* Slot in VarContext.values (-1: unbound, reads 0) */
+            int symbol;     /* Entry in Bytecode.var_names */
+        } var;
         struct {
-            char name[32];
+            MathFunction id;
             int arg_count;
         } func;
     } data;
 } BytecodeInstruction;
 
+/* Register code: ast_compile() translates the stack program into
+ * three-address instructions over a register file whose size is known at
+ * compile time, so vm_execute() needs no stack pointer or bounds checks.
+ * Constant right operands are folded into the *_K forms, and known
+ * functions are resolved to C function pointers.
+ */
+typedef enum {
+    REG_LOAD_K,       /* dst = k */
+    REG_LOAD_VAR,     /* dst = vars[var_index] */
+    REG_MOVE,         /* dst = a */
+    REG_ADD,          /* dst = a op b */
+    REG_SUBTRACT,
+    REG_MULTIPLY,
+    REG_DIVIDE,
+    REG_POWER,
+    REG_AND,
+    REG_OR,
+    REG_GREATER,
+    REG_LESS,
+    REG_GREATER_EQ,
+    REG_LESS_EQ,
+    REG_EQUAL,
+    REG_NOT_EQUAL,
+    REG_ADD_K,        /* dst = a op k */
+    REG_SUBTRACT_K,
+    REG_MULTIPLY_K,
+    REG_DIVIDE_K,
+    REG_POWER_K,
+    REG_NEGATE,       /* dst = op a */
+    REG_NOT,
+    REG_CALL1,        /* dst = fn1(a) */
+    REG_CALL2,        /* dst = fn2(a, a+1) */
+    REG_CALLN,        /* dst = func(a .. a+b-1) */
+    REG_HALT          /* return a */
+} RegOp;
+
+typedef struct {
+    unsigned short op;
+    unsigned short dst;
+    unsigned short a;
+    unsigned short b;
+    union {
+        double k;
+        int var_index;
+        double (*fn1)(double);
+        double (*fn2)(double, double);
+        MathFunction func;
+    } data;
+} RegInstruction;
+
 typedef struct {
     BytecodeInstruction *instructions;
     int count;
     int capacity;
+    RegInstruction *reg_code;   /* NULL for hand-built programs (stack VM runs them) */
+    int reg_count;              /* Number of register instructions */
+    int register_count;         /* Register file size */
+    char **var_names;           /* Symbol table: distinct variable names */
+    int var_count;
+    int temp_count;             /* Temporaries used by STORE_TEMP/LOAD_TEMP */
 } Bytecode;
 
-/* Bytecode Compilation */
+/* Bytecode Compilation
+ * Variables are bound to VarContext value slots at compile time, by default
+ * single letters A-Z to slots 0-25 (other names are unbound and read 0).
+ *
+ * ast_compile() optimizes before emitting code: constants are folded with
+ * the VM's semantics, x^2 becomes x*x (and x^1, x*1, x/1, x-0, --x become
+ * x), and repeated subexpressions are computed once into temporaries.
+ * Results are unchanged. With DEBUG_OPTIMIZE set, instruction counts before
+ * and after are reported through the debug output.
+ */
 Bytecode* ast_compile(const ASTNode *node);
+
+/* Emit bytecode straight from the tree, one instruction per node */
+Bytecode* ast_compile_unoptimized(const ASTNode *node);
 void bytecode_free(Bytecode *bc);
+
+/* Rebind every variable name to a slot of layout->values, resolving names
+ * through layout->mappings (or single letters when mappings is NULL) once,
+ * so evaluation is a plain indexed load. NULL restores the default binding.
+ * Returns the number of names left unbound, or -1 on error.
+ */
+int bytecode_bind(Bytecode *bc, const VarContext *layout);
 void bytecode_print(const Bytecode *bc);
 
 /* Bytecode VM Execution */
@@ -440,19 +746,202 @@ typedef struct {
 
 VM* vm_create(VarContext *vars);
 void vm_free(VM *vm);
+
+/* Execute a program: runs the register code when present, else the stack
+ * interpreter. Allocates nothing for programs of up to VM_MAX_REGISTERS.
+ */
+#define VM_MAX_REGISTERS 256
 double vm_execute(VM *vm, const Bytecode *bc);
 
+/* Reference stack interpreter over bc->instructions */
+double vm_execute_stack(VM *vm, const Bytecode *bc);
+
+/* Run bc on dual numbers: the variable bound to slot seed_slot carries
+ * derivative 1 (see ast_evaluate_dual). Allocates nothing for programs
+ * of up to VM_MAX_REGISTERS stack entries and temporaries.
+ */
+Dual vm_execute_dual(const Bytecode *bc, const VarContext *vars, int seed_slot);
+
+/* Batched columnar execution
+ * Evaluates bc once per row for row_count rows. Variables are read from
+ * structure-of-arrays columns: columns[i] holds row_count values for
+ * variable slot i (the BC_PUSH_VAR index, A=0, B=1, ...). Slots beyond
+ * column_count or with a NULL column read as 0, like vm_execute().
+ * Rows are processed in blocks of VM_BATCH_BLOCK lanes.
+ * Returns 0 on success, -1 on invalid input or allocation failure.
+ */
+#define VM_BATCH_BLOCK 256
+
+int vm_execute_batch(const Bytecode *bc, const double *const *columns, int column_count,
+                     size_t row_count, double *out);
+
+/* Evaluation Budgets
+ * A budget bounds evaluation by operation count and wall time without
+ * reading the clock at every step: evaluators charge the operations they
+ * are about to perform, and the monotonic clock (clock_gettime, a vDSO
+ * call on Linux) is read only once every EVAL_BUDGET_CHECK_INTERVAL
+ * operations (or the interval given to eval_budget_init_interval()). One
+ * budget can be carried through several calls (the parser,
+ * vm_execute_budget, batches); once a limit is hit it stays exhausted. A
+ * budget belongs to one thread.
+ */
+#define EVAL_BUDGET_CHECK_INTERVAL 4096
+
+typedef enum {
+    EVAL_BUDGET_OK,
+    EVAL_BUDGET_OPERATIONS,     /* max_operations reached */
+    EVAL_BUDGET_TIMEOUT         /* Deadline passed */
+} EvalBudgetStatus;
+
+typedef struct {
+    unsigned long max_operations;   /* 0: unlimited */
+    long long deadline_ns;          /* CLOCK_MONOTONIC, 0: none */
+    unsigned long spent;            /* Operations before the current window */
+    unsigned long window;           /* Operations granted at the last check */
+    unsigned long remaining;        /* Left in the window */
+    unsigned long check_interval;   /* Operations between clock reads */
+    EvalBudgetStatus status;
+} EvalBudget;
+
+/* Start a budget: timeout_ms from now (0: none), max_operations (0: unlimited) */
+void eval_budget_init(EvalBudget *budget, long timeout_ms, unsigned long max_operations);
+
+/* Same, reading the clock every check_interval operations: for evaluators
+ * whose operations are much costlier than a VM instruction */
+void eval_budget_init_interval(EvalBudget *budget, long timeout_ms, unsigned long max_operations,
+                               unsigned long check_interval);
+
+/* Slow path of eval_budget_charge(): checks the limits and opens a new window */
+bool eval_budget_refill(EvalBudget *budget, unsigned long operations);
+
+/* Operations charged so far */
+unsigned long eval_budget_operations(const EvalBudget *budget);
+
+/* Charge operations about to be performed; false once the budget is exhausted */
+static inline bool eval_budget_charge(EvalBudget *budget, unsigned long operations) {
+    if (operations < budget->remaining) {
+        budget->remaining -= operations;
+        return true;
+    }
+    return eval_budget_refill(budget, operations);
+}
+
+/* Run bc unless its instructions exceed the budget. Returns false, without
+ * running, once the budget is exhausted.
+ */
+bool vm_execute_budget(VM *vm, const Bytecode *bc, EvalBudget *budget, double *result);
+
+/* vm_execute_batch() charging each block of rows to budget (NULL: none).
+ * Returns 0 when all rows were evaluated, 1 when the budget ran out (the
+ * first *rows_done rows of out are filled), -1 on error.
+ */
+int vm_execute_batch_budget(const Bytecode *bc, const double *const *columns, int column_count,
+                            size_t row_count, double *out, EvalBudget *budget, size_t *rows_done);
+
+/* Native code for register programs (jit.c). x86-64 only: elsewhere, or
+ * when built with -DFLUXPARSER_NO_JIT, jit_compile() returns NULL and
+ * callers keep using the VM.
+ */
+typedef struct JitCode JitCode;
+
+bool jit_supported(void);
+JitCode* jit_compile(const Bytecode *bc);
+void jit_free(JitCode *jit);
+size_t jit_code_size(const JitCode *jit);
+
+/* Run native code. Returns false without running when vars do not cover
+ * every slot the program reads (the VM reads those as 0).
+ */
+bool jit_execute(const JitCode *jit, const VarContext *vars, double *result);
+
 /* High-level API */
 typedef struct {
     ASTNode *ast;
     Bytecode *bytecode;
     char *original_expr;
+    int slot_count;         /* Values expected by prepared_expression_evaluate() */
+    JitCode *jit;           /* Native code, NULL until compiled_expression_jit() */
 } CompiledExpression;
 
+/* Parse an expression string into an AST without evaluating it.
+ * Identifiers not followed by '(' become AST_VARIABLE nodes (upper-cased,
+ * like the evaluating parser); PI and E are folded to numbers.
+ * Returns NULL on error and fills *error if provided.
+ */
+ASTNode* parse_expression_ast(const char *expr, ParserErrorInfo *error);
+
+/* Parse once into an AST and bytecode for repeated evaluation.
+ * Returns NULL if the expression does not parse.
+ */
 CompiledExpression* compile_expression(const char *expr);
+
+/* Compile an already-built AST; takes ownership of ast. expr is kept as
+ * the original text.
+ */
+CompiledExpression* compiled_expression_from_ast(const char *expr, ASTNode *ast);
 void compiled_expression_free(CompiledExpression *ce);
 double compiled_expression_evaluate(CompiledExpression *ce, VarContext *vars);
 
+/* Compile the expression to native code; later evaluations run it.
+ * Returns 0 if native code is in use, -1 if evaluation stays on the VM.
+ */
+int compiled_expression_jit(CompiledExpression *ce);
+
+/* Prepared expressions: compile once with variable names bound to slots,
+ * var_names[i] -> values[i] (matched case-insensitively, any length).
+ * Returns NULL and fills *error on a parse error or a name not in var_names.
+ * PI and E are constants, not variables.
+ */
+CompiledExpression* prepare_expression(const char *expr, const char *const *var_names,
+                                       int var_count, ParserErrorInfo *error);
+
+/* Evaluate a prepared expression; values holds one entry per var_names entry */
+double prepared_expression_evaluate(const CompiledExpression *ce, const double *values);
+
+/* Rebind a compiled expression to a VarContext layout (see bytecode_bind) */
+int compiled_expression_bind(CompiledExpression *ce, const VarContext *layout);
+
+/* Evaluate a compiled expression over row_count rows of column data
+ * (see vm_execute_batch). Returns 0 on success, -1 on error.
+ */
+int compiled_expression_evaluate_batch(CompiledExpression *ce, const double *const *columns,
+                                       int column_count, size_t row_count, double *out);
+
+/* Budgeted forms (see Evaluation Budgets): compiled_expression_evaluate()
+ * unless the program's instructions exceed the budget, and the batch
+ * charged block by block as in vm_execute_batch_budget().
+ */
+bool compiled_expression_evaluate_budget(CompiledExpression *ce, VarContext *vars, EvalBudget *budget,
+                                         double *result);
+int compiled_expression_evaluate_batch_budget(CompiledExpression *ce, const double *const *columns,
+                                              int column_count, size_t row_count, double *out,
+                                              EvalBudget *budget, size_t *rows_done);
+
+/* Reverse-Mode Differentiation
+ * A gradient program records the optimized code of expr (folded, with
+ * shared subexpressions computed once) as a tape, so one forward pass and
+ * one backward sweep give f and all of its partial derivatives, at a small
+ * constant multiple of the cost of evaluating f. var_names[i] reads
+ * values[i] and receives gradient[i]; names match exactly, as in
+ * ast_evaluate(), and any other variable reads 0.
+ *
+ * Derivatives follow the evaluator's conventions: where it divides by
+ * zero (giving 0) the derivative is 0, piecewise-constant functions
+ * (ROUND, FLOOR, CEIL, INT, SGN), comparisons and logic have zero
+ * derivative, and ABS, MIN and MAX use the branch that was taken.
+ * Evaluation does not modify the program, so threads may share one.
+ */
+typedef struct GradientProgram GradientProgram;
+
+GradientProgram* gradient_program_create(const ASTNode *expr, const char *const *var_names, int var_count);
+void gradient_program_free(GradientProgram *program);
+
+/* Number of tape entries (values computed per evaluation) */
+int gradient_program_size(const GradientProgram *program);
+
+/* Returns f(values); fills gradient[0..var_count-1] unless it is NULL */
+double gradient_program_evaluate(const GradientProgram *program, const double *values, double *gradient);
+
 /* Symbolic Operations */
 char* differentiate_expression(const char *expr, const char *var_name);
 char* simplify_expression(const char *expr);
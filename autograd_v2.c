@@ -5,6 +5,7 @@
 #include "autograd_v2.h"
 #include "arena.h"
 #include "blas_wrapper.h"
+#include "threadpool.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -17,6 +18,136 @@ static int g_use_blas = 1;  /* Enabled by default if available */
 /* Global state */
 TapeV2 *g_tape = NULL;
 
+/* Worker pool for the tensor kernels; NULL runs them on the calling thread */
+static ThreadPool *g_pool = NULL;
+
+/* ============================================================================
+ * PARALLEL LOOPS
+ * ============================================================================ */
+
+/* Elements a range should cover before it is worth handing to a worker */
+#define PARALLEL_GRAIN 16384
+
+typedef struct {
+    ParallelRangeFunc body;
+    void *arg;
+    int count;
+    int chunk;
+} RangeLoop;
+
+static void run_range(void *arg, size_t index) {
+    RangeLoop *loop = (RangeLoop*)arg;
+    int begin = (int)index * loop->chunk;
+    int end = loop->count - begin < loop->chunk ? loop->count : begin + loop->chunk;
+    loop->body(loop->arg, begin, end);
+}
+
+void autograd_parallel_for(int count, int cost, ParallelRangeFunc body, void *arg) {
+    if (count <= 0) return;
+
+    int threads = thread_pool_size(g_pool);
+    int grain = (cost > 0 && cost < PARALLEL_GRAIN) ? PARALLEL_GRAIN / cost : 1;
+    if (threads == 1 || count < 2 * grain) {
+        body(arg, 0, count);
+        return;
+    }
+
+    /* A few ranges per thread even out uneven progress */
+    int chunk = (count + threads * 4 - 1) / (threads * 4);
+    if (chunk < grain) chunk = grain;
+    RangeLoop loop = {body, arg, count, chunk};
+    thread_pool_for(g_pool, (size_t)((count + chunk - 1) / chunk), run_range, &loop);
+}
+
+/* Elementwise kernels: out[i] op= a[i] (op b[i]) over [begin, end) */
+typedef struct {
+    double *out;
+    const double *a;
+    const double *b;
+    double scale;
+} Elementwise;
+
+static void add_range(void *arg, int begin, int end) {
+    Elementwise *e = (Elementwise*)arg;
+    for (int i = begin; i < end; i++) e->out[i] = e->a[i] + e->b[i];
+}
+
+static void subtract_range(void *arg, int begin, int end) {
+    Elementwise *e = (Elementwise*)arg;
+    for (int i = begin; i < end; i++) e->out[i] = e->a[i] - e->b[i];
+}
+
+static void multiply_range(void *arg, int begin, int end) {
+    Elementwise *e = (Elementwise*)arg;
+    for (int i = begin; i < end; i++) e->out[i] = e->a[i] * e->b[i];
+}
+
+static void relu_range(void *arg, int begin, int end) {
+    Elementwise *e = (Elementwise*)arg;
+    for (int i = begin; i < end; i++) e->out[i] = e->a[i] > 0 ? e->a[i] : 0;
+}
+
+static void accumulate_range(void *arg, int begin, int end) {
+    Elementwise *e = (Elementwise*)arg;
+    for (int i = begin; i < end; i++) e->out[i] += e->a[i];
+}
+
+static void accumulate_product_range(void *arg, int begin, int end) {
+    Elementwise *e = (Elementwise*)arg;
+    for (int i = begin; i < end; i++) e->out[i] += e->a[i] * e->b[i];
+}
+
+/* ReLU backward: a is the incoming gradient, b the ReLU input */
+static void accumulate_where_positive_range(void *arg, int begin, int end) {
+    Elementwise *e = (Elementwise*)arg;
+    for (int i = begin; i < end; i++) {
+        if (e->b[i] > 0) e->out[i] += e->a[i];
+    }
+}
+
+static void subtract_scaled_range(void *arg, int begin, int end) {
+    Elementwise *e = (Elementwise*)arg;
+    for (int i = begin; i < end; i++) e->out[i] -= e->scale * e->a[i];
+}
+
+static void elementwise(ParallelRangeFunc body, double *out, const double *a, const double *b, int size) {
+    Elementwise e = {out, a, b, 0.0};
+    autograd_parallel_for(size, 1, body, &e);
+}
+
+/* Softmax over rows of length dim: out = softmax(in), or for backward
+ * out += J^T grad with J the Jacobian at the softmax output in */
+typedef struct {
+    double *out;
+    const double *in;
+    const double *grad;
+    int dim;
+} SoftmaxRows;
+
+static void softmax_range(void *arg, int begin, int end) {
+    SoftmaxRows *s = (SoftmaxRows*)arg;
+    int dim = s->dim;
+    for (int b = begin; b < end; b++) {
+        const double *x = s->in + (size_t)b * dim;
+        double *y = s->out + (size_t)b * dim;
+
+        double max_val = x[0];
+        for (int i = 1; i < dim; i++) {
+            if (x[i] > max_val) max_val = x[i];
+        }
+
+        double sum = 0.0;
+        for (int i = 0; i < dim; i++) {
+            y[i] = exp(x[i] - max_val);
+            sum += y[i];
+        }
+
+        for (int i = 0; i < dim; i++) {
+            y[i] /= sum;
+        }
+    }
+}
+
 /* ============================================================================
  * TENSOR V2 IMPLEMENTATION
  * ============================================================================ */
@@ -38,6 +169,9 @@ TensorV2* tensor_create_persistent(const int *shape, int rank) {
     t->rank = rank;
     t->size = calculate_size(shape, rank);
     t->storage = TENSOR_PERSISTENT;
+    t->version = 0;
+    t->strides = NULL;
+    t->base = NULL;
 
     t->shape = malloc(rank * sizeof(int));
     memcpy(t->shape, shape, rank * sizeof(int));
@@ -64,6 +198,9 @@ TensorV2* tensor_create_temp(const int *shape, int rank) {
     t->rank = rank;
     t->size = calculate_size(shape, rank);
     t->storage = TENSOR_TEMPORARY;
+    t->version = 0;
+    t->strides = NULL;
+    t->base = NULL;
 
     t->shape = arena_alloc(global_arena, rank * sizeof(int));
     memcpy(t->shape, shape, rank * sizeof(int));
@@ -105,6 +242,29 @@ TensorV2* tensor_randn_persistent(const int *shape, int rank, double scale) {
     return t;
 }
 
+/* Row-major copy of a strided view */
+static void copy_strided(const TensorV2 *t, double *out) {
+    if (t->rank == 2 && t->strides[0] == 1 && t->strides[1] == t->shape[0]) {
+        /* Transposed row-major matrix */
+        transpose_optimized(t->data, out, t->shape[1], t->shape[0], g_use_blas);
+        return;
+    }
+
+    int index[t->rank];
+    memset(index, 0, sizeof(index));
+    for (int i = 0; i < t->size; i++) {
+        size_t offset = 0;
+        for (int d = 0; d < t->rank; d++) {
+            offset += (size_t)index[d] * t->strides[d];
+        }
+        out[i] = t->data[offset];
+
+        for (int d = t->rank - 1; d >= 0 && ++index[d] == t->shape[d]; d--) {
+            index[d] = 0;
+        }
+    }
+}
+
 /* Clone tensor to temporary */
 TensorV2* tensor_clone_temp(const TensorV2 *src) {
     if (!src) return NULL;
@@ -112,10 +272,23 @@ TensorV2* tensor_clone_temp(const TensorV2 *src) {
     TensorV2 *t = tensor_create_temp(src->shape, src->rank);
     if (!t) return NULL;
 
-    memcpy(t->data, src->data, src->size * sizeof(double));
+    if (src->strides) {
+        copy_strided(src, t->data);
+    } else {
+        memcpy(t->data, src->data, src->size * sizeof(double));
+    }
     return t;
 }
 
+/* Tensor owning t's data, whose version in-place writes bump */
+static TensorV2* tensor_storage(const TensorV2 *t) {
+    return t->base ? t->base : (TensorV2*)t;
+}
+
+void tensor_mark_modified(TensorV2 *t) {
+    tensor_storage(t)->version++;
+}
+
 /* Free persistent tensor */
 void tensor_free_persistent(TensorV2 *t) {
     if (!t || t->storage != TENSOR_PERSISTENT) return;
@@ -125,39 +298,91 @@ void tensor_free_persistent(TensorV2 *t) {
     free(t);
 }
 
+/* Temp tensor over t's data; strides NULL or row-major for a plain layout */
+static TensorV2* tensor_view(const TensorV2 *t, const int *shape, int rank, const int *strides) {
+    if (!global_arena) {
+        arena_init_global();
+    }
+
+    TensorV2 *view = arena_alloc(global_arena, sizeof(TensorV2));
+    view->data = t->data;
+    view->rank = rank;
+    view->size = calculate_size(shape, rank);
+    view->storage = TENSOR_TEMPORARY;
+    view->version = 0;
+    view->base = tensor_storage(t);
+
+    view->shape = arena_alloc(global_arena, rank * sizeof(int));
+    memcpy(view->shape, shape, rank * sizeof(int));
+
+    /* Strides are kept only where they differ from row-major */
+    view->strides = NULL;
+    int row_major = 1;
+    for (int d = rank - 1; strides && d >= 0; d--) {
+        if (shape[d] != 1 && strides[d] != row_major) {
+            view->strides = arena_alloc(global_arena, rank * sizeof(int));
+            memcpy(view->strides, strides, rank * sizeof(int));
+            break;
+        }
+        row_major *= shape[d];
+    }
+    return view;
+}
+
+bool tensor_is_contiguous(const TensorV2 *t) {
+    return t->strides == NULL;
+}
+
+const TensorV2* tensor_contiguous(const TensorV2 *t) {
+    if (!t->strides) return t;
+    return tensor_clone_temp(t);
+}
+
+TensorV2* tensor_reshape(const TensorV2 *t, const int *shape, int rank) {
+    assert(calculate_size(shape, rank) == t->size);
+    return tensor_view(tensor_contiguous(t), shape, rank, NULL);
+}
+
 /* Tensor addition */
 TensorV2* tensor_add(const TensorV2 *a, const TensorV2 *b) {
     assert(a->size == b->size);
+    a = tensor_contiguous(a);
+    b = tensor_contiguous(b);
 
     TensorV2 *result = tensor_create_temp(a->shape, a->rank);
-    for (int i = 0; i < a->size; i++) {
-        result->data[i] = a->data[i] + b->data[i];
-    }
+    elementwise(add_range, result->data, a->data, b->data, a->size);
     return result;
 }
 
 /* Tensor subtraction */
 TensorV2* tensor_subtract(const TensorV2 *a, const TensorV2 *b) {
     assert(a->size == b->size);
+    a = tensor_contiguous(a);
+    b = tensor_contiguous(b);
 
     TensorV2 *result = tensor_create_temp(a->shape, a->rank);
-    for (int i = 0; i < a->size; i++) {
-        result->data[i] = a->data[i] - b->data[i];
-    }
+    elementwise(subtract_range, result->data, a->data, b->data, a->size);
     return result;
 }
 
 /* Element-wise multiplication */
 TensorV2* tensor_multiply(const TensorV2 *a, const TensorV2 *b) {
     assert(a->size == b->size);
+    a = tensor_contiguous(a);
+    b = tensor_contiguous(b);
 
     TensorV2 *result = tensor_create_temp(a->shape, a->rank);
-    for (int i = 0; i < a->size; i++) {
-        result->data[i] = a->data[i] * b->data[i];
-    }
+    elementwise(multiply_range, result->data, a->data, b->data, a->size);
     return result;
 }
 
+/* A 2-D operand as matmul_optimized_ex() reads it: row-major, or the
+ * transposed view of a row-major matrix; other layouts are copied */
+static const double* gemm_operand(const TensorV2 *t, int *transposed) {
+    *transposed = t->strides && t->strides[0] == 1 && t->strides[1] == t->shape[0];
+    return *transposed ? t->data : tensor_contiguous(t)->data;
+}
+
 /* Matrix multiplication */
 TensorV2* tensor_matmul(const TensorV2 *a, const TensorV2 *b) {
     assert(a->rank == 2 && b->rank == 2);
@@ -171,35 +396,34 @@ TensorV2* tensor_matmul(const TensorV2 *a, const TensorV2 *b) {
     TensorV2 *result = tensor_create_temp(shape, 2);
 
     /* Use optimized BLAS if available, otherwise fallback to pure C */
-    matmul_optimized(a->data, b->data, result->data, m, k, n, g_use_blas);
+    int trans_a, trans_b;
+    const double *A = gemm_operand(a, &trans_a);
+    const double *B = gemm_operand(b, &trans_b);
+    matmul_optimized_ex(A, B, result->data, m, k, n, trans_a, trans_b, 0, g_use_blas);
 
     return result;
 }
 
-/* Transpose (2D only) */
+/* Transpose (2D only): a view with the strides swapped */
 TensorV2* tensor_transpose(const TensorV2 *a) {
     assert(a->rank == 2);
 
     int shape[] = {a->shape[1], a->shape[0]};
-    TensorV2 *result = tensor_create_temp(shape, 2);
-
-    /* Use optimized transpose */
-    transpose_optimized(a->data, result->data, a->shape[0], a->shape[1], g_use_blas);
-
-    return result;
+    int strides[] = {a->strides ? a->strides[1] : 1, a->strides ? a->strides[0] : a->shape[1]};
+    return tensor_view(a, shape, 2, strides);
 }
 
 /* ReLU activation */
 TensorV2* tensor_relu(const TensorV2 *x) {
+    x = tensor_contiguous(x);
     TensorV2 *result = tensor_create_temp(x->shape, x->rank);
-    for (int i = 0; i < x->size; i++) {
-        result->data[i] = x->data[i] > 0 ? x->data[i] : 0;
-    }
+    elementwise(relu_range, result->data, x->data, NULL, x->size);
     return result;
 }
 
 /* Softmax (assumes last dimension) */
 TensorV2* tensor_softmax(const TensorV2 *x) {
+    x = tensor_contiguous(x);
     TensorV2 *result = tensor_create_temp(x->shape, x->rank);
 
     if (x->rank == 1) {
@@ -220,29 +444,8 @@ TensorV2* tensor_softmax(const TensorV2 *x) {
         }
     } else if (x->rank == 2) {
         /* 2D softmax over last dimension */
-        int batch = x->shape[0];
-        int dim = x->shape[1];
-
-        for (int b = 0; b < batch; b++) {
-            int offset = b * dim;
-
-            double max_val = x->data[offset];
-            for (int i = 1; i < dim; i++) {
-                if (x->data[offset + i] > max_val) {
-                    max_val = x->data[offset + i];
-                }
-            }
-
-            double sum = 0.0;
-            for (int i = 0; i < dim; i++) {
-                result->data[offset + i] = exp(x->data[offset + i] - max_val);
-                sum += result->data[offset + i];
-            }
-
-            for (int i = 0; i < dim; i++) {
-                result->data[offset + i] /= sum;
-            }
-        }
+        SoftmaxRows rows = {result->data, x->data, NULL, x->shape[1]};
+        autograd_parallel_for(x->shape[0], x->shape[1], softmax_range, &rows);
     }
 
     return result;
@@ -250,6 +453,7 @@ TensorV2* tensor_softmax(const TensorV2 *x) {
 
 /* Sum all elements */
 double tensor_sum(const TensorV2 *x) {
+    x = tensor_contiguous(x);
     double sum = 0.0;
     for (int i = 0; i < x->size; i++) {
         sum += x->data[i];
@@ -380,41 +584,84 @@ void tape_backward(TapeV2 *tape) {
  * AUTOGRAD OPERATIONS
  * ============================================================================ */
 
+/* A tensor backward reads as it was during the forward pass; referenced,
+ * not copied, so it must not be written in place until backward is done */
+typedef struct {
+    const TensorV2 *tensor;
+    unsigned version;
+} SavedTensor;
+
+static SavedTensor save_tensor(const TensorV2 *t) {
+    SavedTensor saved = {t, tensor_storage(t)->version};
+    return saved;
+}
+
+static const TensorV2* saved_tensor(const SavedTensor *saved, const char *op) {
+    unsigned version = tensor_storage(saved->tensor)->version;
+    if (version != saved->version) {
+        fprintf(stderr, "ERROR: %s backward: a saved input was modified in place "
+                "after the forward pass (version %u, saved at %u)\n",
+                op, version, saved->version);
+        exit(1);
+    }
+    return saved->tensor;
+}
+
 /* Context for add backward */
 typedef struct {
     VariableV2 *a;
     VariableV2 *b;
 } AddCtx;
 
+/* A [batch, features] matrix against a [features] vector */
+typedef struct {
+    double *out;
+    const double *matrix;
+    const double *vector;
+    int batch;
+    int features;
+} Broadcast;
+
+/* out[j] += sum over rows of matrix[i][j], for columns [begin, end) */
+static void column_sum_range(void *arg, int begin, int end) {
+    Broadcast *b = (Broadcast*)arg;
+    for (int j = begin; j < end; j++) {
+        double sum = 0.0;
+        for (int i = 0; i < b->batch; i++) {
+            sum += b->matrix[i * b->features + j];
+        }
+        b->out[j] += sum;
+    }
+}
+
+/* out[i][j] = matrix[i][j] + vector[j], for rows [begin, end) */
+static void add_row_vector_range(void *arg, int begin, int end) {
+    Broadcast *b = (Broadcast*)arg;
+    for (int i = begin; i < end; i++) {
+        for (int j = 0; j < b->features; j++) {
+            b->out[i * b->features + j] = b->matrix[i * b->features + j] + b->vector[j];
+        }
+    }
+}
+
 static void backward_add(void *ctx, TensorV2 *grad_output) {
     AddCtx *c = (AddCtx*)ctx;
 
     if (c->a->requires_grad && c->a->grad) {
         /* Gradient for a is just grad_output */
-        for (int i = 0; i < c->a->grad->size; i++) {
-            c->a->grad->data[i] += grad_output->data[i];
-        }
+        elementwise(accumulate_range, c->a->grad->data, grad_output->data, NULL, c->a->grad->size);
     }
 
     if (c->b->requires_grad && c->b->grad) {
         /* Check if b was broadcast */
         if (grad_output->rank == 2 && c->b->data->rank == 1) {
             /* Sum gradients across batch dimension */
-            int batch = grad_output->shape[0];
-            int features = grad_output->shape[1];
-
-            for (int j = 0; j < features; j++) {
-                double sum = 0.0;
-                for (int i = 0; i < batch; i++) {
-                    sum += grad_output->data[i * features + j];
-                }
-                c->b->grad->data[j] += sum;
-            }
+            Broadcast sums = {c->b->grad->data, grad_output->data, NULL,
+                              grad_output->shape[0], grad_output->shape[1]};
+            autograd_parallel_for(sums.features, sums.batch, column_sum_range, &sums);
         } else {
             /* Regular case - same shape */
-            for (int i = 0; i < c->b->grad->size; i++) {
-                c->b->grad->data[i] += grad_output->data[i];
-            }
+            elementwise(accumulate_range, c->b->grad->data, grad_output->data, NULL, c->b->grad->size);
         }
     }
 
@@ -422,6 +669,9 @@ static void backward_add(void *ctx, TensorV2 *grad_output) {
 }
 
 VariableV2* ag_add(VariableV2 *a, VariableV2 *b) {
+    a = var_contiguous(a);
+    b = var_contiguous(b);
+
     /* Handle broadcasting for bias addition */
     TensorV2 *result;
 
@@ -432,12 +682,8 @@ VariableV2* ag_add(VariableV2 *a, VariableV2 *b) {
         assert(b->data->size == features);
 
         result = tensor_create_temp(a->data->shape, a->data->rank);
-        for (int i = 0; i < batch; i++) {
-            for (int j = 0; j < features; j++) {
-                result->data[i * features + j] =
-                    a->data->data[i * features + j] + b->data->data[j];
-            }
-        }
+        Broadcast rows = {result->data, a->data->data, b->data->data, batch, features};
+        autograd_parallel_for(batch, features, add_row_vector_range, &rows);
     } else {
         /* Regular element-wise addition */
         result = tensor_add(a->data, b->data);
@@ -460,33 +706,37 @@ VariableV2* ag_add(VariableV2 *a, VariableV2 *b) {
 
 /* Context for matmul backward */
 typedef struct {
-    TensorV2 *a_data;
-    TensorV2 *b_data;
+    SavedTensor a_data;
+    SavedTensor b_data;
     VariableV2 *a;
     VariableV2 *b;
 } MatmulCtx;
 
 static void backward_matmul(void *ctx, TensorV2 *grad_output) {
     MatmulCtx *c = (MatmulCtx*)ctx;
+    const TensorV2 *a_data = saved_tensor(&c->a_data, "matmul");
+    const TensorV2 *b_data = saved_tensor(&c->b_data, "matmul");
 
-    if (c->a->requires_grad && c->a->grad) {
-        /* grad_a = grad_output @ b^T */
-        TensorV2 *b_T = tensor_transpose(c->b_data);
-        TensorV2 *grad_a = tensor_matmul(grad_output, b_T);
+    int m = a_data->shape[0];
+    int k = a_data->shape[1];
+    int n = b_data->shape[1];
 
-        for (int i = 0; i < c->a->grad->size; i++) {
-            c->a->grad->data[i] += grad_a->data[i];
-        }
+    /* Both products accumulate straight into the gradients, reading the
+     * transposed operand in place (a transposed view reads as row-major) */
+    int trans_a, trans_b;
+    const double *A = gemm_operand(a_data, &trans_a);
+    const double *B = gemm_operand(b_data, &trans_b);
+
+    if (c->a->requires_grad && c->a->grad) {
+        /* grad_a += grad_output @ b^T */
+        matmul_optimized_ex(grad_output->data, B, c->a->grad->data, m, n, k,
+                            0, !trans_b, 1, g_use_blas);
     }
 
     if (c->b->requires_grad && c->b->grad) {
-        /* grad_b = a^T @ grad_output */
-        TensorV2 *a_T = tensor_transpose(c->a_data);
-        TensorV2 *grad_b = tensor_matmul(a_T, grad_output);
-
-        for (int i = 0; i < c->b->grad->size; i++) {
-            c->b->grad->data[i] += grad_b->data[i];
-        }
+        /* grad_b += a^T @ grad_output */
+        matmul_optimized_ex(A, grad_output->data, c->b->grad->data, k, m, n,
+                            !trans_a, 0, 1, g_use_blas);
     }
 
     /* Don't free - context is arena allocated */
@@ -499,8 +749,8 @@ VariableV2* ag_matmul(VariableV2 *a, VariableV2 *b) {
 
     if (g_tape && requires_grad) {
         MatmulCtx *ctx = arena_alloc(global_arena, sizeof(MatmulCtx));
-        ctx->a_data = tensor_clone_temp(a->data);
-        ctx->b_data = tensor_clone_temp(b->data);
+        ctx->a_data = save_tensor(a->data);
+        ctx->b_data = save_tensor(b->data);
         ctx->a = a;
         ctx->b = b;
 
@@ -513,7 +763,7 @@ VariableV2* ag_matmul(VariableV2 *a, VariableV2 *b) {
 
 /* Context for ReLU backward */
 typedef struct {
-    TensorV2 *input_data;
+    SavedTensor input_data;
     VariableV2 *input;
 } ReluCtx;
 
@@ -521,23 +771,21 @@ static void backward_relu(void *ctx, TensorV2 *grad_output) {
     ReluCtx *c = (ReluCtx*)ctx;
 
     if (c->input->requires_grad && c->input->grad) {
-        for (int i = 0; i < grad_output->size; i++) {
-            if (c->input_data->data[i] > 0) {
-                c->input->grad->data[i] += grad_output->data[i];
-            }
-        }
+        elementwise(accumulate_where_positive_range, c->input->grad->data, grad_output->data,
+                    saved_tensor(&c->input_data, "relu")->data, grad_output->size);
     }
 
     /* Don't free - context is arena allocated */
 }
 
 VariableV2* ag_relu(VariableV2 *x) {
+    x = var_contiguous(x);
     TensorV2 *result = tensor_relu(x->data);
     VariableV2 *output = var_create_temp(result, x->requires_grad);
 
     if (g_tape && x->requires_grad) {
         ReluCtx *ctx = arena_alloc(global_arena, sizeof(ReluCtx));
-        ctx->input_data = tensor_clone_temp(x->data);
+        ctx->input_data = save_tensor(x->data);
         ctx->input = x;
 
         VariableV2 *inputs[] = {x};
@@ -677,9 +925,9 @@ void optimizer_step(OptimizerV2 *opt) {
     for (int i = 0; i < opt->num_params; i++) {
         VariableV2 *param = opt->parameters[i];
         if (param->grad) {
-            for (int j = 0; j < param->data->size; j++) {
-                param->data->data[j] -= opt->lr * param->grad->data[j];
-            }
+            Elementwise step = {param->data->data, param->grad->data, NULL, opt->lr};
+            autograd_parallel_for(param->data->size, 1, subtract_scaled_range, &step);
+            tensor_mark_modified(param->data);
         }
     }
 }
@@ -697,6 +945,7 @@ void optimizer_destroy(OptimizerV2 *opt) {
 void autograd_v2_init(void) {
     arena_init_global();
     g_tape = tape_create();
+    if (!g_pool) autograd_v2_set_threads(0);
 
     /* Print BLAS acceleration info */
     if (has_blas()) {
@@ -704,12 +953,33 @@ void autograd_v2_init(void) {
     } else {
         printf("⚠️  Using pure C (no BLAS) - training will be slower\n");
     }
+    printf("🧵 Tensor kernels on %d thread%s\n", autograd_v2_threads(), autograd_v2_threads() == 1 ? "" : "s");
+}
+
+void autograd_v2_set_threads(int thread_count) {
+    if (thread_count <= 0) {
+        const char *env = getenv("FLUXPARSER_THREADS");
+        thread_count = env ? atoi(env) : 0;
+    }
+
+    /* NULL (no worker could start) leaves the kernels single-threaded */
+    ThreadPool *pool = thread_pool_create(thread_count);
+    blas_set_thread_pool(pool);
+    thread_pool_destroy(g_pool);
+    g_pool = pool;
+}
+
+int autograd_v2_threads(void) {
+    return thread_pool_size(g_pool);
 }
 
 /* Cleanup */
 void autograd_v2_cleanup(void) {
     tape_destroy(g_tape);
     g_tape = NULL;
+    blas_set_thread_pool(NULL);
+    thread_pool_destroy(g_pool);
+    g_pool = NULL;
     arena_cleanup_global();
 }
 
@@ -738,18 +1008,15 @@ static void backward_transpose(void *ctx, TensorV2 *grad_output) {
     TransposeCtx *c = (TransposeCtx*)ctx;
 
     if (c->input->requires_grad && c->input->grad) {
-        /* Gradient of transpose is just transpose of the gradient */
-        TensorV2 *grad_transposed = tensor_transpose(grad_output);
-
-        for (int i = 0; i < c->input->grad->size; i++) {
-            c->input->grad->data[i] += grad_transposed->data[i];
-        }
+        /* Gradient of transpose is the transposed gradient, added in one pass */
+        transpose_optimized_ex(grad_output->data, c->input->grad->data, grad_output->shape[0],
+                               grad_output->shape[1], 1, g_use_blas);
     }
 
     /* Don't free - context is arena allocated */
 }
 
-/* Transpose operation */
+/* Transpose operation: a view of x's data with its own gradient */
 VariableV2* ag_transpose(VariableV2 *x) {
     TensorV2 *result = tensor_transpose(x->data);
     VariableV2 *output = var_create_temp(result, x->requires_grad);
@@ -769,72 +1036,41 @@ VariableV2* ag_transpose(VariableV2 *x) {
  * ADDITIONAL OPERATIONS FOR TRANSFORMER
  * ============================================================================ */
 
-/* Reshape variable */
-/* Context for reshape backward */
-typedef struct {
-    VariableV2 *input;
-    int *original_shape;
-    int original_rank;
-} ReshapeCtx;
-
-static void backward_reshape(void *ctx, TensorV2 *grad_output) {
-    ReshapeCtx *c = (ReshapeCtx*)ctx;
-
-    /* Reshape gradient back to original shape */
-    if (c->input->requires_grad && c->input->grad) {
-        /* Just copy gradients since reshape is just a view */
-        for (int i = 0; i < grad_output->size; i++) {
-            c->input->grad->data[i] += grad_output->data[i];
-        }
-    }
+/* A variable over data sharing x's gradient, which has the same
+ * row-major layout; no backward pass of its own is needed */
+static VariableV2* var_alias(VariableV2 *x, TensorV2 *data, TensorV2 *grad) {
+    VariableV2 *var = arena_alloc(global_arena, sizeof(VariableV2));
+    var->data = data;
+    var->grad = x->requires_grad ? grad : NULL;
+    var->requires_grad = x->requires_grad;
+    var->is_parameter = false;
+    return var;
+}
 
-    /* Don't free - arena allocated */
+VariableV2* var_contiguous(VariableV2 *x) {
+    if (tensor_is_contiguous(x->data)) return x;
+    return var_alias(x, tensor_clone_temp(x->data), x->grad);
 }
 
+/* Reshape variable */
 VariableV2* var_reshape(VariableV2 *x, int *new_shape, int new_rank) {
-    /* Verify total size matches */
-    int new_size = 1;
-    for (int i = 0; i < new_rank; i++) {
-        new_size *= new_shape[i];
-    }
-    assert(new_size == x->data->size);
-
-    /* Create reshaped tensor (view of same data) */
-    TensorV2 *reshaped = tensor_create_temp(new_shape, new_rank);
-    memcpy(reshaped->data, x->data->data, new_size * sizeof(double));
-
-    VariableV2 *output = var_create_temp(reshaped, x->requires_grad);
-
-    /* Record for backward pass */
-    if (x->requires_grad && g_tape) {
-        ReshapeCtx *ctx = arena_alloc(global_arena, sizeof(ReshapeCtx));
-        ctx->input = x;
-        ctx->original_rank = x->data->rank;
-        /* Allocate shape in arena to avoid leak */
-        ctx->original_shape = arena_alloc(global_arena, x->data->rank * sizeof(int));
-        memcpy(ctx->original_shape, x->data->shape, x->data->rank * sizeof(int));
-
-        VariableV2 *inputs[] = {x};
-        tape_add_op(g_tape, inputs, 1, output, backward_reshape, ctx);
-    }
-
-    return output;
+    x = var_contiguous(x);
+    TensorV2 *grad = x->grad ? tensor_reshape(x->grad, new_shape, new_rank) : NULL;
+    return var_alias(x, tensor_reshape(x->data, new_shape, new_rank), grad);
 }
 
 /* ReLU activation */
 VariableV2* var_relu(VariableV2 *x) {
+    x = var_contiguous(x);
     TensorV2 *result = tensor_create_temp(x->data->shape, x->data->rank);
-
-    for (int i = 0; i < x->data->size; i++) {
-        result->data[i] = fmax(0.0, x->data->data[i]);
-    }
+    elementwise(relu_range, result->data, x->data->data, NULL, x->data->size);
 
     VariableV2 *output = var_create_temp(result, x->requires_grad);
 
     /* Record for backward pass */
     if (x->requires_grad && g_tape) {
         ReluCtx *ctx = arena_alloc(global_arena, sizeof(ReluCtx));
-        ctx->input_data = tensor_clone_temp(x->data);
+        ctx->input_data = save_tensor(x->data);
         ctx->input = x;
 
         VariableV2 *inputs[] = {x};
@@ -847,9 +1083,31 @@ VariableV2* var_relu(VariableV2 *x) {
 /* Context for softmax backward */
 typedef struct {
     VariableV2 *input;
-    TensorV2 *output_data;  /* Store softmax output for backward */
+    SavedTensor output_data;    /* Softmax output, for backward */
 } SoftmaxCtx;
 
+/* Jacobian-vector product for rows [begin, end) */
+static void softmax_backward_range(void *arg, int begin, int end) {
+    SoftmaxRows *s = (SoftmaxRows*)arg;
+    int dim = s->dim;
+    for (int b = begin; b < end; b++) {
+        int offset = b * dim;
+        for (int i = 0; i < dim; i++) {
+            double sum = 0.0;
+            for (int j = 0; j < dim; j++) {
+                double jacobian_ij;
+                if (i == j) {
+                    jacobian_ij = s->in[offset + i] * (1.0 - s->in[offset + i]);
+                } else {
+                    jacobian_ij = -s->in[offset + i] * s->in[offset + j];
+                }
+                sum += jacobian_ij * s->grad[offset + j];
+            }
+            s->out[offset + i] += sum;
+        }
+    }
+}
+
 static void backward_softmax_2d(void *ctx, TensorV2 *grad_output) {
     SoftmaxCtx *c = (SoftmaxCtx*)ctx;
 
@@ -860,32 +1118,16 @@ static void backward_softmax_2d(void *ctx, TensorV2 *grad_output) {
         }
         int dim = grad_output->shape[grad_output->rank - 1];
 
-        for (int b = 0; b < batch_size; b++) {
-            int offset = b * dim;
-
-            /* Compute Jacobian-vector product */
-            for (int i = 0; i < dim; i++) {
-                double sum = 0.0;
-                for (int j = 0; j < dim; j++) {
-                    double jacobian_ij;
-                    if (i == j) {
-                        jacobian_ij = c->output_data->data[offset + i] *
-                                      (1.0 - c->output_data->data[offset + i]);
-                    } else {
-                        jacobian_ij = -c->output_data->data[offset + i] *
-                                      c->output_data->data[offset + j];
-                    }
-                    sum += jacobian_ij * grad_output->data[offset + j];
-                }
-                c->input->grad->data[offset + i] += sum;
-            }
-        }
+        SoftmaxRows rows = {c->input->grad->data, saved_tensor(&c->output_data, "softmax")->data,
+                            grad_output->data, dim};
+        autograd_parallel_for(batch_size, dim * dim, softmax_backward_range, &rows);
     }
 }
 
 /* Softmax over 2D tensor (last dimension) */
 VariableV2* var_softmax_2d(VariableV2 *x) {
     assert(x->data->rank >= 2);
+    x = var_contiguous(x);
 
     int batch_size = 1;
     for (int i = 0; i < x->data->rank - 1; i++) {
@@ -894,27 +1136,8 @@ VariableV2* var_softmax_2d(VariableV2 *x) {
     int dim = x->data->shape[x->data->rank - 1];
 
     TensorV2 *result = tensor_create_temp(x->data->shape, x->data->rank);
-
-    for (int b = 0; b < batch_size; b++) {
-        /* Find max for numerical stability */
-        double max_val = -INFINITY;
-        for (int i = 0; i < dim; i++) {
-            double val = x->data->data[b * dim + i];
-            if (val > max_val) max_val = val;
-        }
-
-        /* Compute exp and sum */
-        double sum = 0.0;
-        for (int i = 0; i < dim; i++) {
-            result->data[b * dim + i] = exp(x->data->data[b * dim + i] - max_val);
-            sum += result->data[b * dim + i];
-        }
-
-        /* Normalize */
-        for (int i = 0; i < dim; i++) {
-            result->data[b * dim + i] /= sum;
-        }
-    }
+    SoftmaxRows rows = {result->data, x->data->data, NULL, dim};
+    autograd_parallel_for(batch_size, dim, softmax_range, &rows);
 
     VariableV2 *output = var_create_temp(result, x->requires_grad);
 
@@ -922,7 +1145,7 @@ VariableV2* var_softmax_2d(VariableV2 *x) {
     if (x->requires_grad && g_tape) {
         SoftmaxCtx *ctx = arena_alloc(global_arena, sizeof(SoftmaxCtx));
         ctx->input = x;
-        ctx->output_data = tensor_clone_temp(result);
+        ctx->output_data = save_tensor(result);
 
         VariableV2 *inputs[] = {x};
         tape_add_op(g_tape, inputs, 1, output, backward_softmax_2d, ctx);
@@ -942,70 +1165,92 @@ typedef struct {
     int d_model;      /* Size of each position */
 } LayerNormCtx;
 
-static void backward_layer_norm(void *ctx, TensorV2 *grad_output) {
-    LayerNormCtx *c = (LayerNormCtx*)ctx;
+typedef struct {
+    LayerNormCtx *ctx;
+    const double *grad_output;
+} LayerNormBackward;
+
+/* Gamma and beta gradients for features [begin, end), summed over positions */
+static void layer_norm_params_range(void *arg, int begin, int end) {
+    LayerNormBackward *lb = (LayerNormBackward*)arg;
+    LayerNormCtx *c = lb->ctx;
     int d_model = c->d_model;
-    int n_positions = c->n_positions;
     double eps = 1e-5;
 
-    /* Accumulate gradients for gamma and beta across all positions */
     if (c->gamma->requires_grad && c->gamma->grad) {
-        for (int pos = 0; pos < n_positions; pos++) {
+        for (int pos = 0; pos < c->n_positions; pos++) {
             double mean = c->means[pos];
-            double var = c->vars[pos];
-            double std = sqrt(var + eps);
-
+            double std = sqrt(c->vars[pos] + eps);
             int offset = pos * d_model;
-            for (int i = 0; i < d_model; i++) {
+            for (int i = begin; i < end; i++) {
                 double x_normalized = (c->input->data->data[offset + i] - mean) / std;
-                c->gamma->grad->data[i] += grad_output->data[offset + i] * x_normalized;
+                c->gamma->grad->data[i] += lb->grad_output[offset + i] * x_normalized;
             }
         }
     }
 
     if (c->beta->requires_grad && c->beta->grad) {
-        for (int pos = 0; pos < n_positions; pos++) {
+        for (int pos = 0; pos < c->n_positions; pos++) {
             int offset = pos * d_model;
-            for (int i = 0; i < d_model; i++) {
-                c->beta->grad->data[i] += grad_output->data[offset + i];
+            for (int i = begin; i < end; i++) {
+                c->beta->grad->data[i] += lb->grad_output[offset + i];
             }
         }
     }
+}
 
-    /* Compute gradient for input */
-    if (c->input->requires_grad && c->input->grad) {
-        for (int pos = 0; pos < n_positions; pos++) {
-            double mean = c->means[pos];
-            double var = c->vars[pos];
-            double std = sqrt(var + eps);
-            int offset = pos * d_model;
+/* Input gradient for positions [begin, end) */
+static void layer_norm_input_range(void *arg, int begin, int end) {
+    LayerNormBackward *lb = (LayerNormBackward*)arg;
+    LayerNormCtx *c = lb->ctx;
+    const double *grad_output = lb->grad_output;
+    int d_model = c->d_model;
+    double eps = 1e-5;
 
-            /* Compute intermediate values for this position */
-            double grad_mean = 0.0;
-            double grad_var = 0.0;
+    for (int pos = begin; pos < end; pos++) {
+        double mean = c->means[pos];
+        double var = c->vars[pos];
+        double std = sqrt(var + eps);
+        int offset = pos * d_model;
 
-            /* First pass: compute grad_mean and grad_var */
-            for (int i = 0; i < d_model; i++) {
-                double grad_x_norm = grad_output->data[offset + i] * c->gamma->data->data[i];
+        /* Compute intermediate values for this position */
+        double grad_mean = 0.0;
+        double grad_var = 0.0;
 
-                grad_var += grad_x_norm * (c->input->data->data[offset + i] - mean) * (-0.5) * pow(var + eps, -1.5);
-                grad_mean += grad_x_norm * (-1.0 / std);
-            }
+        /* First pass: compute grad_mean and grad_var */
+        for (int i = 0; i < d_model; i++) {
+            double grad_x_norm = grad_output[offset + i] * c->gamma->data->data[i];
 
-            /* Add contribution from grad_var to grad_mean */
-            for (int i = 0; i < d_model; i++) {
-                grad_mean += grad_var * 2.0 * (c->input->data->data[offset + i] - mean) / d_model;
-            }
+            grad_var += grad_x_norm * (c->input->data->data[offset + i] - mean) * (-0.5) * pow(var + eps, -1.5);
+            grad_mean += grad_x_norm * (-1.0 / std);
+        }
 
-            /* Second pass: compute final gradient */
-            for (int i = 0; i < d_model; i++) {
-                double grad_x_norm = grad_output->data[offset + i] * c->gamma->data->data[i];
-                c->input->grad->data[offset + i] += grad_x_norm / std
-                    + grad_var * 2.0 * (c->input->data->data[offset + i] - mean) / d_model
-                    + grad_mean / d_model;
-            }
+        /* Add contribution from grad_var to grad_mean */
+        for (int i = 0; i < d_model; i++) {
+            grad_mean += grad_var * 2.0 * (c->input->data->data[offset + i] - mean) / d_model;
+        }
+
+        /* Second pass: compute final gradient */
+        for (int i = 0; i < d_model; i++) {
+            double grad_x_norm = grad_output[offset + i] * c->gamma->data->data[i];
+            c->input->grad->data[offset + i] += grad_x_norm / std
+                + grad_var * 2.0 * (c->input->data->data[offset + i] - mean) / d_model
+                + grad_mean / d_model;
         }
     }
+}
+
+static void backward_layer_norm(void *ctx, TensorV2 *grad_output) {
+    LayerNormCtx *c = (LayerNormCtx*)ctx;
+    LayerNormBackward lb = {c, grad_output->data};
+
+    /* Accumulate gradients for gamma and beta across all positions */
+    autograd_parallel_for(c->d_model, c->n_positions, layer_norm_params_range, &lb);
+
+    /* Compute gradient for input */
+    if (c->input->requires_grad && c->input->grad) {
+        autograd_parallel_for(c->n_positions, c->d_model, layer_norm_input_range, &lb);
+    }
 
     /* Don't free - arena allocated */
 }
@@ -1069,15 +1314,18 @@ typedef struct {
     int seq_len;
 } CrossEntropyCtx;
 
-static void backward_cross_entropy(void *ctx, TensorV2 *grad_output) {
-    CrossEntropyCtx *c = (CrossEntropyCtx*)ctx;
-
-    if (!c->logits->requires_grad || !c->logits->grad) return;
-
+typedef struct {
+    CrossEntropyCtx *ctx;
+    double grad_output;
+} CrossEntropyBackward;
+
+/* Logit gradients for positions [begin, end) */
+static void cross_entropy_range(void *arg, int begin, int end) {
+    CrossEntropyBackward *cb = (CrossEntropyBackward*)arg;
+    CrossEntropyCtx *c = cb->ctx;
     int vocab_size = c->logits->data->shape[c->logits->data->rank - 1];
 
-    /* For each position in sequence */
-    for (int t = 0; t < c->seq_len; t++) {
+    for (int t = begin; t < end; t++) {
         /* Compute softmax */
         double max_val = -INFINITY;
         for (int v = 0; v < vocab_size; v++) {
@@ -1100,9 +1348,20 @@ static void backward_cross_entropy(void *ctx, TensorV2 *grad_output) {
             }
             /* Scale by output gradient and average over sequence */
             c->logits->grad->data[t * vocab_size + v] +=
-                grad * grad_output->data[0] / c->seq_len;
+                grad * cb->grad_output / c->seq_len;
         }
     }
+}
+
+static void backward_cross_entropy(void *ctx, TensorV2 *grad_output) {
+    CrossEntropyCtx *c = (CrossEntropyCtx*)ctx;
+
+    if (!c->logits->requires_grad || !c->logits->grad) return;
+
+    /* For each position in sequence */
+    CrossEntropyBackward cb = {c, grad_output->data[0]};
+    autograd_parallel_for(c->seq_len, c->logits->data->shape[c->logits->data->rank - 1],
+                          cross_entropy_range, &cb);
 
     /* Don't free - context is arena allocated */
 }
@@ -1152,27 +1411,27 @@ void var_free_persistent(VariableV2 *v) {
 
 /* Context for multiply backward */
 typedef struct {
-    TensorV2 *a_data;
-    TensorV2 *b_data;
+    SavedTensor a_data;
+    SavedTensor b_data;
     VariableV2 *a;
     VariableV2 *b;
 } MultiplyCtx;
 
 static void backward_multiply(void *ctx, TensorV2 *grad_output) {
     MultiplyCtx *c = (MultiplyCtx*)ctx;
+    const TensorV2 *a_data = saved_tensor(&c->a_data, "multiply");
+    const TensorV2 *b_data = saved_tensor(&c->b_data, "multiply");
 
     if (c->a->requires_grad && c->a->grad) {
         /* grad_a = grad_output * b */
-        for (int i = 0; i < grad_output->size; i++) {
-            c->a->grad->data[i] += grad_output->data[i] * c->b_data->data[i];
-        }
+        elementwise(accumulate_product_range, c->a->grad->data, grad_output->data, b_data->data,
+                    grad_output->size);
     }
 
     if (c->b->requires_grad && c->b->grad) {
         /* grad_b = grad_output * a */
-        for (int i = 0; i < grad_output->size; i++) {
-            c->b->grad->data[i] += grad_output->data[i] * c->a_data->data[i];
-        }
+        elementwise(accumulate_product_range, c->b->grad->data, grad_output->data, a_data->data,
+                    grad_output->size);
     }
 
     /* Don't free - context is arena allocated */
@@ -1180,14 +1439,16 @@ static void backward_multiply(void *ctx, TensorV2 *grad_output) {
 
 /* Multiply operation */
 VariableV2* ag_multiply(VariableV2 *a, VariableV2 *b) {
+    a = var_contiguous(a);
+    b = var_contiguous(b);
     TensorV2 *result = tensor_multiply(a->data, b->data);
     bool requires_grad = a->requires_grad || b->requires_grad;
     VariableV2 *output = var_create_temp(result, requires_grad);
 
     if (g_tape && requires_grad) {
         MultiplyCtx *ctx = arena_alloc(global_arena, sizeof(MultiplyCtx));
-        ctx->a_data = tensor_clone_temp(a->data);
-        ctx->b_data = tensor_clone_temp(b->data);
+        ctx->a_data = save_tensor(a->data);
+        ctx->b_data = save_tensor(b->data);
         ctx->a = a;
         ctx->b = b;
 
@@ -29,12 +29,21 @@ typedef enum {
     TENSOR_TEMPORARY    /* Arena allocated (for intermediates) */
 } TensorStorage;
 
+/* A view (reshape, transpose) shares the data of its base tensor: data
+ * points at the view's first element, and element (i, j, ...) is at
+ * data[i * strides[0] + j * strides[1] + ...]. Tensors laid out row-major
+ * have strides == NULL; kernels that need that layout call
+ * tensor_contiguous(), which copies only strided views.
+ */
 struct TensorV2 {
     double *data;
     int *shape;
     int rank;
     int size;
     TensorStorage storage;
+    unsigned version;   /* Bumped by in-place writes (tensor_mark_modified) */
+    int *strides;       /* Per-dimension element strides, NULL if row-major */
+    TensorV2 *base;     /* Tensor owning data if this is a view, else NULL */
 };
 
 /* Tensor creation */
@@ -43,16 +52,27 @@ TensorV2* tensor_create_temp(const int *shape, int rank);
 TensorV2* tensor_zeros_persistent(const int *shape, int rank);
 TensorV2* tensor_zeros_temp(const int *shape, int rank);
 TensorV2* tensor_randn_persistent(const int *shape, int rank, double scale);
-TensorV2* tensor_clone_temp(const TensorV2 *src);
+TensorV2* tensor_clone_temp(const TensorV2 *src);   /* Always row-major */
 void tensor_free_persistent(TensorV2 *t);
 /* No free for temp tensors - arena handles it */
 
+/* Record an in-place write to t->data. The tape keeps references to the
+ * inputs it needs for backward instead of copies, and backward fails if
+ * one of them was modified after it was recorded.
+ */
+void tensor_mark_modified(TensorV2 *t);
+
+/* Views (temp tensors sharing the data, O(1) unless noted) */
+bool tensor_is_contiguous(const TensorV2 *t);
+const TensorV2* tensor_contiguous(const TensorV2 *t);  /* t, or a row-major copy */
+TensorV2* tensor_reshape(const TensorV2 *t, const int *shape, int rank);  /* Copies strided t */
+
 /* Tensor operations (all return temp tensors) */
 TensorV2* tensor_add(const TensorV2 *a, const TensorV2 *b);
 TensorV2* tensor_subtract(const TensorV2 *a, const TensorV2 *b);
 TensorV2* tensor_multiply(const TensorV2 *a, const TensorV2 *b);
 TensorV2* tensor_matmul(const TensorV2 *a, const TensorV2 *b);
-TensorV2* tensor_transpose(const TensorV2 *a);
+TensorV2* tensor_transpose(const TensorV2 *a);  /* View */
 TensorV2* tensor_relu(const TensorV2 *x);
 TensorV2* tensor_softmax(const TensorV2 *x);
 double tensor_sum(const TensorV2 *x);
@@ -173,8 +193,30 @@ void autograd_v2_cleanup(void);
 /* Reset arena after each iteration */
 void autograd_reset_iteration(void);
 
+/* Worker pool for the tensor kernels (matmul, elementwise, layer norm,
+ * softmax, attention), started by autograd_v2_init() with FLUXPARSER_THREADS
+ * threads if set, else one per CPU. Results do not depend on the thread
+ * count. Resize only between iterations; <= 0 restores the default.
+ */
+void autograd_v2_set_threads(int thread_count);
+int autograd_v2_threads(void);
+
+/* Run body(arg, begin, end) over disjoint ranges covering [0, count).
+ * cost is the work per index in elements; loops too small to pay for the
+ * hand-off run on the calling thread. body must not allocate from the arena.
+ */
+typedef void (*ParallelRangeFunc)(void *arg, int begin, int end);
+void autograd_parallel_for(int count, int cost, ParallelRangeFunc body, void *arg);
+
 /* Additional operations for transformer */
+
+/* Reshape is a view of x's data (copied first if x is a strided view). Its
+ * gradient is a view of x's gradient, so it needs no backward pass of its
+ * own; var_contiguous() returns x itself unless x is strided, then a
+ * row-major copy sharing x's gradient in the same way.
+ */
 VariableV2* var_reshape(VariableV2 *x, int *new_shape, int new_rank);
+VariableV2* var_contiguous(VariableV2 *x);
 VariableV2* var_relu(VariableV2 *x);
 VariableV2* var_softmax_2d(VariableV2 *x);
 void tape_record_layer_norm(VariableV2 *output, VariableV2 *input,
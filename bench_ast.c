@@ -0,0 +1,255 @@
+/*
+ * FluxParser - Research-Grade C Math Parser
+ * Copyright (C) 2025 Eduardo Stern
+ *
+ * Dual Licensed:
+ * - GPL-3.0 for open-source/non-commercial use
+ * - Commercial license available - see LICENSE-COMMERCIAL.md
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * Symbolic benchmark: the test_calculus workloads (differentiate, integrate,
+ * simplify, Taylor series) with nodes on the heap vs in an ASTArena that is
+ * reset after every operation, repeated differentiation as trees vs in a
+ * hash-consed ASTDag, then the gradient of an n-variable objective from the
+ * symbolic partials vs one reverse-mode sweep, and Newton root-finds one at
+ * a time vs batched.
+ *
+ * Usage: ./bench_ast [iterations]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "ast.h"
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+typedef enum { WORK_DIFF, WORK_INTEGRATE, WORK_TAYLOR } Work;
+
+static const struct {
+    const char *label;
+    const char *expr;
+    Work work;
+    int order;          /* Taylor series order */
+} workloads[] = {
+    {"d/dx, simplify: polynomial", "x^3 + 2*x^2 - 5*x + 1", WORK_DIFF, 0},
+    {"d/dx, simplify: trig product", "sin(x) * cos(x) + exp(2*x)", WORK_DIFF, 0},
+    {"d/dx, simplify: quotient", "ln(x^2 + 1) / (x + 1)", WORK_DIFF, 0},
+    {"integrate, simplify: linear", "3*x + 5", WORK_INTEGRATE, 0},
+    {"integrate, simplify: sum", "x^2 + sin(x) + exp(x)", WORK_INTEGRATE, 0},
+    {"taylor order 6: sin*exp", "sin(x) * exp(x)", WORK_TAYLOR, 6},
+    {"taylor order 4: 1/(1-x)", "1 / (1 - x)", WORK_TAYLOR, 4},
+};
+
+static ASTNode* run(size_t w, const ASTNode *f) {
+    switch (workloads[w].work) {
+        case WORK_DIFF:
+            return ast_simplify(ast_differentiate(f, "X"));
+        case WORK_INTEGRATE:
+            return ast_simplify(ast_integrate(f, "X"));
+        case WORK_TAYLOR:
+            return ast_taylor_series(f, "X", 0.0, workloads[w].order);
+    }
+    return NULL;
+}
+
+int main(int argc, char **argv) {
+    int iterations = argc > 1 ? atoi(argv[1]) : 20000;
+    if (iterations <= 0) iterations = 20000;
+
+    ASTArena *arena = ast_arena_create();
+    long sink = 0;
+
+    printf("FluxParser symbolic benchmark (%d iterations, %zu-byte nodes)\n\n",
+           iterations, sizeof(ASTNode));
+    printf("%-32s %12s %12s %8s %10s\n", "workload", "heap ns/op", "arena ns/op", "speedup", "nodes");
+
+    for (size_t w = 0; w < sizeof(workloads) / sizeof(workloads[0]); w++) {
+        ParserErrorInfo error;
+        ASTNode *f = parse_expression_ast(workloads[w].expr, &error);
+        if (!f) {
+            fprintf(stderr, "failed to parse '%s'\n", workloads[w].expr);
+            return 1;
+        }
+        int n = workloads[w].work == WORK_TAYLOR ? iterations / 20 + 1 : iterations;
+
+        double start = now_seconds();
+        for (int i = 0; i < n; i++) {
+            ASTNode *result = run(w, f);
+            sink += result->type;
+            ast_free(result);
+        }
+        double heap_ns = (now_seconds() - start) * 1e9 / n;
+
+        size_t nodes = 0;
+        start = now_seconds();
+        for (int i = 0; i < n; i++) {
+            ASTArena *previous = ast_arena_push(arena);
+            ASTNode *result = run(w, f);
+            sink += result->type;
+            ast_arena_pop(previous);
+            nodes = ast_arena_node_count(arena);
+            ast_arena_reset(arena);
+        }
+        double arena_ns = (now_seconds() - start) * 1e9 / n;
+
+        printf("%-32s %12.0f %12.0f %7.2fx %10zu\n", workloads[w].label,
+               heap_ns, arena_ns, heap_ns / arena_ns, nodes);
+        ast_free(f);
+    }
+
+    ast_arena_destroy(arena);
+
+    /* n-th derivative of exp(x)*sin(x): trees grow geometrically with n */
+    printf("\n%-32s %12s %12s %8s %10s\n", "d^n/dx^n exp(x)*sin(x)", "tree ns/op", "dag ns/op",
+           "speedup", "tree/dag");
+    ParserErrorInfo error;
+    ASTNode *f = parse_expression_ast("exp(x) * sin(x)", &error);
+    for (int order = 2; order <= 8; order += 2) {
+        int n = iterations / (1 << order) + 1;
+        size_t dag_nodes = 0;
+        double start = now_seconds();
+        for (int i = 0; i < n; i++) {
+            ASTDag *dag = ast_dag_create();
+            ASTNode *d = ast_dag_simplify(dag, f);
+            for (int k = 0; k < order; k++) d = ast_dag_differentiate(dag, d, "X");
+            sink += d->type;
+            dag_nodes = ast_dag_node_count(dag);
+            ast_dag_destroy(dag);
+        }
+        double dag_ns = (now_seconds() - start) * 1e9 / n;
+
+        int tree_ops = 0;
+        start = now_seconds();
+        for (int i = 0; i < n; i++) {
+            ASTNode *d = ast_clone(f);
+            for (int k = 0; k < order; k++) {
+                ASTNode *next = ast_differentiate(d, "X");
+                ast_free(d);
+                d = next;
+            }
+            tree_ops = ast_count_operations(d);
+            ast_free(d);
+        }
+        double tree_ns = (now_seconds() - start) * 1e9 / n;
+
+        char label[32];
+        snprintf(label, sizeof(label), "order %d", order);
+        printf("%-32s %12.0f %12.0f %7.2fx %4d/%-5zu\n", label, tree_ns, dag_ns,
+               tree_ns / dag_ns, tree_ops, dag_nodes);
+    }
+    ast_free(f);
+
+    /* Gradient of sum over i of x_i * sin(x_i * x_(i+1)) + exp(-x_i^2) */
+    printf("\n%-32s %12s %12s %8s %10s\n", "gradient, n variables", "symbolic ns", "reverse ns",
+           "speedup", "tape");
+    for (int vars = 4; vars <= 64; vars *= 4) {
+        char (*names)[8] = malloc(sizeof(*names) * vars);
+        const char **var_names = malloc(sizeof(char *) * vars);
+        VarMapping *mappings = malloc(sizeof(VarMapping) * vars);
+        double *values = malloc(sizeof(double) * vars);
+        double *gradient = malloc(sizeof(double) * vars);
+        ASTNode *objective = NULL;
+        for (int i = 0; i < vars; i++) {
+            snprintf(names[i], sizeof(names[i]), "V%d", i);
+            var_names[i] = names[i];
+            mappings[i].name = names[i];
+            mappings[i].index = i;
+            values[i] = 0.1 + 0.01 * i;
+        }
+        for (int i = 0; i < vars; i++) {
+            ASTNode *xi = ast_create_variable(names[i]);
+            ASTNode *next = ast_create_variable(names[(i + 1) % vars]);
+            ASTNode *arg = ast_create_binary_op(OP_MULTIPLY, ast_create_variable(names[i]), next);
+            ASTNode *term = ast_create_binary_op(OP_ADD,
+                ast_create_binary_op(OP_MULTIPLY, xi, ast_create_function_call("SIN", &arg, 1)),
+                ast_create_function_call("EXP", (ASTNode *[]){ast_create_unary_op(OP_NEGATE,
+                    ast_create_binary_op(OP_POWER, ast_create_variable(names[i]), ast_create_number(2.0)))}, 1));
+            objective = objective ? ast_create_binary_op(OP_ADD, objective, term) : term;
+        }
+
+        VarContext ctx = {.values = values, .count = vars, .mappings = mappings, .mapping_count = vars};
+        int n = iterations * 4 / vars + 1;
+
+        Gradient grad = ast_gradient(objective, var_names, vars);
+        double start = now_seconds();
+        for (int i = 0; i < n; i++) {
+            double *g = gradient_evaluate(&grad, &ctx);
+            sink += g[0] > 0;
+            free(g);
+        }
+        double symbolic_ns = (now_seconds() - start) * 1e9 / n;
+        gradient_free(&grad);
+
+        GradientProgram *program = gradient_program_create(objective, var_names, vars);
+        start = now_seconds();
+        for (int i = 0; i < n; i++) {
+            gradient_program_evaluate(program, values, gradient);
+            sink += gradient[0] > 0;
+        }
+        double reverse_ns = (now_seconds() - start) * 1e9 / n;
+
+        char label[32];
+        snprintf(label, sizeof(label), "n = %d", vars);
+        printf("%-32s %12.0f %12.0f %7.2fx %10d\n", label, symbolic_ns, reverse_ns,
+               symbolic_ns / reverse_ns, gradient_program_size(program));
+
+        gradient_program_free(program);
+        ast_free(objective);
+        free(names);
+        free(var_names);
+        free(mappings);
+        free(values);
+        free(gradient);
+    }
+
+    /* Root of x^3 + x - a for many a, from the same start */
+    printf("\n%-32s %12s %12s %8s\n", "newton: x^3 + x = a", "single ns", "batch ns", "speedup");
+    f = parse_expression_ast("x^3 + x - a", &error);
+    for (int problems = 16; problems <= 4096; problems *= 16) {
+        double *params = malloc(sizeof(double) * problems);
+        double *guesses = malloc(sizeof(double) * problems);
+        NumericalSolveResult *results = malloc(sizeof(NumericalSolveResult) * problems);
+        for (int i = 0; i < problems; i++) {
+            params[i] = 1.0 + 0.01 * i;
+            guesses[i] = 1.0;
+        }
+        int rounds = iterations * 4 / problems + 1;
+
+        double start = now_seconds();
+        for (int k = 0; k < rounds; k++) {
+            for (int i = 0; i < problems; i++) {
+                /* The parameter is a constant of the equation being solved */
+                ASTNode *a = ast_create_number(params[i]);
+                ASTNode *eq = ast_create_binary_op(OP_SUBTRACT, ast_clone(f->data.binary.left), a);
+                NumericalSolveResult r = ast_solve_numerical(eq, "X", guesses[i], 1e-12, 50);
+                sink += r.iterations;
+                ast_free(eq);
+            }
+        }
+        double single_ns = (now_seconds() - start) * 1e9 / ((double)rounds * problems);
+
+        start = now_seconds();
+        for (int k = 0; k < rounds; k++) {
+            ast_solve_numerical_batch(f, "X", "A", params, guesses, problems, 1e-12, 50, results);
+            sink += results[problems - 1].iterations;
+        }
+        double batch_ns = (now_seconds() - start) * 1e9 / ((double)rounds * problems);
+
+        char label[32];
+        snprintf(label, sizeof(label), "%d problems", problems);
+        printf("%-32s %12.0f %12.0f %7.2fx\n", label, single_ns, batch_ns, single_ns / batch_ns);
+        free(params);
+        free(guesses);
+        free(results);
+    }
+    ast_free(f);
+
+    printf("\n(checksum %ld)\n", sink);
+    return 0;
+}
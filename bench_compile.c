@@ -0,0 +1,126 @@
+/*
+ * FluxParser - Research-Grade C Math Parser
+ * Copyright (C) 2025 Eduardo Stern
+ *
+ * Dual Licensed:
+ * - GPL-3.0 for open-source/non-commercial use
+ * - Commercial license available - see LICENSE-COMMERCIAL.md
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * Parse-vs-compiled benchmark: cost of re-parsing an expression on every
+ * call, of the same call served by the expression cache, of compiling
+ * it once and evaluating the bytecode, and of evaluating the bytecode over
+ * all rows at once in column batches.
+ *
+ * Usage: ./bench_compile [iterations]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "ast.h"
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static const char *expressions[] = {
+    "2 + 3 * 4",
+    "x * x + 2 * x * y + y * y",
+    "sin(x) * cos(y) + tan(x / 4)",
+    "sqrt(x * x + y * y) / (1 + exp(-x))",
+    "(x > 0 && y > 0) || (x < 0 && y < 0)",
+    "((((x + 1) * 2 - 3) / 4 + 5) * 6 - 7) / 8",
+};
+
+int main(int argc, char **argv) {
+    int iterations = argc > 1 ? atoi(argv[1]) : 200000;
+    if (iterations <= 0) iterations = 200000;
+
+    double values[26] = {0};
+    VarContext ctx = {.values = values, .count = 26};
+    volatile double sink = 0.0;
+
+    /* Column data for the batch run: same X/Y values as the scalar loops */
+    double *xs = malloc(sizeof(double) * iterations);
+    double *ys = malloc(sizeof(double) * iterations);
+    double *out = malloc(sizeof(double) * iterations);
+    const double *columns[26] = {0};
+    columns['X' - 'A'] = xs;
+    columns['Y' - 'A'] = ys;
+    for (int i = 0; i < iterations; i++) {
+        xs[i] = i * 1e-3;
+        ys[i] = 1.0 - i * 1e-3;
+    }
+
+    printf("FluxParser parse-vs-compiled benchmark (%d iterations)\n\n", iterations);
+    printf("%-40s %12s %12s %12s %12s %12s %8s\n", "expression", "parse ns/op",
+           "cached ns/op", "compile ns", "eval ns/op", "batch ns/op", "speedup");
+
+    for (size_t e = 0; e < sizeof(expressions) / sizeof(expressions[0]); e++) {
+        const char *expr = expressions[e];
+
+        /* Direct parser: tokenize + parse + evaluate every call */
+        parser_cache_set_capacity(0);
+        double start = now_seconds();
+        for (int i = 0; i < iterations; i++) {
+            values['X' - 'A'] = i * 1e-3;
+            values['Y' - 'A'] = 1.0 - i * 1e-3;
+            sink += parse_expression_with_vars_safe(expr, &ctx).value;
+        }
+        double parse_ns = (now_seconds() - start) * 1e9 / iterations;
+
+        /* Same calls through the expression cache */
+        parser_cache_set_capacity(PARSER_CACHE_DEFAULT_CAPACITY);
+        start = now_seconds();
+        for (int i = 0; i < iterations; i++) {
+            values['X' - 'A'] = i * 1e-3;
+            values['Y' - 'A'] = 1.0 - i * 1e-3;
+            sink += parse_expression_with_vars_safe(expr, &ctx).value;
+        }
+        double cached_ns = (now_seconds() - start) * 1e9 / iterations;
+
+        /* One-time compilation */
+        start = now_seconds();
+        CompiledExpression *ce = compile_expression(expr);
+        double compile_ns = (now_seconds() - start) * 1e9;
+        if (!ce) {
+            fprintf(stderr, "failed to compile '%s'\n", expr);
+            return 1;
+        }
+
+        /* Compiled evaluation: VM cost only */
+        start = now_seconds();
+        for (int i = 0; i < iterations; i++) {
+            values['X' - 'A'] = i * 1e-3;
+            values['Y' - 'A'] = 1.0 - i * 1e-3;
+            sink += compiled_expression_evaluate(ce, &ctx);
+        }
+        double eval_ns = (now_seconds() - start) * 1e9 / iterations;
+
+        /* Batched evaluation: one call for all rows */
+        start = now_seconds();
+        compiled_expression_evaluate_batch(ce, columns, 26, iterations, out);
+        double batch_ns = (now_seconds() - start) * 1e9 / iterations;
+        for (int i = 0; i < iterations; i++) sink += out[i];
+
+        printf("%-40.40s %12.1f %12.1f %12.1f %12.1f %12.1f %7.1fx\n", expr, parse_ns,
+               cached_ns, compile_ns, eval_ns, batch_ns, parse_ns / batch_ns);
+
+        compiled_expression_free(ce);
+    }
+
+    ParserCacheStats stats;
+    parser_cache_get_stats(&stats);
+    printf("\ncache: %llu hits, %llu misses, %llu evictions, %llu fallbacks\n",
+           stats.hits, stats.misses, stats.evictions, stats.fallbacks);
+    printf("(checksum %.6g)\n", (double)sink);
+
+    free(xs);
+    free(ys);
+    free(out);
+    return 0;
+}
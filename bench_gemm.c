@@ -0,0 +1,145 @@
+/*
+ * GEMM benchmark: GFLOP/s of matmul_optimized() on the matrix shapes the
+ * transformer runs (sequence length 64, d_model 128/256/512, d_ff = 4 *
+ * d_model, head size 32), including the transposed products of the
+ * backward pass, against the naive triple loop and, when built with BLAS,
+ * against BLAS. Every result is checked against the naive loop.
+ *
+ * Usage: ./bench_gemm [seconds per measurement]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+#include "blas_wrapper.h"
+
+#define SEQ_LEN 64
+#define HEAD_SIZE 32
+#define VOCAB 256
+
+typedef struct {
+    const char *name;
+    int m, k, n;
+    int trans_a, trans_b;       /* Operand stored transposed (backward pass) */
+} Shape;
+
+static const Shape shapes[] = {
+    {"attention scores", SEQ_LEN, HEAD_SIZE, SEQ_LEN, 0, 0},
+    {"attention values", SEQ_LEN, SEQ_LEN, HEAD_SIZE, 0, 0},
+    {"qkv d=128", SEQ_LEN, 128, 128, 0, 0},
+    {"ffn up d=128", SEQ_LEN, 128, 512, 0, 0},
+    {"ffn down d=128", SEQ_LEN, 512, 128, 0, 0},
+    {"qkv d=256", SEQ_LEN, 256, 256, 0, 0},
+    {"ffn up d=256", SEQ_LEN, 256, 1024, 0, 0},
+    {"ffn down d=256", SEQ_LEN, 1024, 256, 0, 0},
+    {"lm head d=256", SEQ_LEN, 256, VOCAB, 0, 0},
+    {"input grad d=256", SEQ_LEN, 1024, 256, 0, 1},
+    {"weight grad d=256", 256, SEQ_LEN, 1024, 1, 0},
+    {"qkv d=512", SEQ_LEN, 512, 512, 0, 0},
+    {"ffn up d=512", SEQ_LEN, 512, 2048, 0, 0},
+    {"ffn down d=512", SEQ_LEN, 2048, 512, 0, 0},
+    {"input grad d=512", SEQ_LEN, 2048, 512, 0, 1},
+    {"weight grad d=512", 512, SEQ_LEN, 2048, 1, 0},
+    {"square 512", 512, 512, 512, 0, 0},
+};
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void matmul_naive(const Shape *s, const double *A, const double *B, double *C, int use_blas) {
+    (void)use_blas;
+    int m = s->m, k = s->k, n = s->n;
+    for (int i = 0; i < m; i++) {
+        for (int j = 0; j < n; j++) {
+            double sum = 0.0;
+            for (int l = 0; l < k; l++) {
+                double a = s->trans_a ? A[l * m + i] : A[i * k + l];
+                double b = s->trans_b ? B[j * k + l] : B[l * n + j];
+                sum += a * b;
+            }
+            C[i * n + j] = sum;
+        }
+    }
+}
+
+static void matmul(const Shape *s, const double *A, const double *B, double *C, int use_blas) {
+    matmul_optimized_ex(A, B, C, s->m, s->k, s->n, s->trans_a, s->trans_b, 0, use_blas);
+}
+
+typedef void (*MatmulFn)(const Shape *s, const double *A, const double *B, double *C, int use_blas);
+
+/* GFLOP/s over repeated runs lasting at least min_seconds */
+static double measure(MatmulFn fn, int use_blas, const Shape *s, const double *A, const double *B,
+                      double *C, double min_seconds) {
+    fn(s, A, B, C, use_blas);                       /* Warm-up */
+    long runs = 0;
+    double start = now_seconds(), elapsed;
+    do {
+        fn(s, A, B, C, use_blas);
+        runs++;
+        elapsed = now_seconds() - start;
+    } while (elapsed < min_seconds);
+    return 2.0 * s->m * s->k * s->n * runs / elapsed / 1e9;
+}
+
+static double max_error(const double *C, const double *reference, int count) {
+    double worst = 0.0;
+    for (int i = 0; i < count; i++) {
+        double e = fabs(C[i] - reference[i]) / (1.0 + fabs(reference[i]));
+        if (e > worst) worst = e;
+    }
+    return worst;
+}
+
+int main(int argc, char **argv) {
+    double min_seconds = argc > 1 ? atof(argv[1]) : 0.2;
+    if (min_seconds <= 0) min_seconds = 0.2;
+    int blas = has_blas();
+    int failures = 0;
+
+    printf("GEMM benchmark: %s\n\n", get_blas_impl());
+    printf("%-20s %3s %14s %9s %9s %8s", "shape", "op", "m x k x n", "naive", "pure C", "speedup");
+    if (blas) printf(" %9s %8s", "BLAS", "vs BLAS");
+    printf("   (GFLOP/s)\n");
+
+    for (size_t i = 0; i < sizeof(shapes) / sizeof(shapes[0]); i++) {
+        const Shape *s = &shapes[i];
+        double *A = malloc(sizeof(double) * s->m * s->k);
+        double *B = malloc(sizeof(double) * s->k * s->n);
+        double *C = malloc(sizeof(double) * s->m * s->n);
+        double *reference = malloc(sizeof(double) * s->m * s->n);
+        for (int j = 0; j < s->m * s->k; j++) A[j] = (double)rand() / RAND_MAX - 0.5;
+        for (int j = 0; j < s->k * s->n; j++) B[j] = (double)rand() / RAND_MAX - 0.5;
+
+        matmul_naive(s, A, B, reference, 0);
+        matmul(s, A, B, C, 0);
+        double error = max_error(C, reference, s->m * s->n);
+
+        double naive = measure(matmul_naive, 0, s, A, B, C, min_seconds);
+        double pure = measure(matmul, 0, s, A, B, C, min_seconds);
+
+        char dims[32];
+        snprintf(dims, sizeof(dims), "%dx%dx%d", s->m, s->k, s->n);
+        printf("%-20s  %c%c %14s %9.2f %9.2f %7.1fx", s->name, s->trans_a ? 'T' : 'N', s->trans_b ? 'T' : 'N',
+               dims, naive, pure, pure / naive);
+        if (blas) {
+            double fast = measure(matmul, 1, s, A, B, C, min_seconds);
+            printf(" %9.2f %7.2fx", fast, pure / fast);
+        }
+        if (error > 1e-12) {
+            printf("  MISMATCH (%.2g)", error);
+            failures++;
+        }
+        printf("\n");
+
+        free(A);
+        free(B);
+        free(C);
+        free(reference);
+    }
+    return failures ? 1 : 0;
+}
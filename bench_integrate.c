@@ -0,0 +1,134 @@
+/*
+ * FluxParser - Research-Grade C Math Parser
+ * Copyright (C) 2025 Eduardo Stern
+ *
+ * Dual Licensed:
+ * - GPL-3.0 for open-source/non-commercial use
+ * - Commercial license available - see LICENSE-COMMERCIAL.md
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * Numerical integration benchmark: Simpson's rule with one ast_evaluate()
+ * per sample vs the batched, pooled engine, then the evaluations Simpson
+ * and adaptive Gauss-Kronrod need to reach the same accuracy, and the
+ * cost of multi-dimensional cubature and Sobol points by dimension.
+ *
+ * Usage: ./bench_integrate [steps]     (FLUXPARSER_THREADS sets the pool size)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <string.h>
+#include <time.h>
+#include "ast.h"
+#include "threadpool.h"
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* Simpson's rule the way it used to run: a tree walk per sample */
+static double simpson_tree(const ASTNode *expr, double a, double b, int steps) {
+    VarMapping mapping = {.name = "X", .index = 0};
+    double x;
+    VarContext ctx = {.values = &x, .count = 1, .mappings = &mapping, .mapping_count = 1};
+    double h = (b - a) / steps, sum = 0.0;
+    for (int i = 0; i <= steps; i++) {
+        x = (i == steps) ? b : a + i * h;
+        double w = (i == 0 || i == steps) ? 1.0 : (i % 2 == 0) ? 2.0 : 4.0;
+        sum += w * ast_evaluate(expr, &ctx);
+    }
+    return (h / 3.0) * sum;
+}
+
+static const struct {
+    const char *expr;
+    double a, b;
+    double exact;
+} integrands[] = {
+    {"exp(-x * x)", 0.0, 3.0, 0.886207348259521},             /* sqrt(pi)/2 erf(3) */
+    {"1 / (1 + 25 * x^2)", -1.0, 1.0, 0.549360306778006},   /* 2 atan(5) / 5 */
+    {"sqrt(x) * ln(x + 1)", 0.0, 1.0, 0.303789458065588},  /* 2 ln 2 / 3 - pi / 3 + 8 / 9 */
+    {"sin(x)^2 * cos(3 * x)^2", 0.0, 50.0, 0.0},
+};
+
+int main(int argc, char **argv) {
+    int steps = argc > 1 ? atoi(argv[1]) : 2000000;
+    if (steps <= 0) steps = 2000000;
+
+    printf("FluxParser integration benchmark (%d Simpson steps, %d threads)\n\n",
+           steps, thread_pool_size(thread_pool_shared()));
+    printf("%-28s %12s %12s %8s\n", "integrand", "tree ms", "engine ms", "speedup");
+
+    for (size_t i = 0; i < sizeof(integrands) / sizeof(integrands[0]); i++) {
+        ParserErrorInfo error;
+        ASTNode *f = parse_expression_ast(integrands[i].expr, &error);
+
+        double start = now_seconds();
+        double tree = simpson_tree(f, integrands[i].a, integrands[i].b, steps);
+        double tree_ms = (now_seconds() - start) * 1e3;
+
+        start = now_seconds();
+        double engine = ast_integrate_numerical_simpson(f, "X", integrands[i].a, integrands[i].b, steps);
+        double engine_ms = (now_seconds() - start) * 1e3;
+
+        printf("%-28s %12.1f %12.1f %7.2fx   (|diff| %.1e)\n", integrands[i].expr, tree_ms, engine_ms,
+               tree_ms / engine_ms, fabs(tree - engine));
+        ast_free(f);
+    }
+
+    /* Evaluations to reach 1e-10: Simpson doubles steps until it gets there */
+    printf("\n%-28s %14s %14s %10s\n", "evaluations for 1e-10", "simpson", "gauss-kronrod", "gk error");
+    for (size_t i = 0; i < 3; i++) {
+        ParserErrorInfo error;
+        ASTNode *f = parse_expression_ast(integrands[i].expr, &error);
+        double exact = integrands[i].exact;
+
+        int n = 2;
+        while (n < (1 << 24) &&
+               fabs(ast_integrate_numerical_simpson(f, "X", integrands[i].a, integrands[i].b, n) - exact) > 1e-10) {
+            n *= 2;
+        }
+        IntegrationResult gk = ast_integrate_adaptive(f, "X", integrands[i].a, integrands[i].b, 1e-10, 0.0, 0);
+
+        printf("%-28s %14d %14d %10.1e\n", integrands[i].expr, n + 1, gk.evaluations, fabs(gk.value - exact));
+        ast_free(f);
+    }
+
+    /* exp(-|x|^2) over [-2, 2]^d to a relative 1e-4 */
+    static const char *names[INTEGRATE_MAX_DIMS] = {"X1", "X2", "X3", "X4", "X5", "X6", "X7", "X8", "X9", "X10"};
+    printf("\n%-28s %12s %10s %10s %12s %10s %10s\n", "exp(-|x|^2), rel 1e-4", "cubature", "error", "ms",
+           "sobol", "error", "ms");
+    for (int dims = 2; dims <= 8; dims += 2) {
+        char expr[256] = "exp(-(x1 * x1";
+        for (int d = 2; d <= dims; d++) snprintf(expr + strlen(expr), sizeof(expr) - strlen(expr), " + x%d * x%d", d, d);
+        strcat(expr, "))");
+        ParserErrorInfo error;
+        ASTNode *f = parse_expression_ast(expr, &error);
+        double lower[INTEGRATE_MAX_DIMS], upper[INTEGRATE_MAX_DIMS];
+        for (int d = 0; d < dims; d++) {
+            lower[d] = -2.0;
+            upper[d] = 2.0;
+        }
+        double exact = pow(sqrt(M_PI) * erf(2.0), dims);
+
+        double start = now_seconds();
+        IntegrationResult cube = ast_integrate_multi(f, names, lower, upper, dims, 0.0, 1e-4, 0, CUBATURE_ADAPTIVE);
+        double cube_ms = (now_seconds() - start) * 1e3;
+        start = now_seconds();
+        IntegrationResult sobol = ast_integrate_multi(f, names, lower, upper, dims, 0.0, 1e-4, 0, CUBATURE_SOBOL);
+        double sobol_ms = (now_seconds() - start) * 1e3;
+
+        char label[32];
+        snprintf(label, sizeof(label), "%d dimensions", dims);
+        printf("%-28s %11d%s %10.1e %10.1f %11d%s %10.1e %10.1f\n", label, cube.evaluations,
+               cube.converged ? " " : "*", fabs(cube.value - exact) / exact, cube_ms, sobol.evaluations,
+               sobol.converged ? " " : "*", fabs(sobol.value - exact) / exact, sobol_ms);
+        ast_free(f);
+    }
+    printf("(* = stopped at the default budget of a million evaluations)\n");
+    return 0;
+}
@@ -0,0 +1,107 @@
+/*
+ * FluxParser - Research-Grade C Math Parser
+ * Copyright (C) 2025 Eduardo Stern
+ *
+ * Dual Licensed:
+ * - GPL-3.0 for open-source/non-commercial use
+ * - Commercial license available - see LICENSE-COMMERCIAL.md
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * JIT benchmark: ast_evaluate() vs vm_execute() vs native code on the
+ * test_advanced expressions. Variables a and b vary per iteration so the
+ * work cannot be hoisted.
+ *
+ * Usage: ./bench_jit [iterations]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "ast.h"
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* From test_advanced.c (comparisons, logic, timeout and config tests) */
+static const char *expressions[] = {
+    "5 > 3",
+    "5 >= 5",
+    "5 != 6",
+    "(2 + 3) > 4",
+    "sqrt(16) == 4",
+    "abs(-5) != 5",
+    "5 > 3 && 10 < 20",
+    "5 < 3 || 10 > 20",
+    "!(5 > 3)",
+    "5 > 3 && 4 < 6 && 7 == 7",
+    "2 + 2 == 4 && 3 * 3 == 9",
+    "2 + 3 * 4",
+    "a > b && a != 0",
+    NULL,   /* "1+1+...+1" (501 terms), built in main() */
+};
+
+int main(int argc, char **argv) {
+    int iterations = argc > 1 ? atoi(argv[1]) : 1000000;
+    if (iterations <= 0) iterations = 1000000;
+
+    size_t count = sizeof(expressions) / sizeof(expressions[0]);
+    char long_expr[1100];
+    strcpy(long_expr, "1");
+    for (int i = 0; i < 500; i++) strcat(long_expr, "+1");
+    expressions[count - 1] = long_expr;
+
+    double values[2] = {10.0, 5.0};
+    VarContext ctx = {.values = values, .count = 2};
+    VM *vm = vm_create(&ctx);
+    volatile double sink = 0.0;
+
+    printf("FluxParser JIT benchmark (%d iterations, JIT %s)\n\n", iterations,
+           jit_supported() ? "available" : "not available on this platform");
+    printf("%-32s %10s %10s %10s %10s %10s\n", "expression", "ast ns/op",
+           "vm ns/op", "jit ns/op", "vs vm", "vs ast");
+
+    for (size_t e = 0; e < count; e++) {
+        CompiledExpression *ce = compile_expression(expressions[e]);
+        if (!ce) {
+            fprintf(stderr, "failed to compile '%s'\n", expressions[e]);
+            return 1;
+        }
+        bool native = compiled_expression_jit(ce) == 0;
+
+        double start = now_seconds();
+        for (int i = 0; i < iterations; i++) {
+            values[0] = i * 1e-3;
+            sink += ast_evaluate(ce->ast, &ctx);
+        }
+        double ast_ns = (now_seconds() - start) * 1e9 / iterations;
+
+        start = now_seconds();
+        for (int i = 0; i < iterations; i++) {
+            values[0] = i * 1e-3;
+            sink += vm_execute(vm, ce->bytecode);
+        }
+        double vm_ns = (now_seconds() - start) * 1e9 / iterations;
+
+        /* Falls back to the VM when native code is unavailable */
+        start = now_seconds();
+        for (int i = 0; i < iterations; i++) {
+            values[0] = i * 1e-3;
+            sink += compiled_expression_evaluate(ce, &ctx);
+        }
+        double jit_ns = (now_seconds() - start) * 1e9 / iterations;
+
+        printf("%-32.32s %10.1f %10.1f %9.1f%s %9.1fx %9.1fx\n", expressions[e],
+               ast_ns, vm_ns, jit_ns, native ? " " : "*", vm_ns / jit_ns, ast_ns / jit_ns);
+
+        compiled_expression_free(ce);
+    }
+
+    vm_free(vm);
+    printf("\n(* = VM fallback; checksum %.6g)\n", (double)sink);
+    return 0;
+}
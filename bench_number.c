@@ -0,0 +1,215 @@
+/*
+ * FluxParser - Research-Grade C Math Parser
+ * Copyright (C) 2025 Eduardo Stern
+ *
+ * Dual Licensed:
+ * - GPL-3.0 for open-source/non-commercial use
+ * - Commercial license available - see LICENSE-COMMERCIAL.md
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * Number scanning benchmark: number_parse() vs strtod() on literal corpora,
+ * number_scan_lines() vs a strtod() field loop on CSV text, and the parser
+ * on literal-heavy expressions close to PARSER_MAX_EXPR_LENGTH.
+ *
+ * Usage: ./bench_number [rounds]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+#include <time.h>
+#include "number.h"
+#include "parser.h"
+
+#define CORPUS_SIZE 4096
+#define SCAN_ROWS 100000
+#define SCAN_FIELDS 4
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static uint64_t rng_state = 0x2545F4914F6CDD1DULL;
+
+static uint64_t next_random(void) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 7;
+    rng_state ^= rng_state << 17;
+    return rng_state;
+}
+
+/* ============================================================================
+ * CORPORA
+ * ============================================================================
+ */
+
+typedef enum { KIND_INTEGER, KIND_SHORT, KIND_FULL, KIND_EXPONENT, KIND_COUNT } Kind;
+
+static const char *kind_names[KIND_COUNT] = {"integers", "short decimals", "17 digits", "exponents"};
+
+static int format_literal(char *out, size_t size, Kind kind) {
+    switch (kind) {
+        case KIND_INTEGER:
+            return snprintf(out, size, "%u", (unsigned)(next_random() % 1000000));
+        case KIND_SHORT:
+            return snprintf(out, size, "%.3f", (double)(next_random() % 100000) / 7.0);
+        case KIND_FULL:
+            return snprintf(out, size, "%.17g", (double)(next_random() >> 11) * 0x1p-53);
+        default:
+            return snprintf(out, size, "%.6e", (double)(next_random() >> 11) * 0x1p-53 *
+                            pow(10.0, (double)(next_random() % 600) - 300.0));
+    }
+}
+
+/* Literals separated by '\0', so strtod() sees each one terminated */
+static char* build_corpus(Kind kind, const char **starts) {
+    char *text = malloc(CORPUS_SIZE * 32);
+    char *p = text;
+    for (int i = 0; i < CORPUS_SIZE; i++) {
+        starts[i] = p;
+        p += format_literal(p, 31, kind) + 1;
+    }
+    return text;
+}
+
+static void bench_literals(int rounds) {
+    static const char *starts[CORPUS_SIZE];
+    volatile double sink = 0.0;
+
+    printf("%-16s %12s %12s %8s\n", "literals", "strtod ns", "number ns", "speedup");
+    for (int k = 0; k < KIND_COUNT; k++) {
+        char *text = build_corpus((Kind)k, starts);
+        size_t total = (size_t)rounds * CORPUS_SIZE;
+
+        double start = now_seconds();
+        for (int r = 0; r < rounds; r++) {
+            for (int i = 0; i < CORPUS_SIZE; i++) sink += strtod(starts[i], NULL);
+        }
+        double strtod_ns = (now_seconds() - start) * 1e9 / total;
+
+        start = now_seconds();
+        for (int r = 0; r < rounds; r++) {
+            for (int i = 0; i < CORPUS_SIZE; i++) {
+                double v;
+                number_parse(starts[i], starts[i] + strlen(starts[i]), &v);
+                sink += v;
+            }
+        }
+        double number_ns = (now_seconds() - start) * 1e9 / total;
+
+        printf("%-16s %12.1f %12.1f %7.2fx\n", kind_names[k], strtod_ns, number_ns, strtod_ns / number_ns);
+        free(text);
+    }
+    (void)sink;
+}
+
+/* ============================================================================
+ * DELIMITED LINES
+ * ============================================================================
+ */
+
+/* The field loop bulk evaluation would need without number_scan_lines() */
+static size_t scan_with_strtod(const char *text, double *const *columns) {
+    size_t rows = 0;
+    const char *p = text;
+    while (*p) {
+        for (int f = 0; f < SCAN_FIELDS; f++) {
+            char *stop;
+            columns[f][rows] = strtod(p, &stop);
+            p = *stop ? stop + 1 : stop;
+        }
+        rows++;
+    }
+    return rows;
+}
+
+static void bench_scan(int rounds) {
+    char *text = malloc((size_t)SCAN_ROWS * SCAN_FIELDS * 32 + 1);
+    char *p = text;
+    for (int r = 0; r < SCAN_ROWS; r++) {
+        for (int f = 0; f < SCAN_FIELDS; f++) {
+            p += format_literal(p, 31, f == 0 ? KIND_INTEGER : f == 3 ? KIND_FULL : KIND_SHORT);
+            *p++ = f + 1 < SCAN_FIELDS ? ',' : '\n';
+        }
+    }
+    *p = '\0';
+    size_t length = (size_t)(p - text);
+
+    double *storage = malloc(sizeof(double) * SCAN_ROWS * SCAN_FIELDS);
+    double *columns[SCAN_FIELDS];
+    for (int f = 0; f < SCAN_FIELDS; f++) columns[f] = storage + (size_t)f * SCAN_ROWS;
+    NumberScanFormat format = {.delimiter = ',', .field_count = SCAN_FIELDS, .wanted = NULL};
+
+    double start = now_seconds();
+    size_t rows = 0;
+    for (int r = 0; r < rounds; r++) rows += scan_with_strtod(text, columns);
+    double strtod_s = now_seconds() - start;
+
+    start = now_seconds();
+    for (int r = 0; r < rounds; r++) {
+        rows += number_scan_lines(text, text + length, &format, columns, SCAN_ROWS, NULL, NULL);
+    }
+    double scan_s = now_seconds() - start;
+
+    double megabytes = (double)length * rounds / 1e6;
+    printf("\n%-16s %12s %12s %8s\n", "CSV lines", "strtod MB/s", "scan MB/s", "speedup");
+    printf("%-16s %12.1f %12.1f %7.2fx\n", "4 fields", megabytes / strtod_s, megabytes / scan_s,
+           strtod_s / scan_s);
+    if (rows != 2 * (size_t)rounds * SCAN_ROWS) printf("row count mismatch: %zu\n", rows);
+
+    free(storage);
+    free(text);
+}
+
+/* ============================================================================
+ * LITERAL-HEAVY EXPRESSIONS
+ * ============================================================================
+ */
+
+static void bench_expressions(int rounds) {
+    static char expression[PARSER_MAX_EXPR_LENGTH];
+    ParserConfig config = {0};
+    volatile double sink = 0.0;
+
+    printf("\n%-16s %8s %12s %12s\n", "expressions", "chars", "us/parse", "MB/s");
+    for (int k = 0; k < KIND_COUNT; k++) {
+        /* A sum of literals just below the length limit */
+        size_t n = 0;
+        char literal[32];
+        for (;;) {
+            int length = format_literal(literal, sizeof(literal), (Kind)k);
+            if (n + (size_t)length + 3 >= sizeof(expression)) break;
+            if (n) {
+                memcpy(expression + n, " + ", 3);
+                n += 3;
+            }
+            memcpy(expression + n, literal, (size_t)length);
+            n += (size_t)length;
+        }
+        expression[n] = '\0';
+
+        double start = now_seconds();
+        for (int r = 0; r < rounds; r++) sink += parse_expression_ex(expression, NULL, &config).value;
+        double seconds = now_seconds() - start;
+
+        printf("%-16s %8zu %12.1f %12.1f\n", kind_names[k], n, seconds * 1e6 / rounds,
+               (double)n * rounds / seconds / 1e6);
+    }
+    (void)sink;
+}
+
+int main(int argc, char **argv) {
+    int rounds = argc > 1 ? atoi(argv[1]) : 200;
+    if (rounds <= 0) rounds = 200;
+
+    printf("FluxParser number scanning benchmark (%d rounds)\n\n", rounds);
+    bench_literals(rounds);
+    bench_scan(rounds / 20 > 0 ? rounds / 20 : 1);
+    bench_expressions(rounds);
+    return 0;
+}
@@ -0,0 +1,127 @@
+/*
+ * Thread scaling benchmark: one training iteration (forward, loss,
+ * backward, update) of the train_full default model, and its largest
+ * GEMM, on 1..N threads of the tensor kernel pool. Reports time, speedup
+ * over one thread and parallel efficiency, and checks that every thread
+ * count computes the same loss.
+ *
+ * Usage: ./bench_scaling [max threads] [iterations]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include "transformer_v2.h"
+#include "blas_wrapper.h"
+
+/* train_full defaults; vocabulary of the Shakespeare character dataset */
+#define VOCAB 66
+#define D_MODEL 256
+#define N_HEADS 8
+#define N_LAYERS 4
+#define D_FF 1024
+#define MAX_SEQ_LEN 128
+#define SEQ_LEN 64
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* One training step as train_full runs it; returns the loss */
+static double train_step(TransformerV2 *model, AdamOptimizerV2 *optimizer, int *inputs, int *targets) {
+    VariableV2 *logits = transformer_forward(model, inputs, SEQ_LEN);
+    VariableV2 *loss = compute_cross_entropy_loss(logits, targets, SEQ_LEN);
+    double value = loss->data->data[0];
+    loss->grad->data[0] = 1.0;
+    tape_backward(g_tape);
+    adam_step(optimizer);
+    autograd_reset_iteration();
+    return value;
+}
+
+/* Seconds per d_model x d_ff GEMM of the feed-forward layer */
+static double time_gemm(const double *A, const double *B, double *C, int iterations) {
+    matmul_optimized(A, B, C, SEQ_LEN, D_MODEL, D_FF, 0);    /* Warm-up */
+    double start = now_seconds();
+    for (int i = 0; i < iterations; i++) {
+        matmul_optimized(A, B, C, SEQ_LEN, D_MODEL, D_FF, 0);
+    }
+    return (now_seconds() - start) / iterations;
+}
+
+int main(int argc, char **argv) {
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    int max_threads = argc > 1 ? atoi(argv[1]) : (int)(cpus > 0 ? cpus : 1);
+    int iterations = argc > 2 ? atoi(argv[2]) : 5;
+    if (max_threads <= 0) max_threads = 1;
+    if (iterations <= 0) iterations = 5;
+
+    autograd_v2_init();
+    srand(42);
+    TransformerV2 *model = transformer_create(VOCAB, D_MODEL, N_HEADS, N_LAYERS, D_FF, MAX_SEQ_LEN);
+    VariableV2 **params;
+    int n_params;
+    transformer_get_params(model, &params, &n_params);
+
+    /* A zero learning rate keeps the weights, so every run sees the same model */
+    AdamOptimizerV2 *optimizer = adam_create(0.0);
+    for (int i = 0; i < n_params; i++) {
+        adam_add_param(optimizer, params[i]);
+    }
+    free(params);
+
+    int inputs[SEQ_LEN], targets[SEQ_LEN];
+    for (int i = 0; i < SEQ_LEN; i++) {
+        inputs[i] = rand() % VOCAB;
+        targets[i] = rand() % VOCAB;
+    }
+
+    double *A = malloc(sizeof(double) * SEQ_LEN * D_MODEL);
+    double *B = malloc(sizeof(double) * D_MODEL * D_FF);
+    double *C = malloc(sizeof(double) * SEQ_LEN * D_FF);
+    for (int i = 0; i < SEQ_LEN * D_MODEL; i++) A[i] = (double)rand() / RAND_MAX - 0.5;
+    for (int i = 0; i < D_MODEL * D_FF; i++) B[i] = (double)rand() / RAND_MAX - 0.5;
+
+    printf("\nThread scaling: d_model=%d, n_heads=%d, n_layers=%d, d_ff=%d, seq_len=%d (%ld CPUs online)\n\n",
+           D_MODEL, N_HEADS, N_LAYERS, D_FF, SEQ_LEN, cpus);
+    printf("%7s %12s %8s %10s %12s %8s\n", "threads", "ms/iter", "speedup", "efficiency", "GEMM ms", "speedup");
+
+    double base_iter = 0.0, base_gemm = 0.0, reference_loss = 0.0;
+    int failures = 0;
+    for (int threads = 1; threads <= max_threads; threads++) {
+        autograd_v2_set_threads(threads);
+
+        double loss = train_step(model, optimizer, inputs, targets);    /* Warm-up */
+        double start = now_seconds();
+        for (int i = 0; i < iterations; i++) {
+            train_step(model, optimizer, inputs, targets);
+        }
+        double iter_seconds = (now_seconds() - start) / iterations;
+        double gemm_seconds = time_gemm(A, B, C, 20 * iterations);
+
+        if (threads == 1) {
+            base_iter = iter_seconds;
+            base_gemm = gemm_seconds;
+            reference_loss = loss;
+        }
+        double speedup = base_iter / iter_seconds;
+        printf("%7d %12.2f %7.2fx %9.0f%% %12.3f %7.2fx", autograd_v2_threads(), iter_seconds * 1e3, speedup,
+               100.0 * speedup / threads, gemm_seconds * 1e3, base_gemm / gemm_seconds);
+        if (loss != reference_loss) {
+            printf("  LOSS MISMATCH (%.17g vs %.17g)", loss, reference_loss);
+            failures++;
+        }
+        printf("\n");
+    }
+
+    free(A);
+    free(B);
+    free(C);
+    adam_free(optimizer);
+    transformer_free(model);
+    autograd_v2_cleanup();
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,362 @@
+/*
+ * FluxParser - Research-Grade C Math Parser
+ * Copyright (C) 2025 Eduardo Stern
+ *
+ * Dual Licensed:
+ * - GPL-3.0 for open-source/non-commercial use
+ * - Commercial license available - see LICENSE-COMMERCIAL.md
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * Benchmark suite: a corpus of expressions in five categories (short
+ * arithmetic, trig-heavy, deep nesting, many variables, long expressions)
+ * timed on every evaluation path: the uncached parser, the cached
+ * parse_expression_with_vars_safe(), ast_evaluate(), vm_execute() and
+ * batched evaluation (per row). Each entry reports the mean ns/op and
+ * the p50/p99 of samples; a sample times a calibrated group of ops
+ * (about 2 us), since one op is close to the cost of reading the clock.
+ *
+ * Usage: ./bench_suite [--samples N] [--filter TEXT] [--json FILE]
+ *                      [--baseline FILE] [--threshold PERCENT]
+ *   --json FILE       write results as JSON ('-' for stdout)
+ *   --baseline FILE   compare p50 against a JSON file written earlier;
+ *                     exits 1 if an entry is slower by more than the
+ *                     threshold (default 10%)
+ *
+ * `make bench` runs it and writes bench_results.json (BASELINE=file to
+ * compare).
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include "ast.h"
+#include "parser.h"
+
+#define VAR_COUNT 23
+#define NESTED_DEPTH 11
+#define MAX_CATEGORY_EXPRESSIONS 8
+#define BATCH_ROWS 1024
+#define SAMPLE_TARGET_NS 2000.0
+#define DEFAULT_SAMPLES 2000
+#define DEFAULT_THRESHOLD 10.0
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/* ============================================================================
+ * CORPUS
+ * ============================================================================
+ */
+
+static const char *var_names[VAR_COUNT] = {
+    "X", "Y", "Z", "X1", "X2", "X3", "X4", "X5", "X6", "X7", "X8", "X9", "X10",
+    "X11", "X12", "X13", "X14", "X15", "X16", "X17", "X18", "X19", "X20",
+};
+
+typedef struct {
+    const char *name;
+    const char *expressions[MAX_CATEGORY_EXPRESSIONS];
+} Category;
+
+static char nested_deep[512], nested_calls[512], long_sum[2048], long_poly[2048], long_mixed[2048];
+
+static Category categories[] = {
+    {"short", {"2 + 3 * 4", "(1 + 2) / 3 - 4", "2 ^ 10 - 1000", "1.5 * 4 + 6 / 3 - 0.25"}},
+    {"trig", {"sin(x) * cos(y) + tan(x / 4)", "atan2(y, x) + asin(x / 10) - acos(y / 10)",
+              "sin(x)^2 + cos(x)^2 - sin(2 * x) / 2", "exp(-x * x) * cos(3 * y) + log(1 + x * x)"}},
+    {"nested", {"((((x + 1) * 2 - 3) / 4 + 5) * 6 - 7) / 8", nested_deep, nested_calls,
+                "(x > 0 && y > 0) || (x < 0 && (y < 0 || z == 0))"}},
+    {"variables", {"x1 * x2 + x3 * x4 - x5 * x6 + x7 * x8 - x9 * x10",
+                   "x11 + x12 + x13 + x14 + x15 + x16 + x17 + x18 + x19 + x20",
+                   "(x1 - x20) * (x2 - x19) / (1 + x3 * x3 + x18 * x18)",
+                   "min(x4, x5) + max(x6, x7) + abs(x8 - x9) + sqrt(x10 * x10 + x11 * x11)"}},
+    {"long", {long_sum, long_poly, long_mixed}},
+};
+
+#define CATEGORY_COUNT ((int)(sizeof(categories) / sizeof(categories[0])))
+
+static void build_corpus(void) {
+    /* Parentheses as deep as the parser allows (PARSER_MAX_DEPTH) */
+    char *p = nested_deep;
+    for (int i = 0; i < NESTED_DEPTH; i++) *p++ = '(';
+    p += sprintf(p, "x");
+    for (int i = 0; i < NESTED_DEPTH; i++) p += sprintf(p, " %c %d)", "+-*/"[i % 4], i % 4 == 3 ? 2 : i + 1);
+
+    /* Function calls nested 8 deep */
+    p = nested_calls;
+    static const char *calls[] = {"sqrt(", "abs(", "exp(", "sin(", "cos(", "log(1 + ", "abs(", "sqrt(1 + "};
+    for (int i = 0; i < 8; i++) p += sprintf(p, "%s", calls[i]);
+    p += sprintf(p, "x * y");
+    for (int i = 0; i < 8; i++) *p++ = ')';
+    *p = '\0';
+
+    p = long_sum;
+    for (int i = 1; i <= 20; i++) p += sprintf(p, "%s%d.5 * x%d", i > 1 ? " + " : "", i, i);
+
+    /* A degree-24 polynomial, term by term */
+    p = long_poly;
+    p += sprintf(p, "0.5");
+    for (int i = 1; i <= 24; i++) p += sprintf(p, " + %d.25 * x^%d", i % 7, i);
+
+    p = long_mixed;
+    for (int i = 1; i <= 12; i++) {
+        p += sprintf(p, "%ssin(x%d) * cos(x%d + %d) - sqrt(1 + x%d * x%d) / %d", i > 1 ? " + " : "", i, i + 1,
+                     i, i + 2, i + 2, i + 1);
+    }
+}
+
+/* ============================================================================
+ * EVALUATION PATHS
+ * ============================================================================
+ */
+
+typedef enum { PATH_PARSE, PATH_PARSE_CACHED, PATH_AST, PATH_VM, PATH_BATCH, PATH_COUNT } BenchPath;
+
+static const char *path_names[PATH_COUNT] = {"parse", "parse_cached", "ast_evaluate", "vm_execute", "batch"};
+
+typedef struct {
+    const char *text;
+    ASTNode *ast;
+    CompiledExpression *prepared;
+    VM *vm;
+} Entry;
+
+typedef struct {
+    Entry entries[MAX_CATEGORY_EXPRESSIONS];
+    int count;
+} Corpus;
+
+static double values[VAR_COUNT];
+static VarMapping mappings[VAR_COUNT];
+static VarContext named_vars = {.values = values, .count = VAR_COUNT, .mappings = mappings, .mapping_count = VAR_COUNT};
+static VarContext slot_vars = {.values = values, .count = VAR_COUNT};
+static double *columns[VAR_COUNT];
+static double batch_out[BATCH_ROWS];
+static volatile double sink;
+
+static double run_op(const Entry *e, BenchPath path) {
+    ParserConfig config = {0};
+    switch (path) {
+        case PATH_PARSE: return parse_expression_ex(e->text, &named_vars, &config).value;
+        case PATH_PARSE_CACHED: return parse_expression_with_vars_safe(e->text, &named_vars).value;
+        case PATH_AST: return ast_evaluate(e->ast, &named_vars);
+        case PATH_VM: return vm_execute(e->vm, e->prepared->bytecode);
+        case PATH_BATCH:
+            compiled_expression_evaluate_batch(e->prepared, (const double *const *)columns, VAR_COUNT, BATCH_ROWS,
+                                               batch_out);
+            return batch_out[BATCH_ROWS - 1];
+        default: return 0.0;
+    }
+}
+
+/* ============================================================================
+ * MEASUREMENT
+ * ============================================================================
+ */
+
+typedef struct {
+    char name[64];
+    const char *unit;
+    double ns_per_op;               /* Mean */
+    double p50, p99;
+    double baseline_p50;            /* 0: not in the baseline */
+} Result;
+
+static int compare_doubles(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+static void measure(const Corpus *corpus, BenchPath path, int samples, Result *result) {
+    /* Ops per sample: every expression of the category equally often, in
+     * rounds enough for SAMPLE_TARGET_NS */
+    long group = corpus->count;
+    for (;;) {
+        double start = now_ns();
+        for (long i = 0; i < group; i++) sink = run_op(&corpus->entries[i % corpus->count], path);
+        if (now_ns() - start >= SAMPLE_TARGET_NS || group >= (1L << 20)) break;
+        group *= 2;
+    }
+
+    double *times = malloc(sizeof(double) * samples);
+    double total = 0.0;
+    for (int s = -samples / 10; s < samples; s++) {         /* Warm-up samples first */
+        double start = now_ns();
+        for (long i = 0; i < group; i++) sink = run_op(&corpus->entries[i % corpus->count], path);
+        double elapsed = now_ns() - start;
+        if (s < 0) continue;
+        times[s] = elapsed / group;
+        total += elapsed;
+    }
+    qsort(times, samples, sizeof(double), compare_doubles);
+
+    double per = path == PATH_BATCH ? BATCH_ROWS : 1.0;
+    result->unit = path == PATH_BATCH ? "ns/row" : "ns/op";
+    result->ns_per_op = total / ((double)group * samples) / per;
+    result->p50 = times[samples / 2] / per;
+    result->p99 = times[(int)(samples * 0.99)] / per;
+    free(times);
+}
+
+/* ============================================================================
+ * JSON
+ * ============================================================================
+ */
+
+static bool write_json(const char *path, const Result *results, int count, int samples) {
+    FILE *f = strcmp(path, "-") == 0 ? stdout : fopen(path, "w");
+    if (!f) return false;
+    fprintf(f, "{\n  \"suite\": \"fluxparser\",\n  \"version\": 1,\n  \"samples\": %d,\n  \"results\": [\n", samples);
+    for (int i = 0; i < count; i++) {
+        fprintf(f, "    {\"name\": \"%s\", \"unit\": \"%s\", \"ns_per_op\": %.2f, \"p50_ns\": %.2f, \"p99_ns\": %.2f}%s\n",
+                results[i].name, results[i].unit, results[i].ns_per_op, results[i].p50, results[i].p99,
+                i + 1 < count ? "," : "");
+    }
+    fprintf(f, "  ]\n}\n");
+    return f == stdout ? fflush(f) == 0 : fclose(f) == 0;
+}
+
+/* Read p50_ns for each result name from a file written by write_json() */
+static bool read_baseline(const char *path, Result *results, int count) {
+    FILE *f = fopen(path, "r");
+    if (!f) return false;
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    char *text = malloc((size_t)size + 1);
+    size_t n = fread(text, 1, (size_t)size, f);
+    text[n] = '\0';
+    fclose(f);
+
+    for (const char *p = strstr(text, "\"name\": \""); p; p = strstr(p, "\"name\": \"")) {
+        p += strlen("\"name\": \"");
+        const char *name_end = strchr(p, '"');
+        const char *p50 = strstr(p, "\"p50_ns\": ");
+        const char *next = strstr(p, "\"name\": \"");
+        if (!name_end || !p50 || (next && p50 > next)) continue;
+        for (int i = 0; i < count; i++) {
+            if (strlen(results[i].name) == (size_t)(name_end - p) && strncmp(results[i].name, p, name_end - p) == 0) {
+                results[i].baseline_p50 = strtod(p50 + strlen("\"p50_ns\": "), NULL);
+            }
+        }
+    }
+    free(text);
+    return true;
+}
+
+int main(int argc, char **argv) {
+    int samples = DEFAULT_SAMPLES;
+    const char *json_path = NULL, *baseline_path = NULL, *filter = NULL;
+    double threshold = DEFAULT_THRESHOLD;
+
+    for (int i = 1; i < argc; i++) {
+        bool has_value = i + 1 < argc;
+        if (strcmp(argv[i], "--samples") == 0 && has_value) {
+            samples = atoi(argv[++i]);
+            if (samples < 10) samples = 10;
+        } else if (strcmp(argv[i], "--json") == 0 && has_value) {
+            json_path = argv[++i];
+        } else if (strcmp(argv[i], "--baseline") == 0 && has_value) {
+            baseline_path = argv[++i];
+        } else if (strcmp(argv[i], "--threshold") == 0 && has_value) {
+            threshold = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--filter") == 0 && has_value) {
+            filter = argv[++i];
+        } else {
+            fprintf(stderr, "Usage: %s [--samples N] [--filter TEXT] [--json FILE] [--baseline FILE] "
+                            "[--threshold PERCENT]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    build_corpus();
+    for (int v = 0; v < VAR_COUNT; v++) {
+        mappings[v].name = var_names[v];
+        mappings[v].index = v;
+        values[v] = 0.25 + 0.5 * v;
+        columns[v] = malloc(sizeof(double) * BATCH_ROWS);
+        for (int r = 0; r < BATCH_ROWS; r++) columns[v][r] = values[v] + r * 1e-3;
+    }
+
+    Corpus corpora[CATEGORY_COUNT];
+    for (int c = 0; c < CATEGORY_COUNT; c++) {
+        Corpus *corpus = &corpora[c];
+        corpus->count = 0;
+        for (int i = 0; i < MAX_CATEGORY_EXPRESSIONS && categories[c].expressions[i]; i++) {
+            Entry *e = &corpus->entries[corpus->count];
+            ParserErrorInfo error;
+            e->text = categories[c].expressions[i];
+            e->ast = parse_expression_ast(e->text, &error);
+            e->prepared = prepare_expression(e->text, var_names, VAR_COUNT, &error);
+            if (!e->ast || !e->prepared) {
+                fprintf(stderr, "bench_suite: %s: %s\n", e->text, error.message);
+                return 1;
+            }
+            e->vm = vm_create(&slot_vars);
+            corpus->count++;
+        }
+    }
+
+    /* The table goes to stderr when the JSON goes to stdout */
+    FILE *report = json_path && strcmp(json_path, "-") == 0 ? stderr : stdout;
+    Result results[CATEGORY_COUNT * PATH_COUNT];
+    int count = 0;
+    fprintf(report, "FluxParser benchmark suite (%d samples per entry)\n\n", samples);
+    fprintf(report, "%-26s %10s %10s %10s %8s\n", "benchmark", "mean", "p50", "p99", "unit");
+    for (int c = 0; c < CATEGORY_COUNT; c++) {
+        for (int path = 0; path < PATH_COUNT; path++) {
+            Result *r = &results[count];
+            memset(r, 0, sizeof(*r));
+            snprintf(r->name, sizeof(r->name), "%s/%s", categories[c].name, path_names[path]);
+            if (filter && !strstr(r->name, filter)) continue;
+
+            measure(&corpora[c], (BenchPath)path, samples, r);
+            fprintf(report, "%-26s %10.1f %10.1f %10.1f %8s\n", r->name, r->ns_per_op, r->p50, r->p99, r->unit);
+            fflush(report);
+            count++;
+        }
+    }
+
+    int regressions = 0;
+    if (baseline_path) {
+        if (!read_baseline(baseline_path, results, count)) {
+            fprintf(stderr, "bench_suite: cannot read baseline %s\n", baseline_path);
+            return 1;
+        }
+        fprintf(report, "\nComparison with %s (p50, threshold %.0f%%)\n\n", baseline_path, threshold);
+        fprintf(report, "%-26s %10s %10s %9s\n", "benchmark", "baseline", "current", "change");
+        for (int i = 0; i < count; i++) {
+            if (results[i].baseline_p50 <= 0.0) {
+                fprintf(report, "%-26s %10s %10.1f %9s\n", results[i].name, "-", results[i].p50, "new");
+                continue;
+            }
+            double change = (results[i].p50 / results[i].baseline_p50 - 1.0) * 100.0;
+            bool regressed = change > threshold;
+            regressions += regressed;
+            fprintf(report, "%-26s %10.1f %10.1f %+8.1f%%%s\n", results[i].name, results[i].baseline_p50, results[i].p50,
+                   change, regressed ? "  REGRESSION" : change < -threshold ? "  faster" : "");
+        }
+        fprintf(report, "\n%d regression%s\n", regressions, regressions == 1 ? "" : "s");
+    }
+
+    if (json_path && !write_json(json_path, results, count, samples)) {
+        fprintf(stderr, "bench_suite: cannot write %s\n", json_path);
+        return 1;
+    }
+
+    for (int c = 0; c < CATEGORY_COUNT; c++) {
+        for (int i = 0; i < corpora[c].count; i++) {
+            ast_free(corpora[c].entries[i].ast);
+            compiled_expression_free(corpora[c].entries[i].prepared);
+            vm_free(corpora[c].entries[i].vm);
+        }
+    }
+    for (int v = 0; v < VAR_COUNT; v++) free(columns[v]);
+    return regressions > 0 ? 1 : 0;
+}
@@ -0,0 +1,93 @@
+/*
+ * FluxParser - Research-Grade C Math Parser
+ * Copyright (C) 2025 Eduardo Stern
+ *
+ * Dual Licensed:
+ * - GPL-3.0 for open-source/non-commercial use
+ * - Commercial license available - see LICENSE-COMMERCIAL.md
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * Evaluator benchmark: tree-walking ast_evaluate() vs the reference stack
+ * interpreter (vm_execute_stack) vs the register VM (vm_execute), all on
+ * the same compiled expression.
+ *
+ * Usage: ./bench_vm [iterations]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "ast.h"
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static const char *expressions[] = {
+    "2 + 3 * 4",
+    "x * x + 2 * x * y + y * y",
+    "(x + 1) * (x - 1) / (y + 2) - x / 3",
+    "sin(x) * cos(y) + tan(x / 4)",
+    "sqrt(x * x + y * y) / (1 + exp(-x))",
+    "(x > 0 && y > 0) || (x < 0 && y < 0)",
+    "((((x + 1) * 2 - 3) / 4 + 5) * 6 - 7) / 8",
+    "min(x, y) + max(x, y) + abs(x - y) + floor(x * 10) / 10",
+};
+
+int main(int argc, char **argv) {
+    int iterations = argc > 1 ? atoi(argv[1]) : 1000000;
+    if (iterations <= 0) iterations = 1000000;
+
+    double values[26] = {0};
+    VarContext ctx = {.values = values, .count = 26};
+    VM *vm = vm_create(&ctx);
+    volatile double sink = 0.0;
+
+    printf("FluxParser evaluator benchmark (%d iterations)\n\n", iterations);
+    printf("%-40s %10s %10s %10s %10s %10s\n", "expression", "ast ns/op",
+           "stack ns/op", "reg ns/op", "vs stack", "vs ast");
+
+    for (size_t e = 0; e < sizeof(expressions) / sizeof(expressions[0]); e++) {
+        CompiledExpression *ce = compile_expression(expressions[e]);
+        if (!ce) {
+            fprintf(stderr, "failed to compile '%s'\n", expressions[e]);
+            return 1;
+        }
+
+        double start = now_seconds();
+        for (int i = 0; i < iterations; i++) {
+            values['X' - 'A'] = i * 1e-6;
+            values['Y' - 'A'] = 1.0 - i * 1e-6;
+            sink += ast_evaluate(ce->ast, &ctx);
+        }
+        double ast_ns = (now_seconds() - start) * 1e9 / iterations;
+
+        start = now_seconds();
+        for (int i = 0; i < iterations; i++) {
+            values['X' - 'A'] = i * 1e-6;
+            values['Y' - 'A'] = 1.0 - i * 1e-6;
+            sink += vm_execute_stack(vm, ce->bytecode);
+        }
+        double stack_ns = (now_seconds() - start) * 1e9 / iterations;
+
+        start = now_seconds();
+        for (int i = 0; i < iterations; i++) {
+            values['X' - 'A'] = i * 1e-6;
+            values['Y' - 'A'] = 1.0 - i * 1e-6;
+            sink += vm_execute(vm, ce->bytecode);
+        }
+        double reg_ns = (now_seconds() - start) * 1e9 / iterations;
+
+        printf("%-40.40s %10.1f %10.1f %10.1f %9.1fx %9.1fx\n", expressions[e],
+               ast_ns, stack_ns, reg_ns, stack_ns / reg_ns, ast_ns / reg_ns);
+
+        compiled_expression_free(ce);
+    }
+
+    vm_free(vm);
+    printf("\n(checksum %.6g)\n", (double)sink);
+    return 0;
+}
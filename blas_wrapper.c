@@ -1,30 +1,339 @@
 /*
  * BLAS Wrapper Implementation
+ *
+ * Without BLAS, matrix multiplication uses a packed, cache-blocked GEMM:
+ * B is packed into KC x NC panels (L3), A into MC x KC blocks (L2), and a
+ * register-blocked MR x NR micro-kernel streams one KC-long sliver of each
+ * (L1). On x86 the micro-kernel uses AVX2/FMA when the CPU has them,
+ * chosen at run time; elsewhere (or built with -DNO_SIMD) a portable
+ * kernel runs on the same packed layout. With a worker pool, large
+ * products are cut into tiles of C that run the blocked GEMM in parallel.
  */
 
 #include "blas_wrapper.h"
+#include <stdlib.h>
+#include <stdbool.h>
 #include <string.h>
 
-/* Pure C fallback implementation */
-static void matmul_pure_c(const double *A, const double *B, double *C,
-                         int m, int k, int n) {
-    /* C = A * B where A is m×k, B is k×n, C is m×n */
-    for (int i = 0; i < m; i++) {
-        for (int j = 0; j < n; j++) {
-            double sum = 0.0;
-            for (int l = 0; l < k; l++) {
-                sum += A[i * k + l] * B[l * n + j];
+#if !defined(NO_SIMD) && defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    #define GEMM_AVX2 1
+    #include <immintrin.h>
+#else
+    #define GEMM_AVX2 0
+#endif
+
+/* ============================================================================
+ * BLOCKED GEMM
+ * ============================================================================
+ */
+
+#define GEMM_MR 6                   /* Micro-tile rows */
+#define GEMM_NR 8                   /* Micro-tile columns (two AVX2 vectors) */
+#define GEMM_KC 256                 /* Shared dimension per packed block */
+#define GEMM_MC 72                  /* Rows of A per packed block (multiple of MR) */
+#define GEMM_NC 2048                /* Columns of B per packed panel (multiple of NR) */
+#define GEMM_SMALL 32768            /* m*n*k below which packing does not pay */
+#define GEMM_PARALLEL 262144        /* m*n*k below which one thread does it all */
+#define TRANSPOSE_BLOCK 32          /* Square tiles a transpose moves at once */
+
+static ThreadPool *g_pool = NULL;
+
+void blas_set_thread_pool(ThreadPool *pool) {
+    g_pool = pool;
+}
+
+/* C[MR x NR] (= or +=) packed A sliver * packed B sliver */
+typedef void (*GemmKernel)(int kc, const double *a, const double *b, double *c, int ldc, int accumulate);
+
+static void kernel_scalar(int kc, const double *a, const double *b, double *c, int ldc, int accumulate) {
+    double acc[GEMM_MR][GEMM_NR] = {{0}};
+    for (int l = 0; l < kc; l++) {
+        for (int i = 0; i < GEMM_MR; i++) {
+            double ai = a[i];
+            for (int j = 0; j < GEMM_NR; j++) {
+                acc[i][j] += ai * b[j];
+            }
+        }
+        a += GEMM_MR;
+        b += GEMM_NR;
+    }
+    for (int i = 0; i < GEMM_MR; i++) {
+        for (int j = 0; j < GEMM_NR; j++) {
+            c[i * ldc + j] = accumulate ? c[i * ldc + j] + acc[i][j] : acc[i][j];
+        }
+    }
+}
+
+#if GEMM_AVX2
+/* 12 accumulators + 2 B vectors + 1 broadcast = 15 of the 16 ymm registers */
+#define ROW_FMA(r) \
+    do { \
+        __m256d ar = _mm256_broadcast_sd(a + (r)); \
+        c##r##0 = _mm256_fmadd_pd(ar, b0, c##r##0); \
+        c##r##1 = _mm256_fmadd_pd(ar, b1, c##r##1); \
+    } while (0)
+
+#define ROW_STORE(r) \
+    do { \
+        double *cr = c + (r) * ldc; \
+        if (accumulate) { \
+            c##r##0 = _mm256_add_pd(c##r##0, _mm256_loadu_pd(cr)); \
+            c##r##1 = _mm256_add_pd(c##r##1, _mm256_loadu_pd(cr + 4)); \
+        } \
+        _mm256_storeu_pd(cr, c##r##0); \
+        _mm256_storeu_pd(cr + 4, c##r##1); \
+    } while (0)
+
+__attribute__((target("avx2,fma")))
+static void kernel_avx2(int kc, const double *a, const double *b, double *c, int ldc, int accumulate) {
+    __m256d c00 = _mm256_setzero_pd(), c01 = _mm256_setzero_pd();
+    __m256d c10 = _mm256_setzero_pd(), c11 = _mm256_setzero_pd();
+    __m256d c20 = _mm256_setzero_pd(), c21 = _mm256_setzero_pd();
+    __m256d c30 = _mm256_setzero_pd(), c31 = _mm256_setzero_pd();
+    __m256d c40 = _mm256_setzero_pd(), c41 = _mm256_setzero_pd();
+    __m256d c50 = _mm256_setzero_pd(), c51 = _mm256_setzero_pd();
+
+    for (int l = 0; l < kc; l++) {
+        __m256d b0 = _mm256_loadu_pd(b);
+        __m256d b1 = _mm256_loadu_pd(b + 4);
+        ROW_FMA(0);
+        ROW_FMA(1);
+        ROW_FMA(2);
+        ROW_FMA(3);
+        ROW_FMA(4);
+        ROW_FMA(5);
+        a += GEMM_MR;
+        b += GEMM_NR;
+    }
+
+    ROW_STORE(0);
+    ROW_STORE(1);
+    ROW_STORE(2);
+    ROW_STORE(3);
+    ROW_STORE(4);
+    ROW_STORE(5);
+}
+
+#undef ROW_FMA
+#undef ROW_STORE
+#endif
+
+static GemmKernel select_kernel(void) {
+#if GEMM_AVX2
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) return kernel_avx2;
+#endif
+    return kernel_scalar;
+}
+
+/* Element (i, l) of A is A[i * rs + l * cs]; rows past mc are zero */
+static void pack_a(int mc, int kc, const double *A, int rs, int cs, double *packed) {
+    for (int ir = 0; ir < mc; ir += GEMM_MR) {
+        int mr = mc - ir < GEMM_MR ? mc - ir : GEMM_MR;
+        const double *panel = A + (size_t)ir * rs;
+        for (int l = 0; l < kc; l++) {
+            int i = 0;
+            for (; i < mr; i++) *packed++ = panel[(size_t)i * rs + (size_t)l * cs];
+            for (; i < GEMM_MR; i++) *packed++ = 0.0;
+        }
+    }
+}
+
+/* Element (l, j) of B is B[l * rs + j * cs]; columns past nc are zero */
+static void pack_b(int kc, int nc, const double *B, int rs, int cs, double *packed) {
+    for (int jr = 0; jr < nc; jr += GEMM_NR) {
+        int nr = nc - jr < GEMM_NR ? nc - jr : GEMM_NR;
+        const double *panel = B + (size_t)jr * cs;
+        for (int l = 0; l < kc; l++) {
+            const double *row = panel + (size_t)l * rs;
+            if (nr == GEMM_NR && cs == 1) {
+                memcpy(packed, row, sizeof(double) * GEMM_NR);
+                packed += GEMM_NR;
+                continue;
+            }
+            int j = 0;
+            for (; j < nr; j++) *packed++ = row[(size_t)j * cs];
+            for (; j < GEMM_NR; j++) *packed++ = 0.0;
+        }
+    }
+}
+
+/* One packed block of A times one packed panel of B into C */
+static void gemm_macro(GemmKernel kernel, int mc, int nc, int kc, const double *packed_a,
+                       const double *packed_b, double *C, int ldc, int accumulate) {
+    for (int jr = 0; jr < nc; jr += GEMM_NR) {
+        int nr = nc - jr < GEMM_NR ? nc - jr : GEMM_NR;
+        for (int ir = 0; ir < mc; ir += GEMM_MR) {
+            int mr = mc - ir < GEMM_MR ? mc - ir : GEMM_MR;
+            const double *a = packed_a + (size_t)ir * kc;
+            const double *b = packed_b + (size_t)jr * kc;
+            double *c = C + (size_t)ir * ldc + jr;
+
+            if (mr == GEMM_MR && nr == GEMM_NR) {
+                kernel(kc, a, b, c, ldc, accumulate);
+                continue;
+            }
+            /* Edge tile: compute the full tile aside, keep its valid part */
+            double tile[GEMM_MR * GEMM_NR];
+            kernel(kc, a, b, tile, GEMM_NR, 0);
+            for (int i = 0; i < mr; i++) {
+                for (int j = 0; j < nr; j++) {
+                    double v = tile[i * GEMM_NR + j];
+                    c[(size_t)i * ldc + j] = accumulate ? c[(size_t)i * ldc + j] + v : v;
+                }
             }
-            C[i * n + j] = sum;
         }
     }
 }
 
-static void transpose_pure_c(const double *A, double *B, int m, int n) {
-    /* B = A^T where A is m×n, B is n×m */
+/* C (m x n, row stride ldc) = A * B, or += if accumulate, with
+ * A(i, l) = A[i * rs_a + l * cs_a] and B(l, j) = B[l * rs_b + j * cs_b].
+ * Returns 0 if the packing buffers could not be allocated (C untouched).
+ */
+static int gemm_blocked(int m, int n, int k, const double *A, int rs_a, int cs_a,
+                        const double *B, int rs_b, int cs_b, double *C, int ldc, int accumulate) {
+    int kc_max = k < GEMM_KC ? k : GEMM_KC;
+    int nc_max = n < GEMM_NC ? n : GEMM_NC;
+    nc_max = (nc_max + GEMM_NR - 1) / GEMM_NR * GEMM_NR;
+    int mc_max = m < GEMM_MC ? m : GEMM_MC;
+    mc_max = (mc_max + GEMM_MR - 1) / GEMM_MR * GEMM_MR;
+
+    double *packed_a = malloc(sizeof(double) * (size_t)mc_max * kc_max);
+    double *packed_b = malloc(sizeof(double) * (size_t)kc_max * nc_max);
+    if (!packed_a || !packed_b) {
+        free(packed_a);
+        free(packed_b);
+        return 0;
+    }
+
+    GemmKernel kernel = select_kernel();
+    for (int jc = 0; jc < n; jc += GEMM_NC) {
+        int nc = n - jc < GEMM_NC ? n - jc : GEMM_NC;
+        for (int pc = 0; pc < k; pc += GEMM_KC) {
+            int kc = k - pc < GEMM_KC ? k - pc : GEMM_KC;
+            pack_b(kc, nc, B + (size_t)pc * rs_b + (size_t)jc * cs_b, rs_b, cs_b, packed_b);
+            for (int ic = 0; ic < m; ic += GEMM_MC) {
+                int mc = m - ic < GEMM_MC ? m - ic : GEMM_MC;
+                pack_a(mc, kc, A + (size_t)ic * rs_a + (size_t)pc * cs_a, rs_a, cs_a, packed_a);
+                gemm_macro(kernel, mc, nc, kc, packed_a, packed_b, C + (size_t)ic * ldc + jc, ldc,
+                           accumulate || pc > 0);
+            }
+        }
+    }
+
+    free(packed_a);
+    free(packed_b);
+    return 1;
+}
+
+/* Unpacked loops over strided operands, for small products and for when
+ * packing fails. When rows of B are contiguous the i-l-j order streams
+ * them; otherwise (B transposed) each C element is a dot product along
+ * columns of B, which are then contiguous.
+ */
+static void gemm_unpacked(int m, int n, int k, const double *A, int rs_a, int cs_a,
+                          const double *B, int rs_b, int cs_b, double *C, int ldc, int accumulate) {
     for (int i = 0; i < m; i++) {
-        for (int j = 0; j < n; j++) {
-            B[j * m + i] = A[i * n + j];
+        double *c = C + (size_t)i * ldc;
+        const double *a = A + (size_t)i * rs_a;
+        if (cs_b != 1) {
+            for (int j = 0; j < n; j++) {
+                const double *b = B + (size_t)j * cs_b;
+                double sum = 0.0;
+                for (int l = 0; l < k; l++) {
+                    sum += a[(size_t)l * cs_a] * b[(size_t)l * rs_b];
+                }
+                c[j] = accumulate ? c[j] + sum : sum;
+            }
+            continue;
+        }
+        if (!accumulate) memset(c, 0, sizeof(double) * (size_t)n);
+        for (int l = 0; l < k; l++) {
+            double al = a[(size_t)l * cs_a];
+            const double *b = B + (size_t)l * rs_b;
+            for (int j = 0; j < n; j++) {
+                c[j] += al * b[j];
+            }
+        }
+    }
+}
+
+/* ============================================================================
+ * PARALLEL TILES
+ * ============================================================================
+ */
+
+typedef struct {
+    int m, n, k;
+    const double *A;
+    int rs_a, cs_a;
+    const double *B;
+    int rs_b, cs_b;
+    double *C;
+    int ldc;
+    int accumulate;
+    int tile_rows, tile_cols;       /* Multiples of MR and NR */
+    int tiles_n;
+} GemmTiles;
+
+static void gemm_tile(void *arg, size_t index) {
+    const GemmTiles *t = arg;
+    int i0 = (int)(index / (size_t)t->tiles_n) * t->tile_rows;
+    int j0 = (int)(index % (size_t)t->tiles_n) * t->tile_cols;
+    int mt = t->m - i0 < t->tile_rows ? t->m - i0 : t->tile_rows;
+    int nt = t->n - j0 < t->tile_cols ? t->n - j0 : t->tile_cols;
+
+    const double *A = t->A + (size_t)i0 * t->rs_a;
+    const double *B = t->B + (size_t)j0 * t->cs_b;
+    double *C = t->C + (size_t)i0 * t->ldc + j0;
+    if (!gemm_blocked(mt, nt, t->k, A, t->rs_a, t->cs_a, B, t->rs_b, t->cs_b, C, t->ldc, t->accumulate)) {
+        gemm_unpacked(mt, nt, t->k, A, t->rs_a, t->cs_a, B, t->rs_b, t->cs_b, C, t->ldc, t->accumulate);
+    }
+}
+
+/* Split C into a few tiles per thread, cutting the longer side first */
+static void gemm_parallel(ThreadPool *pool, int m, int n, int k, const double *A, int rs_a, int cs_a,
+                          const double *B, int rs_b, int cs_b, double *C, int ldc, int accumulate) {
+    int target = thread_pool_size(pool) * 2;
+    int tiles_m = 1, tiles_n = 1;
+    while (tiles_m * tiles_n < target) {
+        bool split_m = m / (tiles_m + 1) >= 2 * GEMM_MR;
+        bool split_n = n / (tiles_n + 1) >= 2 * GEMM_NR;
+        if (split_m && (!split_n || m / tiles_m >= n / tiles_n)) {
+            tiles_m++;
+        } else if (split_n) {
+            tiles_n++;
+        } else {
+            break;
+        }
+    }
+
+    GemmTiles t = {m, n, k, A, rs_a, cs_a, B, rs_b, cs_b, C, ldc, accumulate, 0, 0, 0};
+    t.tile_rows = ((m + tiles_m - 1) / tiles_m + GEMM_MR - 1) / GEMM_MR * GEMM_MR;
+    t.tile_cols = ((n + tiles_n - 1) / tiles_n + GEMM_NR - 1) / GEMM_NR * GEMM_NR;
+    t.tiles_n = (n + t.tile_cols - 1) / t.tile_cols;
+    size_t count = (size_t)((m + t.tile_rows - 1) / t.tile_rows) * (size_t)t.tiles_n;
+    thread_pool_for(pool, count, gemm_tile, &t);
+}
+
+typedef struct {
+    const double *A;
+    double *B;
+    int m, n;
+    int accumulate;
+} TransposeBlocks;
+
+/* One band of TRANSPOSE_BLOCK rows of A, moved in square tiles */
+static void transpose_band(void *arg, size_t index) {
+    const TransposeBlocks *t = arg;
+    int i0 = (int)index * TRANSPOSE_BLOCK;
+    int i1 = t->m - i0 < TRANSPOSE_BLOCK ? t->m : i0 + TRANSPOSE_BLOCK;
+    for (int j0 = 0; j0 < t->n; j0 += TRANSPOSE_BLOCK) {
+        int j1 = t->n - j0 < TRANSPOSE_BLOCK ? t->n : j0 + TRANSPOSE_BLOCK;
+        for (int i = i0; i < i1; i++) {
+            for (int j = j0; j < j1; j++) {
+                double v = t->A[(size_t)i * t->n + j];
+                t->B[(size_t)j * t->m + i] = t->accumulate ? t->B[(size_t)j * t->m + i] + v : v;
+            }
         }
     }
 }
@@ -32,37 +341,57 @@ static void transpose_pure_c(const double *A, double *B, int m, int n) {
 /* Optimized matrix multiplication */
 void matmul_optimized(const double *A, const double *B, double *C,
                      int m, int k, int n, int use_blas) {
+    matmul_optimized_ex(A, B, C, m, k, n, 0, 0, 0, use_blas);
+}
+
+void matmul_optimized_ex(const double *A, const double *B, double *C, int m, int k, int n,
+                         int trans_a, int trans_b, int accumulate, int use_blas) {
 #if HAS_BLAS
     if (use_blas) {
-        /* Use BLAS dgemm: C = alpha*A*B + beta*C
-         * We want C = A*B, so alpha=1, beta=0
+        /* Use BLAS dgemm: C = alpha*op(A)*op(B) + beta*C
+         * alpha=1, and beta=1 when accumulating, else 0
          *
          * BLAS dgemm signature:
          * cblas_dgemm(Order, TransA, TransB, M, N, K,
          *             alpha, A, lda, B, ldb, beta, C, ldc)
          *
-         * For C = A*B (no transpose):
-         * - Order: CblasRowMajor
-         * - TransA: CblasNoTrans
-         * - TransB: CblasNoTrans
-         * - M, N, K: dimensions
-         * - lda = K (leading dimension of A)
-         * - ldb = N (leading dimension of B)
-         * - ldc = N (leading dimension of C)
+         * Row-major leading dimensions are the stored row lengths:
+         * - lda = K, or M if A is stored transposed (k×m)
+         * - ldb = N, or K if B is stored transposed (n×k)
+         * - ldc = N
          */
-        cblas_dgemm(CblasRowMajor, CblasNoTrans, CblasNoTrans,
+        cblas_dgemm(CblasRowMajor, trans_a ? CblasTrans : CblasNoTrans,
+                   trans_b ? CblasTrans : CblasNoTrans,
                    m, n, k,
-                   1.0, A, k, B, n,
-                   0.0, C, n);
+                   1.0, A, trans_a ? m : k, B, trans_b ? k : n,
+                   accumulate ? 1.0 : 0.0, C, n);
         return;
     }
+#else
+    (void)use_blas;
 #endif
-    /* Fallback to pure C */
-    matmul_pure_c(A, B, C, m, k, n);
+    if (m <= 0 || n <= 0) return;
+    if (k < 0) k = 0;
+
+    /* op(A)(i, l) = A[i * rs_a + l * cs_a], op(B)(l, j) = B[l * rs_b + j * cs_b] */
+    int rs_a = trans_a ? 1 : k, cs_a = trans_a ? m : 1;
+    int rs_b = trans_b ? 1 : n, cs_b = trans_b ? k : 1;
+    size_t work = (size_t)m * n * k;
+    if (work < GEMM_SMALL) {
+        gemm_unpacked(m, n, k, A, rs_a, cs_a, B, rs_b, cs_b, C, n, accumulate);
+    } else if (work >= GEMM_PARALLEL && thread_pool_size(g_pool) > 1) {
+        gemm_parallel(g_pool, m, n, k, A, rs_a, cs_a, B, rs_b, cs_b, C, n, accumulate);
+    } else if (!gemm_blocked(m, n, k, A, rs_a, cs_a, B, rs_b, cs_b, C, n, accumulate)) {
+        gemm_unpacked(m, n, k, A, rs_a, cs_a, B, rs_b, cs_b, C, n, accumulate);
+    }
 }
 
 /* Optimized transpose */
 void transpose_optimized(const double *A, double *B, int m, int n, int use_blas) {
+    transpose_optimized_ex(A, B, m, n, 0, use_blas);
+}
+
+void transpose_optimized_ex(const double *A, double *B, int m, int n, int accumulate, int use_blas) {
 #if HAS_BLAS
     if (use_blas) {
         /* BLAS doesn't have a dedicated transpose, but we can use dgemm
@@ -71,9 +400,14 @@ void transpose_optimized(const double *A, double *B, int m, int n, int use_blas)
          * But simpler: just use the pure C version (it's fast enough for transpose)
          */
     }
+#else
+    (void)use_blas;
 #endif
-    /* Always use pure C for transpose (simple enough, memory-bound anyway) */
-    transpose_pure_c(A, B, m, n);
+    /* Always use pure C for transpose (simple enough, memory-bound anyway):
+     * square tiles keep both sides in cache, bands of rows run in parallel */
+    TransposeBlocks t = {A, B, m, n, accumulate};
+    size_t bands = (size_t)(m + TRANSPOSE_BLOCK - 1) / TRANSPOSE_BLOCK;
+    thread_pool_for((size_t)m * n >= GEMM_SMALL ? g_pool : NULL, bands, transpose_band, &t);
 }
 
 /* Check if BLAS is available */
@@ -90,6 +424,6 @@ const char* get_blas_impl(void) {
         return "OpenBLAS";
     #endif
 #else
-    return "Pure C (no BLAS)";
+    return select_kernel() == kernel_scalar ? "Pure C (blocked)" : "Pure C (blocked, AVX2/FMA)";
 #endif
 }
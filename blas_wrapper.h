@@ -7,6 +7,7 @@
 #define BLAS_WRAPPER_H
 
 #include <stddef.h>
+#include "threadpool.h"
 
 /* Check if we have BLAS available */
 #ifdef __APPLE__
@@ -27,11 +28,29 @@
 void matmul_optimized(const double *A, const double *B, double *C,
                      int m, int k, int n, int use_blas);
 
+/* General form: C = op(A) * op(B), or C += op(A) * op(B) if accumulate
+ * op(A): m×k, stored k×m (A^T) if trans_a
+ * op(B): k×n, stored n×k (B^T) if trans_b
+ * C: m×n
+ */
+void matmul_optimized_ex(const double *A, const double *B, double *C, int m, int k, int n,
+                         int trans_a, int trans_b, int accumulate, int use_blas);
+
 /* Matrix transpose: B = A^T
  * A: m×n, B: n×m
  */
 void transpose_optimized(const double *A, double *B, int m, int n, int use_blas);
 
+/* B = A^T, or B += A^T if accumulate */
+void transpose_optimized_ex(const double *A, double *B, int m, int n, int accumulate, int use_blas);
+
+/* Worker pool for the pure C matmul and transpose (NULL: calling thread
+ * only). Large products are split into tiles of C, each computed whole by
+ * one thread, so results do not depend on the thread count. Set it while
+ * no matmul is running.
+ */
+void blas_set_thread_pool(ThreadPool *pool);
+
 /* Check if BLAS is available */
 int has_blas(void);
 
@@ -0,0 +1,663 @@
+/*
+ * FluxParser - Research-Grade C Math Parser
+ * Copyright (C) 2025 Eduardo Stern
+ *
+ * Dual Licensed:
+ * - GPL-3.0 for open-source/non-commercial use
+ * - Commercial license available - see LICENSE-COMMERCIAL.md
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * Streaming bulk evaluator: evaluates compiled expressions over every row
+ * of a delimited numeric file (CSV, TSV or whitespace-separated lines).
+ *
+ * The input is memory-mapped and cut into chunks of whole lines. A batch
+ * of chunks runs on the shared worker pool: each chunk parses the columns
+ * the expressions use into reusable column arrays, evaluates every
+ * expression with the batched VM and formats its output lines into a
+ * reusable buffer. Batches alternate between two sets of chunks, so a
+ * writer thread writes one batch while the pool works on the next and the
+ * kernel reads ahead into the one after. Nothing is allocated per row.
+ *
+ * Usage: ./bulk_eval [options] -e EXPR [-e EXPR ...] INPUT
+ *   -e [NAME=]EXPR  Expression over the input columns, named by the header
+ *                   (repeatable; NAME labels the output column)
+ *   -o FILE         Output file (default: stdout)
+ *   -d CHAR         Input delimiter: ',', ';', 't' (tab) or 's' (whitespace);
+ *                   detected from the first line by default
+ *   -n              No header line: columns are named C1, C2, ...
+ *   -p DIGITS       Significant digits written (default: enough to read back
+ *                   the same double)
+ *   -q              Do not report statistics on stderr
+ *
+ * FLUXPARSER_THREADS sets the pool size. Fields that are missing or not
+ * numbers read as NaN and are counted in the statistics. PI and E (any
+ * case) are the constants; an expression naming a column called PI or E
+ * is rejected rather than silently reading the constant.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <ctype.h>
+#include <math.h>
+#include <float.h>
+#include <time.h>
+#include <pthread.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "ast.h"
+#include "threadpool.h"
+#include "number.h"
+
+#define MAX_EXPRESSIONS 16
+#define CHUNK_BYTES (1 << 20)
+#define CHUNKS_PER_THREAD 4
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* ============================================================================
+ * NUMBER FORMATTING
+ * ============================================================================
+ * Input fields are converted by number_scan_lines() (number.c), correctly
+ * rounded and independent of the locale.
+ */
+
+static const double powers_of_ten[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+};
+
+static char* format_digits(char *out, uint64_t n) {
+    char digits[20];
+    int count = 0;
+    do {
+        digits[count++] = (char)('0' + n % 10);
+        n /= 10;
+    } while (n);
+    while (count) *out++ = digits[--count];
+    return out;
+}
+
+/* The digits of a scaled to [10^(digits-1), 10^digits), adjusting the
+ * decimal exponent *k when log10 was off by one; 0 if out of range */
+static uint64_t scaled_digits(double a, int *k, int digits) {
+    uint64_t low = (uint64_t)powers_of_ten[digits - 1], high = (uint64_t)powers_of_ten[digits];
+    for (int attempt = 0; attempt < 2; attempt++) {
+        int scale = digits - 1 - *k;
+        if (scale < 0 || scale > 22) return 0;
+        uint64_t m = (uint64_t)llroundl((long double)a * (long double)powers_of_ten[scale]);
+        if (m >= high) {
+            (*k)++;
+        } else if (m < low) {
+            (*k)--;
+        } else {
+            return m;
+        }
+    }
+    return 0;
+}
+
+/* Round-trip output without printf for values in [1e-4, 1e15): 15
+ * significant digits when reading them back (exact, as above) gives the
+ * same double, else 17 digits scaled in long double, whose 64-bit
+ * mantissa keeps the rounding error far below the last digit. Other
+ * values, and platforms with a shorter long double, use %.17g.
+ */
+static char* format_round_trip(char *out, double v) {
+    double a = fabs(v);
+    if (!(a >= 1e-4 && a < 1e15)) return NULL;
+
+    int k = (int)floor(log10(a));
+    int length = 15;
+    uint64_t m = scaled_digits(a, &k, 15);
+    if (!m) return NULL;
+    if ((double)m / powers_of_ten[14 - k] != a) {
+        if (LDBL_MANT_DIG < 64) return NULL;
+        length = 17;
+        m = scaled_digits(a, &k, 17);
+        if (!m) return NULL;
+    }
+
+    /* Drop trailing zeros, then place the point k + 1 digits in */
+    while (m % 10 == 0) {
+        m /= 10;
+        length--;
+    }
+    char digits[17];
+    for (int i = length - 1; i >= 0; i--) {
+        digits[i] = (char)('0' + m % 10);
+        m /= 10;
+    }
+    if (v < 0) *out++ = '-';
+    if (k < 0) {
+        *out++ = '0';
+        *out++ = '.';
+        for (int i = -1; i > k; i--) *out++ = '0';
+        memcpy(out, digits, (size_t)length);
+        return out + length;
+    }
+    for (int i = 0; i < length || i <= k; i++) {
+        if (i == k + 1) *out++ = '.';
+        *out++ = i < length ? digits[i] : '0';
+    }
+    return out;
+}
+
+/* Append v to out: integers exactly, others with the given precision (0: round-trip) */
+static char* format_number(char *out, double v, int precision) {
+    if (v == floor(v) && fabs(v) < 1e15) {
+        if (v < 0 || (v == 0 && signbit(v))) *out++ = '-';
+        return format_digits(out, (uint64_t)fabs(v));
+    }
+    if (precision == 0) {
+        char *end = format_round_trip(out, v);
+        return end ? end : out + snprintf(out, 32, "%.17g", v);
+    }
+    return out + snprintf(out, 32, "%.*g", precision, v);
+}
+
+/* ============================================================================
+ * CHUNKS
+ * ============================================================================
+ */
+
+typedef struct {
+    const char *begin, *end;        /* Whole lines of input */
+    size_t rows;
+    size_t capacity;                /* Rows the arrays below hold */
+    double **columns;               /* One per input column, NULL if unused */
+    double *results[MAX_EXPRESSIONS];
+    char *out;
+    size_t out_length, out_capacity;
+    size_t bad_fields;
+    bool failed;                    /* Allocation or evaluation failure */
+} Chunk;
+
+typedef struct {
+    Chunk *chunks;
+    size_t count;
+    bool full;                      /* Waiting for the writer */
+} Batch;
+
+typedef struct {
+    CompiledExpression *expressions[MAX_EXPRESSIONS];
+    int expression_count;
+    int column_count;
+    const bool *used;               /* Columns any expression reads */
+    char delimiter;
+    int precision;
+} Job;
+
+static bool chunk_reserve(Chunk *chunk, const Job *job, size_t rows) {
+    if (rows <= chunk->capacity) return true;
+
+    size_t capacity = chunk->capacity ? chunk->capacity : 4096;
+    while (capacity < rows) capacity *= 2;
+    for (int c = 0; c < job->column_count; c++) {
+        if (!job->used[c]) continue;
+        double *grown = realloc(chunk->columns[c], sizeof(double) * capacity);
+        if (!grown) return false;
+        chunk->columns[c] = grown;
+    }
+    for (int e = 0; e < job->expression_count; e++) {
+        double *grown = realloc(chunk->results[e], sizeof(double) * capacity);
+        if (!grown) return false;
+        chunk->results[e] = grown;
+    }
+    chunk->capacity = capacity;
+    return true;
+}
+
+static bool is_field_end(char c, char delimiter) {
+    return delimiter == NUMBER_SCAN_BLANKS ? (c == ' ' || c == '\t') : c == delimiter;
+}
+
+/* Parse the used columns of every line; unused fields are skipped */
+static bool chunk_parse(Chunk *chunk, const Job *job) {
+    size_t lines = 1;
+    for (const char *p = chunk->begin; (p = memchr(p, '\n', (size_t)(chunk->end - p))) != NULL; p++) lines++;
+    if (!chunk_reserve(chunk, job, lines)) return false;
+
+    NumberScanFormat format = {.delimiter = job->delimiter, .field_count = job->column_count, .wanted = job->used};
+    chunk->bad_fields = 0;
+    chunk->rows = number_scan_lines(chunk->begin, chunk->end, &format, chunk->columns, lines, NULL,
+                                    &chunk->bad_fields);
+    return true;
+}
+
+static bool chunk_format(Chunk *chunk, const Job *job) {
+    /* Longest formatted number plus a separator */
+    size_t need = chunk->rows * (size_t)job->expression_count * 40 + 1;
+    if (need > chunk->out_capacity) {
+        char *grown = realloc(chunk->out, need);
+        if (!grown) return false;
+        chunk->out = grown;
+        chunk->out_capacity = need;
+    }
+
+    char *o = chunk->out;
+    for (size_t r = 0; r < chunk->rows; r++) {
+        for (int e = 0; e < job->expression_count; e++) {
+            if (e) *o++ = ',';
+            o = format_number(o, chunk->results[e][r], job->precision);
+        }
+        *o++ = '\n';
+    }
+    chunk->out_length = (size_t)(o - chunk->out);
+    return true;
+}
+
+typedef struct {
+    const Job *job;
+    Batch *batch;
+} BatchTask;
+
+static void process_chunk(void *arg, size_t index) {
+    const BatchTask *task = arg;
+    const Job *job = task->job;
+    Chunk *chunk = &task->batch->chunks[index];
+
+    chunk->out_length = 0;
+    chunk->failed = !chunk_parse(chunk, job);
+    for (int e = 0; e < job->expression_count && !chunk->failed; e++) {
+        chunk->failed = compiled_expression_evaluate_batch(job->expressions[e], (const double *const *)chunk->columns,
+                                                           job->column_count, chunk->rows, chunk->results[e]) != 0;
+    }
+    if (!chunk->failed) chunk->failed = !chunk_format(chunk, job);
+}
+
+/* ============================================================================
+ * WRITER
+ * ============================================================================
+ * Batches are handed over in order; the writer empties one while the pool
+ * fills the other.
+ */
+
+typedef struct {
+    FILE *out;
+    Batch *batches;
+    pthread_mutex_t lock;
+    pthread_cond_t changed;
+    size_t submitted, written;      /* Batch sequence numbers */
+    bool finished;
+    bool error;
+} Writer;
+
+static void* writer_main(void *arg) {
+    Writer *w = arg;
+    pthread_mutex_lock(&w->lock);
+    for (;;) {
+        while (w->written == w->submitted && !w->finished) pthread_cond_wait(&w->changed, &w->lock);
+        if (w->written == w->submitted) break;
+        Batch *batch = &w->batches[w->written & 1];
+        pthread_mutex_unlock(&w->lock);
+
+        bool ok = true;
+        for (size_t i = 0; i < batch->count; i++) {
+            Chunk *chunk = &batch->chunks[i];
+            if (chunk->out_length && fwrite(chunk->out, 1, chunk->out_length, w->out) != chunk->out_length) ok = false;
+        }
+
+        pthread_mutex_lock(&w->lock);
+        if (!ok) w->error = true;
+        batch->full = false;
+        w->written++;
+        pthread_cond_broadcast(&w->changed);
+    }
+    pthread_mutex_unlock(&w->lock);
+    return NULL;
+}
+
+/* ============================================================================
+ * INPUT LAYOUT
+ * ============================================================================
+ */
+
+static char detect_delimiter(const char *line, const char *end) {
+    size_t commas = 0, semicolons = 0, tabs = 0;
+    for (const char *p = line; p < end; p++) {
+        commas += *p == ',';
+        semicolons += *p == ';';
+        tabs += *p == '\t';
+    }
+    if (commas >= semicolons && commas >= tabs && commas > 0) return ',';
+    if (semicolons >= tabs && semicolons > 0) return ';';
+    if (tabs > 0) return '\t';
+    return NUMBER_SCAN_BLANKS;
+}
+
+/* Split the header line into column names (trimmed, quotes removed) */
+static int read_header(const char *line, const char *end, char delimiter, char ***names_out) {
+    int capacity = 16, count = 0;
+    char **names = malloc(sizeof(char *) * capacity);
+    const char *p = line;
+    for (;;) {
+        if (delimiter == NUMBER_SCAN_BLANKS) {
+            while (p < end && (*p == ' ' || *p == '\t')) p++;
+            if (p == end) break;
+        }
+        const char *field = p;
+        while (p < end && !is_field_end(*p, delimiter)) p++;
+        const char *field_end = p;
+        while (field < field_end && isspace((unsigned char)*field)) field++;
+        while (field_end > field && isspace((unsigned char)field_end[-1])) field_end--;
+        if (field_end - field >= 2 && *field == '"' && field_end[-1] == '"') {
+            field++;
+            field_end--;
+        }
+        if (count == capacity) {
+            capacity *= 2;
+            names = realloc(names, sizeof(char *) * capacity);
+        }
+        size_t n = (size_t)(field_end - field);
+        names[count] = malloc(n + 1);
+        memcpy(names[count], field, n);
+        names[count][n] = '\0';
+        count++;
+        if (p == end) break;
+        p++;
+    }
+    *names_out = names;
+    return count;
+}
+
+/* Columns without a header are C1, C2, ... */
+static int count_fields(const char *line, const char *end, char delimiter, char ***names_out) {
+    char **fields;
+    int count = read_header(line, end, delimiter, &fields);
+    for (int i = 0; i < count; i++) {
+        free(fields[i]);
+        fields[i] = malloc(16);
+        snprintf(fields[i], 16, "C%d", i + 1);
+    }
+    *names_out = fields;
+    return count;
+}
+
+static void usage(void) {
+    fprintf(stderr,
+            "Usage: ./bulk_eval [options] -e [NAME=]EXPR [-e ...] INPUT\n"
+            "  -e [NAME=]EXPR  expression over the header's column names (repeatable, up to %d)\n"
+            "  -o FILE         output file (default: stdout)\n"
+            "  -d CHAR         delimiter: ',', ';', 't' (tab) or 's' (whitespace); default: detected\n"
+            "  -n              no header line: columns are C1, C2, ...\n"
+            "  (PI and E are the constants: an expression naming a column called\n"
+            "   PI or E, in any case, is rejected)\n"
+            "  -p DIGITS       significant digits written (default: round-trip)\n"
+            "  -q              no statistics on stderr\n",
+            MAX_EXPRESSIONS);
+}
+
+/* name[0..len) upper-cased is upper */
+static bool same_name(const char *name, size_t len, const char *upper) {
+    size_t k = 0;
+    while (k < len && upper[k] && toupper((unsigned char)name[k]) == upper[k]) k++;
+    return k == len && !upper[k];
+}
+
+/* True if expr has the identifier upper (case-insensitively), read the
+ * way the tokenizer reads it: numbers such as 1e5 are skipped whole */
+static bool names_identifier(const char *expr, const char *upper) {
+    const char *end = expr + strlen(expr);
+    const char *p = expr;
+    while (p < end) {
+        if (isdigit((unsigned char)*p) || *p == '.') {
+            double value;
+            const char *next = number_parse(p, end, &value);
+            p = next > p ? next : p + 1;
+        } else if (isalpha((unsigned char)*p)) {
+            const char *start = p;
+            while (isalnum((unsigned char)*p)) p++;
+            if (same_name(start, (size_t)(p - start), upper)) return true;
+        } else {
+            p++;
+        }
+    }
+    return false;
+}
+
+/* "name=expr" where name is an identifier and '=' does not start "==" */
+static const char* split_label(const char *arg, char *label, size_t size) {
+    const char *p = arg;
+    while (isalnum((unsigned char)*p) || *p == '_') p++;
+    if (p > arg && *p == '=' && p[1] != '=' && isalpha((unsigned char)*arg) && (size_t)(p - arg) < size) {
+        memcpy(label, arg, (size_t)(p - arg));
+        label[p - arg] = '\0';
+        return p + 1;
+    }
+    label[0] = '\0';
+    return arg;
+}
+
+int main(int argc, char **argv) {
+    const char *sources[MAX_EXPRESSIONS];
+    char labels[MAX_EXPRESSIONS][64];
+    int expression_count = 0;
+    const char *input_path = NULL, *output_path = NULL;
+    char delimiter = 0;
+    bool header = true, quiet = false;
+    int precision = 0;
+
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (strcmp(arg, "-e") == 0 && has_value) {
+            if (expression_count == MAX_EXPRESSIONS) {
+                fprintf(stderr, "bulk_eval: at most %d expressions\n", MAX_EXPRESSIONS);
+                return 1;
+            }
+            sources[expression_count] = split_label(argv[++i], labels[expression_count], sizeof(labels[0]));
+            expression_count++;
+        } else if (strcmp(arg, "-o") == 0 && has_value) {
+            output_path = argv[++i];
+        } else if (strcmp(arg, "-d") == 0 && has_value) {
+            const char *d = argv[++i];
+            delimiter = d[0] == 't' ? '\t' : d[0] == 's' ? NUMBER_SCAN_BLANKS : d[0];
+        } else if (strcmp(arg, "-p") == 0 && has_value) {
+            precision = atoi(argv[++i]);
+            if (precision < 1 || precision > 17) precision = 0;
+        } else if (strcmp(arg, "-n") == 0) {
+            header = false;
+        } else if (strcmp(arg, "-q") == 0) {
+            quiet = true;
+        } else if (arg[0] != '-' && !input_path) {
+            input_path = arg;
+        } else {
+            usage();
+            return 1;
+        }
+    }
+    if (!input_path || expression_count == 0) {
+        usage();
+        return 1;
+    }
+
+    /* Map the input */
+    int fd = open(input_path, O_RDONLY);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0) {
+        perror(input_path);
+        return 1;
+    }
+    size_t size = (size_t)st.st_size;
+    const char *data = NULL;
+    if (size > 0) {
+        data = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data == MAP_FAILED) {
+            perror("mmap");
+            return 1;
+        }
+        madvise((void *)data, size, MADV_SEQUENTIAL);
+    }
+    close(fd);
+    const char *end = data + size;
+
+    /* Column names from the first line */
+    const char *first_end = data ? memchr(data, '\n', size) : NULL;
+    if (!first_end) first_end = end;
+    const char *first_stop = first_end > data && first_end[-1] == '\r' ? first_end - 1 : first_end;
+    if (!delimiter) delimiter = detect_delimiter(data, first_stop);
+    char **names;
+    int column_count = header ? read_header(data, first_stop, delimiter, &names)
+                              : count_fields(data, first_stop, delimiter, &names);
+    const char *body = header ? (first_end < end ? first_end + 1 : end) : data;
+
+    Job job = {.expression_count = expression_count, .column_count = column_count,
+               .delimiter = delimiter, .precision = precision};
+    bool *used = calloc((size_t)column_count + 1, sizeof(bool));
+    job.used = used;
+    for (int e = 0; e < expression_count; e++) {
+        /* PI and E always read as the constants, never as a column */
+        for (int c = 0; c < column_count; c++) {
+            size_t n = strlen(names[c]);
+            const char *constant = same_name(names[c], n, "PI") ? "PI" : same_name(names[c], n, "E") ? "E" : NULL;
+            if (constant && names_identifier(sources[e], constant)) {
+                fprintf(stderr, "bulk_eval: %s: '%s' is the constant %s, not column %d; rename the column\n",
+                        sources[e], names[c], constant, c + 1);
+                return 1;
+            }
+        }
+
+        ParserErrorInfo error;
+        job.expressions[e] = prepare_expression(sources[e], (const char *const *)names, column_count, &error);
+        if (!job.expressions[e]) {
+            fprintf(stderr, "bulk_eval: %s: %s\n", sources[e], error.message);
+            return 1;
+        }
+        /* Bound slots are column indices */
+        const Bytecode *bc = job.expressions[e]->bytecode;
+        for (int s = 0; s < bc->var_count; s++) {
+            for (int c = 0; c < column_count; c++) {
+                char upper[32];
+                size_t k = 0;
+                for (; names[c][k] && k < sizeof(upper) - 1; k++) upper[k] = (char)toupper((unsigned char)names[c][k]);
+                upper[k] = '\0';
+                if (strcmp(upper, bc->var_names[s]) == 0) used[c] = true;
+            }
+        }
+    }
+
+    FILE *out = output_path ? fopen(output_path, "wb") : stdout;
+    if (!out) {
+        perror(output_path);
+        return 1;
+    }
+    setvbuf(out, NULL, _IOFBF, 1 << 20);
+    for (int e = 0; e < expression_count; e++) {
+        if (labels[e][0]) {
+            fprintf(out, "%s%s", e ? "," : "", labels[e]);
+        } else {
+            fprintf(out, "%sexpr%d", e ? "," : "", e + 1);
+        }
+    }
+    fputc('\n', out);
+
+    ThreadPool *pool = thread_pool_shared();
+    size_t chunks_per_batch = (size_t)thread_pool_size(pool) * CHUNKS_PER_THREAD;
+    Batch batches[2];
+    for (int b = 0; b < 2; b++) {
+        batches[b].chunks = calloc(chunks_per_batch, sizeof(Chunk));
+        batches[b].full = false;
+        for (size_t i = 0; i < chunks_per_batch; i++) {
+            batches[b].chunks[i].columns = calloc((size_t)column_count + 1, sizeof(double *));
+        }
+    }
+
+    Writer writer = {.out = out, .batches = batches};
+    pthread_mutex_init(&writer.lock, NULL);
+    pthread_cond_init(&writer.changed, NULL);
+    pthread_t writer_thread;
+    pthread_create(&writer_thread, NULL, writer_main, &writer);
+
+    double start = now_seconds();
+    size_t rows = 0, bad_fields = 0;
+    bool failed = false;
+    const char *p = body;
+    for (size_t sequence = 0; p < end && !failed; sequence++) {
+        Batch *batch = &batches[sequence & 1];
+        pthread_mutex_lock(&writer.lock);
+        while (batch->full) pthread_cond_wait(&writer.changed, &writer.lock);
+        pthread_mutex_unlock(&writer.lock);
+
+        /* Cut whole lines */
+        batch->count = 0;
+        while (p < end && batch->count < chunks_per_batch) {
+            const char *stop = (size_t)(end - p) > CHUNK_BYTES ? p + CHUNK_BYTES : end;
+            if (stop < end) {
+                const char *newline = memchr(stop, '\n', (size_t)(end - stop));
+                stop = newline ? newline + 1 : end;
+            }
+            batch->chunks[batch->count].begin = p;
+            batch->chunks[batch->count].end = stop;
+            batch->count++;
+            p = stop;
+        }
+
+        /* Read ahead into the next batch while this one runs */
+        if (p < end) {
+            size_t ahead = chunks_per_batch * (size_t)CHUNK_BYTES;
+            size_t offset = (size_t)(p - data) & ~(size_t)(sysconf(_SC_PAGESIZE) - 1);
+            if (offset + ahead > size) ahead = size - offset;
+            madvise((void *)(data + offset), ahead, MADV_WILLNEED);
+        }
+
+        BatchTask task = {.job = &job, .batch = batch};
+        thread_pool_for(pool, batch->count, process_chunk, &task);
+        for (size_t i = 0; i < batch->count; i++) {
+            rows += batch->chunks[i].rows;
+            bad_fields += batch->chunks[i].bad_fields;
+            if (batch->chunks[i].failed) failed = true;
+        }
+
+        pthread_mutex_lock(&writer.lock);
+        batch->full = true;
+        writer.submitted++;
+        pthread_cond_broadcast(&writer.changed);
+        pthread_mutex_unlock(&writer.lock);
+    }
+
+    pthread_mutex_lock(&writer.lock);
+    writer.finished = true;
+    pthread_cond_broadcast(&writer.changed);
+    pthread_mutex_unlock(&writer.lock);
+    pthread_join(writer_thread, NULL);
+    bool write_error = writer.error || fflush(out) != 0;
+    double seconds = now_seconds() - start;
+
+    if (failed) fprintf(stderr, "bulk_eval: out of memory\n");
+    if (write_error) fprintf(stderr, "bulk_eval: write failed\n");
+    if (!quiet) {
+        fprintf(stderr, "bulk_eval: %zu rows x %d expressions in %.3f s: %.2fM rows/s, %.1f MB/s in, %d threads\n",
+                rows, expression_count, seconds, seconds > 0 ? rows / seconds / 1e6 : 0.0,
+                seconds > 0 ? (double)(end - body) / seconds / 1e6 : 0.0, thread_pool_size(pool));
+        if (bad_fields) fprintf(stderr, "bulk_eval: %zu missing or non-numeric fields read as NaN\n", bad_fields);
+    }
+
+    if (out != stdout) fclose(out);
+    for (int b = 0; b < 2; b++) {
+        for (size_t i = 0; i < chunks_per_batch; i++) {
+            Chunk *chunk = &batches[b].chunks[i];
+            for (int c = 0; c < column_count; c++) free(chunk->columns[c]);
+            for (int e = 0; e < expression_count; e++) free(chunk->results[e]);
+            free(chunk->columns);
+            free(chunk->out);
+        }
+        free(batches[b].chunks);
+    }
+    for (int e = 0; e < expression_count; e++) compiled_expression_free(job.expressions[e]);
+    for (int c = 0; c < column_count; c++) free(names[c]);
+    free(names);
+    free(used);
+    pthread_mutex_destroy(&writer.lock);
+    pthread_cond_destroy(&writer.changed);
+    if (data) munmap((void *)data, size);
+    return failed || write_error ? 1 : 0;
+}
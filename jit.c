@@ -0,0 +1,418 @@
+/*
+ * FluxParser - Research-Grade C Math Parser
+ * Copyright (C) 2025 Eduardo Stern
+ *
+ * Dual Licensed:
+ * - GPL-3.0 for open-source/non-commercial use
+ * - Commercial license available - see LICENSE-COMMERCIAL.md
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * x86-64 JIT: lowers register code (see ast_compile) to native SSE2.
+ *
+ * The generated function is double fn(const double *values). Registers
+ * live in a stack frame at [rsp + 8*i]; every instruction loads its
+ * operands into xmm0/xmm1, computes, and stores xmm0 back, so calls into
+ * libm need no spilling. values is kept in rbx (callee-saved). Comparisons
+ * and logic are branchless: cmpsd produces an all-ones mask which is
+ * ANDed with 1.0. Code is written into an mmap'd buffer which is then made
+ * read+execute (never writable and executable at once).
+ */
+
+#include "ast.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+
+#if defined(__x86_64__) && (defined(__linux__) || defined(__APPLE__)) && !defined(FLUXPARSER_NO_JIT)
+#define JIT_X86_64 1
+#include <sys/mman.h>
+#endif
+
+struct JitCode {
+    double (*fn)(const double *values);
+    void *code;
+    size_t code_size;
+    int value_count;    /* values[] entries read by the code (max slot + 1) */
+};
+
+bool jit_supported(void) {
+#ifdef JIT_X86_64
+    return true;
+#else
+    return false;
+#endif
+}
+
+#ifdef JIT_X86_64
+
+/* ============================================================================
+ * CODE BUFFER
+ * ============================================================================ */
+
+typedef struct {
+    uint8_t *data;
+    size_t size;
+    size_t capacity;
+    bool failed;
+} CodeBuffer;
+
+static void emit_bytes(CodeBuffer *cb, const uint8_t *bytes, size_t n) {
+    if (cb->failed) return;
+    if (cb->size + n > cb->capacity) {
+        size_t capacity = cb->capacity ? cb->capacity * 2 : 256;
+        while (capacity < cb->size + n) capacity *= 2;
+        uint8_t *data = realloc(cb->data, capacity);
+        if (!data) {
+            cb->failed = true;
+            return;
+        }
+        cb->data = data;
+        cb->capacity = capacity;
+    }
+    memcpy(cb->data + cb->size, bytes, n);
+    cb->size += n;
+}
+
+static void emit_u32(CodeBuffer *cb, uint32_t v) {
+    uint8_t b[4] = {v & 0xFF, (v >> 8) & 0xFF, (v >> 16) & 0xFF, (v >> 24) & 0xFF};
+    emit_bytes(cb, b, 4);
+}
+
+static void emit_u64(CodeBuffer *cb, uint64_t v) {
+    emit_u32(cb, (uint32_t)v);
+    emit_u32(cb, (uint32_t)(v >> 32));
+}
+
+#define EMIT(cb, ...) do { \
+    const uint8_t bytes_[] = {__VA_ARGS__}; \
+    emit_bytes(cb, bytes_, sizeof(bytes_)); \
+} while (0)
+
+/* ============================================================================
+ * INSTRUCTION ENCODERS
+ * xmm operands are 0-2; ModRM mod=10 (disp32) for memory forms
+ * ============================================================================ */
+
+/* Scalar double SSE2 opcodes (F2 0F xx) */
+enum {
+    SSE_MOVSD_LOAD = 0x10,
+    SSE_MOVSD_STORE = 0x11,
+    SSE_ADDSD = 0x58,
+    SSE_MULSD = 0x59,
+    SSE_SUBSD = 0x5C,
+    SSE_DIVSD = 0x5E
+};
+
+/* cmpsd predicates */
+enum {
+    CMP_EQ = 0,
+    CMP_LT = 1,
+    CMP_LE = 2,
+    CMP_NEQ = 4     /* Unordered or not equal: true for NaN, like C's != */
+};
+
+/* op xmm, [rsp + 8*reg] */
+static void emit_sd_reg(CodeBuffer *cb, uint8_t opcode, int xmm, int reg) {
+    EMIT(cb, 0xF2, 0x0F, opcode, (uint8_t)(0x84 | (xmm << 3)), 0x24);
+    emit_u32(cb, (uint32_t)(reg * 8));
+}
+
+/* movsd xmm, [rbx + 8*slot] */
+static void emit_load_value(CodeBuffer *cb, int xmm, int slot) {
+    EMIT(cb, 0xF2, 0x0F, SSE_MOVSD_LOAD, (uint8_t)(0x83 | (xmm << 3)));
+    emit_u32(cb, (uint32_t)(slot * 8));
+}
+
+/* op xmm_dst, xmm_src */
+static void emit_sd_xmm(CodeBuffer *cb, uint8_t opcode, int dst, int src) {
+    EMIT(cb, 0xF2, 0x0F, opcode, (uint8_t)(0xC0 | (dst << 3) | src));
+}
+
+/* Packed logic ops (66 0F xx): andpd 54, orpd 56, xorpd 57, movapd 28 */
+static void emit_pd_xmm(CodeBuffer *cb, uint8_t opcode, int dst, int src) {
+    EMIT(cb, 0x66, 0x0F, opcode, (uint8_t)(0xC0 | (dst << 3) | src));
+}
+
+/* cmpsd dst, src, predicate */
+static void emit_cmpsd(CodeBuffer *cb, int dst, int src, uint8_t predicate) {
+    EMIT(cb, 0xF2, 0x0F, 0xC2, (uint8_t)(0xC0 | (dst << 3) | src), predicate);
+}
+
+/* xmm = bit pattern (via rax) */
+static void emit_load_bits(CodeBuffer *cb, int xmm, uint64_t bits) {
+    EMIT(cb, 0x48, 0xB8);                                   /* mov rax, imm64 */
+    emit_u64(cb, bits);
+    EMIT(cb, 0x66, 0x48, 0x0F, 0x6E, (uint8_t)(0xC0 | (xmm << 3)));  /* movq xmm, rax */
+}
+
+static void emit_load_const(CodeBuffer *cb, int xmm, double k) {
+    uint64_t bits;
+    memcpy(&bits, &k, sizeof(bits));
+    if (bits == 0) {
+        emit_pd_xmm(cb, 0x57, xmm, xmm);                    /* xorpd xmm, xmm */
+    } else {
+        emit_load_bits(cb, xmm, bits);
+    }
+}
+
+static void emit_call(CodeBuffer *cb, const void *fn) {
+    uint64_t addr;
+    memcpy(&addr, &fn, sizeof(addr));
+    EMIT(cb, 0x48, 0xB8);                                   /* mov rax, imm64 */
+    emit_u64(cb, addr);
+    EMIT(cb, 0xFF, 0xD0);                                   /* call rax */
+}
+
+/* xmm0 = mask & 1.0 */
+static void emit_mask_to_bool(CodeBuffer *cb) {
+    emit_load_const(cb, 1, 1.0);
+    emit_pd_xmm(cb, 0x54, 0, 1);                            /* andpd xmm0, xmm1 */
+}
+
+/* xmm = (xmm != 0) mask, using xmm2 as scratch */
+static void emit_nonzero_mask(CodeBuffer *cb, int xmm) {
+    emit_pd_xmm(cb, 0x57, 2, 2);
+    emit_cmpsd(cb, xmm, 2, CMP_NEQ);
+}
+
+/* ============================================================================
+ * LOWERING
+ * ============================================================================ */
+
+static double (*const jit_pow)(double, double) = pow;
+
+static bool lower_instruction(CodeBuffer *cb, const RegInstruction *ip) {
+    switch (ip->op) {
+        case REG_LOAD_K:
+            emit_load_const(cb, 0, ip->data.k);
+            break;
+        case REG_LOAD_VAR:
+            if (ip->data.var_index >= 0) {
+                emit_load_value(cb, 0, ip->data.var_index);
+            } else {
+                emit_load_const(cb, 0, 0.0);
+            }
+            break;
+
+        case REG_ADD:
+        case REG_SUBTRACT:
+        case REG_MULTIPLY: {
+            uint8_t opcode = ip->op == REG_ADD ? SSE_ADDSD
+                           : ip->op == REG_SUBTRACT ? SSE_SUBSD : SSE_MULSD;
+            emit_sd_reg(cb, SSE_MOVSD_LOAD, 0, ip->a);
+            emit_sd_reg(cb, opcode, 0, ip->b);
+            break;
+        }
+        case REG_DIVIDE:
+            /* b != 0 ? a / b : 0, as a mask over the quotient */
+            emit_sd_reg(cb, SSE_MOVSD_LOAD, 0, ip->a);
+            emit_sd_reg(cb, SSE_MOVSD_LOAD, 1, ip->b);
+            emit_sd_xmm(cb, SSE_DIVSD, 0, 1);
+            emit_nonzero_mask(cb, 1);
+            emit_pd_xmm(cb, 0x54, 0, 1);
+            break;
+        case REG_POWER:
+            emit_sd_reg(cb, SSE_MOVSD_LOAD, 0, ip->a);
+            emit_sd_reg(cb, SSE_MOVSD_LOAD, 1, ip->b);
+            emit_call(cb, (const void *)jit_pow);
+            break;
+
+        case REG_ADD_K:
+        case REG_SUBTRACT_K:
+        case REG_MULTIPLY_K:
+        case REG_DIVIDE_K: {
+            uint8_t opcode = ip->op == REG_ADD_K ? SSE_ADDSD
+                           : ip->op == REG_SUBTRACT_K ? SSE_SUBSD
+                           : ip->op == REG_MULTIPLY_K ? SSE_MULSD : SSE_DIVSD;
+            emit_sd_reg(cb, SSE_MOVSD_LOAD, 0, ip->a);
+            emit_load_const(cb, 1, ip->data.k);
+            emit_sd_xmm(cb, opcode, 0, 1);
+            break;
+        }
+        case REG_POWER_K:
+            emit_sd_reg(cb, SSE_MOVSD_LOAD, 0, ip->a);
+            emit_load_const(cb, 1, ip->data.k);
+            emit_call(cb, (const void *)jit_pow);
+            break;
+
+        case REG_AND:
+        case REG_OR:
+            emit_sd_reg(cb, SSE_MOVSD_LOAD, 0, ip->a);
+            emit_sd_reg(cb, SSE_MOVSD_LOAD, 1, ip->b);
+            emit_nonzero_mask(cb, 0);
+            emit_nonzero_mask(cb, 1);
+            emit_pd_xmm(cb, ip->op == REG_AND ? 0x54 : 0x56, 0, 1);
+            emit_mask_to_bool(cb);
+            break;
+
+        case REG_GREATER:
+        case REG_GREATER_EQ:
+            /* a > b  <=>  b < a (ordered, so NaN compares false) */
+            emit_sd_reg(cb, SSE_MOVSD_LOAD, 0, ip->b);
+            emit_sd_reg(cb, SSE_MOVSD_LOAD, 1, ip->a);
+            emit_cmpsd(cb, 0, 1, ip->op == REG_GREATER ? CMP_LT : CMP_LE);
+            emit_mask_to_bool(cb);
+            break;
+        case REG_LESS:
+        case REG_LESS_EQ:
+            emit_sd_reg(cb, SSE_MOVSD_LOAD, 0, ip->a);
+            emit_sd_reg(cb, SSE_MOVSD_LOAD, 1, ip->b);
+            emit_cmpsd(cb, 0, 1, ip->op == REG_LESS ? CMP_LT : CMP_LE);
+            emit_mask_to_bool(cb);
+            break;
+
+        case REG_EQUAL:
+        case REG_NOT_EQUAL:
+            /* fabs(a - b) < 1e-12, or 1e-12 <= fabs(a - b) */
+            emit_sd_reg(cb, SSE_MOVSD_LOAD, 0, ip->a);
+            emit_sd_reg(cb, SSE_MOVSD_LOAD, 1, ip->b);
+            emit_sd_xmm(cb, SSE_SUBSD, 0, 1);
+            emit_load_bits(cb, 1, 0x7FFFFFFFFFFFFFFFull);
+            emit_pd_xmm(cb, 0x54, 0, 1);
+            emit_load_const(cb, 1, 1e-12);
+            if (ip->op == REG_EQUAL) {
+                emit_cmpsd(cb, 0, 1, CMP_LT);
+            } else {
+                emit_cmpsd(cb, 1, 0, CMP_LE);
+                emit_pd_xmm(cb, 0x28, 0, 1);                /* movapd xmm0, xmm1 */
+            }
+            emit_mask_to_bool(cb);
+            break;
+
+        case REG_MOVE:
+            emit_sd_reg(cb, SSE_MOVSD_LOAD, 0, ip->a);
+            break;
+        case REG_NEGATE:
+            emit_sd_reg(cb, SSE_MOVSD_LOAD, 0, ip->a);
+            emit_load_bits(cb, 1, 0x8000000000000000ull);
+            emit_pd_xmm(cb, 0x57, 0, 1);
+            break;
+        case REG_NOT:
+            emit_sd_reg(cb, SSE_MOVSD_LOAD, 0, ip->a);
+            emit_pd_xmm(cb, 0x57, 1, 1);
+            emit_cmpsd(cb, 0, 1, CMP_EQ);
+            emit_mask_to_bool(cb);
+            break;
+
+        case REG_CALL1:
+            emit_sd_reg(cb, SSE_MOVSD_LOAD, 0, ip->a);
+            emit_call(cb, (const void *)ip->data.fn1);
+            break;
+        case REG_CALL2:
+            emit_sd_reg(cb, SSE_MOVSD_LOAD, 0, ip->a);
+            emit_sd_reg(cb, SSE_MOVSD_LOAD, 1, ip->a + 1);
+            emit_call(cb, (const void *)ip->data.fn2);
+            break;
+        case REG_CALLN:
+            /* math_function_eval(func, &r[a], b) */
+            EMIT(cb, 0xBF);                                 /* mov edi, imm32 */
+            emit_u32(cb, (uint32_t)ip->data.func);
+            EMIT(cb, 0x48, 0x8D, 0xB4, 0x24);               /* lea rsi, [rsp + disp32] */
+            emit_u32(cb, (uint32_t)(ip->a * 8));
+            EMIT(cb, 0xBA);                                 /* mov edx, imm32 */
+            emit_u32(cb, (uint32_t)ip->b);
+            emit_call(cb, (const void *)math_function_eval);
+            break;
+
+        case REG_HALT:
+            emit_sd_reg(cb, SSE_MOVSD_LOAD, 0, ip->a);
+            return true;
+
+        default:
+            cb->failed = true;
+            return true;
+    }
+
+    emit_sd_reg(cb, SSE_MOVSD_STORE, 0, ip->dst);
+    return false;
+}
+
+JitCode* jit_compile(const Bytecode *bc) {
+    if (!bc || !bc->reg_code || bc->reg_count <= 0) return NULL;
+
+    /* Frame: registers, 16-byte aligned so calls see an aligned stack */
+    uint32_t frame = (uint32_t)(((bc->register_count > 0 ? bc->register_count : 1) * 8 + 15) & ~15);
+
+    CodeBuffer cb = {0};
+    EMIT(&cb, 0x53);                                        /* push rbx */
+    EMIT(&cb, 0x48, 0x81, 0xEC);                            /* sub rsp, frame */
+    emit_u32(&cb, frame);
+    EMIT(&cb, 0x48, 0x89, 0xFB);                            /* mov rbx, rdi */
+
+    int value_count = 0;
+    bool halted = false;
+    for (int pc = 0; pc < bc->reg_count && !halted && !cb.failed; pc++) {
+        const RegInstruction *ip = &bc->reg_code[pc];
+        if (ip->op == REG_LOAD_VAR && ip->data.var_index + 1 > value_count) {
+            value_count = ip->data.var_index + 1;
+        }
+        halted = lower_instruction(&cb, ip);
+    }
+
+    EMIT(&cb, 0x48, 0x81, 0xC4);                            /* add rsp, frame */
+    emit_u32(&cb, frame);
+    EMIT(&cb, 0x5B, 0xC3);                                  /* pop rbx; ret */
+
+    if (cb.failed || !halted) {
+        free(cb.data);
+        return NULL;
+    }
+
+    void *mem = mmap(NULL, cb.size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANON, -1, 0);
+    if (mem == MAP_FAILED) {
+        free(cb.data);
+        return NULL;
+    }
+    memcpy(mem, cb.data, cb.size);
+    free(cb.data);
+    if (mprotect(mem, cb.size, PROT_READ | PROT_EXEC) != 0) {
+        munmap(mem, cb.size);
+        return NULL;
+    }
+
+    JitCode *jit = malloc(sizeof(JitCode));
+    if (!jit) {
+        munmap(mem, cb.size);
+        return NULL;
+    }
+    /* Object-to-function pointer conversion: valid on every target we JIT for */
+    memcpy(&jit->fn, &mem, sizeof(mem));
+    jit->code = mem;
+    jit->code_size = cb.size;
+    jit->value_count = value_count;
+    return jit;
+}
+
+void jit_free(JitCode *jit) {
+    if (!jit) return;
+    munmap(jit->code, jit->code_size);
+    free(jit);
+}
+
+#else /* !JIT_X86_64 */
+
+JitCode* jit_compile(const Bytecode *bc) {
+    (void)bc;
+    return NULL;
+}
+
+void jit_free(JitCode *jit) {
+    free(jit);
+}
+
+#endif /* JIT_X86_64 */
+
+bool jit_execute(const JitCode *jit, const VarContext *vars, double *result) {
+    if (!jit) return false;
+    const double *values = vars ? vars->values : NULL;
+    int count = values ? vars->count : 0;
+    if (count < jit->value_count) return false;  /* The VM zero-fills missing slots */
+    *result = jit->fn(values);
+    return true;
+}
+
+size_t jit_code_size(const JitCode *jit) {
+    return jit ? jit->code_size : 0;
+}
@@ -0,0 +1,51 @@
+/*
+ * FluxParser - Research-Grade C Math Parser
+ * Copyright (C) 2025 Eduardo Stern
+ *
+ * Dual Licensed:
+ * - GPL-3.0 for open-source/non-commercial use
+ * - Commercial license available - see LICENSE-COMMERCIAL.md
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * Decimal number scanning independent of the C locale: correctly rounded
+ * conversion of numeric literals (the tokenizer's) and of delimited
+ * numeric text into columns (bulk evaluation).
+ */
+
+#ifndef NUMBER_H
+#define NUMBER_H
+
+#include <stddef.h>
+#include <stdbool.h>
+
+/* Convert the number at the start of [p, end) to the nearest double.
+ * Accepts what strtod() accepts in the "C" locale: an optional sign,
+ * decimal digits with an optional '.' and exponent, hexadecimal (0x...),
+ * and inf, infinity, nan and nan(chars) (any case). The decimal point is
+ * always '.'.
+ * Returns the end of the number, or p (and *value = 0) if there is none.
+ */
+const char* number_parse(const char *p, const char *end, double *value);
+
+/* Delimiter for fields separated by runs of spaces and tabs */
+#define NUMBER_SCAN_BLANKS ' '
+
+typedef struct {
+    char delimiter;             /* Field separator, or NUMBER_SCAN_BLANKS */
+    int field_count;            /* Fields per line */
+    const bool *wanted;         /* Fields to convert (NULL: all) */
+} NumberScanFormat;
+
+/* Scan up to max_rows lines of [text, end) into columns: columns[f][row]
+ * for each wanted field f. Spaces around a field are ignored, lines may
+ * end in "\r\n" and blank lines (empty, or only spaces and tabs) are
+ * skipped. Fields that are missing or
+ * not a number are stored as NaN and counted in *bad_fields (if not
+ * NULL). *next (if not NULL) receives the start of the first line not
+ * scanned. Returns the number of rows stored.
+ */
+size_t number_scan_lines(const char *text, const char *end, const NumberScanFormat *format,
+                         double *const *columns, size_t max_rows, const char **next, size_t *bad_fields);
+
+#endif /* NUMBER_H */
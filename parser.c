@@ -10,125 +10,181 @@
  */
 
 #include "parser.h"
+#include "ast.h"
+#include "number.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdint.h>
 #include <ctype.h>
 #include <math.h>
 #include <time.h>
 #include <stdarg.h>
 #include <pthread.h>
-#include <sys/time.h>
 
 #define STRINGIFY_HELPER(x) #x
 #define STRINGIFY(x) STRINGIFY_HELPER(x)
 
 /* ========== DEBUG MODE & CALLBACKS ========== */
 
-/* Global debug state (protected by mutex for thread safety) */
-static pthread_mutex_t debug_mutex = PTHREAD_MUTEX_INITIALIZER;
-static int debug_level = DEBUG_OFF;
-static FILE *debug_output = NULL;  /* NULL means stderr */
-
-/* Global callback state (protected by mutex for thread safety) */
-static pthread_mutex_t callback_mutex = PTHREAD_MUTEX_INITIALIZER;
-static ParserErrorCallback error_callback = NULL;
-static void *error_callback_userdata = NULL;
-static ParserDebugCallback debug_callback = NULL;
-static void *debug_callback_userdata = NULL;
+/* Debug level, output, callbacks and configuration of one parser context.
+ * debug_level is read with a relaxed atomic load on every token and
+ * variable lookup, so the common case (debugging off) takes no lock; the
+ * rest is read only when a message is emitted or an error is reported,
+ * under the context's own mutex.
+ */
+struct ParserContext {
+    int debug_level;                    /* Atomic */
+    pthread_mutex_t lock;               /* Guards the fields below */
+    FILE *debug_output;                 /* NULL means stderr */
+    ParserErrorCallback error_callback;
+    void *error_callback_userdata;
+    ParserDebugCallback debug_callback;
+    void *debug_callback_userdata;
+    ParserConfig config;                /* Fixed at creation */
+    bool has_config;
+};
+
+/* The context behind the global API */
+static ParserContext default_context = {
+    .debug_level = DEBUG_OFF,
+    .lock = PTHREAD_MUTEX_INITIALIZER
+};
+
+static inline bool debug_enabled(const ParserContext *ctx, int level) {
+    return (__atomic_load_n(&ctx->debug_level, __ATOMIC_RELAXED) & level) != 0;
+}
 
 /* Debug helper: printf-style output (thread-safe) */
-static void debug_print(int level, const char *format, ...) {
-    /* Quick check without lock (performance optimization) */
-    pthread_mutex_lock(&debug_mutex);
-    int current_level = debug_level;
-    pthread_mutex_unlock(&debug_mutex);
-
-    if (!(current_level & level)) return;
+static void debug_vprint(ParserContext *ctx, int level, const char *format, va_list args) {
+    if (!debug_enabled(ctx, level)) return;
 
     char buffer[1024];
-    va_list args;
 
     /* Format the message */
-    va_start(args, format);
     vsnprintf(buffer, sizeof(buffer), format, args);
-    va_end(args);
 
-    /* Lock for callback/output access */
-    pthread_mutex_lock(&callback_mutex);
-    ParserDebugCallback callback = debug_callback;
-    void *userdata = debug_callback_userdata;
-    pthread_mutex_unlock(&callback_mutex);
+    pthread_mutex_lock(&ctx->lock);
+    ParserDebugCallback callback = ctx->debug_callback;
+    void *userdata = ctx->debug_callback_userdata;
+    pthread_mutex_unlock(&ctx->lock);
 
     /* Call callback if set, otherwise print to file/stderr */
     if (callback) {
         callback(level, buffer, userdata);
     } else {
-        pthread_mutex_lock(&debug_mutex);
-        FILE *out = debug_output ? debug_output : stderr;
+        pthread_mutex_lock(&ctx->lock);
+        FILE *out = ctx->debug_output ? ctx->debug_output : stderr;
         fprintf(out, "%s", buffer);
         fflush(out);
-        pthread_mutex_unlock(&debug_mutex);
+        pthread_mutex_unlock(&ctx->lock);
     }
 }
 
-/* Debug API implementation (thread-safe) */
-void parser_set_debug_level(int level) {
-    pthread_mutex_lock(&debug_mutex);
-    debug_level = level;
-    pthread_mutex_unlock(&debug_mutex);
+static void debug_print(ParserContext *ctx, int level, const char *format, ...) {
+    if (!debug_enabled(ctx, level)) return;
+
+    va_list args;
+    va_start(args, format);
+    debug_vprint(ctx, level, format, args);
+    va_end(args);
+}
+
+void parser_debug_log(int level, const char *format, ...) {
+    if (!debug_enabled(&default_context, level)) return;
+
+    va_list args;
+    va_start(args, format);
+    debug_vprint(&default_context, level, format, args);
+    va_end(args);
+}
+
+/* Per-context API implementation */
+ParserContext* parser_context_create(const ParserConfig *config) {
+    ParserContext *ctx = calloc(1, sizeof(ParserContext));
+    if (!ctx) return NULL;
+    if (pthread_mutex_init(&ctx->lock, NULL) != 0) {
+        free(ctx);
+        return NULL;
+    }
+    ctx->debug_level = DEBUG_OFF;
+    if (config) {
+        ctx->config = *config;
+        ctx->has_config = true;
+    }
+    return ctx;
+}
+
+void parser_context_free(ParserContext *ctx) {
+    if (!ctx || ctx == &default_context) return;
+    pthread_mutex_destroy(&ctx->lock);
+    free(ctx);
+}
+
+void parser_context_set_debug_level(ParserContext *ctx, int level) {
+    __atomic_store_n(&ctx->debug_level, level, __ATOMIC_RELAXED);
 
     if (level != DEBUG_OFF) {
-        debug_print(DEBUG_ALL, "═══ DEBUG MODE ENABLED (level=0x%02X) ═══\n", level);
+        debug_print(ctx, DEBUG_ALL, "═══ DEBUG MODE ENABLED (level=0x%02X) ═══\n", level);
     }
 }
 
+int parser_context_get_debug_level(const ParserContext *ctx) {
+    return __atomic_load_n(&ctx->debug_level, __ATOMIC_RELAXED);
+}
+
+void parser_context_set_debug_output(ParserContext *ctx, FILE *fp) {
+    pthread_mutex_lock(&ctx->lock);
+    ctx->debug_output = fp;
+    pthread_mutex_unlock(&ctx->lock);
+}
+
+void parser_context_set_error_callback(ParserContext *ctx, ParserErrorCallback callback, void *user_data) {
+    pthread_mutex_lock(&ctx->lock);
+    ctx->error_callback = callback;
+    ctx->error_callback_userdata = user_data;
+    pthread_mutex_unlock(&ctx->lock);
+}
+
+void parser_context_set_debug_callback(ParserContext *ctx, ParserDebugCallback callback, void *user_data) {
+    pthread_mutex_lock(&ctx->lock);
+    ctx->debug_callback = callback;
+    ctx->debug_callback_userdata = user_data;
+    pthread_mutex_unlock(&ctx->lock);
+}
+
+/* Global debug API: the default context */
+void parser_set_debug_level(int level) {
+    parser_context_set_debug_level(&default_context, level);
+}
+
 int parser_get_debug_level(void) {
-    pthread_mutex_lock(&debug_mutex);
-    int level = debug_level;
-    pthread_mutex_unlock(&debug_mutex);
-    return level;
+    return parser_context_get_debug_level(&default_context);
 }
 
 void parser_set_debug_output(FILE *fp) {
-    pthread_mutex_lock(&debug_mutex);
-    debug_output = fp;
-    pthread_mutex_unlock(&debug_mutex);
+    parser_context_set_debug_output(&default_context, fp);
 }
 
 void parser_reset_debug_output(void) {
-    pthread_mutex_lock(&debug_mutex);
-    debug_output = NULL;
-    pthread_mutex_unlock(&debug_mutex);
+    parser_context_set_debug_output(&default_context, NULL);
 }
 
-/* Callback API implementation (thread-safe) */
+/* Global callback API: the default context */
 void parser_set_error_callback(ParserErrorCallback callback, void *user_data) {
-    pthread_mutex_lock(&callback_mutex);
-    error_callback = callback;
-    error_callback_userdata = user_data;
-    pthread_mutex_unlock(&callback_mutex);
+    parser_context_set_error_callback(&default_context, callback, user_data);
 }
 
 void parser_set_debug_callback(ParserDebugCallback callback, void *user_data) {
-    pthread_mutex_lock(&callback_mutex);
-    debug_callback = callback;
-    debug_callback_userdata = user_data;
-    pthread_mutex_unlock(&callback_mutex);
+    parser_context_set_debug_callback(&default_context, callback, user_data);
 }
 
 void parser_clear_error_callback(void) {
-    pthread_mutex_lock(&callback_mutex);
-    error_callback = NULL;
-    error_callback_userdata = NULL;
-    pthread_mutex_unlock(&callback_mutex);
+    parser_context_set_error_callback(&default_context, NULL, NULL);
 }
 
 void parser_clear_debug_callback(void) {
-    pthread_mutex_lock(&callback_mutex);
-    debug_callback = NULL;
-    debug_callback_userdata = NULL;
-    pthread_mutex_unlock(&callback_mutex);
+    parser_context_set_debug_callback(&default_context, NULL, NULL);
 }
 
 /* ========== END DEBUG MODE & CALLBACKS ========== */
@@ -180,12 +236,22 @@ typedef struct {
     VarContext *vars;  /* Optional variable context */
     ParserErrorInfo *error;  /* Error tracking */
     bool has_error;
-    struct timeval start_time;  /* For timeout */
-    long timeout_us;  /* Timeout in microseconds (0 = no timeout) */
+    EvalBudget budget;  /* Timeout and operation limit (zeroed = unlimited) */
     int error_count;  /* For error recovery */
     bool continue_on_error;  /* Error recovery mode */
+    bool quiet;  /* Suppress stderr diagnostics and callbacks (AST mode reports via set_error) */
+    ParserContext *ctx;  /* Debug level, output and callbacks */
+    unsigned constants_used;  /* PARSER_CONST_* folded by the tokenizer */
 } Parser;
 
+/* Constants folded into TOK_NUMBER by the tokenizer (tracked for the cache) */
+#define PARSER_CONST_PI 1u
+#define PARSER_CONST_E  2u
+
+/* Tokens between clock reads under a timeout: a token costs tens of
+ * nanoseconds to scan and evaluate, a clock read (vDSO) about 20 */
+#define PARSER_CLOCK_INTERVAL 64
+
 /* Forward declarations */
 static void set_error(Parser *p, ParserError code, const char *message);
 static double parse_or_expr(Parser *p);
@@ -225,32 +291,40 @@ static const char* token_type_string(TokenType type) {
     }
 }
 
-/* Timeout checking */
+/* Timeout and operation limit: each token costs one operation, and the
+ * clock is read once per PARSER_CLOCK_INTERVAL tokens */
 static bool check_timeout(Parser *p) {
-    if (p->timeout_us == 0) return true;  /* No timeout */
-
-    struct timeval now;
-    gettimeofday(&now, NULL);
+    if (eval_budget_charge(&p->budget, 1)) return true;
 
-    long elapsed_us = (now.tv_sec - p->start_time.tv_sec) * 1000000L +
-                     (now.tv_usec - p->start_time.tv_usec);
-
-    if (elapsed_us > p->timeout_us) {
+    if (p->budget.status == EVAL_BUDGET_TIMEOUT) {
         set_error(p, PARSER_ERROR_SYNTAX, "Parsing timeout exceeded");
-        return false;
+    } else {
+        set_error(p, PARSER_ERROR_SYNTAX, "Operation budget exceeded");
     }
-    return true;
+    return false;
 }
 
 /* Error reporting helpers */
+static void report_error(Parser *p) {
+    /* Call error callback if registered (thread-safe) */
+    pthread_mutex_lock(&p->ctx->lock);
+    ParserErrorCallback callback = p->ctx->error_callback;
+    void *userdata = p->ctx->error_callback_userdata;
+    pthread_mutex_unlock(&p->ctx->lock);
+
+    if (callback) {
+        callback(p->error, p->input, userdata);
+    }
+}
+
 static void set_error(Parser *p, ParserError code, const char *message) {
     if (!p->error) return;
 
     /* For error recovery: count errors, continue if enabled */
     p->error_count++;
 
-    if (!p->continue_on_error && p->has_error) {
-        return;  /* Don't overwrite first error */
+    if ((!p->continue_on_error || p->budget.status != EVAL_BUDGET_OK) && p->has_error) {
+        return;  /* Don't overwrite first error (or the budget's, which ends parsing) */
     }
 
     p->has_error = true;
@@ -258,15 +332,9 @@ static void set_error(Parser *p, ParserError code, const char *message) {
     p->error->position = (int)p->pos;
     snprintf(p->error->message, sizeof(p->error->message), "%s", message);
 
-    /* Call error callback if registered (thread-safe) */
-    pthread_mutex_lock(&callback_mutex);
-    ParserErrorCallback callback = error_callback;
-    void *userdata = error_callback_userdata;
-    pthread_mutex_unlock(&callback_mutex);
+    if (p->quiet) return;
 
-    if (callback) {
-        callback(p->error, p->input, userdata);
-    }
+    report_error(p);
 }
 
 static void set_error_fmt(Parser *p, ParserError code, const char *fmt, ...) {
@@ -274,7 +342,7 @@ static void set_error_fmt(Parser *p, ParserError code, const char *fmt, ...) {
 
     p->error_count++;
 
-    if (!p->continue_on_error && p->has_error) {
+    if ((!p->continue_on_error || p->budget.status != EVAL_BUDGET_OK) && p->has_error) {
         return;
     }
 
@@ -287,15 +355,9 @@ static void set_error_fmt(Parser *p, ParserError code, const char *fmt, ...) {
     vsnprintf(p->error->message, sizeof(p->error->message), fmt, args);
     va_end(args);
 
-    /* Call error callback if registered (thread-safe) */
-    pthread_mutex_lock(&callback_mutex);
-    ParserErrorCallback callback = error_callback;
-    void *userdata = error_callback_userdata;
-    pthread_mutex_unlock(&callback_mutex);
+    if (p->quiet) return;
 
-    if (callback) {
-        callback(p->error, p->input, userdata);
-    }
+    report_error(p);
 }
 
 static bool check_depth(Parser *p) {
@@ -323,7 +385,7 @@ static bool lookup_variable(Parser *p, const char *name, double *value) {
                 int idx = p->vars->mappings[i].index;
                 if (idx >= 0 && idx < p->vars->count) {
                     *value = p->vars->values[idx];
-                    debug_print(DEBUG_VARS, "[VAR] %s = %.6g (index %d)\n", name, *value, idx);
+                    debug_print(p->ctx, DEBUG_VARS, "[VAR] %s = %.6g (index %d)\n", name, *value, idx);
                     return true;
                 }
                 set_error_fmt(p, PARSER_ERROR_UNKNOWN_VAR,
@@ -342,7 +404,7 @@ static bool lookup_variable(Parser *p, const char *name, double *value) {
             int idx = c - 'A';
             if (idx < p->vars->count) {
                 *value = p->vars->values[idx];
-                debug_print(DEBUG_VARS, "[VAR] %s = %.6g (index %d)\n", name, *value, idx);
+                debug_print(p->ctx, DEBUG_VARS, "[VAR] %s = %.6g (index %d)\n", name, *value, idx);
                 return true;
             }
         }
@@ -360,6 +422,13 @@ static void skip_whitespace(Parser *p) {
 
 /* Get next token */
 static void next_token(Parser *p) {
+    /* A spent budget ends the input; what that breaks is not reported */
+    if (!check_timeout(p)) {
+        p->current_token.type = TOK_END;
+        p->quiet = true;
+        return;
+    }
+
     skip_whitespace(p);
 
     if (!p->input[p->pos]) {
@@ -369,12 +438,11 @@ static void next_token(Parser *p) {
 
     char c = p->input[p->pos];
 
-    /* Check for numbers */
+    /* Check for numbers (correctly rounded, '.' whatever the locale) */
     if (isdigit(c) || c == '.') {
-        char *endptr;
+        const char *start = &p->input[p->pos];
         p->current_token.type = TOK_NUMBER;
-        p->current_token.value = strtod(&p->input[p->pos], &endptr);
-        p->pos = endptr - p->input;
+        p->pos += number_parse(start, p->input + p->input_length, &p->current_token.value) - start;
         return;
     }
 
@@ -408,11 +476,13 @@ static void next_token(Parser *p) {
         if (strcmp(p->current_token.func_name, "PI") == 0) {
             p->current_token.type = TOK_NUMBER;
             p->current_token.value = 3.14159265358979323846;
+            p->constants_used |= PARSER_CONST_PI;
             return;
         }
         if (strcmp(p->current_token.func_name, "E") == 0) {
             p->current_token.type = TOK_NUMBER;
             p->current_token.value = 2.71828182845904523536;
+            p->constants_used |= PARSER_CONST_E;
             return;
         }
 
@@ -451,7 +521,7 @@ static void next_token(Parser *p) {
                 p->pos++;
                 p->current_token.type = TOK_AND;            } else {
                 p->current_token.type = TOK_ERROR;
-                fprintf(stderr, "Error: Expected '&&' but got '&'\n");
+                if (!p->quiet) fprintf(stderr, "Error: Expected '&&' but got '&'\n");
             }
             break;
         case '|':
@@ -459,7 +529,7 @@ static void next_token(Parser *p) {
                 p->pos++;
                 p->current_token.type = TOK_OR;            } else {
                 p->current_token.type = TOK_ERROR;
-                fprintf(stderr, "Error: Expected '||' but got '|'\n");
+                if (!p->quiet) fprintf(stderr, "Error: Expected '||' but got '|'\n");
             }
             break;
         case '>':
@@ -482,27 +552,27 @@ static void next_token(Parser *p) {
                 p->pos++;
                 p->current_token.type = TOK_EQUAL;            } else {
                 p->current_token.type = TOK_ERROR;
-                fprintf(stderr, "Error: Expected '==' but got '='\n");
+                if (!p->quiet) fprintf(stderr, "Error: Expected '==' but got '='\n");
             }
             break;
         default:
             p->current_token.type = TOK_ERROR;
-            fprintf(stderr, "Error: Unexpected character '%c'\n", c);
+            if (!p->quiet) fprintf(stderr, "Error: Unexpected character '%c'\n", c);
             break;
     }
 
     /* Debug: show tokenization */
-    if (debug_level & DEBUG_TOKENS) {
+    if (debug_enabled(p->ctx, DEBUG_TOKENS)) {
         if (p->current_token.type == TOK_NUMBER) {
-            debug_print(DEBUG_TOKENS, "[TOKEN] %s = %.6g\n",
+            debug_print(p->ctx, DEBUG_TOKENS, "[TOKEN] %s = %.6g\n",
                        token_type_string(p->current_token.type),
                        p->current_token.value);
         } else if (p->current_token.type == TOK_FUNCTION) {
-            debug_print(DEBUG_TOKENS, "[TOKEN] %s '%s'\n",
+            debug_print(p->ctx, DEBUG_TOKENS, "[TOKEN] %s '%s'\n",
                        token_type_string(p->current_token.type),
                        p->current_token.func_name);
         } else {
-            debug_print(DEBUG_TOKENS, "[TOKEN] %s\n",
+            debug_print(p->ctx, DEBUG_TOKENS, "[TOKEN] %s\n",
                        token_type_string(p->current_token.type));
         }
     }
@@ -512,73 +582,42 @@ static void next_token(Parser *p) {
 static double eval_function(const char *name, double *args, int arg_count, Parser *p) {
     (void)p;  /* Unused parameter - kept for API consistency */
 
+    const MathFunctionInfo *f = math_function_lookup(name);
+
     /* Zero-argument functions */
-    if (strcmp(name, "RANDOM") == 0 || strcmp(name, "RND") == 0) {
+    if (f && f->id == FUNC_RANDOM) {
         if (arg_count != 0) {
             fprintf(stderr, "Error: %s expects 0 arguments, got %d\n", name, arg_count);
             return 0.0;
         }
-        /* Thread-safe RNG with mutex protection */
-        pthread_mutex_lock(&rng_mutex);
-        if (!random_seeded) {
-            srand(time(NULL));
-            random_seeded = true;
-        }
-        double r = (double)rand() / (double)RAND_MAX;
-        pthread_mutex_unlock(&rng_mutex);
-        return r;
-    }
-
-    /* One-argument functions */
-    if (arg_count == 1) {
-        double x = args[0];
-
-        if (strcmp(name, "ABS") == 0) return fabs(x);
-        if (strcmp(name, "ROUND") == 0) return round(x);
-        if (strcmp(name, "FLOOR") == 0) return floor(x);
-        if (strcmp(name, "CEIL") == 0) return ceil(x);
-        if (strcmp(name, "SQRT") == 0) {
-            if (x < 0.0) {
-                fprintf(stderr, "Error: SQRT of negative number\n");
-                return 0.0;
-            }
-            return sqrt(x);
-        }
-        if (strcmp(name, "SIN") == 0) return sin(x);
-        if (strcmp(name, "COS") == 0) return cos(x);
-        if (strcmp(name, "TAN") == 0) return tan(x);
-        if (strcmp(name, "ASIN") == 0) return asin(x);
-        if (strcmp(name, "ACOS") == 0) return acos(x);
-        if (strcmp(name, "ATAN") == 0) return atan(x);
-        if (strcmp(name, "LOG") == 0 || strcmp(name, "LN") == 0) {
-            if (x <= 0.0) {
-                fprintf(stderr, "Error: LOG of non-positive number\n");
-                return 0.0;
-            }
-            return log(x);
-        }
-        if (strcmp(name, "LOG10") == 0) {
-            if (x <= 0.0) {
-                fprintf(stderr, "Error: LOG10 of non-positive number\n");
-                return 0.0;
-            }
-            return log10(x);
-        }
-        if (strcmp(name, "EXP") == 0) return exp(x);
-        if (strcmp(name, "INT") == 0) return floor(x);  /* BASIC-style INT */
-        if (strcmp(name, "SGN") == 0) return (x > 0.0) ? 1.0 : (x < 0.0) ? -1.0 : 0.0;
+        return math_function_eval(FUNC_RANDOM, args, 0);
     }
 
-    /* Two-argument functions */
-    if (arg_count == 2) {
-        double x = args[0];
-        double y = args[1];
-
-        if (strcmp(name, "MIN") == 0) return fmin(x, y);
-        if (strcmp(name, "MAX") == 0) return fmax(x, y);
-        if (strcmp(name, "POW") == 0) return pow(x, y);
-        if (strcmp(name, "ATAN2") == 0) return atan2(y, x);
-        if (strcmp(name, "MOD") == 0) return fmod(x, y);
+    if (f && arg_count == f->arg_count) {
+        /* Domain errors are reported here; the shared table would give NaN/-inf */
+        switch (f->id) {
+            case FUNC_SQRT:
+                if (args[0] < 0.0) {
+                    fprintf(stderr, "Error: SQRT of negative number\n");
+                    return 0.0;
+                }
+                break;
+            case FUNC_LOG:
+                if (args[0] <= 0.0) {
+                    fprintf(stderr, "Error: LOG of non-positive number\n");
+                    return 0.0;
+                }
+                break;
+            case FUNC_LOG10:
+                if (args[0] <= 0.0) {
+                    fprintf(stderr, "Error: LOG10 of non-positive number\n");
+                    return 0.0;
+                }
+                break;
+            default:
+                break;
+        }
+        return math_function_eval(f->id, args, arg_count);
     }
 
     fprintf(stderr, "Error: Unknown function '%s' or wrong number of arguments\n", name);
@@ -613,7 +652,7 @@ static double parse_primary_expr(Parser *p) {
 
         /* Expect opening parenthesis */
         if (p->current_token.type != TOK_LPAREN) {
-            fprintf(stderr, "Error: Expected '(' after function name\n");
+            if (!p->quiet) fprintf(stderr, "Error: Expected '(' after function name\n");
             p->depth--;
             return 0.0;
         }
@@ -643,7 +682,7 @@ static double parse_primary_expr(Parser *p) {
                     next_token(p);
                     break;
                 } else {
-                    fprintf(stderr, "Error: Expected ',' or ')' in function call\n");
+                    if (!p->quiet) fprintf(stderr, "Error: Expected ',' or ')' in function call\n");
                     break;
                 }
             }
@@ -657,10 +696,10 @@ static double parse_primary_expr(Parser *p) {
         if (p->current_token.type == TOK_RPAREN) {
             next_token(p);
         } else {
-            fprintf(stderr, "Error: Expected closing parenthesis\n");
+            if (!p->quiet) fprintf(stderr, "Error: Expected closing parenthesis\n");
         }
     } else {
-        fprintf(stderr, "Error: Expected number, function, or '('\n");
+        if (!p->quiet) fprintf(stderr, "Error: Expected number, function, or '('\n");
     }
 
     p->depth--;
@@ -764,7 +803,7 @@ static double parse_additive_expr(Parser *p) {
 /* Parse comparison expression: <, >, <=, >=, ==, != */
 static double parse_comparison_expr(Parser *p) {
     p->depth++;
-    if (!check_depth(p) || !check_timeout(p)) {
+    if (!check_depth(p)) {
         p->depth--;
         return 0.0;
     }
@@ -816,10 +855,6 @@ static double parse_comparison_expr(Parser *p) {
 /* Parse AND expression: && */
 static double parse_and_expr(Parser *p) {
     p->depth++;
-    if (!check_timeout(p)) {
-        p->depth--;
-        return 0.0;
-    }
 
     double result = parse_comparison_expr(p);
 
@@ -849,6 +884,275 @@ static double parse_or_expr(Parser *p) {
     return result;
 }
 
+/* ========== AST BUILDING MODE ==========
+ * Same grammar as the evaluating parser above, but builds an ASTNode tree
+ * for ast_compile()/vm_execute() instead of computing a value. Identifiers
+ * not followed by '(' become AST_VARIABLE nodes that are resolved at
+ * evaluation time, so one tree serves any VarContext.
+ */
+
+static ASTNode* parse_or_ast(Parser *p);
+
+/* Combine two operands, releasing the left one if the right failed to parse */
+static ASTNode* binary_ast(BinaryOp op, ASTNode *left, ASTNode *right) {
+    if (!right) {
+        ast_free(left);
+        return NULL;
+    }
+    return ast_create_binary_op(op, left, right);
+}
+
+/* Parse primary expression: number, variable, function call, or (expression) */
+static ASTNode* parse_primary_ast(Parser *p) {
+    p->depth++;
+    if (!check_depth(p) || p->has_error) {
+        p->depth--;
+        return NULL;
+    }
+
+    ASTNode *node = NULL;
+
+    if (p->current_token.type == TOK_NUMBER) {
+        node = ast_create_number(p->current_token.value);
+        next_token(p);
+    } else if (p->current_token.type == TOK_FUNCTION) {
+        char name[32];
+        strncpy(name, p->current_token.func_name, sizeof(name) - 1);
+        name[sizeof(name) - 1] = '\0';
+
+        next_token(p);
+
+        /* Bare identifier: variable looked up when the tree is evaluated */
+        if (p->current_token.type != TOK_LPAREN) {
+            p->depth--;
+            return ast_create_variable(name);
+        }
+        next_token(p);
+
+        ASTNode *args[PARSER_MAX_FUNC_ARGS];
+        int arg_count = 0;
+
+        if (p->current_token.type == TOK_RPAREN) {
+            next_token(p);
+        } else {
+            while (1) {
+                if (arg_count >= PARSER_MAX_FUNC_ARGS) {
+                    set_error(p, PARSER_ERROR_WRONG_ARGS, "Too many function arguments (max "
+                              STRINGIFY(PARSER_MAX_FUNC_ARGS) ")");
+                    break;
+                }
+
+                ASTNode *arg = parse_or_ast(p);
+                if (!arg) break;
+                args[arg_count++] = arg;
+
+                if (p->current_token.type == TOK_COMMA) {
+                    next_token(p);
+                } else if (p->current_token.type == TOK_RPAREN) {
+                    next_token(p);
+                    break;
+                } else {
+                    set_error(p, PARSER_ERROR_SYNTAX, "Expected ',' or ')' in function call");
+                    break;
+                }
+            }
+        }
+
+        if (p->has_error) {
+            for (int i = 0; i < arg_count; i++) {
+                ast_free(args[i]);
+            }
+        } else {
+            node = ast_create_function_call(name, args, arg_count);
+        }
+
+    } else if (p->current_token.type == TOK_LPAREN) {
+        next_token(p);
+        node = parse_or_ast(p);
+        if (node && p->current_token.type == TOK_RPAREN) {
+            next_token(p);
+        } else if (node) {
+            set_error(p, PARSER_ERROR_UNMATCHED_PAREN, "Expected closing parenthesis");
+            ast_free(node);
+            node = NULL;
+        }
+    } else {
+        set_error(p, PARSER_ERROR_UNEXPECTED_TOKEN, "Expected number, function, or '('");
+    }
+
+    p->depth--;
+    return node;
+}
+
+/* Parse unary expression: !expr, -expr or primary */
+static ASTNode* parse_unary_ast(Parser *p) {
+    p->depth++;
+
+    ASTNode *node;
+
+    if (p->current_token.type == TOK_NOT || p->current_token.type == TOK_MINUS) {
+        UnaryOp op = (p->current_token.type == TOK_NOT) ? OP_NOT : OP_NEGATE;
+        next_token(p);
+        ASTNode *operand = parse_unary_ast(p);
+        node = operand ? ast_create_unary_op(op, operand) : NULL;
+    } else {
+        node = parse_primary_ast(p);
+    }
+
+    p->depth--;
+    return node;
+}
+
+/* Parse power expression: base ^ exponent (right associative) */
+static ASTNode* parse_power_ast(Parser *p) {
+    p->depth++;
+
+    ASTNode *node = parse_unary_ast(p);
+
+    if (node && p->current_token.type == TOK_POWER) {
+        next_token(p);
+        node = binary_ast(OP_POWER, node, parse_power_ast(p));
+    }
+
+    p->depth--;
+    return node;
+}
+
+/* Parse multiplicative expression: * and / */
+static ASTNode* parse_multiplicative_ast(Parser *p) {
+    p->depth++;
+
+    ASTNode *node = parse_power_ast(p);
+
+    while (node && (p->current_token.type == TOK_MULTIPLY ||
+                    p->current_token.type == TOK_DIVIDE)) {
+        BinaryOp op = (p->current_token.type == TOK_MULTIPLY) ? OP_MULTIPLY : OP_DIVIDE;
+        next_token(p);
+        node = binary_ast(op, node, parse_power_ast(p));
+    }
+
+    p->depth--;
+    return node;
+}
+
+/* Parse additive expression: + and - */
+static ASTNode* parse_additive_ast(Parser *p) {
+    p->depth++;
+
+    ASTNode *node = parse_multiplicative_ast(p);
+
+    while (node && (p->current_token.type == TOK_PLUS ||
+                    p->current_token.type == TOK_MINUS)) {
+        BinaryOp op = (p->current_token.type == TOK_PLUS) ? OP_ADD : OP_SUBTRACT;
+        next_token(p);
+        node = binary_ast(op, node, parse_multiplicative_ast(p));
+    }
+
+    p->depth--;
+    return node;
+}
+
+/* Parse comparison expression: <, >, <=, >=, ==, != (non-associative) */
+static ASTNode* parse_comparison_ast(Parser *p) {
+    p->depth++;
+    if (!check_depth(p)) {
+        p->depth--;
+        return NULL;
+    }
+
+    ASTNode *node = parse_additive_ast(p);
+
+    if (node) {
+        BinaryOp op;
+        bool is_comparison = true;
+
+        switch (p->current_token.type) {
+            case TOK_GREATER: op = OP_GREATER; break;
+            case TOK_LESS: op = OP_LESS; break;
+            case TOK_GREATER_EQ: op = OP_GREATER_EQ; break;
+            case TOK_LESS_EQ: op = OP_LESS_EQ; break;
+            case TOK_EQUAL: op = OP_EQUAL; break;
+            case TOK_NOT_EQUAL: op = OP_NOT_EQUAL; break;
+            default: op = OP_EQUAL; is_comparison = false; break;
+        }
+
+        if (is_comparison) {
+            next_token(p);
+            node = binary_ast(op, node, parse_additive_ast(p));
+        }
+    }
+
+    p->depth--;
+    return node;
+}
+
+/* Parse AND expression: && */
+static ASTNode* parse_and_ast(Parser *p) {
+    p->depth++;
+
+    ASTNode *node = parse_comparison_ast(p);
+
+    while (node && p->current_token.type == TOK_AND) {
+        next_token(p);
+        node = binary_ast(OP_AND, node, parse_comparison_ast(p));
+    }
+
+    p->depth--;
+    return node;
+}
+
+/* Parse OR expression: || */
+static ASTNode* parse_or_ast(Parser *p) {
+    p->depth++;
+
+    ASTNode *node = parse_and_ast(p);
+
+    while (node && p->current_token.type == TOK_OR) {
+        next_token(p);
+        node = binary_ast(OP_OR, node, parse_and_ast(p));
+    }
+
+    p->depth--;
+    return node;
+}
+
+/* Build an AST for a validated expression; reports folded constants */
+static ASTNode* parse_ast_internal(ParserContext *ctx, const char *expr, size_t len, ParserErrorInfo *error,
+                                   unsigned *constants) {
+    /* No VarContext: identifiers stay symbolic instead of being substituted */
+    Parser parser = {
+        .input = expr,
+        .pos = 0,
+        .input_length = len,
+        .depth = 0,
+        .max_depth_reached = 0,
+        .vars = NULL,
+        .error = error,
+        .has_error = false,
+        .quiet = true,
+        .ctx = ctx
+    };
+
+    next_token(&parser);
+    ASTNode *ast = parse_or_ast(&parser);
+
+    /* Check for trailing tokens */
+    if (!parser.has_error && parser.current_token.type != TOK_END) {
+        set_error(&parser, PARSER_ERROR_UNEXPECTED_TOKEN,
+                  "Unexpected tokens at end of expression");
+    }
+
+    if (parser.has_error) {
+        ast_free(ast);
+        return NULL;
+    }
+
+    if (constants) {
+        *constants = parser.constants_used;
+    }
+    return ast;
+}
+
 /* Public API */
 double parse_expression(const char *expr) {
     if (!expr || !*expr) {
@@ -864,7 +1168,8 @@ double parse_expression(const char *expr) {
         .max_depth_reached = 0,
         .vars = NULL,
         .error = NULL,
-        .has_error = false
+        .has_error = false,
+        .ctx = &default_context
     };
 
 
@@ -893,7 +1198,8 @@ double parse_expression_with_vars(const char *expr, VarContext *vars) {
         .max_depth_reached = 0,
         .vars = vars,
         .error = NULL,
-        .has_error = false
+        .has_error = false,
+        .ctx = &default_context
     };
 
 
@@ -908,80 +1214,736 @@ double parse_expression_with_vars(const char *expr, VarContext *vars) {
     return result;
 }
 
-/* NEW SAFE API IMPLEMENTATION */
+/* ========== COMPILED EXPRESSION CACHE ==========
+ * parse_expression_safe()/parse_expression_with_vars_safe() look the
+ * expression text up in a process-wide cache of parsed ASTs, so repeated
+ * strings skip tokenizing and parsing. The cache is split into shards, each
+ * with its own rwlock, so concurrent readers never serialize on one mutex.
+ * Replacement is CLOCK (second chance), an LRU approximation in which a hit
+ * only sets a reference bit instead of relinking a list.
+ *
+ * A cached AST is used only when its value is guaranteed to equal what the
+ * evaluating parser would return. Anything the parser reports on stderr or
+ * resolves differently for this VarContext (division by zero, domain errors,
+ * unknown names, variables shadowing PI/E or function names) is handed back
+ * to the parser. Expressions that fail to parse are cached as negative
+ * entries so the parser runs directly without a second parse attempt.
+ */
 
-ParseResult parse_expression_safe(const char *expr) {
-    return parse_expression_with_vars_safe(expr, NULL);
+#define CACHE_SHARD_BITS 4
+#define CACHE_SHARDS (1 << CACHE_SHARD_BITS)
+
+typedef struct CacheEntry {
+    uint64_t hash;
+    char *expr;
+    size_t len;
+    ASTNode *ast;               /* NULL: not cacheable, always use the parser */
+    unsigned constants;         /* PARSER_CONST_* folded into the AST */
+    unsigned char referenced;   /* CLOCK bit, set by readers */
+    struct CacheEntry *next;    /* Bucket chain */
+
+    /* Tiered execution state (parse_expression_ex), written under the write lock */
+    unsigned long calls;            /* Tiered calls so far */
+    CompiledExpression *program;    /* Guarded bytecode, NULL below the compile tier */
+    bool tier_failed;               /* Not compilable for the layout seen at promotion */
+    bool jit_tried;
+    bool layout_has_values;         /* VarContext layout the program is bound to */
+    int layout_count;
+    VarMapping *layout_mappings;
+    int layout_mapping_count;
+} CacheEntry;
+
+typedef struct {
+    pthread_rwlock_t lock;
+    CacheEntry *entries;        /* Entry pool (capacity slots) */
+    CacheEntry **buckets;       /* Hash chains into the pool */
+    size_t bucket_mask;
+    size_t capacity;
+    size_t count;
+    size_t hand;                /* CLOCK hand */
+    unsigned long long hits;
+    unsigned long long misses;
+    unsigned long long evictions;
+    unsigned long long fallbacks;
+    unsigned long long tier_calls[3];   /* Indexed by ParserTier */
+    unsigned long long tier_promotions[3];
+    unsigned long long deopts;
+} __attribute__((aligned(64))) CacheShard;
+
+static CacheShard cache_shards[CACHE_SHARDS];
+static pthread_once_t cache_once = PTHREAD_ONCE_INIT;
+static size_t cache_capacity = PARSER_CACHE_DEFAULT_CAPACITY;
+
+static void cache_init(void) {
+    for (int i = 0; i < CACHE_SHARDS; i++) {
+        pthread_rwlock_init(&cache_shards[i].lock, NULL);
+    }
 }
 
-ParseResult parse_expression_with_vars_safe(const char *expr, VarContext *vars) {
-    ParseResult result = {
-        .value = 0.0,
-        .error = {
-            .code = PARSER_OK,
-            .position = 0,
-            .message = {0}
-        },
-        .has_error = false
-    };
+static void cache_count(unsigned long long *counter) {
+    __atomic_fetch_add(counter, 1, __ATOMIC_RELAXED);
+}
 
-    /* Input validation */
-    if (!expr) {
-        result.has_error = true;
-        result.error.code = PARSER_ERROR_EMPTY_EXPR;
-        snprintf(result.error.message, sizeof(result.error.message),
-                 "Expression is NULL");
-        return result;
+/* FNV-1a */
+static uint64_t cache_hash(const char *expr, size_t len) {
+    uint64_t h = 14695981039346656037ULL;
+    for (size_t i = 0; i < len; i++) {
+        h ^= (unsigned char)expr[i];
+        h *= 1099511628211ULL;
     }
+    return h;
+}
 
-    size_t len = strlen(expr);
-    if (len == 0) {
-        result.has_error = true;
-        result.error.code = PARSER_ERROR_EMPTY_EXPR;
-        snprintf(result.error.message, sizeof(result.error.message),
-                 "Expression is empty");
-        return result;
+/* True if every call in the tree is a known function with the right arity */
+static bool cache_validate(const ASTNode *node) {
+    switch (node->type) {
+        case AST_NUMBER:
+        case AST_VARIABLE:
+            return true;
+        case AST_BINARY_OP:
+            return cache_validate(node->data.binary.left) &&
+                   cache_validate(node->data.binary.right);
+        case AST_UNARY_OP:
+            return cache_validate(node->data.unary.operand);
+        case AST_FUNCTION_CALL: {
+            const MathFunctionInfo *f = math_function_info(node->data.function.id);
+            if (!f || f->arg_count != node->data.function.arg_count) return false;
+            for (int i = 0; i < node->data.function.arg_count; i++) {
+                if (!cache_validate(node->data.function.args[i])) return false;
+            }
+            return true;
+        }
+        default:
+            return false;
     }
+}
 
-    if (len > PARSER_MAX_EXPR_LENGTH) {
-        result.has_error = true;
-        result.error.code = PARSER_ERROR_TOO_LONG;
-        snprintf(result.error.message, sizeof(result.error.message),
-                 "Expression too long (%zu chars, max %d)",
-                 len, PARSER_MAX_EXPR_LENGTH);
-        return result;
+/* Resolve a name the way lookup_variable() does.
+ * Returns 1 if found, 0 if the parser would not treat it as a variable,
+ * -1 if the parser would report an error (mapping index out of range).
+ */
+static int cache_lookup_var(const VarContext *vars, const char *name, double *value) {
+    if (!vars || !vars->values) return 0;
+
+    if (vars->mappings && vars->mapping_count > 0) {
+        for (int i = 0; i < vars->mapping_count; i++) {
+            if (strcmp(name, vars->mappings[i].name) == 0) {
+                int idx = vars->mappings[i].index;
+                if (idx < 0 || idx >= vars->count) return -1;
+                *value = vars->values[idx];
+                return 1;
+            }
+        }
+        return 0;
     }
 
-    /* Initialize parser with error tracking */
-    Parser parser = {
-        .input = expr,
-        .pos = 0,
-        .input_length = len,
-        .depth = 0,
-        .max_depth_reached = 0,
-        .vars = vars,
-        .error = &result.error,
-        .has_error = false
-    };
+    if (name[0] >= 'A' && name[0] <= 'Z' && name[1] == '\0') {
+        int idx = name[0] - 'A';
+        if (idx < vars->count) {
+            *value = vars->values[idx];
+            return 1;
+        }
+    }
+    return 0;
+}
 
+/* Evaluate a cached AST with the evaluating parser's semantics.
+ * Returns false wherever the parser would print a diagnostic or resolve a
+ * name differently; the caller then runs the parser instead.
+ */
+static bool cache_eval(const ASTNode *node, const VarContext *vars, double *out) {
+    switch (node->type) {
+        case AST_NUMBER:
+            *out = node->data.number.value;
+            return true;
+
+        case AST_VARIABLE:
+            return cache_lookup_var(vars, node->data.variable.name, out) == 1;
+
+        case AST_BINARY_OP: {
+            double left, right;
+            if (!cache_eval(node->data.binary.left, vars, &left) ||
+                !cache_eval(node->data.binary.right, vars, &right)) {
+                return false;
+            }
+            switch (node->data.binary.op) {
+                case OP_ADD: *out = left + right; break;
+                case OP_SUBTRACT: *out = left - right; break;
+                case OP_MULTIPLY: *out = left * right; break;
+                case OP_DIVIDE:
+                    if (right == 0.0) return false;
+                    *out = left / right;
+                    break;
+                case OP_POWER: *out = pow(left, right); break;
+                case OP_AND: *out = (left != 0.0) && (right != 0.0) ? 1.0 : 0.0; break;
+                case OP_OR: *out = (left != 0.0) || (right != 0.0) ? 1.0 : 0.0; break;
+                case OP_GREATER: *out = (left > right) ? 1.0 : 0.0; break;
+                case OP_LESS: *out = (left < right) ? 1.0 : 0.0; break;
+                case OP_GREATER_EQ: *out = (left >= right) ? 1.0 : 0.0; break;
+                case OP_LESS_EQ: *out = (left <= right) ? 1.0 : 0.0; break;
+                case OP_EQUAL: *out = (fabs(left - right) < 1e-12) ? 1.0 : 0.0; break;
+                case OP_NOT_EQUAL: *out = (fabs(left - right) >= 1e-12) ? 1.0 : 0.0; break;
+            }
+            return true;
+        }
 
-    /* Parse expression */
-    next_token(&parser);
-    result.value = parse_or_expr(&parser);
+        case AST_UNARY_OP: {
+            double operand;
+            if (!cache_eval(node->data.unary.operand, vars, &operand)) return false;
+            *out = node->data.unary.op == OP_NEGATE ? -operand : !operand;
+            return true;
+        }
 
-    /* Check for trailing tokens */
-    if (!parser.has_error && parser.current_token.type != TOK_END) {
-        set_error(&parser, PARSER_ERROR_UNEXPECTED_TOKEN,
-                  "Unexpected tokens at end of expression");
+        case AST_FUNCTION_CALL: {
+            const char *name = node->data.function.name;
+            double args[PARSER_MAX_FUNC_ARGS];
+
+            /* A variable with this name would replace the call in the parser */
+            if (cache_lookup_var(vars, name, &args[0]) != 0) return false;
+
+            for (int i = 0; i < node->data.function.arg_count; i++) {
+                if (!cache_eval(node->data.function.args[i], vars, &args[i])) return false;
+            }
+
+            /* Domain errors are reported by eval_function() */
+            MathFunction id = node->data.function.id;
+            if (id == FUNC_SQRT && args[0] < 0.0) return false;
+            if ((id == FUNC_LOG || id == FUNC_LOG10) && args[0] <= 0.0) return false;
+
+            *out = math_function_eval(id, args, node->data.function.arg_count);
+            return true;
+        }
+
+        default:
+            return false;
     }
+}
 
-    result.has_error = parser.has_error;
+/* Evaluate a cache entry; false if the parser must handle this call */
+static bool cache_entry_eval(const CacheEntry *entry, const VarContext *vars, double *out) {
+    double shadow;
+    if (!entry->ast) return false;
+    if ((entry->constants & PARSER_CONST_PI) && cache_lookup_var(vars, "PI", &shadow) != 0) return false;
+    if ((entry->constants & PARSER_CONST_E) && cache_lookup_var(vars, "E", &shadow) != 0) return false;
+    return cache_eval(entry->ast, vars, out);
+}
+
+static CacheEntry* cache_find(CacheShard *shard, uint64_t hash, const char *expr, size_t len) {
+    if (!shard->buckets) return NULL;
+    for (CacheEntry *e = shard->buckets[hash & shard->bucket_mask]; e; e = e->next) {
+        if (e->hash == hash && e->len == len && memcmp(e->expr, expr, len) == 0) {
+            return e;
+        }
+    }
+    return NULL;
+}
 
+static void cache_entry_release(CacheEntry *entry) {
+    free(entry->expr);
+    ast_free(entry->ast);
+    compiled_expression_free(entry->program);
+    free(entry->layout_mappings);
+    entry->expr = NULL;
+    entry->ast = NULL;
+    entry->program = NULL;
+    entry->layout_mappings = NULL;
+}
 
-    return result;
+/* Free every entry and the shard's tables (caller holds the write lock) */
+static void cache_shard_clear(CacheShard *shard) {
+    for (size_t i = 0; i < shard->count; i++) {
+        cache_entry_release(&shard->entries[i]);
+    }
+    free(shard->entries);
+    free(shard->buckets);
+    shard->entries = NULL;
+    shard->buckets = NULL;
+    shard->bucket_mask = 0;
+    shard->capacity = 0;
+    shard->count = 0;
+    shard->hand = 0;
 }
 
-ParseResult parse_expression_ex(const char *expr, VarContext *vars, ParserConfig *config) {
+static size_t cache_shard_capacity(size_t capacity) {
+    return (capacity + CACHE_SHARDS - 1) / CACHE_SHARDS;
+}
+
+/* Take ownership of ast and insert it (caller holds the write lock) */
+static void cache_insert(CacheShard *shard, uint64_t hash, const char *expr, size_t len,
+                         ASTNode *ast, unsigned constants) {
+    size_t capacity = cache_shard_capacity(__atomic_load_n(&cache_capacity, __ATOMIC_RELAXED));
+
+    if (capacity == 0 || cache_find(shard, hash, expr, len)) {
+        ast_free(ast);  /* Disabled, or another thread inserted it first */
+        return;
+    }
+
+    if (!shard->entries) {
+        size_t buckets = 8;
+        while (buckets < capacity * 2) buckets <<= 1;
+        shard->entries = calloc(capacity, sizeof(CacheEntry));
+        shard->buckets = calloc(buckets, sizeof(CacheEntry *));
+        if (!shard->entries || !shard->buckets) {
+            cache_shard_clear(shard);
+            ast_free(ast);
+            return;
+        }
+        shard->bucket_mask = buckets - 1;
+        shard->capacity = capacity;
+    }
+
+    char *copy = malloc(len + 1);
+    if (!copy) {
+        ast_free(ast);
+        return;
+    }
+    memcpy(copy, expr, len + 1);
+
+    CacheEntry *slot;
+    if (shard->count < shard->capacity) {
+        slot = &shard->entries[shard->count++];
+    } else {
+        /* CLOCK: skip recently referenced entries, clearing their bit */
+        for (;;) {
+            slot = &shard->entries[shard->hand];
+            shard->hand = (shard->hand + 1) % shard->capacity;
+            if (!__atomic_load_n(&slot->referenced, __ATOMIC_RELAXED)) break;
+            __atomic_store_n(&slot->referenced, 0, __ATOMIC_RELAXED);
+        }
+
+        CacheEntry **link = &shard->buckets[slot->hash & shard->bucket_mask];
+        while (*link != slot) link = &(*link)->next;
+        *link = slot->next;
+        cache_entry_release(slot);
+        cache_count(&shard->evictions);
+    }
+
+    slot->expr = copy;
+    slot->hash = hash;
+    slot->len = len;
+    slot->ast = ast;
+    slot->constants = constants;
+    slot->referenced = 0;
+    slot->calls = 0;
+    slot->tier_failed = false;
+    slot->jit_tried = false;
+    slot->next = shard->buckets[hash & shard->bucket_mask];
+    shard->buckets[hash & shard->bucket_mask] = slot;
+}
+
+/* Parse an expression for the cache: NULL if it cannot be served from
+ * there. Cached trees outlive any arena the caller has pushed, so they
+ * always go on the heap. */
+static ASTNode* cache_parse(ParserContext *ctx, const char *expr, size_t len, unsigned *constants) {
+    ParserErrorInfo error;
+    ASTArena *previous = ast_arena_push(NULL);
+    ASTNode *ast = parse_ast_internal(ctx, expr, len, &error, constants);
+    if (ast && !cache_validate(ast)) {
+        ast_free(ast);
+        ast = NULL;
+    }
+    ast_arena_pop(previous);
+    return ast;
+}
+
+/* Serve a validated expression from the cache.
+ * Returns false when the evaluating parser has to run instead.
+ */
+static bool cache_evaluate(ParserContext *ctx, const char *expr, size_t len, const VarContext *vars,
+                           double *value) {
+    if (__atomic_load_n(&cache_capacity, __ATOMIC_RELAXED) == 0) return false;
+    if (debug_enabled(ctx, DEBUG_ALL)) return false;  /* Tracing needs the parser */
+
+    pthread_once(&cache_once, cache_init);
+
+    uint64_t hash = cache_hash(expr, len);
+    CacheShard *shard = &cache_shards[hash >> (64 - CACHE_SHARD_BITS)];
+
+    pthread_rwlock_rdlock(&shard->lock);
+    CacheEntry *entry = cache_find(shard, hash, expr, len);
+    if (entry) {
+        if (!__atomic_load_n(&entry->referenced, __ATOMIC_RELAXED)) {
+            __atomic_store_n(&entry->referenced, 1, __ATOMIC_RELAXED);
+        }
+        bool ok = cache_entry_eval(entry, vars, value);
+        pthread_rwlock_unlock(&shard->lock);
+
+        cache_count(&shard->hits);
+        if (!ok) cache_count(&shard->fallbacks);
+        return ok;
+    }
+    pthread_rwlock_unlock(&shard->lock);
+
+    cache_count(&shard->misses);
+
+    /* Parse outside the lock; uncompilable expressions become negative entries */
+    CacheEntry fresh = {.hash = hash, .len = len};
+    fresh.ast = cache_parse(ctx, expr, len, &fresh.constants);
+
+    bool ok = cache_entry_eval(&fresh, vars, value);
+    if (!ok) cache_count(&shard->fallbacks);
+
+    pthread_rwlock_wrlock(&shard->lock);
+    cache_insert(shard, hash, expr, len, fresh.ast, fresh.constants);
+    pthread_rwlock_unlock(&shard->lock);
+
+    return ok;
+}
+
+void parser_cache_set_capacity(size_t capacity) {
+    pthread_once(&cache_once, cache_init);
+    __atomic_store_n(&cache_capacity, capacity, __ATOMIC_RELAXED);
+    parser_cache_clear();
+}
+
+size_t parser_cache_get_capacity(void) {
+    return cache_shard_capacity(__atomic_load_n(&cache_capacity, __ATOMIC_RELAXED)) * CACHE_SHARDS;
+}
+
+void parser_cache_clear(void) {
+    pthread_once(&cache_once, cache_init);
+    for (int i = 0; i < CACHE_SHARDS; i++) {
+        pthread_rwlock_wrlock(&cache_shards[i].lock);
+        cache_shard_clear(&cache_shards[i]);
+        pthread_rwlock_unlock(&cache_shards[i].lock);
+    }
+}
+
+void parser_cache_get_stats(ParserCacheStats *stats) {
+    if (!stats) return;
+    pthread_once(&cache_once, cache_init);
+
+    memset(stats, 0, sizeof(*stats));
+    for (int i = 0; i < CACHE_SHARDS; i++) {
+        CacheShard *shard = &cache_shards[i];
+        stats->hits += __atomic_load_n(&shard->hits, __ATOMIC_RELAXED);
+        stats->misses += __atomic_load_n(&shard->misses, __ATOMIC_RELAXED);
+        stats->evictions += __atomic_load_n(&shard->evictions, __ATOMIC_RELAXED);
+        stats->fallbacks += __atomic_load_n(&shard->fallbacks, __ATOMIC_RELAXED);
+
+        pthread_rwlock_rdlock(&shard->lock);
+        stats->entries += shard->count;
+        pthread_rwlock_unlock(&shard->lock);
+    }
+    stats->capacity = parser_cache_get_capacity();
+}
+
+void parser_cache_reset_stats(void) {
+    for (int i = 0; i < CACHE_SHARDS; i++) {
+        __atomic_store_n(&cache_shards[i].hits, 0, __ATOMIC_RELAXED);
+        __atomic_store_n(&cache_shards[i].misses, 0, __ATOMIC_RELAXED);
+        __atomic_store_n(&cache_shards[i].evictions, 0, __ATOMIC_RELAXED);
+        __atomic_store_n(&cache_shards[i].fallbacks, 0, __ATOMIC_RELAXED);
+    }
+}
+
+/* ---------- Tiered execution ----------
+ * parse_expression_ex() promotes hot entries to compiled code. The program
+ * is the entry's AST plus a guard: every division by zero, SQRT of a
+ * negative and LOG/LOG10 of a non-positive argument (the cases the parser
+ * reports) is OR-ed into g, and the program computes value + SQRT(-g).
+ * SQRT(-0) is -0, which leaves every value unchanged; SQRT(-1) is NaN. A
+ * NaN result therefore means "ask the parser", which also covers NaN
+ * results that did not come from a guard. Name resolution does not depend
+ * on values, so it is checked once for the layout the program is bound to.
+ */
+
+static ASTNode* tier_guard_or(ASTNode *guard, ASTNode *cond) {
+    return guard ? ast_create_binary_op(OP_OR, guard, cond) : cond;
+}
+
+/* OR every parser-reported domain condition in node into guard */
+static ASTNode* tier_collect_guards(const ASTNode *node, ASTNode *guard) {
+    switch (node->type) {
+        case AST_BINARY_OP:
+            guard = tier_collect_guards(node->data.binary.left, guard);
+            guard = tier_collect_guards(node->data.binary.right, guard);
+            if (node->data.binary.op == OP_DIVIDE) {
+                /* EQUAL's 1e-12 tolerance only adds spurious parser calls */
+                guard = tier_guard_or(guard, ast_create_binary_op(OP_EQUAL,
+                        ast_clone(node->data.binary.right), ast_create_number(0.0)));
+            }
+            return guard;
+        case AST_UNARY_OP:
+            return tier_collect_guards(node->data.unary.operand, guard);
+        case AST_FUNCTION_CALL: {
+            for (int i = 0; i < node->data.function.arg_count; i++) {
+                guard = tier_collect_guards(node->data.function.args[i], guard);
+            }
+            MathFunction id = node->data.function.id;
+            if (id == FUNC_SQRT || id == FUNC_LOG || id == FUNC_LOG10) {
+                guard = tier_guard_or(guard, ast_create_binary_op(
+                        id == FUNC_SQRT ? OP_LESS : OP_LESS_EQ,
+                        ast_clone(node->data.function.args[0]), ast_create_number(0.0)));
+            }
+            return guard;
+        }
+        default:
+            return guard;
+    }
+}
+
+/* True if every name in node resolves for vars exactly as compiled code binds it */
+static bool tier_names_resolve(const ASTNode *node, const VarContext *vars) {
+    double value;
+    switch (node->type) {
+        case AST_VARIABLE:
+            return cache_lookup_var(vars, node->data.variable.name, &value) == 1;
+        case AST_BINARY_OP:
+            return tier_names_resolve(node->data.binary.left, vars) &&
+                   tier_names_resolve(node->data.binary.right, vars);
+        case AST_UNARY_OP:
+            return tier_names_resolve(node->data.unary.operand, vars);
+        case AST_FUNCTION_CALL:
+            if (cache_lookup_var(vars, node->data.function.name, &value) != 0) return false;
+            for (int i = 0; i < node->data.function.arg_count; i++) {
+                if (!tier_names_resolve(node->data.function.args[i], vars)) return false;
+            }
+            return true;
+        default:
+            return true;
+    }
+}
+
+static int tier_mapping_count(const VarContext *vars) {
+    return vars->mappings && vars->mapping_count > 0 ? vars->mapping_count : 0;
+}
+
+static bool tier_layout_matches(const CacheEntry *entry, const VarContext *vars) {
+    bool has_values = vars && vars->values;
+    if (has_values != entry->layout_has_values) return false;
+    if (!has_values) return true;
+    if (vars->count != entry->layout_count) return false;
+    if (tier_mapping_count(vars) != entry->layout_mapping_count) return false;
+    for (int i = 0; i < entry->layout_mapping_count; i++) {
+        if (vars->mappings[i].index != entry->layout_mappings[i].index ||
+            strcmp(vars->mappings[i].name, entry->layout_mappings[i].name) != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/* Build the guarded program for an entry bound to vars (caller holds a lock).
+ * Returns NULL if the entry cannot run compiled with this layout.
+ */
+static CompiledExpression* tier_build(const CacheEntry *entry, const VarContext *vars) {
+    double shadow;
+    if (!entry->ast) return NULL;
+    if ((entry->constants & PARSER_CONST_PI) && cache_lookup_var(vars, "PI", &shadow) != 0) return NULL;
+    if ((entry->constants & PARSER_CONST_E) && cache_lookup_var(vars, "E", &shadow) != 0) return NULL;
+    if (!tier_names_resolve(entry->ast, vars)) return NULL;
+
+    /* The program lives in the cache: keep it out of the caller's arena */
+    ASTArena *previous = ast_arena_push(NULL);
+    ASTNode *program = ast_clone(entry->ast);
+    ASTNode *guard = tier_collect_guards(entry->ast, NULL);
+    if (guard) {
+        ASTNode *arg = ast_create_unary_op(OP_NEGATE, guard);
+        program = ast_create_binary_op(OP_ADD, program, ast_create_function_call("SQRT", &arg, 1));
+    }
+
+    CompiledExpression *ce = compiled_expression_from_ast(entry->expr, program);
+    ast_arena_pop(previous);
+    if (vars && vars->values) {
+        compiled_expression_bind(ce, vars);
+    }
+    return ce;
+}
+
+/* Install a built program, or record that none can be built (write lock held) */
+static void tier_install(CacheShard *shard, CacheEntry *entry, CompiledExpression *ce,
+                         const VarContext *vars) {
+    if (entry->program || entry->tier_failed) {
+        compiled_expression_free(ce);
+        return;
+    }
+    if (!ce) {
+        entry->tier_failed = true;
+        return;
+    }
+
+    int mapping_count = vars && vars->values ? tier_mapping_count(vars) : 0;
+    VarMapping *mappings = NULL;
+    if (mapping_count > 0) {
+        mappings = malloc(sizeof(VarMapping) * mapping_count);
+        if (!mappings) {
+            compiled_expression_free(ce);
+            return;
+        }
+        /* The caller may reuse its name buffers: keep copies to compare against */
+        for (int i = 0; i < mapping_count; i++) {
+            mappings[i].name = ast_intern(vars->mappings[i].name);
+            mappings[i].index = vars->mappings[i].index;
+            if (!mappings[i].name) {
+                free(mappings);
+                compiled_expression_free(ce);
+                return;
+            }
+        }
+    }
+
+    entry->program = ce;
+    entry->layout_has_values = vars && vars->values;
+    entry->layout_count = entry->layout_has_values ? vars->count : 0;
+    entry->layout_mappings = mappings;
+    entry->layout_mapping_count = mapping_count;
+    cache_count(&shard->tier_promotions[PARSER_TIER_BYTECODE]);
+}
+
+/* Run an expression on its current tier and count the call.
+ * Returns false when the evaluating parser has to run instead.
+ */
+static bool tier_evaluate(ParserContext *ctx, const char *expr, size_t len, VarContext *vars,
+                          const ParserConfig *config, double *value) {
+    /* Operation counts are defined by the parser's steps */
+    if (__atomic_load_n(&cache_capacity, __ATOMIC_RELAXED) == 0 || debug_enabled(ctx, DEBUG_ALL) ||
+        config->max_operations > 0) {
+        return false;
+    }
+
+    pthread_once(&cache_once, cache_init);
+
+    uint64_t hash = cache_hash(expr, len);
+    CacheShard *shard = &cache_shards[hash >> (64 - CACHE_SHARD_BITS)];
+
+    pthread_rwlock_rdlock(&shard->lock);
+    CacheEntry *entry = cache_find(shard, hash, expr, len);
+    if (!entry) {
+        pthread_rwlock_unlock(&shard->lock);
+        cache_count(&shard->misses);
+        cache_count(&shard->tier_calls[PARSER_TIER_PARSE]);
+
+        CacheEntry fresh = {.hash = hash, .len = len};
+        fresh.ast = cache_parse(ctx, expr, len, &fresh.constants);
+
+        pthread_rwlock_wrlock(&shard->lock);
+        cache_insert(shard, hash, expr, len, fresh.ast, fresh.constants);
+        entry = cache_find(shard, hash, expr, len);
+        if (entry && __atomic_add_fetch(&entry->calls, 1, __ATOMIC_RELAXED) >= config->compile_after &&
+            !entry->program && !entry->tier_failed) {
+            tier_install(shard, entry, tier_build(entry, vars), vars);
+        }
+        pthread_rwlock_unlock(&shard->lock);
+        return false;
+    }
+
+    cache_count(&shard->hits);
+    if (!__atomic_load_n(&entry->referenced, __ATOMIC_RELAXED)) {
+        __atomic_store_n(&entry->referenced, 1, __ATOMIC_RELAXED);
+    }
+    unsigned long calls = __atomic_add_fetch(&entry->calls, 1, __ATOMIC_RELAXED);
+
+    if (entry->program && tier_layout_matches(entry, vars)) {
+        CompiledExpression *program = entry->program;
+        ParserTier tier = program->jit ? PARSER_TIER_JIT : PARSER_TIER_BYTECODE;
+        double result = compiled_expression_evaluate(program, vars);
+        bool promote = tier == PARSER_TIER_BYTECODE && !entry->jit_tried &&
+                       config->jit_after > 0 && calls >= config->jit_after;
+        pthread_rwlock_unlock(&shard->lock);
+
+        if (promote) {
+            pthread_rwlock_wrlock(&shard->lock);
+            entry = cache_find(shard, hash, expr, len);
+            if (entry && entry->program == program && !entry->jit_tried) {
+                entry->jit_tried = true;
+                if (compiled_expression_jit(program) == 0) {
+                    cache_count(&shard->tier_promotions[PARSER_TIER_JIT]);
+                }
+            }
+            pthread_rwlock_unlock(&shard->lock);
+        }
+
+        if (isnan(result)) {
+            cache_count(&shard->deopts);
+            cache_count(&shard->tier_calls[PARSER_TIER_PARSE]);
+            return false;
+        }
+        cache_count(&shard->tier_calls[tier]);
+        *value = result;
+        return true;
+    }
+
+    /* Build under the read lock (the AST is only read), install under the write lock */
+    bool other_layout = entry->program != NULL;
+    bool promote = !entry->program && !entry->tier_failed && calls >= config->compile_after;
+    CompiledExpression *built = promote ? tier_build(entry, vars) : NULL;
+    pthread_rwlock_unlock(&shard->lock);
+
+    if (promote) {
+        pthread_rwlock_wrlock(&shard->lock);
+        entry = cache_find(shard, hash, expr, len);
+        if (entry) {
+            tier_install(shard, entry, built, vars);
+        } else {
+            compiled_expression_free(built);
+        }
+        pthread_rwlock_unlock(&shard->lock);
+    } else if (other_layout) {
+        cache_count(&shard->deopts);  /* Compiled for another layout */
+    }
+
+    cache_count(&shard->tier_calls[PARSER_TIER_PARSE]);
+    return false;
+}
+
+void parser_tier_get_stats(ParserTierStats *stats) {
+    if (!stats) return;
+
+    memset(stats, 0, sizeof(*stats));
+    for (int i = 0; i < CACHE_SHARDS; i++) {
+        CacheShard *shard = &cache_shards[i];
+        stats->parse_calls += __atomic_load_n(&shard->tier_calls[PARSER_TIER_PARSE], __ATOMIC_RELAXED);
+        stats->bytecode_calls += __atomic_load_n(&shard->tier_calls[PARSER_TIER_BYTECODE], __ATOMIC_RELAXED);
+        stats->jit_calls += __atomic_load_n(&shard->tier_calls[PARSER_TIER_JIT], __ATOMIC_RELAXED);
+        stats->bytecode_promotions += __atomic_load_n(&shard->tier_promotions[PARSER_TIER_BYTECODE], __ATOMIC_RELAXED);
+        stats->jit_promotions += __atomic_load_n(&shard->tier_promotions[PARSER_TIER_JIT], __ATOMIC_RELAXED);
+        stats->deopts += __atomic_load_n(&shard->deopts, __ATOMIC_RELAXED);
+    }
+}
+
+void parser_tier_reset_stats(void) {
+    for (int i = 0; i < CACHE_SHARDS; i++) {
+        for (int t = 0; t < 3; t++) {
+            __atomic_store_n(&cache_shards[i].tier_calls[t], 0, __ATOMIC_RELAXED);
+            __atomic_store_n(&cache_shards[i].tier_promotions[t], 0, __ATOMIC_RELAXED);
+        }
+        __atomic_store_n(&cache_shards[i].deopts, 0, __ATOMIC_RELAXED);
+    }
+}
+
+ParserTier parser_expression_tier(const char *expr) {
+    if (!expr) return PARSER_TIER_PARSE;
+    pthread_once(&cache_once, cache_init);
+
+    size_t len = strlen(expr);
+    uint64_t hash = cache_hash(expr, len);
+    CacheShard *shard = &cache_shards[hash >> (64 - CACHE_SHARD_BITS)];
+
+    ParserTier tier = PARSER_TIER_PARSE;
+    pthread_rwlock_rdlock(&shard->lock);
+    CacheEntry *entry = cache_find(shard, hash, expr, len);
+    if (entry && entry->program) {
+        tier = entry->program->jit ? PARSER_TIER_JIT : PARSER_TIER_BYTECODE;
+    }
+    pthread_rwlock_unlock(&shard->lock);
+    return tier;
+}
+
+/* ========== END COMPILED EXPRESSION CACHE ========== */
+
+/* NEW SAFE API IMPLEMENTATION */
+
+ParseResult parse_expression_safe(const char *expr) {
+    return parse_expression_with_vars_safe(expr, NULL);
+}
+
+/* Evaluate expr in ctx. With compile_after set in config, hot expressions
+ * run on their compiled tier; otherwise, if cached, repeated expressions
+ * are answered from the expression cache.
+ */
+static ParseResult evaluate_expression(ParserContext *ctx, const char *expr, VarContext *vars,
+                                       const ParserConfig *config, bool cached) {
     ParseResult result = {
         .value = 0.0,
         .error = {
@@ -1019,6 +1981,14 @@ ParseResult parse_expression_ex(const char *expr, VarContext *vars, ParserConfig
         return result;
     }
 
+    /* Hot expressions run compiled once promoted */
+    if (config && config->compile_after > 0) {
+        if (tier_evaluate(ctx, expr, len, vars, config, &result.value)) return result;
+    } else if (cached && cache_evaluate(ctx, expr, len, vars, &result.value)) {
+        /* Repeated expressions skip parsing entirely */
+        return result;
+    }
+
     /* Initialize parser with full configuration */
     Parser parser = {
         .input = expr,
@@ -1029,14 +1999,15 @@ ParseResult parse_expression_ex(const char *expr, VarContext *vars, ParserConfig
         .vars = vars,
         .error = &result.error,
         .has_error = false,
-        .timeout_us = config ? config->timeout_ms * 1000 : 0,
         .error_count = 0,
-        .continue_on_error = config ? config->continue_on_error : false
+        .continue_on_error = config ? config->continue_on_error : false,
+        .ctx = ctx
     };
 
-    /* Start timeout timer */
-    if (parser.timeout_us > 0) {
-        gettimeofday(&parser.start_time, NULL);
+    /* Start timeout timer and operation count */
+    if (config) {
+        eval_budget_init_interval(&parser.budget, config->timeout_ms, config->max_operations,
+                                  PARSER_CLOCK_INTERVAL);
     }
 
     /* Parse expression */
@@ -1054,6 +2025,54 @@ ParseResult parse_expression_ex(const char *expr, VarContext *vars, ParserConfig
     return result;
 }
 
+ParseResult parse_expression_with_vars_safe(const char *expr, VarContext *vars) {
+    return evaluate_expression(&default_context, expr, vars, NULL, true);
+}
+
+ParseResult parse_expression_ex(const char *expr, VarContext *vars, ParserConfig *config) {
+    return evaluate_expression(&default_context, expr, vars, config, false);
+}
+
+ParseResult parser_context_evaluate(ParserContext *ctx, const char *expr, VarContext *vars) {
+    if (!ctx) ctx = &default_context;
+    /* A config (timeout, operation limit, error recovery) is honoured by the parser, not the cache */
+    return evaluate_expression(ctx, expr, vars, ctx->has_config ? &ctx->config : NULL, !ctx->has_config);
+}
+
+ASTNode* parse_expression_ast(const char *expr, ParserErrorInfo *error) {
+    ParserErrorInfo local_error;
+    if (!error) {
+        error = &local_error;
+    }
+    error->code = PARSER_OK;
+    error->position = 0;
+    error->message[0] = '\0';
+
+    /* Input validation */
+    if (!expr) {
+        error->code = PARSER_ERROR_EMPTY_EXPR;
+        snprintf(error->message, sizeof(error->message), "Expression is NULL");
+        return NULL;
+    }
+
+    size_t len = strlen(expr);
+    if (len == 0) {
+        error->code = PARSER_ERROR_EMPTY_EXPR;
+        snprintf(error->message, sizeof(error->message), "Expression is empty");
+        return NULL;
+    }
+
+    if (len > PARSER_MAX_EXPR_LENGTH) {
+        error->code = PARSER_ERROR_TOO_LONG;
+        snprintf(error->message, sizeof(error->message),
+                 "Expression too long (%zu chars, max %d)",
+                 len, PARSER_MAX_EXPR_LENGTH);
+        return NULL;
+    }
+
+    return parse_ast_internal(&default_context, expr, len, error, NULL);
+}
+
 /* UTILITY FUNCTIONS */
 
 const char* parser_error_string(ParserError error) {
@@ -13,6 +13,7 @@
 #define PARSER_H
 
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdio.h>
 
 /* Parser limits */
@@ -69,8 +70,15 @@ typedef struct {
     long timeout_ms;         /* Timeout in milliseconds (0 = no timeout) */
     bool continue_on_error;  /* Continue parsing after errors to collect all errors */
     bool thread_safe;        /* Reserved for future use */
+    unsigned long compile_after;  /* Calls before an expression runs as bytecode (0 = never) */
+    unsigned long jit_after;      /* Calls before it runs as native code (0 = never) */
+    unsigned long max_operations; /* Tokens the parser may read, end included (0 = unlimited) */
 } ParserConfig;
 
+/* Suggested tiering thresholds for ParserConfig */
+#define PARSER_DEFAULT_COMPILE_AFTER 8
+#define PARSER_DEFAULT_JIT_AFTER 1000
+
 /* NEW SAFE API - Returns detailed error information */
 
 /* Parse and evaluate an expression string (safe version)
@@ -88,6 +96,86 @@ ParseResult parse_expression_with_vars_safe(const char *expr, VarContext *vars);
  */
 ParseResult parse_expression_ex(const char *expr, VarContext *vars, ParserConfig *config);
 
+/* COMPILED EXPRESSION CACHE
+ *
+ * parse_expression_safe() and parse_expression_with_vars_safe() keep parsed
+ * expressions in a process-wide, thread-safe cache keyed by expression text,
+ * so repeated strings skip tokenizing and parsing. Results are identical to
+ * an uncached parse; calls the cache cannot answer exactly (domain errors,
+ * unresolved names, debug tracing enabled) run the parser as before.
+ */
+
+#define PARSER_CACHE_DEFAULT_CAPACITY 1024
+
+/* Cache statistics (counters are cumulative since the last reset) */
+typedef struct {
+    unsigned long long hits;       /* Lookups that found the expression */
+    unsigned long long misses;     /* Lookups that had to parse and insert */
+    unsigned long long evictions;  /* Entries replaced to stay within capacity */
+    unsigned long long fallbacks;  /* Calls answered by the parser instead of the cache */
+    size_t entries;                /* Expressions currently cached */
+    size_t capacity;               /* Maximum number of cached expressions */
+} ParserCacheStats;
+
+/* Set the maximum number of cached expressions (0 disables the cache).
+ * The cache is sharded, so capacity is rounded up to a multiple of the
+ * shard count. Clears all cached entries.
+ */
+void parser_cache_set_capacity(size_t capacity);
+
+/* Get the effective cache capacity */
+size_t parser_cache_get_capacity(void);
+
+/* Drop all cached expressions (statistics are kept) */
+void parser_cache_clear(void);
+
+/* Read hit/miss/eviction counters and current occupancy */
+void parser_cache_get_stats(ParserCacheStats *stats);
+
+/* Reset hit/miss/eviction/fallback counters to zero */
+void parser_cache_reset_stats(void);
+
+/* TIERED EXECUTION
+ *
+ * With config->compile_after set, parse_expression_ex() counts calls per
+ * expression text (in the expression cache above). The first calls are
+ * evaluated by the parser; after compile_after calls the expression is
+ * compiled to register bytecode, and after jit_after calls to native code
+ * where the JIT is available. Compiled tiers guard every case in which the
+ * parser would report an error or resolve a name differently, and hand
+ * those calls back to the parser, so results are unchanged. Compiled code
+ * is specialized to the VarContext layout (count, mapping names and
+ * indices) seen at promotion; names are compared by contents, and calls
+ * with another layout use the parser. A compiled call
+ * is straight-line code of bounded length and does not check
+ * config->timeout_ms; with config->max_operations set every call is
+ * evaluated by the parser, so operation counts stay those of the parser.
+ * Callers bounding compiled code directly use the EvalBudget functions in
+ * ast.h.
+ */
+
+typedef enum {
+    PARSER_TIER_PARSE,       /* Evaluated by the parser */
+    PARSER_TIER_BYTECODE,    /* Register VM */
+    PARSER_TIER_JIT          /* Native code */
+} ParserTier;
+
+/* Tier statistics (cumulative since the last reset) */
+typedef struct {
+    unsigned long long parse_calls;          /* Calls evaluated by the parser */
+    unsigned long long bytecode_calls;       /* Calls run on the register VM */
+    unsigned long long jit_calls;            /* Calls run as native code */
+    unsigned long long bytecode_promotions;  /* Expressions compiled to bytecode */
+    unsigned long long jit_promotions;       /* Expressions compiled to native code */
+    unsigned long long deopts;               /* Compiled calls handed back to the parser */
+} ParserTierStats;
+
+void parser_tier_get_stats(ParserTierStats *stats);
+void parser_tier_reset_stats(void);
+
+/* Current tier of an expression (PARSER_TIER_PARSE if not tracked) */
+ParserTier parser_expression_tier(const char *expr);
+
 /* LEGACY API - For backward compatibility (less safe) */
 
 /* Parse and evaluate an expression string
@@ -146,6 +234,9 @@ void parser_set_debug_level(int level);
 /* Get current debug level */
 int parser_get_debug_level(void);
 
+/* Emit a printf-style message if level is enabled (other modules' tracing) */
+void parser_debug_log(int level, const char *format, ...);
+
 /* Set debug output file (default: stderr) */
 void parser_set_debug_output(FILE *fp);
 
@@ -164,6 +255,37 @@ void parser_clear_error_callback(void);
 /* Clear debug callback (revert to default stderr/file output) */
 void parser_clear_debug_callback(void);
 
+/* PARSER CONTEXTS
+ *
+ * A ParserContext carries its own debug level, debug output, callbacks and
+ * configuration, so components that trace or report errors differently do
+ * not share settings. The global functions above act on a built-in default
+ * context. Contexts may be shared between threads and their settings
+ * changed at any time; with debugging off, evaluation reads the context
+ * without taking a lock.
+ */
+
+typedef struct ParserContext ParserContext;
+
+/* Create a context with debugging off and no callbacks. config (copied;
+ * NULL for none) applies to every evaluation in the context, as in
+ * parse_expression_ex(). Returns NULL on allocation failure.
+ */
+ParserContext* parser_context_create(const ParserConfig *config);
+void parser_context_free(ParserContext *ctx);
+
+void parser_context_set_debug_level(ParserContext *ctx, int level);
+int parser_context_get_debug_level(const ParserContext *ctx);
+void parser_context_set_debug_output(ParserContext *ctx, FILE *fp);     /* NULL: stderr */
+void parser_context_set_error_callback(ParserContext *ctx, ParserErrorCallback callback, void *user_data);
+void parser_context_set_debug_callback(ParserContext *ctx, ParserDebugCallback callback, void *user_data);
+
+/* Evaluate an expression in ctx (NULL: the default context). Without a
+ * config this uses the expression cache; with one it evaluates as
+ * parse_expression_ex() does (compiled tiers only if compile_after is set).
+ */
+ParseResult parser_context_evaluate(ParserContext *ctx, const char *expr, VarContext *vars);
+
 /* UTILITY FUNCTIONS */
 
 /* Get string description of error code */
@@ -572,10 +572,9 @@ double tensor_min(const Tensor *x) {
 ASTNode* ast_create_tensor(Tensor *tensor) {
     if (!tensor) return NULL;
 
-    ASTNode *node = malloc(sizeof(ASTNode));
+    ASTNode *node = ast_node_alloc(AST_TENSOR);
     if (!node) return NULL;
 
-    node->type = AST_TENSOR;
     node->data.tensor.tensor = tensor;
     tensor_retain(tensor);  // Increment ref count
 
@@ -0,0 +1,248 @@
+/*
+ * FluxParser - Research-Grade C Math Parser
+ * Copyright (C) 2025 Eduardo Stern
+ *
+ * Dual Licensed:
+ * - GPL-3.0 for open-source/non-commercial use
+ * - Commercial license available - see LICENSE-COMMERCIAL.md
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * AST arena and name interning tests: trees built in an arena must match
+ * heap-built trees, be released together, and stay private to their thread;
+ * trees the expression cache keeps never go into a caller's arena.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <pthread.h>
+#include "ast.h"
+#include "test_common.h"
+
+/* ast_to_string() of the tree, freed */
+static bool prints_as(const ASTNode *node, const char *expected) {
+    char *s = ast_to_string(node);
+    bool ok = s && strcmp(s, expected) == 0;
+    free(s);
+    return ok;
+}
+
+static void test_interning() {
+    printf("\n=== Name Interning ===\n");
+
+    char buffer[16];
+    strcpy(buffer, "VELOCITY");
+    const char *a = ast_intern("VELOCITY");
+    const char *b = ast_intern(buffer);
+    check(a && a == b && a != buffer, "equal names share one copy");
+    check(ast_intern("VELOCITZ") != a, "different names stay apart");
+
+    ASTNode *x1 = ast_create_variable("X");
+    ASTNode *x2 = ast_create_variable("X");
+    ASTNode *f = ast_create_function_call("SIN", &x2, 1);
+    check(x1->data.variable.name == x2->data.variable.name &&
+          f->data.function.name == ast_intern("SIN"), "nodes hold interned names");
+    ast_free(x1);
+    ast_free(f);
+
+    /* Grows well past the initial table */
+    bool stable = true;
+    for (int i = 0; i < 5000 && stable; i++) {
+        snprintf(buffer, sizeof(buffer), "V%d", i);
+        const char *p = ast_intern(buffer);
+        stable = p && strcmp(p, buffer) == 0 && ast_intern(buffer) == p;
+    }
+    check(stable && ast_intern("VELOCITY") == a, "table growth keeps pointers");
+
+    check(sizeof(ASTNode) <= 4 * sizeof(void *), "nodes are four words");
+}
+
+static void test_arena_trees() {
+    printf("\n=== Arena Trees ===\n");
+
+    ParserErrorInfo error;
+    ASTNode *f = parse_expression_ast("x^3 * sin(x) + exp(2 * x) / (x + 1)", &error);
+    ASTNode *heap_d = ast_simplify(ast_differentiate(f, "X"));
+    ASTNode *five = ast_create_number(5.0);
+    ASTNode *heap_i = ast_simplify(ast_integrate(five, "X"));
+    ASTNode *heap_t = ast_taylor_series(f, "X", 0.5, 4);
+
+    ASTArena *arena = ast_arena_create();
+    ASTArena *previous = ast_arena_push(arena);
+    check(previous == NULL, "no arena is current by default");
+
+    ASTNode *d = ast_simplify(ast_differentiate(f, "X"));
+    ASTNode *i5 = ast_simplify(ast_integrate(ast_create_number(5.0), "X"));
+    ASTNode *t = ast_taylor_series(f, "X", 0.5, 4);
+    ASTNode *parsed = parse_expression_ast("max(a, b) - c", &error);
+
+    char *heap_str = ast_to_string(heap_d);
+    check(prints_as(d, heap_str), "derivative matches the heap-built one");
+    free(heap_str);
+    heap_str = ast_to_string(heap_i);
+    check(prints_as(i5, heap_str), "integral matches the heap-built one");
+    free(heap_str);
+    heap_str = ast_to_string(heap_t);
+    check(prints_as(t, heap_str), "Taylor series matches the heap-built one");
+    free(heap_str);
+
+    check(d->in_arena && t->in_arena && parsed->in_arena && parsed->data.binary.left->in_arena,
+          "nodes come from the current arena");
+    size_t nodes = ast_arena_node_count(arena);
+    check(nodes > 20 && ast_arena_bytes_used(arena) >= nodes * sizeof(ASTNode),
+          "arena counts its nodes");
+
+    ast_free(d);   /* No-op for arena nodes */
+    check(ast_arena_node_count(arena) == nodes && prints_as(parsed, "(MAX(A, B) - C)"),
+          "ast_free leaves arena trees alone");
+
+    ast_arena_pop(previous);
+    ASTNode *after = ast_create_number(1.0);
+    check(!after->in_arena, "popping restores heap allocation");
+    ast_free(after);
+
+    ast_arena_reset(arena);
+    check(ast_arena_node_count(arena) == 0, "reset frees every tree at once");
+
+    /* Memory is reused after a reset */
+    size_t used = 0;
+    for (int round = 0; round < 3; round++) {
+        previous = ast_arena_push(arena);
+        ASTNode *again = ast_taylor_series(f, "X", 0.0, 5);
+        ast_arena_pop(previous);
+        (void)again;
+        if (round == 0) used = ast_arena_bytes_used(arena);
+        else if (ast_arena_bytes_used(arena) != used) used = 0;
+        ast_arena_reset(arena);
+    }
+    check(used > 0, "same work, same footprint after reset");
+
+    ast_arena_destroy(arena);
+    ast_free(f);
+    ast_free(five);
+    ast_free(heap_d);
+    ast_free(heap_i);
+    ast_free(heap_t);
+}
+
+static void test_tensor_nodes() {
+    printf("\n=== Tensor Nodes ===\n");
+
+    int shape[1] = {3};
+    double data[3] = {1, 2, 3};
+    Tensor *tensor = tensor_create_from_data(data, shape, 1);
+
+    ASTArena *arena = ast_arena_create();
+    ASTArena *previous = ast_arena_push(arena);
+    ASTNode *node = ast_create_tensor(tensor);
+    ast_arena_pop(previous);
+
+    check(node->in_arena && tensor->ref_count == 2, "arena tensor node holds a reference");
+    ast_arena_destroy(arena);
+    check(tensor->ref_count == 1, "destroying the arena releases it");
+    tensor_release(tensor);
+}
+
+#define NUM_THREADS 4
+
+static void *arena_thread(void *arg) {
+    const ASTNode *f = arg;
+    ASTArena *arena = ast_arena_create();
+    long errors = 0;
+
+    for (int i = 0; i < 200; i++) {
+        ASTArena *previous = ast_arena_push(arena);
+        ASTNode *d = ast_simplify(ast_differentiate(f, "X"));
+        if (!d->in_arena || previous != NULL) errors++;
+        ast_arena_pop(previous);
+
+        ASTNode *heap = ast_create_variable("Y");
+        if (heap->in_arena || heap->data.variable.name != ast_intern("Y")) errors++;
+        ast_free(heap);
+        ast_arena_reset(arena);
+    }
+
+    ast_arena_destroy(arena);
+    return (void *)errors;
+}
+
+/* The expression cache and its compiled tiers outlive any arena */
+static void test_cached_trees() {
+    printf("\n=== Cached Trees ===\n");
+
+    parser_cache_clear();
+    ASTArena *arena = ast_arena_create();
+    ASTArena *previous = ast_arena_push(arena);
+    ParseResult r = parse_expression_safe("1 + 2 * 3");
+    ast_arena_pop(previous);
+    ast_arena_destroy(arena);
+    ParseResult again = parse_expression_safe("1 + 2 * 3");
+    check(!r.has_error && r.value == 7.0 && !again.has_error && again.value == 7.0,
+          "cache hit after the parse's arena is destroyed");
+
+    /* Tiered: the parse, the guard and the bytecode are all built in the arena's scope */
+    arena = ast_arena_create();
+    double x = 2.0;
+    VarMapping mapping = {.name = "X", .index = 0};
+    VarContext vars = {.values = &x, .count = 1, .mappings = &mapping, .mapping_count = 1};
+    ParserConfig config = {.compile_after = 1};
+    previous = ast_arena_push(arena);
+    bool ok = true;
+    for (int i = 0; i < 4; i++) {
+        r = parse_expression_ex("sqrt(x) * 3 + x", &vars, &config);
+        ok = ok && !r.has_error && close_to(r.value, sqrt(2.0) * 3.0 + 2.0, 1e-15);
+    }
+    ast_arena_pop(previous);
+    check(ok && parser_expression_tier("sqrt(x) * 3 + x") == PARSER_TIER_BYTECODE &&
+          ast_arena_node_count(arena) == 0, "cache and tier trees stay out of the caller's arena");
+
+    /* Reuse the arena's memory, then hit the compiled tier */
+    ast_arena_reset(arena);
+    previous = ast_arena_push(arena);
+    ParserErrorInfo error;
+    for (int i = 0; i < 100; i++) parse_expression_ast("y * 9 - z / 4 + cos(y)", &error);
+    ast_arena_pop(previous);
+    r = parse_expression_ex("sqrt(x) * 3 + x", &vars, &config);
+    check(!r.has_error && close_to(r.value, sqrt(2.0) * 3.0 + 2.0, 1e-15), "compiled tier after the arena is reused");
+    ast_arena_destroy(arena);
+}
+
+static void test_threads() {
+    printf("\n=== Per-Thread Arenas ===\n");
+
+    ParserErrorInfo error;
+    ASTNode *f = parse_expression_ast("x^2 * cos(x) + y", &error);
+
+    pthread_t threads[NUM_THREADS];
+    for (int t = 0; t < NUM_THREADS; t++) {
+        pthread_create(&threads[t], NULL, arena_thread, f);
+    }
+    long errors = 0;
+    for (int t = 0; t < NUM_THREADS; t++) {
+        void *ret;
+        pthread_join(threads[t], &ret);
+        errors += (long)ret;
+    }
+    check(errors == 0, "each thread allocates from its own arena");
+
+    ASTNode *main_node = ast_create_number(2.0);
+    check(!main_node->in_arena, "other threads' arenas do not leak into this one");
+    ast_free(main_node);
+    ast_free(f);
+}
+
+int main() {
+    printf("=========================================\n");
+    printf("  FluxParser - AST Arena Tests\n");
+    printf("=========================================\n");
+
+    test_interning();
+    test_arena_trees();
+    test_tensor_nodes();
+    test_cached_trees();
+    test_threads();
+
+    return test_report();
+}
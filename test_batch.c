@@ -0,0 +1,130 @@
+/*
+ * FluxParser - Research-Grade C Math Parser
+ * Copyright (C) 2025 Eduardo Stern
+ *
+ * Dual Licensed:
+ * - GPL-3.0 for open-source/non-commercial use
+ * - Commercial license available - see LICENSE-COMMERCIAL.md
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * Batched columnar evaluation tests: one program over many rows must give
+ * the same values as vm_execute() on each row.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "ast.h"
+#include "test_common.h"
+
+static bool same_value(double a, double b) {
+    if (isnan(a) || isnan(b)) return isnan(a) && isnan(b);
+    return a == b;
+}
+
+static const char *corpus[] = {
+    "2 + 3 * 4",
+    "x * x + 2 * x * y + y * y",
+    "x / y",
+    "x^y - -x",
+    "sin(x) * cos(y) + tan(x / 4) + atan2(x, y)",
+    "sqrt(x) + log(y) + log10(abs(y)) + exp(-x)",
+    "min(x, y) * max(x, y) + mod(x, 3) + pow(2, y)",
+    "sgn(x - y) + int(x * 3.7) + round(y) + floor(x) + ceil(y)",
+    "(x > y && y >= 0) || !(x == y) || x != 1",
+    "x <= y",
+    "foo(x) + 1",
+};
+
+/* Row counts around the block size */
+static const size_t row_counts[] = {0, 1, 7, VM_BATCH_BLOCK - 1, VM_BATCH_BLOCK,
+                                    VM_BATCH_BLOCK + 1, 3 * VM_BATCH_BLOCK + 17};
+
+static void test_matches_vm() {
+    printf("\n=== Batch vs vm_execute ===\n");
+
+    size_t max_rows = row_counts[sizeof(row_counts) / sizeof(row_counts[0]) - 1];
+    double *xs = malloc(sizeof(double) * max_rows);
+    double *ys = malloc(sizeof(double) * max_rows);
+    double *out = malloc(sizeof(double) * max_rows);
+
+    for (size_t r = 0; r < max_rows; r++) {
+        xs[r] = (double)r * 0.37 - 20.0;
+        ys[r] = (r % 5 == 0) ? 0.0 : (double)(r % 11) - 4.5;
+    }
+
+    /* Column slots follow BC_PUSH_VAR: X = 23, Y = 24 */
+    const double *columns[26] = {0};
+    columns['X' - 'A'] = xs;
+    columns['Y' - 'A'] = ys;
+
+    double values[26] = {0};
+    VarContext ctx = {.values = values, .count = 26};
+    VM *vm = vm_create(&ctx);
+
+    for (size_t e = 0; e < sizeof(corpus) / sizeof(corpus[0]); e++) {
+        CompiledExpression *ce = compile_expression(corpus[e]);
+        bool ok = ce != NULL;
+
+        for (size_t c = 0; ok && c < sizeof(row_counts) / sizeof(row_counts[0]); c++) {
+            size_t rows = row_counts[c];
+            ok = compiled_expression_evaluate_batch(ce, columns, 26, rows, out) == 0;
+            for (size_t r = 0; ok && r < rows; r++) {
+                values['X' - 'A'] = xs[r];
+                values['Y' - 'A'] = ys[r];
+                ok = same_value(out[r], vm_execute(vm, ce->bytecode));
+            }
+        }
+
+        check(ok, corpus[e]);
+        compiled_expression_free(ce);
+    }
+
+    vm_free(vm);
+    free(xs);
+    free(ys);
+    free(out);
+}
+
+static void test_columns() {
+    printf("\n=== Column Handling ===\n");
+
+    double xs[4] = {1, 2, 3, 4};
+    double out[4];
+    CompiledExpression *ce = compile_expression("x + y + 1");
+
+    /* Y has no column: reads as 0 like an out-of-range VarContext slot */
+    const double *columns[24] = {0};
+    columns['X' - 'A'] = xs;
+    check(vm_execute_batch(ce->bytecode, columns, 24, 4, out) == 0 &&
+          out[0] == 2 && out[3] == 5, "missing columns read as zero");
+
+    check(vm_execute_batch(ce->bytecode, NULL, 0, 4, out) == 0 &&
+          out[0] == 1 && out[3] == 1, "no columns at all");
+
+    compiled_expression_free(ce);
+
+    /* A program that pops more than it pushes is rejected */
+    BytecodeInstruction bad[] = {{.op = BC_ADD}, {.op = BC_HALT}};
+    Bytecode bc = {.instructions = bad, .count = 2, .capacity = 2};
+    check(vm_execute_batch(&bc, NULL, 0, 4, out) == -1, "stack underflow rejected");
+
+    ce = compile_expression("random()");
+    bool in_range = compiled_expression_evaluate_batch(ce, NULL, 0, 4, out) == 0;
+    for (int i = 0; i < 4; i++) in_range = in_range && out[i] >= 0.0 && out[i] <= 1.0;
+    check(in_range, "random() evaluated per row");
+    compiled_expression_free(ce);
+}
+
+int main() {
+    printf("=========================================\n");
+    printf("  FluxParser - Batch Evaluation Tests\n");
+    printf("=========================================\n");
+
+    test_matches_vm();
+    test_columns();
+
+    return test_report();
+}
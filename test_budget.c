@@ -0,0 +1,227 @@
+/*
+ * FluxParser - Research-Grade C Math Parser
+ * Copyright (C) 2025 Eduardo Stern
+ *
+ * Dual Licensed:
+ * - GPL-3.0 for open-source/non-commercial use
+ * - Commercial license available - see LICENSE-COMMERCIAL.md
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * Evaluation budget tests: operation accounting, operation limits and
+ * deadlines in the budget itself, in the parser (ParserConfig timeout_ms
+ * and max_operations) and in the VM and batch evaluators.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include "ast.h"
+#include "parser.h"
+#include "test_common.h"
+
+static void sleep_ms(long ms) {
+    struct timespec ts = {.tv_sec = ms / 1000, .tv_nsec = (ms % 1000) * 1000000L};
+    nanosleep(&ts, NULL);
+}
+
+static void test_accounting() {
+    printf("\n=== Budget Accounting ===\n");
+
+    EvalBudget budget;
+    eval_budget_init(&budget, 0, 0);
+    bool ok = true;
+    for (int i = 0; i < 100000; i++) ok = ok && eval_budget_charge(&budget, 3);
+    check(ok && budget.status == EVAL_BUDGET_OK, "unlimited budget never runs out");
+    check(eval_budget_operations(&budget) == 300000, "operations are counted");
+
+    eval_budget_init(&budget, 0, 1000);
+    unsigned long charged = 0;
+    while (eval_budget_charge(&budget, 7)) charged += 7;
+    check(charged == 994 && budget.status == EVAL_BUDGET_OPERATIONS, "operation limit stops at the last whole charge");
+    check(eval_budget_operations(&budget) == 994, "refused charges are not counted");
+    check(!eval_budget_charge(&budget, 1), "exhausted budget stays exhausted");
+
+    eval_budget_init(&budget, 0, 10);
+    check(eval_budget_charge(&budget, 10) && !eval_budget_charge(&budget, 1), "limit is inclusive");
+
+    /* A window is granted before the deadline passes; the next check sees it */
+    eval_budget_init(&budget, 1, 0);
+    sleep_ms(5);
+    unsigned long steps = 0;
+    while (eval_budget_charge(&budget, 1)) steps++;
+    check(budget.status == EVAL_BUDGET_TIMEOUT, "deadline is detected");
+    check(steps < EVAL_BUDGET_CHECK_INTERVAL, "clock is checked within one interval");
+
+    eval_budget_init_interval(&budget, 1, 0, 16);
+    sleep_ms(5);
+    steps = 0;
+    while (eval_budget_charge(&budget, 1)) steps++;
+    check(budget.status == EVAL_BUDGET_TIMEOUT && steps < 16, "custom clock interval");
+}
+
+static bool quiet_errors(const ParserErrorInfo *error, const char *expr, void *user_data) {
+    (void)error;
+    (void)expr;
+    (void)user_data;
+    return false;
+}
+
+static int tokens_seen = 0;
+
+static void stall_first_token(int level, const char *message, void *user_data) {
+    (void)level;
+    (void)user_data;
+    if (strstr(message, "[TOKEN]") && tokens_seen++ == 0) sleep_ms(5);
+}
+
+static void test_parser_limits() {
+    printf("\n=== Parser Limits ===\n");
+    parser_set_error_callback(quiet_errors, NULL);
+
+    const char *expr = "sin(1) + cos(2) * (3 + (4 - (5 * (6 + 7))))";
+    ParseResult plain = parse_expression_safe(expr);
+
+    ParserConfig config = {.timeout_ms = 1000};
+    ParseResult r = parse_expression_ex(expr, NULL, &config);
+    check(!r.has_error && r.value == plain.value, "generous timeout gives the same value");
+
+    config = (ParserConfig){.max_operations = 1000};
+    r = parse_expression_ex(expr, NULL, &config);
+    check(!r.has_error && r.value == plain.value, "generous operation limit gives the same value");
+
+    config.max_operations = 3;
+    r = parse_expression_ex(expr, NULL, &config);
+    check(r.has_error && strstr(r.error.message, "Operation budget exceeded") != NULL,
+          "nested expression exceeds a small operation limit");
+
+    /* One operation per token (end of input included), however deep */
+    config.max_operations = 6;
+    check(!parse_expression_ex("1 + 2 * 3", NULL, &config).has_error &&
+          parse_expression_ex("1 + 2 * 3 - 4", NULL, &config).has_error, "one operation per token");
+    config.max_operations = 14;
+    check(!parse_expression_ex("((((((1))))))", NULL, &config).has_error &&
+          !parse_expression_ex("1+2+3+4+5+6+7", NULL, &config).has_error, "nesting costs no extra operations");
+
+    config.max_operations = 5;
+    r = parse_expression_ex("1+2+3+4+5+6+7+8+9+10+11+12+13+14+15", NULL, &config);
+    check(r.has_error && strstr(r.error.message, "Operation budget exceeded") != NULL,
+          "flat sum exceeds a small operation limit");
+
+    /* A parse running past its deadline (stalled on its first token) stops
+     * within a few dozen tokens, however shallow the input */
+    char sum[401];
+    for (int i = 0; i < 200; i++) {
+        sum[2 * i] = '1';
+        sum[2 * i + 1] = '+';
+    }
+    sum[399] = '\0';
+    config = (ParserConfig){.timeout_ms = 1};
+    parser_set_debug_callback(stall_first_token, NULL);
+    parser_set_debug_level(DEBUG_TOKENS);
+    r = parse_expression_ex(sum, NULL, &config);
+    parser_set_debug_level(DEBUG_OFF);
+    parser_clear_debug_callback();
+    check(r.has_error && strstr(r.error.message, "Parsing timeout exceeded") != NULL &&
+          r.error.position < 200, "timeout stops a long flat sum");
+
+    /* A context's config is not bypassed by the expression cache */
+    parser_context_evaluate(NULL, expr, NULL);
+    parser_context_evaluate(NULL, expr, NULL);
+    config = (ParserConfig){.max_operations = 3};
+    ParserContext *ctx = parser_context_create(&config);
+    parser_context_set_error_callback(ctx, quiet_errors, NULL);
+    r = parser_context_evaluate(ctx, expr, NULL);
+    ParseResult again = parser_context_evaluate(ctx, expr, NULL);
+    check(r.has_error && again.has_error && strstr(again.error.message, "Operation budget exceeded") != NULL,
+          "context operation limit applies to cached expressions");
+    parser_context_free(ctx);
+
+    /* Tiered evaluation defers to the parser when operations are limited */
+    config = (ParserConfig){.max_operations = 3, .compile_after = 1};
+    bool all_failed = true;
+    for (int i = 0; i < 20; i++) all_failed = all_failed && parse_expression_ex(expr, NULL, &config).has_error;
+    check(all_failed && parser_expression_tier(expr) == PARSER_TIER_PARSE, "tiers keep the operation limit");
+    parser_clear_error_callback();
+}
+
+static void test_vm_budget() {
+    printf("\n=== VM and Batch Budgets ===\n");
+
+    CompiledExpression *ce = compile_expression("a * a + 2 * a * b + b * b");
+    if (!ce) {
+        check(false, "compile test expression");
+        return;
+    }
+    double values[2] = {3.0, 4.0};
+    VarContext vars = {.values = values, .count = 2};
+    VM *vm = vm_create(&vars);
+
+    EvalBudget budget;
+    eval_budget_init(&budget, 0, 0);
+    double result = 0.0;
+    check(vm_execute_budget(vm, ce->bytecode, &budget, &result) && result == 49.0, "budgeted VM gives the value");
+    unsigned long cost = eval_budget_operations(&budget);
+    check(cost > 0, "VM charges its instructions");
+
+    eval_budget_init(&budget, 0, cost * 3);
+    int runs = 0;
+    while (vm_execute_budget(vm, ce->bytecode, &budget, &result)) runs++;
+    check(runs == 3 && budget.status == EVAL_BUDGET_OPERATIONS, "operation limit bounds repeated runs");
+    vm_free(vm);
+
+    eval_budget_init(&budget, 0, 0);
+    check(compiled_expression_evaluate_budget(ce, &vars, &budget, &result) && result == 49.0,
+          "budgeted compiled expression gives the value");
+
+    size_t rows = 100000;
+    double *a = malloc(sizeof(double) * rows);
+    double *b = malloc(sizeof(double) * rows);
+    double *out = calloc(rows, sizeof(double));
+    for (size_t i = 0; i < rows; i++) {
+        a[i] = (double)i;
+        b[i] = 1.0;
+    }
+    const double *columns[2] = {a, b};
+
+    size_t done = 0;
+    eval_budget_init(&budget, 0, 0);
+    int status = compiled_expression_evaluate_batch_budget(ce, columns, 2, rows, out, &budget, &done);
+    check(status == 0 && done == rows && out[rows - 1] == (double)rows * rows, "unlimited batch runs every row");
+
+    /* Room for two blocks and a half: the third block is refused whole */
+    unsigned long block_cost = (unsigned long)VM_BATCH_BLOCK * (unsigned long)ce->bytecode->count;
+    eval_budget_init(&budget, 0, block_cost * 5 / 2);
+    memset(out, 0, sizeof(double) * rows);
+    status = vm_execute_batch_budget(ce->bytecode, columns, 2, rows, out, &budget, &done);
+    check(status == 1 && done == 2 * VM_BATCH_BLOCK, "operation limit stops the batch between blocks");
+    check(out[done - 1] == (double)done * done && out[done] == 0.0, "rows before the stop are filled");
+
+    /* An expired deadline stops a long batch at the next check */
+    eval_budget_init(&budget, 1, 0);
+    sleep_ms(5);
+    status = vm_execute_batch_budget(ce->bytecode, columns, 2, rows, out, &budget, &done);
+    check(status == 1 && budget.status == EVAL_BUDGET_TIMEOUT && done < rows, "deadline stops the batch");
+
+    check(vm_execute_batch_budget(ce->bytecode, columns, 2, rows, out, NULL, &done) == 0 && done == rows,
+          "NULL budget runs every row");
+
+    free(a);
+    free(b);
+    free(out);
+    compiled_expression_free(ce);
+}
+
+int main() {
+    printf("=========================================\n");
+    printf("  FluxParser - Evaluation Budget Tests\n");
+    printf("=========================================\n");
+
+    test_accounting();
+    test_parser_limits();
+    test_vm_budget();
+
+    return test_report();
+}
@@ -0,0 +1,212 @@
+/*
+ * FluxParser - Research-Grade C Math Parser
+ * Copyright (C) 2025 Eduardo Stern
+ *
+ * Dual Licensed:
+ * - GPL-3.0 for open-source/non-commercial use
+ * - Commercial license available - see LICENSE-COMMERCIAL.md
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * Compiled-expression cache tests: cached results must be indistinguishable
+ * from an uncached parse, counters must add up, capacity must be respected,
+ * and concurrent readers must agree.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <pthread.h>
+#include "parser.h"
+#include "test_common.h"
+
+static bool same_result(const ParseResult *a, const ParseResult *b) {
+    if (a->has_error != b->has_error) return false;
+    if (a->error.code != b->error.code || a->error.position != b->error.position) return false;
+    if (strcmp(a->error.message, b->error.message) != 0) return false;
+    if (isnan(a->value) || isnan(b->value)) return isnan(a->value) && isnan(b->value);
+    return a->value == b->value;
+}
+
+/* Includes every case the cache has to hand back to the parser */
+static const char *corpus[] = {
+    "2 + 3 * 4",
+    "2^3^2 - -2^2",
+    "sin(pi/4) * cos(x) + tan(y / 4)",
+    "x * x + 2 * x * y + y * y",
+    "(x > 0 && y > 0) || !(x == y)",
+    "e * 2",                    /* E shadowed by a variable */
+    "x / (y - y)",              /* Division by zero */
+    "sqrt(y)",                  /* Domain error for negative y */
+    "log(x) + log10(x)",
+    "foo(1)",                   /* Unknown function */
+    "sqrt(1, 2)",               /* Wrong argument count */
+    "velocity * 2",             /* Unresolved identifier */
+    "2 +",                      /* Syntax error */
+    "(1 + 2",
+    "1 < 2 < 3",
+    "max(1 2)",
+};
+
+static void test_matches_uncached() {
+    printf("\n=== Cached vs Uncached ===\n");
+
+    double values[26] = {0};
+    VarContext ctx = {.values = values, .count = 26};
+    const double points[][2] = {{0.5, 2.0}, {1.25, -3.0}, {0.0, 0.0}};
+
+    for (size_t i = 0; i < sizeof(corpus) / sizeof(corpus[0]); i++) {
+        bool ok = true;
+        for (size_t k = 0; k < sizeof(points) / sizeof(points[0]); k++) {
+            values['X' - 'A'] = points[k][0];
+            values['Y' - 'A'] = points[k][1];
+            values['E' - 'A'] = 10.0;
+
+            parser_cache_set_capacity(0);
+            ParseResult direct = parse_expression_with_vars_safe(corpus[i], &ctx);
+            parser_cache_set_capacity(PARSER_CACHE_DEFAULT_CAPACITY);
+
+            /* First call inserts, second call is served from the cache */
+            ParseResult first = parse_expression_with_vars_safe(corpus[i], &ctx);
+            ParseResult second = parse_expression_with_vars_safe(corpus[i], &ctx);
+            ok = ok && same_result(&direct, &first) && same_result(&direct, &second);
+        }
+        check(ok, corpus[i]);
+    }
+}
+
+static void test_mappings() {
+    printf("\n=== Named Variables ===\n");
+
+    double values[3] = {2.0, 5.0, 100.0};
+    VarMapping mappings[] = {{"RATE", 0}, {"TIME", 1}, {"SIN", 2}, {"PI", 2}, {"BAD", 7}};
+    VarContext ctx = {.values = values, .count = 3, .mappings = mappings, .mapping_count = 2};
+
+    const char *exprs[] = {"rate * time + 1", "rate * pi", "sin(time)", "bad + 1"};
+    for (int m = 2; m <= 5; m++) {
+        ctx.mapping_count = m;
+        for (size_t i = 0; i < sizeof(exprs) / sizeof(exprs[0]); i++) {
+            parser_cache_set_capacity(0);
+            ParseResult direct = parse_expression_with_vars_safe(exprs[i], &ctx);
+            parser_cache_set_capacity(PARSER_CACHE_DEFAULT_CAPACITY);
+            parse_expression_with_vars_safe(exprs[i], &ctx);
+            ParseResult cached = parse_expression_with_vars_safe(exprs[i], &ctx);
+
+            char what[128];
+            snprintf(what, sizeof(what), "'%s' with %d mappings", exprs[i], m);
+            check(same_result(&direct, &cached), what);
+        }
+    }
+}
+
+static void test_counters() {
+    printf("\n=== Hit/Miss/Eviction Counters ===\n");
+
+    parser_cache_set_capacity(PARSER_CACHE_DEFAULT_CAPACITY);
+    parser_cache_reset_stats();
+
+    for (int i = 0; i < 10; i++) {
+        parse_expression_safe("1 + 2 * 3");
+    }
+    parse_expression_safe("4 / 0");
+    parse_expression_safe("4 / 0");
+
+    ParserCacheStats stats;
+    parser_cache_get_stats(&stats);
+    check(stats.misses == 2, "one miss per distinct expression");
+    check(stats.hits == 10, "repeats are hits");
+    check(stats.fallbacks == 2, "division by zero falls back to the parser");
+    check(stats.entries == 2, "two entries cached");
+    check(stats.evictions == 0, "no evictions below capacity");
+
+    /* Overflow a small cache */
+    parser_cache_set_capacity(32);
+    parser_cache_reset_stats();
+    char expr[64];
+    for (int i = 0; i < 1000; i++) {
+        snprintf(expr, sizeof(expr), "%d + 1", i);
+        ParseResult r = parse_expression_safe(expr);
+        if (r.value != i + 1) {
+            check(false, "values stay correct under eviction");
+            break;
+        }
+    }
+    parser_cache_get_stats(&stats);
+    check(stats.capacity == 32, "capacity rounds to shard multiple");
+    check(stats.entries <= stats.capacity, "entries bounded by capacity");
+    check(stats.evictions == stats.misses - stats.entries, "every overflow insert evicts");
+
+    parser_cache_set_capacity(0);
+    parser_cache_reset_stats();
+    parse_expression_safe("1 + 1");
+    parse_expression_safe("1 + 1");
+    parser_cache_get_stats(&stats);
+    check(stats.hits == 0 && stats.misses == 0 && stats.entries == 0,
+          "capacity 0 disables the cache");
+
+    parser_cache_set_capacity(PARSER_CACHE_DEFAULT_CAPACITY);
+}
+
+#define NUM_THREADS 8
+#define ITERATIONS 20000
+
+static void *reader_thread(void *arg) {
+    int id = *(int *)arg;
+    double values[26] = {0};
+    VarContext ctx = {.values = values, .count = 26};
+    static const char *exprs[] = {"x * 2 + 1", "sqrt(x) + x^2", "(x + 1) * (x - 1)", "max(x, 3)"};
+    long errors = 0;
+
+    for (int i = 0; i < ITERATIONS; i++) {
+        double x = id * ITERATIONS + i;
+        values['X' - 'A'] = x;
+        int e = i % 4;
+        ParseResult r = parse_expression_with_vars_safe(exprs[e], &ctx);
+        double expected = e == 0 ? x * 2 + 1 : e == 1 ? sqrt(x) + pow(x, 2)
+                        : e == 2 ? (x + 1) * (x - 1) : fmax(x, 3);
+        if (r.has_error || r.value != expected) errors++;
+    }
+    return (void *)errors;
+}
+
+static void test_concurrent_readers() {
+    printf("\n=== Concurrent Readers ===\n");
+
+    parser_cache_set_capacity(PARSER_CACHE_DEFAULT_CAPACITY);
+    parser_cache_reset_stats();
+
+    pthread_t threads[NUM_THREADS];
+    int ids[NUM_THREADS];
+    for (int t = 0; t < NUM_THREADS; t++) {
+        ids[t] = t;
+        pthread_create(&threads[t], NULL, reader_thread, &ids[t]);
+    }
+
+    long errors = 0;
+    for (int t = 0; t < NUM_THREADS; t++) {
+        void *ret;
+        pthread_join(threads[t], &ret);
+        errors += (long)ret;
+    }
+
+    ParserCacheStats stats;
+    parser_cache_get_stats(&stats);
+    check(errors == 0, "all threads computed correct values");
+    check(stats.hits + stats.misses == (unsigned long long)NUM_THREADS * ITERATIONS,
+          "every call counted once");
+    check(stats.entries == 4, "shared entries, no duplicates");
+}
+
+int main() {
+    printf("=========================================\n");
+    printf("  FluxParser - Expression Cache Tests\n");
+    printf("=========================================\n");
+
+    test_matches_uncached();
+    test_mappings();
+    test_counters();
+    test_concurrent_readers();
+
+    return test_report();
+}
@@ -0,0 +1,49 @@
+/*
+ * FluxParser - Research-Grade C Math Parser
+ * Copyright (C) 2025 Eduardo Stern
+ *
+ * Dual Licensed:
+ * - GPL-3.0 for open-source/non-commercial use
+ * - Commercial license available - see LICENSE-COMMERCIAL.md
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * Shared harness of the standalone test programs: pass/fail counters,
+ * check(), close_to() and the results footer. Include it once, from the
+ * test's .c file.
+ */
+
+#ifndef TEST_COMMON_H
+#define TEST_COMMON_H
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <math.h>
+
+static int test_count = 0;
+static int passed = 0;
+
+static inline void check(bool ok, const char *what) {
+    test_count++;
+    if (ok) {
+        passed++;
+        printf("  [PASS] %s\n", what);
+    } else {
+        printf("  [FAIL] %s\n", what);
+    }
+}
+
+/* |a - b| within tol, relative to b once |b| > 1 */
+static inline bool close_to(double a, double b, double tol) {
+    return fabs(a - b) <= tol * (1.0 + fabs(b));
+}
+
+/* Print the results footer; returns the exit status (0: all passed) */
+static inline int test_report(void) {
+    printf("\n=========================================\n");
+    printf("Results: %d/%d tests passed\n", passed, test_count);
+    printf("=========================================\n");
+    return (passed == test_count) ? 0 : 1;
+}
+
+#endif /* TEST_COMMON_H */
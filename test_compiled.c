@@ -0,0 +1,454 @@
+/*
+ * FluxParser - Research-Grade C Math Parser
+ * Copyright (C) 2025 Eduardo Stern
+ *
+ * Dual Licensed:
+ * - GPL-3.0 for open-source/non-commercial use
+ * - Commercial license available - see LICENSE-COMMERCIAL.md
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * Compiled expression tests: parse once, evaluate many times.
+ * Every compiled result is checked against the direct evaluating parser.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "ast.h"
+#include "test_common.h"
+
+static bool close_enough(double a, double b) {
+    if (isnan(a) || isnan(b)) return isnan(a) && isnan(b);
+    return fabs(a - b) <= 1e-9 * fmax(1.0, fabs(b));
+}
+
+/* Expressions whose compiled value must match the direct parser exactly */
+static const char *corpus[] = {
+    "2 + 3 * 4",
+    "(2 + 3) * (4 + 5)",
+    "2^3^2",
+    "-2^2",
+    "--3",
+    "!0 + !5",
+    "sqrt(16) + 2^3",
+    "sin(pi/4) + cos(pi/4)",
+    "log(exp(5))",
+    "abs(-42) + floor(2.7) + ceil(2.1) + round(2.5)",
+    "min(5, 3) + max(10, 20) + pow(2, 10) + mod(17, 5) + atan2(1, 1)",
+    "5 > 3 && 10 < 20",
+    "5 < 3 || 10 > 20",
+    "2 + 2 == 4 && 3 * 3 == 9",
+    "1 != 1",
+    "x * x + 2 * x * y + y * y",
+    "(x + 1) * (x - 1) / (y + 2)",
+    "sin(x) * cos(y) + tan(x / 4)",
+    "sgn(x - y) * int(x * 3.7) + log10(abs(y) * 100)",
+    "x >= y || x <= 0.5",
+    "pi * x + exp(1)^y",
+};
+
+static void test_matches_direct_parser() {
+    printf("\n=== Compiled vs Direct Parser ===\n");
+
+    double values[26] = {0};
+    VarContext ctx = {.values = values, .count = 26};
+
+    const double points[][2] = {{0.5, 2.0}, {1.25, -3.0}, {3.0, 7.5}};
+
+    for (size_t i = 0; i < sizeof(corpus) / sizeof(corpus[0]); i++) {
+        CompiledExpression *ce = compile_expression(corpus[i]);
+        bool ok = ce != NULL;
+
+        for (size_t k = 0; ok && k < sizeof(points) / sizeof(points[0]); k++) {
+            values['X' - 'A'] = points[k][0];
+            values['Y' - 'A'] = points[k][1];
+
+            ParseResult direct = parse_expression_with_vars_safe(corpus[i], &ctx);
+            double compiled = compiled_expression_evaluate(ce, &ctx);
+            double tree = ast_evaluate(ce->ast, &ctx);
+
+            ok = !direct.has_error &&
+                 close_enough(compiled, direct.value) &&
+                 close_enough(tree, direct.value);
+        }
+
+        check(ok, corpus[i]);
+        compiled_expression_free(ce);
+    }
+}
+
+/* Register code must agree with the reference stack interpreter */
+static void test_register_vm() {
+    printf("\n=== Register VM vs Stack VM ===\n");
+
+    static const char *exprs[] = {
+        "x / 0 + 0 / 0 + x / (y - y)",
+        "(x + 2) * 3 - 4 / 5 + x^2 - 2^x",
+        "sqrt(x) + atan2(x, y) + min(y, 1) + foo(x, y, 3) + bar()",
+        "-(x < 2) + !(y >= 1) * (x == 0.5) - (x != y)",
+        "((((((x + 1) * (y + 2)) / ((x - 3) * (y - 4))) + 5) * 6) - 7)",
+    };
+
+    double values[26] = {0};
+    VarContext ctx = {.values = values, .count = 26};
+    VM *vm = vm_create(&ctx);
+
+    for (size_t i = 0; i < sizeof(exprs) / sizeof(exprs[0]); i++) {
+        CompiledExpression *ce = compile_expression(exprs[i]);
+        bool ok = ce && ce->bytecode->reg_code;
+        for (double x = -2.0; ok && x <= 2.0; x += 0.5) {
+            values['X' - 'A'] = x;
+            values['Y' - 'A'] = 1.0 - x;
+            double stack = vm_execute_stack(vm, ce->bytecode);
+            ok = close_enough(vm_execute(vm, ce->bytecode), stack) &&
+                 close_enough(compiled_expression_evaluate(ce, &ctx), stack);
+        }
+        check(ok, exprs[i]);
+        compiled_expression_free(ce);
+    }
+
+    /* Hand-built programs without register code still run */
+    BytecodeInstruction prog[] = {
+        {.op = BC_PUSH_NUM, .data.num = 6}, {.op = BC_PUSH_NUM, .data.num = 7},
+        {.op = BC_MULTIPLY}, {.op = BC_HALT}
+    };
+    Bytecode bc = {.instructions = prog, .count = 4, .capacity = 4};
+    check(vm_execute(vm, &bc) == 42.0, "stack fallback for hand-built bytecode");
+
+    vm_free(vm);
+}
+
+/* Native code must reproduce the register VM bit for bit, NaN included */
+static void test_jit() {
+    printf("\n=== JIT vs Register VM ===\n");
+
+    static const char *exprs[] = {
+        "x / 0 + 0 / 0 + x / (y - y) + x / sqrt(y)",
+        "(x + 2) * 3 - 4 / 5 + x^2 - 2^x + x^y",
+        "sqrt(x) + atan2(x, y) + min(y, 1) + foo(x, y, 3) + random() * 0",
+        "-(x < 2) + !(y >= 1) * (x == 0.5) - (x != y) + (x > y) + (x <= y)",
+        "(sqrt(x) != 0) + (sqrt(x) == sqrt(x)) + !sqrt(x) + (sqrt(x) && 1) + (0 || sqrt(x))",
+        "(sqrt(x) > 0) + (sqrt(x) < 0) + (sqrt(x) >= 0) + (sqrt(x) <= 0) + -sqrt(x)",
+        "((((((x + 1) * (y + 2)) / ((x - 3) * (y - 4))) + 5) * 6) - 7) + velocity",
+    };
+
+    double values[26] = {0};
+    VarContext ctx = {.values = values, .count = 26};
+    VM *vm = vm_create(&ctx);
+
+    for (size_t i = 0; i < sizeof(exprs) / sizeof(exprs[0]); i++) {
+        CompiledExpression *ce = compile_expression(exprs[i]);
+        bool native = ce && compiled_expression_jit(ce) == 0;
+        bool ok = ce && (native || !jit_supported());
+        for (double x = -2.0; ok && x <= 2.0; x += 0.25) {
+            values['X' - 'A'] = x;
+            values['Y' - 'A'] = 1.0 - x;
+            double vm_value = vm_execute(vm, ce->bytecode);
+            double jit_value = compiled_expression_evaluate(ce, &ctx);
+            ok = memcmp(&vm_value, &jit_value, sizeof(double)) == 0 ||
+                 (isnan(vm_value) && isnan(jit_value));
+        }
+        check(ok, exprs[i]);
+        compiled_expression_free(ce);
+    }
+    vm_free(vm);
+
+    /* Too few values: falls back to the VM, which reads missing slots as 0 */
+    CompiledExpression *ce = compile_expression("x * 2 + a");
+    compiled_expression_jit(ce);
+    double short_values[1] = {3.0};
+    VarContext short_ctx = {.values = short_values, .count = 1};
+    check(compiled_expression_evaluate(ce, &short_ctx) == 3.0 &&
+          compiled_expression_evaluate(ce, NULL) == 0.0, "uncovered slots fall back to the VM");
+    compiled_expression_free(ce);
+
+    /* Prepared slots and rebinding regenerate native code */
+    const char *names[] = {"rate", "time"};
+    double rt[2] = {2.0, 5.0};
+    ce = prepare_expression("rate * time + 1", names, 2, NULL);
+    compiled_expression_jit(ce);
+    check(ce && prepared_expression_evaluate(ce, rt) == 11.0, "prepared expressions run natively");
+
+    VarMapping swapped[] = {{"RATE", 1}, {"TIME", 0}};
+    double tr[2] = {5.0, 3.0};
+    VarContext layout = {.values = tr, .count = 2, .mappings = swapped, .mapping_count = 2};
+    compiled_expression_bind(ce, &layout);
+    check(ce && (ce->jit || !jit_supported()) && compiled_expression_evaluate(ce, &layout) == 16.0,
+          "rebinding regenerates native code");
+    compiled_expression_free(ce);
+}
+
+/* Bit-identical, any NaN matching any NaN */
+static bool same_bits(double a, double b) {
+    return memcmp(&a, &b, sizeof(double)) == 0 || (isnan(a) && isnan(b));
+}
+
+static int optimize_messages = 0;
+
+static void count_optimize(int level, const char *message, void *user_data) {
+    (void)user_data;
+    if (level == DEBUG_OPTIMIZE && strstr(message, "[OPTIMIZE]")) optimize_messages++;
+}
+
+/* Folding, strength reduction and CSE must not change any result */
+static void test_optimizer() {
+    printf("\n=== Bytecode Optimizer ===\n");
+
+    static const char *exprs[] = {
+        "(x*x + 1) * (x*x + 1)",
+        "sin(x) * sin(x) + cos(x) * cos(x) + sin(x)",
+        "x^2 + pow(y, 2) + x^1 * 1 - 0 + --y / 1",
+        "(2 + 3) * x + sqrt(16) / 0 + !(1 > 2) - (4 == 4)",
+        "max(x * y, x * y + 1) + atan2(x * y, x * y)",
+        "(x / y) * (x / y) + (x / y > 1) + foo(x / y, x / y)",
+        "random() * 0 + random() * 0 + (sqrt(x) == sqrt(x)) + -0 - x * 0",
+        "((x + y) * (x + y) - (x - y) * (x - y)) / ((x + y) * (x - y) + 1)",
+    };
+
+    double values[26] = {0};
+    VarContext ctx = {.values = values, .count = 26};
+    VM *vm = vm_create(&ctx);
+
+    const double xs[] = {-2.0, -0.5, 0.0, 0.5, 1.25, 3.0};
+    const double *columns[26] = {0};
+    double col_x[6], col_y[6], batch[6];
+    for (int k = 0; k < 6; k++) {
+        col_x[k] = xs[k];
+        col_y[k] = 1.0 - xs[k];
+    }
+    columns['X' - 'A'] = col_x;
+    columns['Y' - 'A'] = col_y;
+
+    for (size_t i = 0; i < sizeof(exprs) / sizeof(exprs[0]); i++) {
+        CompiledExpression *ce = compile_expression(exprs[i]);
+        Bytecode *plain = ce ? ast_compile_unoptimized(ce->ast) : NULL;
+        compiled_expression_jit(ce);
+        bool ok = ce && plain && ce->bytecode->count <= plain->count &&
+                  vm_execute_batch(ce->bytecode, columns, 26, 6, batch) == 0;
+
+        for (int k = 0; ok && k < 6; k++) {
+            values['X' - 'A'] = col_x[k];
+            values['Y' - 'A'] = col_y[k];
+            double expected = vm_execute_stack(vm, plain);
+            bool has_random = strstr(exprs[i], "random") != NULL;
+            ok = same_bits(vm_execute_stack(vm, ce->bytecode), expected) &&
+                 same_bits(vm_execute(vm, ce->bytecode), expected) &&
+                 same_bits(compiled_expression_evaluate(ce, &ctx), expected) &&
+                 (has_random || same_bits(batch[k], expected));
+        }
+        check(ok, exprs[i]);
+        bytecode_free(plain);
+        compiled_expression_free(ce);
+    }
+    vm_free(vm);
+
+    CompiledExpression *ce = compile_expression("(x*x + 1) * (x*x + 1)");
+    check(ce && ce->bytecode->count == 9 && ce->bytecode->temp_count == 1,
+          "repeated subexpression computed once into a temporary");
+    compiled_expression_free(ce);
+
+    ce = compile_expression("sqrt(16) + 2^3 * (1 + 1)");
+    check(ce && ce->bytecode->count == 2 && ce->bytecode->instructions[0].op == BC_PUSH_NUM &&
+          ce->bytecode->instructions[0].data.num == 20.0, "constant subtrees fold");
+    compiled_expression_free(ce);
+
+    ce = compile_expression("pow(x, 2)");
+    check(ce && ce->bytecode->count == 4 && ce->bytecode->instructions[2].op == BC_MULTIPLY,
+          "pow(x, 2) becomes x*x");
+    compiled_expression_free(ce);
+
+    ce = compile_expression("random() + random()");
+    check(ce && ce->bytecode->temp_count == 0, "random() is never shared");
+    compiled_expression_free(ce);
+
+    /* Squaring an impure operand must not become RANDOM() * RANDOM() (mean 1/4, not 1/3) */
+    static const char *squares[] = {"RND()^2", "pow(random(), 2)", "(x + rnd())^2"};
+    for (size_t i = 0; i < sizeof(squares) / sizeof(squares[0]); i++) {
+        ce = compile_expression(squares[i]);
+        int calls = 0;
+        for (int j = 0; ce && j < ce->bytecode->count; j++) {
+            const BytecodeInstruction *inst = &ce->bytecode->instructions[j];
+            calls += inst->op == BC_CALL_FUNC && inst->data.func.id == FUNC_RANDOM;
+        }
+        double sum = 0.0;
+        const int samples = 20000;
+        values['X' - 'A'] = 0.0;
+        for (int k = 0; ce && k < samples; k++) sum += compiled_expression_evaluate(ce, &ctx);
+        char what[64];
+        snprintf(what, sizeof(what), "%s keeps one random() call", squares[i]);
+        check(ce && calls == 1 && fabs(sum / samples - 1.0 / 3.0) < 0.02, what);
+        compiled_expression_free(ce);
+    }
+
+    parser_set_debug_callback(count_optimize, NULL);
+    parser_set_debug_level(DEBUG_OPTIMIZE);
+    ce = compile_expression("x * 2 + x * 2");
+    parser_set_debug_level(DEBUG_OFF);
+    parser_clear_debug_callback();
+    check(optimize_messages == 1, "DEBUG_OPTIMIZE reports instruction counts");
+    compiled_expression_free(ce);
+}
+
+static void test_function_table() {
+    printf("\n=== Function Table ===\n");
+
+    const MathFunctionInfo *f = math_function_lookup("LN");
+    check(f && f->id == FUNC_LOG && strcmp(f->name, "LOG") == 0, "LN is an alias of LOG");
+    check(math_function_lookup("RND") == math_function_info(FUNC_RANDOM), "RND is an alias of RANDOM");
+    check(math_function_lookup("NOPE") == NULL && math_function_info(FUNC_UNKNOWN) == NULL,
+          "unknown names resolve to nothing");
+
+    for (int id = FUNC_UNKNOWN + 1; id < FUNC_COUNT; id++) {
+        const MathFunctionInfo *info = math_function_info((MathFunction)id);
+        if (!info || (int)info->id != id || math_function_lookup(info->name) != info) {
+            check(false, "table indexed by id");
+            return;
+        }
+    }
+    check(true, "table indexed by id");
+
+    ASTNode *ast = parse_expression_ast("atan2(1, 2) + mystery(3)", NULL);
+    check(ast && ast->data.binary.left->data.function.id == FUNC_ATAN2 &&
+          ast->data.binary.right->data.function.id == FUNC_UNKNOWN,
+          "call nodes carry resolved ids");
+    ast_free(ast);
+
+    double args[2] = {1.0, 2.0};
+    check(math_function_eval(FUNC_ATAN2, args, 2) == atan2(2.0, 1.0) &&
+          math_function_eval(FUNC_SQRT, args, 2) == 0.0,
+          "ATAN2 argument order and arity check");
+}
+
+static void test_prepared() {
+    printf("\n=== Prepared Expressions ===\n");
+
+    const char *names[] = {"velocity", "Time", "x"};
+    double values[3] = {3.0, 4.0, 0.5};
+    ParserErrorInfo error;
+
+    CompiledExpression *ce = prepare_expression("velocity * time + x^2 - pi", names, 3, &error);
+    check(ce && error.code == PARSER_OK, "multi-letter names prepare");
+    check(ce && ce->bytecode->var_count == 3, "one symbol per distinct name");
+    check(ce && close_enough(prepared_expression_evaluate(ce, values), 12.25 - M_PI),
+          "slots follow the name list");
+
+    /* Register code and stack code read the same slots */
+    bool ok = ce != NULL;
+    VarContext ctx = {.values = values, .count = 3};
+    VM *vm = vm_create(&ctx);
+    for (double v = -2.0; ok && v <= 2.0; v += 0.5) {
+        values[0] = v;
+        values[2] = 1.0 - v;
+        ok = close_enough(prepared_expression_evaluate(ce, values), vm_execute_stack(vm, ce->bytecode)) &&
+             close_enough(vm_execute(vm, ce->bytecode), vm_execute_stack(vm, ce->bytecode));
+    }
+    check(ok, "register VM agrees with stack VM");
+    vm_free(vm);
+
+    /* Batch columns are the prepared slots */
+    double vs[4] = {1, 2, 3, 4}, ts[4] = {10, 20, 30, 40}, xs[4] = {0, 0, 0, 2};
+    const double *columns[3] = {vs, ts, xs};
+    double out[4];
+    check(ce && compiled_expression_evaluate_batch(ce, columns, 3, 4, out) == 0 &&
+          close_enough(out[1], 40 - M_PI) && close_enough(out[3], 164 - M_PI),
+          "batch reads prepared slots");
+    compiled_expression_free(ce);
+
+    ce = prepare_expression("rate * 2 + delta", names, 3, &error);
+    check(ce == NULL && error.code == PARSER_ERROR_UNKNOWN_VAR &&
+          strstr(error.message, "RATE") != NULL, "unknown names are rejected");
+
+    ce = prepare_expression("x + 1", NULL, 0, &error);
+    check(ce == NULL && error.code == PARSER_ERROR_UNKNOWN_VAR, "no names: every variable unknown");
+
+    ce = prepare_expression("2 * (3", names, 3, &error);
+    check(ce == NULL && error.code == PARSER_ERROR_UNMATCHED_PAREN, "parse errors pass through");
+
+    /* Rebinding through named mappings matches ast_evaluate() */
+    double slots[2] = {7.0, 0.25};
+    VarMapping mappings[] = {{"GAIN", 1}, {"Y", 0}, {"OFF", 5}};
+    VarContext layout = {.values = slots, .count = 2, .mappings = mappings, .mapping_count = 3};
+    ce = compile_expression("gain * y + off + z");
+    check(ce && compiled_expression_bind(ce, &layout) == 2, "bind reports unbound names");
+    check(ce && close_enough(compiled_expression_evaluate(ce, &layout), ast_evaluate(ce->ast, &layout)),
+          "mapped binding matches ast_evaluate");
+    double letters[26] = {0};
+    letters['Y' - 'A'] = 3.0;
+    letters['Z' - 'A'] = 5.0;
+    VarContext plain = {.values = letters, .count = 26};
+    check(ce && compiled_expression_bind(ce, NULL) == 2 &&
+          compiled_expression_evaluate(ce, &plain) == 5.0,
+          "NULL layout restores letter slots");
+    compiled_expression_free(ce);
+}
+
+static void test_ast_shape() {
+    printf("\n=== AST Building Mode ===\n");
+
+    ParserErrorInfo error;
+    ASTNode *ast = parse_expression_ast("velocity * t + 2", &error);
+    check(ast && error.code == PARSER_OK, "multi-letter identifiers parse");
+    check(ast && ast->type == AST_BINARY_OP && ast->data.binary.op == OP_ADD,
+          "additive root");
+    check(ast && ast->data.binary.left->data.binary.left->type == AST_VARIABLE &&
+          strcmp(ast->data.binary.left->data.binary.left->data.variable.name, "VELOCITY") == 0,
+          "identifiers become upper-case variables");
+    ast_free(ast);
+
+    ast = parse_expression_ast("pi", &error);
+    check(ast && ast->type == AST_NUMBER && fabs(ast->data.number.value - 3.14159265358979) < 1e-12,
+          "PI folds to a number");
+    ast_free(ast);
+
+    ast = parse_expression_ast("sqrt(x, y, 3)", &error);
+    check(ast && ast->type == AST_FUNCTION_CALL && ast->data.function.arg_count == 3,
+          "argument lists are preserved");
+    ast_free(ast);
+}
+
+static void test_parse_errors() {
+    printf("\n=== Parse Errors ===\n");
+
+    struct {
+        const char *expr;
+        ParserError code;
+    } cases[] = {
+        {"", PARSER_ERROR_EMPTY_EXPR},
+        {"2 +", PARSER_ERROR_UNEXPECTED_TOKEN},
+        {"(2 + 3", PARSER_ERROR_UNMATCHED_PAREN},
+        {"2 3", PARSER_ERROR_UNEXPECTED_TOKEN},
+        {"max(1 2)", PARSER_ERROR_SYNTAX},
+        {"1 < 2 < 3", PARSER_ERROR_UNEXPECTED_TOKEN},
+    };
+
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        ParserErrorInfo error;
+        ASTNode *ast = parse_expression_ast(cases[i].expr, &error);
+        char what[128];
+        snprintf(what, sizeof(what), "'%s' -> %s", cases[i].expr,
+                 parser_error_string(cases[i].code));
+        check(ast == NULL && error.code == cases[i].code, what);
+        ast_free(ast);
+    }
+
+    check(compile_expression("2 * (3") == NULL, "compile_expression returns NULL on error");
+}
+
+int main() {
+    printf("=========================================\n");
+    printf("  FluxParser - Compiled Expression Tests\n");
+    printf("=========================================\n");
+
+    test_matches_direct_parser();
+    test_register_vm();
+    test_jit();
+    test_optimizer();
+    test_function_table();
+    test_prepared();
+    test_ast_shape();
+    test_parse_errors();
+
+    return test_report();
+}
@@ -0,0 +1,277 @@
+/*
+ * FluxParser - Research-Grade C Math Parser
+ * Copyright (C) 2025 Eduardo Stern
+ *
+ * Dual Licensed:
+ * - GPL-3.0 for open-source/non-commercial use
+ * - Commercial license available - see LICENSE-COMMERCIAL.md
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * Hash-consed DAG tests: equal subexpressions must be one node, derivatives
+ * must match the tree-based ones and be memoized, and repeated or deep
+ * differentiation must stay small where trees explode, and Taylor series
+ * built from them must be correct.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "ast.h"
+#include "test_common.h"
+
+/* Evaluate through compiled code, which keeps the DAG's sharing */
+static double eval_x(const ASTNode *node, double x) {
+    VarMapping mapping = {.name = "X", .index = 0};
+    VarContext ctx = {.values = &x, .count = 1, .mappings = &mapping, .mapping_count = 1};
+    Bytecode *bc = ast_compile(node);
+    bytecode_bind(bc, &ctx);
+    VM *vm = vm_create(&ctx);
+    double result = vm_execute(vm, bc);
+    vm_free(vm);
+    bytecode_free(bc);
+    return result;
+}
+
+static double tree_eval_x(const ASTNode *node, double x) {
+    VarMapping mapping = {.name = "X", .index = 0};
+    VarContext ctx = {.values = &x, .count = 1, .mappings = &mapping, .mapping_count = 1};
+    return ast_evaluate(node, &ctx);
+}
+
+static void test_hash_consing() {
+    printf("\n=== Hash-Consing ===\n");
+
+    ASTDag *dag = ast_dag_create();
+    ASTNode *x = ast_dag_variable(dag, "X");
+    ASTNode *two = ast_dag_number(dag, 2.0);
+    ASTNode *a = ast_dag_binary_op(dag, OP_MULTIPLY, two, ast_dag_function_call(dag, "SIN", &x, 1));
+    ASTNode *x_again = ast_dag_variable(dag, "X");
+    ASTNode *b = ast_dag_binary_op(dag, OP_MULTIPLY, ast_dag_number(dag, 2.0),
+                                   ast_dag_function_call(dag, "SIN", &x_again, 1));
+    check(x == x_again && a == b, "equal subexpressions are one node");
+    check(a->consed && a->in_arena, "DAG nodes are marked and arena-owned");
+
+    size_t nodes = ast_dag_node_count(dag);
+    ParserErrorInfo error;
+    ASTNode *tree = parse_expression_ast("2 * sin(x) + 2 * sin(x)", &error);
+    ASTNode *imported = ast_dag_simplify(dag, tree);
+    check(imported->type == AST_BINARY_OP && imported->data.binary.right == a->data.binary.right,
+          "importing a tree reuses existing nodes");
+    check(ast_dag_node_count(dag) == nodes + 2, "only the new nodes (4 * ...) are added");
+    ast_free(tree);
+
+    ast_free(a);    /* No-op for DAG nodes */
+    check(ast_dag_binary_op(dag, OP_MULTIPLY, two, ast_dag_function_call(dag, "SIN", &x, 1)) == a,
+          "ast_free leaves DAG nodes alone");
+    ast_dag_destroy(dag);
+}
+
+static void test_simplification() {
+    printf("\n=== Simplification On Construction ===\n");
+
+    ASTDag *dag = ast_dag_create();
+    ASTNode *x = ast_dag_variable(dag, "X");
+    ASTNode *zero = ast_dag_number(dag, 0.0);
+    ASTNode *one = ast_dag_number(dag, 1.0);
+
+    check(ast_dag_binary_op(dag, OP_ADD, x, zero) == x &&
+          ast_dag_binary_op(dag, OP_MULTIPLY, one, x) == x &&
+          ast_dag_binary_op(dag, OP_POWER, x, one) == x &&
+          ast_dag_binary_op(dag, OP_MULTIPLY, x, zero) == zero, "identities collapse");
+
+    ASTNode *three_x = ast_dag_binary_op(dag, OP_MULTIPLY, ast_dag_number(dag, 3.0), x);
+    ASTNode *two_x = ast_dag_binary_op(dag, OP_MULTIPLY, x, ast_dag_number(dag, 2.0));
+    ASTNode *five_x = ast_dag_binary_op(dag, OP_MULTIPLY, ast_dag_number(dag, 5.0), x);
+    check(ast_dag_binary_op(dag, OP_ADD, three_x, two_x) == five_x, "like terms combine");
+    check(ast_dag_binary_op(dag, OP_MULTIPLY, ast_dag_number(dag, 2.0), three_x) ==
+          ast_dag_binary_op(dag, OP_MULTIPLY, ast_dag_number(dag, 6.0), x), "coefficients fold");
+
+    ASTNode *folded = ast_dag_binary_op(dag, OP_DIVIDE, ast_dag_number(dag, 1.0), ast_dag_number(dag, 3.0));
+    check(folded->type == AST_NUMBER && folded->data.number.value == 1.0 / 3.0,
+          "constants fold in double precision");
+    ASTNode *neg = ast_dag_unary_op(dag, OP_NEGATE, x);
+    check(ast_dag_unary_op(dag, OP_NEGATE, neg) == x, "double negation cancels");
+
+    ParserErrorInfo error;
+    ASTNode *tree = parse_expression_ast("(x * 1 + 0) * (2 + 3) - x ^ 1 / 1", &error);
+    ASTNode *simple = ast_dag_simplify(dag, tree);
+    check(close_to(eval_x(simple, 1.7), tree_eval_x(tree, 1.7), 1e-12) &&
+          ast_count_operations(simple) < ast_count_operations(tree), "import simplifies and agrees");
+    ast_free(tree);
+    ast_dag_destroy(dag);
+}
+
+static void test_derivatives() {
+    printf("\n=== Derivatives ===\n");
+
+    static const char *exprs[] = {
+        "x^3 * sin(x) + exp(2 * x) / (x + 1)",
+        "ln(x^2 + 1) * sqrt(x) - cos(x) * tan(x)",
+        "-(x * x) / (1 + x * x * x)",
+    };
+    ASTDag *dag = ast_dag_create();
+    bool all_match = true;
+    for (size_t i = 0; i < sizeof(exprs) / sizeof(exprs[0]); i++) {
+        ParserErrorInfo error;
+        ASTNode *f = parse_expression_ast(exprs[i], &error);
+        ASTNode *tree_d = ast_differentiate(f, "X");
+        ASTNode *dag_d = ast_dag_differentiate(dag, f, "X");
+        for (double x = 0.3; x < 2.0; x += 0.4) {
+            all_match = all_match && close_to(eval_x(dag_d, x), tree_eval_x(tree_d, x), 1e-10);
+        }
+        ast_free(tree_d);
+        ast_free(f);
+    }
+    check(all_match, "match ast_differentiate()");
+
+    ParserErrorInfo error;
+    ASTNode *f = parse_expression_ast("x * sin(x) * exp(x)", &error);
+    ASTNode *first = ast_dag_differentiate(dag, f, "X");
+    size_t nodes = ast_dag_node_count(dag);
+    ASTNode *g = ast_dag_simplify(dag, f);
+    check(ast_dag_differentiate(dag, g, "X") == first && ast_dag_node_count(dag) == nodes,
+          "derivatives are memoized per node");
+    check(ast_dag_differentiate(dag, g, "Y") == ast_dag_number(dag, 0.0),
+          "other variables give exactly zero");
+
+    /* The tree version gives 0 for a variable exponent */
+    ASTNode *xx = parse_expression_ast("x ^ x", &error);
+    ASTNode *dxx = ast_dag_differentiate(dag, xx, "X");
+    double x0 = 1.3;
+    check(close_to(eval_x(dxx, x0), pow(x0, x0) * (log(x0) + 1.0), 1e-12), "general power rule");
+
+    ast_free(xx);
+    ast_free(f);
+    ast_dag_destroy(dag);
+}
+
+static void test_growth() {
+    printf("\n=== Growth ===\n");
+
+    /* d^n/dx^n (e^x sin x) = 2^(n/2) e^x sin(x + n pi/4) */
+    ParserErrorInfo error;
+    ASTNode *f = parse_expression_ast("exp(x) * sin(x)", &error);
+    ASTDag *dag = ast_dag_create();
+    ASTNode *d = ast_dag_simplify(dag, f);
+    const int order = 16;
+    for (int n = 0; n < order; n++) d = ast_dag_differentiate(dag, d, "X");
+
+    double x = 0.3;
+    double expected = pow(2.0, order / 2.0) * exp(x) * sin(x + order * M_PI / 4.0);
+    check(close_to(eval_x(d, x), expected, 1e-9), "16th derivative is correct");
+    check(ast_dag_node_count(dag) < 1000, "16 derivatives stay under 1000 nodes");
+
+    Bytecode *bc = ast_compile(d);
+    check(bc && bc->count < 2000, "compiled 16th derivative stays small");
+    bytecode_free(bc);
+
+    /* Tree derivatives of the same thing grow geometrically */
+    ASTNode *tree = ast_clone(f);
+    for (int n = 0; n < 6; n++) {
+        ASTNode *next = ast_differentiate(tree, "X");
+        ast_free(tree);
+        tree = next;
+    }
+    check(ast_count_operations(tree) > 1000, "(tree 6th derivative already has > 1000 operations)");
+    ast_free(tree);
+    ast_dag_destroy(dag);
+    ast_free(f);
+}
+
+static void test_taylor() {
+    printf("\n=== Taylor Series ===\n");
+
+    /* All derivatives of exp(x) are one DAG node */
+    ParserErrorInfo error;
+    ASTNode *f = parse_expression_ast("exp(x)", &error);
+    ASTNode *t = ast_taylor_series(f, "X", 0.5, 8);
+    double expected = 0.0;
+    for (int n = 8; n >= 0; n--) expected = 1.0 + expected * 0.2 / (n + 1);
+    check(close_to(tree_eval_x(t, 0.7), exp(0.5) * expected, 1e-12), "exp(x): repeated derivatives");
+    ast_free(t);
+    ast_free(f);
+
+    /* f^(n)(c) = 2^(n/2) e^c sin(c + n pi/4) */
+    f = parse_expression_ast("exp(x) * sin(x)", &error);
+    t = ast_taylor_series(f, "X", 0.3, 16);
+    expected = 0.0;
+    double power = 1.0;
+    for (int n = 0; n <= 16; n++) {
+        expected += pow(2.0, n / 2.0) * exp(0.3) * sin(0.3 + n * M_PI / 4.0) * power;
+        power *= 0.1 / (n + 1);
+    }
+    check(close_to(tree_eval_x(t, 0.4), expected, 1e-12), "exp(x) sin(x): 17 terms");
+    ast_free(t);
+    ast_free(f);
+
+    /* sqrt'(0) is infinite: the series stops before that term */
+    f = parse_expression_ast("sqrt(x)", &error);
+    t = ast_taylor_series(f, "X", 0.0, 4);
+    check(t && t->type == AST_NUMBER && t->data.number.value == 0.0, "sqrt(x) at 0 stops at the constant term");
+    ast_free(t);
+    ast_free(f);
+}
+
+#define CHAIN 60
+
+static void test_gradient() {
+    printf("\n=== Gradient ===\n");
+
+    /* f = sum over i of x_i * x_(i+1) * sin(x_i), nested left to right */
+    char names[CHAIN][8];
+    const char *vars[CHAIN];
+    VarMapping mappings[CHAIN];
+    double values[CHAIN];
+    ASTNode *f = NULL;
+    for (int i = 0; i < CHAIN; i++) {
+        snprintf(names[i], sizeof(names[i]), "V%d", i);
+        vars[i] = names[i];
+        mappings[i].name = names[i];
+        mappings[i].index = i;
+        values[i] = 0.1 + 0.01 * i;
+    }
+    for (int i = 0; i + 1 < CHAIN; i++) {
+        ASTNode *xi = ast_create_variable(names[i]);
+        ASTNode *term = ast_create_binary_op(OP_MULTIPLY,
+            ast_create_binary_op(OP_MULTIPLY, xi, ast_create_variable(names[i + 1])),
+            ast_create_function_call("SIN", (ASTNode *[]){ast_create_variable(names[i])}, 1));
+        f = f ? ast_create_binary_op(OP_ADD, f, term) : term;
+    }
+
+    Gradient grad = ast_gradient(f, vars, CHAIN);
+    VarContext ctx = {.values = values, .count = CHAIN, .mappings = mappings, .mapping_count = CHAIN};
+    double *g = gradient_evaluate(&grad, &ctx);
+
+    bool ok = g != NULL;
+    for (int i = 0; ok && i < CHAIN; i++) {
+        double expected = 0.0;
+        if (i + 1 < CHAIN) expected += values[i + 1] * (sin(values[i]) + values[i] * cos(values[i]));
+        if (i > 0) expected += values[i - 1] * sin(values[i - 1]);
+        ok = close_to(g[i], expected, 1e-12);
+    }
+    check(ok, "gradient matches the analytic one");
+    check(ast_dag_node_count(grad.dag) < 20 * CHAIN, "all partials share one linear-size DAG");
+
+    ast_free(grad.components[0]);   /* No-op: the gradient owns them */
+    free(g);
+    gradient_free(&grad);
+    check(grad.dag == NULL && grad.count == 0, "gradient_free releases the DAG");
+    ast_free(f);
+}
+
+int main() {
+    printf("=========================================\n");
+    printf("  FluxParser - Expression DAG Tests\n");
+    printf("=========================================\n");
+
+    test_hash_consing();
+    test_simplification();
+    test_derivatives();
+    test_growth();
+    test_taylor();
+    test_gradient();
+
+    return test_report();
+}
@@ -0,0 +1,157 @@
+/*
+ * FluxParser - Research-Grade C Math Parser
+ * Copyright (C) 2025 Eduardo Stern
+ *
+ * Dual Licensed:
+ * - GPL-3.0 for open-source/non-commercial use
+ * - Commercial license available - see LICENSE-COMMERCIAL.md
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * Dual-number tests: the tree walker and the VM must give f exactly as the
+ * plain evaluators do and f' as the symbolic derivative does, and Newton
+ * solves (single and batched) built on them must agree with each other.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "ast.h"
+#include "test_common.h"
+
+static void test_tree_and_vm() {
+    printf("\n=== Tree Walker And VM ===\n");
+
+    static const char *exprs[] = {
+        "x^3 * sin(x) + exp(2 * x) / (x + 1)",
+        "ln(x^2 + 1) * sqrt(x) - cos(x) * tan(x)",
+        "sin(x * y) * sin(x * y) + y / (1 + sin(x * y))",
+        "-(x * x) / (1 + x * x * x) + sqrt(x + 3)",
+    };
+    VarMapping mappings[2] = {{"X", 0}, {"Y", 1}};
+    bool values_ok = true, derivs_ok = true, vm_ok = true;
+
+    for (size_t i = 0; i < sizeof(exprs) / sizeof(exprs[0]); i++) {
+        ParserErrorInfo error;
+        ASTNode *f = parse_expression_ast(exprs[i], &error);
+        ASTNode *df = ast_differentiate(f, "X");
+        Bytecode *bc = ast_compile(f);
+        for (double x = 0.3; x < 2.5; x += 0.4) {
+            double vals[2] = {x, 0.8};
+            VarContext ctx = {.values = vals, .count = 2, .mappings = mappings, .mapping_count = 2};
+            bytecode_bind(bc, &ctx);
+
+            Dual tree = ast_evaluate_dual(f, &ctx, 0);
+            Dual vm = vm_execute_dual(bc, &ctx, 0);
+            values_ok = values_ok && tree.value == ast_evaluate(f, &ctx);
+            derivs_ok = derivs_ok && close_to(tree.deriv, ast_evaluate(df, &ctx), 1e-12);
+            vm_ok = vm_ok && close_to(vm.value, tree.value, 1e-14) && close_to(vm.deriv, tree.deriv, 1e-12);
+        }
+        bytecode_free(bc);
+        ast_free(df);
+        ast_free(f);
+    }
+    check(values_ok, "tree walker value matches ast_evaluate() exactly");
+    check(derivs_ok, "tree walker derivative matches ast_differentiate()");
+    check(vm_ok, "VM (with shared temporaries) matches the tree walker");
+
+    /* Seeding another slot differentiates along it */
+    ParserErrorInfo error;
+    ASTNode *f = parse_expression_ast("x^2 * y + y^3", &error);
+    double vals[2] = {1.5, 2.0};
+    VarContext ctx = {.values = vals, .count = 2, .mappings = mappings, .mapping_count = 2};
+    Dual dy = ast_evaluate_dual(f, &ctx, 1);
+    Dual none = ast_evaluate_dual(f, &ctx, -1);
+    check(dy.deriv == 1.5 * 1.5 + 3 * 2.0 * 2.0 && none.deriv == 0.0, "seed slot selects the variable");
+    ast_free(f);
+
+    f = parse_expression_ast("x / (x - 1) + sqrt(x - 1)", &error);
+    vals[0] = 1.0;
+    Dual pole = ast_evaluate_dual(f, &ctx, 0);
+    check(pole.value == 0.0 && pole.deriv == 0.0, "division by zero gives 0, like the VM");
+    ast_free(f);
+}
+
+static void test_newton() {
+    printf("\n=== Newton-Raphson ===\n");
+
+    ParserErrorInfo error;
+    ASTNode *f = parse_expression_ast("atan(x) - 0.5", &error);
+    NumericalSolveResult r = ast_solve_numerical(f, "X", 1.0, 1e-12, 50);
+    check(r.converged && close_to(r.solution, tan(0.5), 1e-12), "functions without a symbolic rule (atan)");
+    ast_free(f);
+
+    f = parse_expression_ast("x ^ x - 2", &error);
+    r = ast_solve_numerical(f, "X", 1.5, 1e-12, 50);
+    check(r.converged && close_to(pow(r.solution, r.solution), 2.0, 1e-12), "variable exponent (x^x = 2)");
+    ast_free(f);
+}
+
+#define PROBLEMS 1000
+
+static void test_batch() {
+    printf("\n=== Batched Solves ===\n");
+
+    ParserErrorInfo error;
+    ASTNode *f = parse_expression_ast("cos(x) - x", &error);
+    double *guesses = malloc(sizeof(double) * PROBLEMS);
+    double *params = malloc(sizeof(double) * PROBLEMS);
+    NumericalSolveResult *results = malloc(sizeof(NumericalSolveResult) * PROBLEMS);
+    for (int i = 0; i < PROBLEMS; i++) {
+        guesses[i] = -3.0 + 6.0 * i / PROBLEMS;
+        params[i] = 1.0 + i;
+    }
+
+    check(ast_solve_numerical_batch(f, "X", NULL, NULL, guesses, PROBLEMS, 1e-10, 100, results) == 0,
+          "batch over many initial guesses runs");
+    bool same = true;
+    for (int i = 0; i < PROBLEMS; i++) {
+        NumericalSolveResult one = ast_solve_numerical(f, "X", guesses[i], 1e-10, 100);
+        same = same && one.converged == results[i].converged && one.iterations == results[i].iterations &&
+               one.solution == results[i].solution && strcmp(one.error_message, results[i].error_message) == 0;
+    }
+    check(same, "each result is exactly the single solve's");
+    ast_free(f);
+
+    /* One compiled equation for a family of parameters */
+    f = parse_expression_ast("x^2 - a", &error);
+    for (int i = 0; i < PROBLEMS; i++) guesses[i] = 1.0;
+    ast_solve_numerical_batch(f, "X", "A", params, guesses, PROBLEMS, 1e-9, 100, results);
+    bool roots = true;
+    for (int i = 0; i < PROBLEMS; i++) {
+        roots = roots && results[i].converged && close_to(results[i].solution, sqrt(params[i]), 1e-9);
+    }
+    check(roots, "parameterized batch finds sqrt(a) for every a");
+
+    /* Problems that stop early (zero derivative) or never converge */
+    guesses[0] = 0.0;
+    ast_solve_numerical_batch(f, "X", "A", params, guesses, 1, 1e-9, 100, results);
+    check(!results[0].converged && strstr(results[0].error_message, "Derivative is zero") != NULL,
+          "failures are reported per problem");
+    guesses[0] = 1.0;
+    ast_solve_numerical_batch(f, "X", "A", params + 99, guesses, 1, 1e-9, 3, results);
+    check(!results[0].converged && results[0].iterations == 3 && strstr(results[0].error_message, "Max iterations"),
+          "iteration limit applies per problem");
+
+    check(ast_solve_numerical_batch(f, "X", "A", NULL, guesses, 1, 1e-9, 10, results) == -1 &&
+          ast_solve_numerical_batch(NULL, "X", NULL, NULL, guesses, 1, 1e-9, 10, results) == -1,
+          "invalid input is rejected");
+
+    ast_free(f);
+    free(guesses);
+    free(params);
+    free(results);
+}
+
+int main() {
+    printf("=========================================\n");
+    printf("  FluxParser - Dual Number Tests\n");
+    printf("=========================================\n");
+
+    test_tree_and_vm();
+    test_newton();
+    test_batch();
+
+    return test_report();
+}
@@ -0,0 +1,289 @@
+/*
+ * FluxParser - Research-Grade C Math Parser
+ * Copyright (C) 2025 Eduardo Stern
+ *
+ * Dual Licensed:
+ * - GPL-3.0 for open-source/non-commercial use
+ * - Commercial license available - see LICENSE-COMMERCIAL.md
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * Numerical integration engine tests: the worker pool, batched
+ * Newton-Cotes rules, adaptive Gauss-Kronrod and multi-dimensional
+ * cubature and Sobol accuracy, error estimates, evaluation counts and
+ * reproducibility across threads.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <pthread.h>
+#include "ast.h"
+#include "threadpool.h"
+#include "test_common.h"
+
+typedef struct {
+    ThreadPool *pool;
+    long *slots;
+} PoolJob;
+
+static void square_index(void *arg, size_t i) {
+    PoolJob *job = arg;
+    job->slots[i] = (long)i * (long)i;
+}
+
+static void nested_index(void *arg, size_t i) {
+    PoolJob *job = arg;
+    long local[4] = {0};
+    PoolJob inner = {.pool = job->pool, .slots = local};
+    thread_pool_for(job->pool, 4, square_index, &inner);   /* Runs serially */
+    job->slots[i] = local[3];
+}
+
+static void test_thread_pool() {
+    printf("\n=== Thread Pool ===\n");
+
+    ThreadPool *pool = thread_pool_create(4);
+    check(pool && thread_pool_size(pool) == 4, "pool has the requested size");
+
+    enum { N = 10000 };
+    long *slots = calloc(N, sizeof(long));
+    PoolJob job = {.pool = pool, .slots = slots};
+    bool ok = true;
+    for (int round = 0; round < 50 && ok; round++) {
+        memset(slots, 0, sizeof(long) * N);
+        thread_pool_for(pool, N, square_index, &job);
+        for (long i = 0; i < N && ok; i++) ok = slots[i] == i * i;
+    }
+    check(ok, "every index runs exactly once, loop after loop");
+
+    thread_pool_for(pool, 64, nested_index, &job);
+    ok = true;
+    for (int i = 0; i < 64; i++) ok = ok && slots[i] == 9;
+    check(ok, "a loop started from inside a task runs on that thread");
+
+    memset(slots, 0, sizeof(long) * N);
+    thread_pool_for(NULL, 100, square_index, &job);
+    check(slots[99] == 99 * 99 && thread_pool_size(NULL) == 1, "NULL pool runs on the caller");
+    check(thread_pool_shared() == thread_pool_shared() && thread_pool_size(thread_pool_shared()) >= 1,
+          "shared pool is created once");
+
+    thread_pool_destroy(pool);
+    free(slots);
+}
+
+static void test_newton_cotes() {
+    printf("\n=== Batched Newton-Cotes ===\n");
+
+    ParserErrorInfo error;
+    ASTNode *f = parse_expression_ast("x^2", &error);
+    check(close_to(ast_integrate_numerical_trapezoidal(f, "X", 0.0, 1.0, 1000), 1.0 / 3.0, 1e-6) &&
+          close_to(ast_integrate_numerical_simpson(f, "X", 0.0, 1.0, 100), 1.0 / 3.0, 1e-14),
+          "small step counts keep their accuracy");
+
+    /* Many chunks: spread over the pool */
+    ASTNode *g = parse_expression_ast("sin(x) * exp(-x / 10)", &error);
+    double exact = (10.0 / 101.0) * (10.0 - exp(-M_PI / 10.0) * (-10.0));   /* ∫0^π e^{-x/10} sin x dx */
+    double simpson = ast_integrate_numerical_simpson(g, "X", 0.0, M_PI, 2000000);
+    check(close_to(simpson, exact, 1e-12), "two million Simpson steps");
+    check(ast_integrate_numerical_simpson(g, "X", 0.0, M_PI, 2000000) == simpson,
+          "repeated runs give identical sums");
+
+    check(ast_integrate_numerical_trapezoidal(f, "X", 0.0, 1.0, 0) == 0.0 &&
+          close_to(ast_integrate_numerical_simpson(f, "X", 1.0, 0.0, 100), -1.0 / 3.0, 1e-14),
+          "no steps gives 0, reversed limits flip the sign");
+    ast_free(f);
+    ast_free(g);
+}
+
+static void test_adaptive() {
+    printf("\n=== Adaptive Gauss-Kronrod ===\n");
+
+    ParserErrorInfo error;
+    ASTNode *f = parse_expression_ast("exp(x)", &error);
+    IntegrationResult r = ast_integrate_adaptive(f, "X", 0.0, 1.0, 1e-12, 1e-12, 0);
+    check(r.converged && close_to(r.value, M_E - 1.0, 1e-14) && r.evaluations == 15,
+          "smooth integrand: one 15-point rule is enough");
+    ast_free(f);
+
+    /* Runge function: needs refinement near the peak */
+    f = parse_expression_ast("1 / (1 + 25 * x^2)", &error);
+    r = ast_integrate_adaptive(f, "X", -1.0, 1.0, 1e-12, 0.0, 0);
+    double exact = 2.0 * atan(5.0) / 5.0;
+    check(r.converged && fabs(r.value - exact) <= fmax(r.error_estimate, 1e-15) && r.intervals > 1,
+          "error estimate bounds the true error");
+    check(r.evaluations < 1000, "Runge function to 1e-12 in under 1000 evaluations");
+    double simpson = ast_integrate_numerical_simpson(f, "X", -1.0, 1.0, 1000);
+    check(fabs(simpson - exact) > fabs(r.value - exact), "(Simpson with 1001 points is less accurate)");
+    ast_free(f);
+
+    /* Endpoint singularity in the derivative */
+    f = parse_expression_ast("sqrt(x)", &error);
+    r = ast_integrate_adaptive(f, "X", 0.0, 1.0, 1e-10, 0.0, 0);
+    check(r.converged && close_to(r.value, 2.0 / 3.0, 1e-10), "sqrt(x) on [0, 1]");
+
+    r = ast_integrate_adaptive(f, "X", 0.0, 1.0, 1e-15, 0.0, 4);
+    check(!r.converged && r.intervals == 4 && r.error_estimate > 0.0, "interval cap stops refinement");
+    ast_free(f);
+
+    /* Oscillatory over a long range */
+    f = parse_expression_ast("sin(x)^2", &error);
+    r = ast_integrate_adaptive(f, "X", 0.0, 100.0, 1e-10, 1e-12, 0);
+    check(r.converged && close_to(r.value, 50.0 - sin(200.0) / 4.0, 1e-10), "sin(x)^2 over [0, 100]");
+    check(close_to(ast_integrate_numerical(f, "X", 0.0, 100.0, 1000, INTEGRATE_GAUSS_KRONROD), r.value, 1e-10),
+          "available through ast_integrate_numerical()");
+
+    r = ast_integrate_adaptive(f, "X", 2.0, 2.0, 1e-10, 0.0, 0);
+    check(r.converged && r.value == 0.0 && r.evaluations == 0, "empty interval");
+    ast_free(f);
+
+    f = parse_expression_ast("x * y", &error);
+    r = ast_integrate_adaptive(f, "X", 0.0, 1.0, 1e-10, 0.0, 0);
+    check(r.converged && r.value == 0.0, "other variables read 0");
+    ast_free(f);
+}
+
+static void test_cubature() {
+    printf("\n=== Multi-Dimensional Cubature ===\n");
+
+    static const char *names[INTEGRATE_MAX_DIMS] = {"X", "Y", "Z", "W", "U", "V", "P", "Q", "R", "S"};
+    double lower[INTEGRATE_MAX_DIMS], upper[INTEGRATE_MAX_DIMS];
+    for (int d = 0; d < INTEGRATE_MAX_DIMS; d++) {
+        lower[d] = 0.0;
+        upper[d] = 1.0;
+    }
+
+    /* Degree 7 is integrated exactly by a single region */
+    ParserErrorInfo error;
+    ASTNode *f = parse_expression_ast("x^3 * y^2 * z^2 + x * y", &error);
+    IntegrationResult r = ast_integrate_multi(f, names, lower, upper, 3, 1e-15, 0.0, 33, CUBATURE_ADAPTIVE);
+    check(close_to(r.value, 1.0 / 36.0 + 0.25, 1e-14) && r.intervals == 1 && r.evaluations == 1 + 12 + 12 + 8,
+          "degree-7 polynomial in one Genz-Malik region");
+    ast_free(f);
+
+    /* Gaussian over a 4-D box: refinement follows the peak */
+    f = parse_expression_ast("exp(-(x * x + y * y + z * z + w * w))", &error);
+    double lo4[4] = {-2, -2, -2, -2}, hi4[4] = {2, 2, 2, 2};
+    double exact = pow(sqrt(M_PI) * erf(2.0), 4);
+    r = ast_integrate_multi(f, names, lo4, hi4, 4, 0.0, 1e-5, 0, CUBATURE_ADAPTIVE);
+    check(r.converged && r.intervals > 1 && fabs(r.value - exact) <= fmax(r.error_estimate, 1e-15),
+          "4-D Gaussian within the error estimate");
+    r = ast_integrate_multi(f, names, lo4, hi4, 4, 0.0, 1e-12, 50000, CUBATURE_ADAPTIVE);
+    check(!r.converged && r.evaluations <= 50000 && r.evaluations > 50000 - 2 * 57, "evaluation budget stops cubature");
+    IntegrationResult q = ast_integrate_multi(f, names, lo4, hi4, 4, 0.0, 1e-4, 0, CUBATURE_SOBOL);
+    check(q.converged && fabs(q.value - exact) <= 5.0 * q.error_estimate && q.intervals >= 2048,
+          "4-D Gaussian with Sobol points");
+    ast_free(f);
+
+    /* Ten dimensions: one region (1245 points), and Sobol */
+    f = parse_expression_ast("x*x + y*y + z*z + w*w + u*u + v*v + p*p + q*q + r*r + s*s", &error);
+    r = ast_integrate_multi(f, names, lower, upper, 10, 1e-10, 0.0, 0, CUBATURE_ADAPTIVE);
+    check(r.converged && close_to(r.value, 10.0 / 3.0, 1e-13) && r.evaluations == 1245, "10-D quadratic");
+    q = ast_integrate_multi(f, names, lower, upper, 10, 0.0, 1e-5, 0, CUBATURE_SOBOL);
+    check(q.converged && fabs(q.value - 10.0 / 3.0) <= 5.0 * q.error_estimate, "10-D quadratic with Sobol points");
+    ast_free(f);
+
+    /* Product of exponentials in 6-D */
+    f = parse_expression_ast("exp(x + y + z + w + u + v)", &error);
+    exact = pow(M_E - 1.0, 6);
+    q = ast_integrate_multi(f, names, lower, upper, 6, 0.0, 1e-5, 0, CUBATURE_SOBOL);
+    check(q.converged && close_to(q.value, exact, 1e-5), "6-D exponential with Sobol points");
+    r = ast_integrate_multi(f, names, lower, upper, 6, 0.0, 1e-6, 20000, CUBATURE_SOBOL);
+    check(!r.converged && r.evaluations <= 20000 && r.evaluations > 0, "evaluation budget stops Sobol");
+    ast_free(f);
+
+    /* Non-smooth: the indicator of the unit disc */
+    f = parse_expression_ast("(x * x + y * y < 1)", &error);
+    double lo2[2] = {-1, -1}, hi2[2] = {1, 1};
+    q = ast_integrate_multi(f, names, lo2, hi2, 2, 1e-3, 0.0, 0, CUBATURE_SOBOL);
+    check(q.converged && fabs(q.value - M_PI) < 5e-3, "area of the unit disc by Sobol points");
+    ast_free(f);
+
+    /* Edge cases */
+    f = parse_expression_ast("x * y + sin(x)", &error);
+    r = ast_integrate_multi(f, names, lower, upper, 1, 1e-12, 0.0, 0, CUBATURE_ADAPTIVE);
+    IntegrationResult gk = ast_integrate_adaptive(f, "X", 0.0, 1.0, 1e-12, 0.0, 1000000 / 15);
+    check(r.value == gk.value && r.evaluations == gk.evaluations, "one dimension is Gauss-Kronrod");
+    double from[2] = {0.0, 1.0}, to[2] = {1.0, 0.0}, zeros[2] = {0.0, 0.0};
+    r = ast_integrate_multi(f, names, lower, upper, 2, 1e-12, 0.0, 0, CUBATURE_ADAPTIVE);
+    q = ast_integrate_multi(f, names, from, to, 2, 1e-12, 0.0, 0, CUBATURE_ADAPTIVE);
+    check(close_to(q.value, -r.value, 1e-14), "reversed limits flip the sign");
+    q = ast_integrate_multi(f, names, zeros, zeros, 2, 1e-12, 0.0, 0, CUBATURE_SOBOL);
+    check(q.converged && q.value == 0.0 && q.evaluations == 0, "empty box");
+    r = ast_integrate_multi(f, names, lower, upper, INTEGRATE_MAX_DIMS + 1, 1e-6, 0.0, 0, CUBATURE_SOBOL);
+    q = ast_integrate_multi(f, names, lower, upper, 0, 1e-6, 0.0, 0, CUBATURE_ADAPTIVE);
+    check(!r.converged && !q.converged && r.evaluations == 0 && q.evaluations == 0, "invalid dimensions");
+    ast_free(f);
+}
+
+#define NUM_THREADS 4
+
+static void *integrate_thread(void *arg) {
+    IntegrationResult *out = arg;
+    ParserErrorInfo error;
+    ASTNode *f = parse_expression_ast("abs(sin(30 * x)) * exp(-x)", &error);
+    *out = ast_integrate_adaptive(f, "X", 0.0, 10.0, 1e-11, 0.0, 20000);
+    ast_free(f);
+    return NULL;
+}
+
+static void *cubature_thread(void *arg) {
+    IntegrationResult *out = arg;
+    static const char *names[3] = {"X", "Y", "Z"};
+    double lower[3] = {0, 0, 0}, upper[3] = {3, 3, 3};
+    ParserErrorInfo error;
+    ASTNode *f = parse_expression_ast("abs(sin(4 * x * y)) * exp(-z)", &error);
+    out[0] = ast_integrate_multi(f, names, lower, upper, 3, 1e-6, 0.0, 0, CUBATURE_ADAPTIVE);
+    out[1] = ast_integrate_multi(f, names, lower, upper, 3, 1e-5, 0.0, 0, CUBATURE_SOBOL);
+    ast_free(f);
+    return NULL;
+}
+
+static void test_reproducible() {
+    printf("\n=== Reproducibility ===\n");
+
+    /* Kinks need many intervals: large batches go to the pool */
+    IntegrationResult single;
+    integrate_thread(&single);
+    check(single.converged && single.intervals > 100, "kinked integrand refines to many intervals");
+
+    /* Concurrent callers find the shared pool busy and run serially */
+    pthread_t threads[NUM_THREADS];
+    IntegrationResult results[NUM_THREADS];
+    for (int t = 0; t < NUM_THREADS; t++) pthread_create(&threads[t], NULL, integrate_thread, &results[t]);
+    bool same = true;
+    for (int t = 0; t < NUM_THREADS; t++) {
+        pthread_join(threads[t], NULL);
+        same = same && results[t].value == single.value && results[t].evaluations == single.evaluations;
+    }
+    check(same, "same bits with or without the pool");
+
+    IntegrationResult cube[2];
+    cubature_thread(cube);
+    check(cube[0].intervals > 100 && cube[1].intervals > 2048, "kinked 3-D integrand needs many points");
+    IntegrationResult cubes[NUM_THREADS][2];
+    for (int t = 0; t < NUM_THREADS; t++) pthread_create(&threads[t], NULL, cubature_thread, cubes[t]);
+    same = true;
+    for (int t = 0; t < NUM_THREADS; t++) {
+        pthread_join(threads[t], NULL);
+        for (int m = 0; m < 2; m++) {
+            same = same && cubes[t][m].value == cube[m].value && cubes[t][m].evaluations == cube[m].evaluations;
+        }
+    }
+    check(same, "cubature and Sobol give the same bits with or without the pool");
+}
+
+int main() {
+    printf("=========================================\n");
+    printf("  FluxParser - Numerical Integration Tests\n");
+    printf("=========================================\n");
+
+    test_thread_pool();
+    test_newton_cotes();
+    test_adaptive();
+    test_cubature();
+    test_reproducible();
+
+    return test_report();
+}
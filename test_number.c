@@ -0,0 +1,189 @@
+/*
+ * FluxParser - Research-Grade C Math Parser
+ * Copyright (C) 2025 Eduardo Stern
+ *
+ * Dual Licensed:
+ * - GPL-3.0 for open-source/non-commercial use
+ * - Commercial license available - see LICENSE-COMMERCIAL.md
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * Number scanning tests: number_parse() against strtod() on edge cases and
+ * random inputs, numeric literals in the tokenizer, and delimited lines
+ * scanned into columns by number_scan_lines().
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+#include "number.h"
+#include "parser.h"
+#include "test_common.h"
+
+/* Same bits and same length as strtod() on the whole string */
+static bool matches_strtod(const char *text) {
+    char *stop;
+    double expected = strtod(text, &stop);
+    double value;
+    const char *end = number_parse(text, text + strlen(text), &value);
+    if (end != stop) return false;
+    if (isnan(expected)) return isnan(value);
+    return memcmp(&expected, &value, sizeof(double)) == 0;
+}
+
+static void test_edge_cases() {
+    printf("\n=== Edge Cases ===\n");
+
+    static const char *cases[] = {
+        "0", "-0", "1", "0.1", "0.2", "0.3", "3.141592653589793", "1e308", "1.7976931348623157e308",
+        "1.7976931348623158e308", "1.8e308", "4.9406564584124654e-324", "2.4703282292062328e-324",
+        "2.4703282292062327e-324", "2.2250738585072011e-308", "2.2250738585072014e-308", "1e-400",
+        "1e400", "9007199254740993", "9007199254740992.5", "123456789012345678901234567890",
+        "0.000000000000000000000000000001", "7.2057594037927933e16", "1e23", "8.533e-309",
+        "179769313486231580793728971405301e276", ".5", "5.", "1.e5", "+2.5", "1e", "1e+", "2.5E-3x",
+        "0x1p-1074", "0x1.fffffffffffffp1023", "0X1A", "inf", "-Infinity", "nan", "NaN(123)",
+        "00000000000000000000000000001.5", "1.00000000000000011102230246251565404236316680908203125",
+        "1.00000000000000011102230246251565404236316680908203124", "4503599627370496.5",
+        "4503599627370497.5", "1448997445238699", "5e-324", "1e-323",
+    };
+    int count = (int)(sizeof(cases) / sizeof(cases[0]));
+    int same = 0;
+    for (int i = 0; i < count; i++) {
+        if (matches_strtod(cases[i])) {
+            same++;
+        } else {
+            printf("    mismatch on %s\n", cases[i]);
+        }
+    }
+    check(same == count, "edge cases match strtod");
+
+    double value = 1.0;
+    const char *text = "abc";
+    check(number_parse(text, text + 3, &value) == text && value == 0.0, "no number returns the start");
+    text = "-.e1";
+    check(number_parse(text, text + 4, &value) == text, "sign and point alone are not a number");
+
+    /* The end bound is honoured without a terminator */
+    text = "12345";
+    check(number_parse(text, text + 3, &value) == text + 3 && value == 123.0, "parsing stops at the end bound");
+    text = "1.5e10";
+    check(number_parse(text, text + 4, &value) == text + 3 && value == 1.5, "cut exponent is not consumed");
+}
+
+static uint64_t rng_state = 0x9E3779B97F4A7C15ULL;
+
+static uint64_t next_random(void) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 7;
+    rng_state ^= rng_state << 17;
+    return rng_state;
+}
+
+static void test_random() {
+    printf("\n=== Random Inputs ===\n");
+
+    /* Shortest and longest representations of random doubles */
+    char text[64];
+    int same = 0, total = 0;
+    for (int i = 0; i < 200000; i++) {
+        uint64_t bits = next_random();
+        double d;
+        memcpy(&d, &bits, sizeof(d));
+        if (!isfinite(d)) continue;
+        snprintf(text, sizeof(text), (i & 1) ? "%.17g" : "%.15g", d);
+        same += matches_strtod(text);
+        total++;
+    }
+    check(same == total, "random doubles match strtod");
+
+    /* Random digit strings with random decimal exponents */
+    same = 0;
+    total = 0;
+    for (int i = 0; i < 200000; i++) {
+        int digits = 1 + (int)(next_random() % 25);
+        int n = 0;
+        for (int k = 0; k < digits; k++) {
+            if (k == 1) text[n++] = '.';
+            text[n++] = (char)('0' + next_random() % 10);
+        }
+        n += snprintf(text + n, sizeof(text) - (size_t)n, "e%d", (int)(next_random() % 700) - 350);
+        same += matches_strtod(text);
+        total++;
+    }
+    check(same == total, "random digit strings match strtod");
+}
+
+static void test_tokenizer() {
+    printf("\n=== Numeric Literals ===\n");
+
+    ParseResult r = parse_expression_safe("0.1 + 0.2");
+    check(!r.has_error && r.value == 0.1 + 0.2, "decimal literals are correctly rounded");
+
+    r = parse_expression_safe("3.14159265358979323846264338327950288 * 2");
+    check(!r.has_error && r.value == 2 * 3.141592653589793, "long literal rounds to the nearest double");
+
+    r = parse_expression_safe("1e400");
+    check(!r.has_error && isinf(r.value), "overflowing literal is infinite");
+
+    r = parse_expression_safe("2.5e-3*4");
+    check(!r.has_error && r.value == 0.01, "exponent is part of the literal");
+
+    r = parse_expression_safe(".5 + 5.");
+    check(!r.has_error && r.value == 5.5, "leading and trailing points");
+
+    r = parse_expression_safe("2e");
+    check(r.has_error, "incomplete exponent is not absorbed");
+}
+
+static void test_scan_lines() {
+    printf("\n=== Scanning Lines ===\n");
+
+    double a[8], b[8], c[8];
+    double *columns[3] = {a, b, c};
+    NumberScanFormat csv = {.delimiter = ',', .field_count = 3, .wanted = NULL};
+
+    const char *text = "1,2,3\r\n\n \t \r\n 4 , 5.5 ,-6\n7,x,9\n  \n10,11\n";
+    size_t bad = 0;
+    const char *next = NULL;
+    size_t rows = number_scan_lines(text, text + strlen(text), &csv, columns, 8, &next, &bad);
+    check(rows == 4 && next == text + strlen(text), "blank lines are skipped");
+    check(a[0] == 1 && b[0] == 2 && c[0] == 3, "CRLF line scans");
+    check(a[1] == 4 && b[1] == 5.5 && c[1] == -6, "spaces around fields are ignored");
+    check(isnan(b[2]) && c[2] == 9 && isnan(c[3]) && bad == 2, "bad and missing fields are NaN and counted");
+
+    bool wanted[3] = {false, true, false};
+    NumberScanFormat some = {.delimiter = ';', .field_count = 3, .wanted = wanted};
+    double *only[3] = {NULL, b, NULL};
+    text = "junk;1.25;junk\nx;2.5;y";
+    bad = 0;
+    rows = number_scan_lines(text, text + strlen(text), &some, only, 8, NULL, &bad);
+    check(rows == 2 && b[0] == 1.25 && b[1] == 2.5 && bad == 0, "only wanted fields are converted");
+
+    NumberScanFormat blanks = {.delimiter = NUMBER_SCAN_BLANKS, .field_count = 2, .wanted = NULL};
+    text = "  1\t\t2  \n3 4\n5 6\n";
+    rows = number_scan_lines(text, text + strlen(text), &blanks, columns, 2, &next, NULL);
+    check(rows == 2 && a[0] == 1 && b[0] == 2 && a[1] == 3 && b[1] == 4, "runs of blanks separate fields");
+    check(next == strstr(text, "5 6"), "scanning stops after max_rows");
+
+    NumberScanFormat tsv = {.delimiter = '\t', .field_count = 2, .wanted = NULL};
+    text = "\t2\n \t \n3\t4\n";
+    bad = 0;
+    rows = number_scan_lines(text, text + strlen(text), &tsv, columns, 8, NULL, &bad);
+    check(rows == 2 && isnan(a[0]) && b[0] == 2 && a[1] == 3 && b[1] == 4 && bad == 1,
+          "leading tab is a delimiter, tab-only line is blank");
+}
+
+int main() {
+    printf("=========================================\n");
+    printf("  FluxParser - Number Scanning Tests\n");
+    printf("=========================================\n");
+
+    test_edge_cases();
+    test_random();
+    test_tokenizer();
+    test_scan_lines();
+
+    return test_report();
+}
@@ -233,9 +233,10 @@ void test_complex_expression() {
 
     /* Also test via bytecode */
     Bytecode *bc = ast_compile(expr);
+    bytecode_bind(bc, &ctx);
     VM *vm = vm_create(&ctx);
     float vm_result = vm_execute(vm, bc);
-    printf("  Bytecode VM result: %.2f\n", vm_result);
+    printf("  Bytecode VM result: %.2f (expected 5.00)\n", vm_result);
 
     vm_free(vm);
     bytecode_free(bc);
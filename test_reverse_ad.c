@@ -0,0 +1,216 @@
+/*
+ * FluxParser - Research-Grade C Math Parser
+ * Copyright (C) 2025 Eduardo Stern
+ *
+ * Dual Licensed:
+ * - GPL-3.0 for open-source/non-commercial use
+ * - Commercial license available - see LICENSE-COMMERCIAL.md
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * Reverse-mode differentiation tests: gradient programs must agree with
+ * ast_gradient() and finite differences, follow the evaluator's edge-case
+ * conventions, and drive the ast_minimize() optimizers to the same minima.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "ast.h"
+#include "test_common.h"
+
+static const char *xyz[] = {"X", "Y", "Z"};
+
+/* Value and gradient of expr at values, against ast_evaluate/ast_gradient */
+static bool matches_symbolic(const char *expr, const double *values, double tol) {
+    ParserErrorInfo error;
+    ASTNode *f = parse_expression_ast(expr, &error);
+    GradientProgram *gp = gradient_program_create(f, xyz, 3);
+    if (!f || !gp) return false;
+
+    VarMapping mappings[3] = {{"X", 0}, {"Y", 1}, {"Z", 2}};
+    VarContext ctx = {.values = (double *)values, .count = 3, .mappings = mappings, .mapping_count = 3};
+    Gradient grad = ast_gradient(f, xyz, 3);
+    double *expected = gradient_evaluate(&grad, &ctx);
+
+    double g[3];
+    bool ok = close_to(gradient_program_evaluate(gp, values, g), ast_evaluate(f, &ctx), tol);
+    for (int i = 0; i < 3; i++) ok = ok && close_to(g[i], expected[i], tol);
+
+    free(expected);
+    gradient_free(&grad);
+    gradient_program_free(gp);
+    ast_free(f);
+    return ok;
+}
+
+/* Gradient of a one-variable expression at x against a central difference */
+static bool matches_difference(const char *expr, double x) {
+    ParserErrorInfo error;
+    ASTNode *f = parse_expression_ast(expr, &error);
+    GradientProgram *gp = gradient_program_create(f, xyz, 1);
+    if (!f || !gp) return false;
+
+    const double h = 1e-6;
+    double lo = x - h, hi = x + h, g;
+    double slope = (gradient_program_evaluate(gp, &hi, NULL) - gradient_program_evaluate(gp, &lo, NULL)) / (2 * h);
+    gradient_program_evaluate(gp, &x, &g);
+
+    gradient_program_free(gp);
+    ast_free(f);
+    return close_to(g, slope, 1e-6);
+}
+
+static void test_agreement() {
+    printf("\n=== Agreement With ast_gradient() ===\n");
+
+    static const char *exprs[] = {
+        "x^2 * y + sin(x * z) - exp(y / z)",
+        "ln(x^2 + y^2 + 1) * sqrt(z) - cos(x) * tan(y)",
+        "(x - y)^3 / (1 + z * z) + x * y * z",
+        "x ^ y * 10 ^ z - -x",
+    };
+    double point[3] = {0.7, -1.3, 1.9};
+    bool ok = true;
+    for (size_t i = 0; i < sizeof(exprs) / sizeof(exprs[0]); i++) {
+        ok = ok && matches_symbolic(exprs[i], point, 1e-12);
+    }
+    check(ok, "value and gradient match at a point");
+
+    bool sweep = true;
+    for (double t = -2.0; t <= 2.0; t += 0.25) {
+        double p[3] = {t, 1.0 - t, 0.5 + t * t};
+        sweep = sweep && matches_symbolic("x * sin(y) + y * cos(z) + z * exp(-x * x)", p, 1e-12);
+    }
+    check(sweep, "match over a sweep of points");
+
+    check(matches_symbolic("5 * 3 + 2", point, 0.0), "constant expression has zero gradient");
+}
+
+static void test_functions() {
+    printf("\n=== Function Derivatives ===\n");
+
+    check(matches_difference("asin(x / 2) + acos(x / 3)", 0.4) &&
+          matches_difference("log10(x) * ln(x)", 1.7) &&
+          matches_difference("abs(x - 1) * x", 0.3), "inverse trig, logarithms, abs");
+    check(matches_difference("pow(x, 3) + pow(2, x)", 1.2) &&
+          matches_difference("x ^ x", 1.3), "power with variable base and exponent");
+    check(matches_difference("atan(x * x)", 0.7), "atan (which ast_differentiate() treats as constant)");
+    check(matches_difference("atan2(x, 2) + atan2(1, x)", 0.8), "atan2 in both arguments");
+    check(matches_difference("mod(x * 7, 3) + mod(5, x)", 1.1), "mod in both arguments");
+    check(matches_difference("min(x * x, 2) + max(x, 1 - x)", 0.9) &&
+          matches_difference("min(x * x, 2) + max(x, 1 - x)", 1.6), "min and max follow the branch taken");
+
+    /* Piecewise-constant pieces contribute nothing */
+    ParserErrorInfo error;
+    ASTNode *f = parse_expression_ast("floor(x) + ceil(x) + round(x) + int(x) + sgn(x) + (x > 1) + 3 * x", &error);
+    GradientProgram *gp = gradient_program_create(f, xyz, 1);
+    double x = 1.4, g;
+    gradient_program_evaluate(gp, &x, &g);
+    check(g == 3.0, "piecewise-constant functions and comparisons have zero derivative");
+    gradient_program_free(gp);
+    ast_free(f);
+}
+
+static void test_conventions() {
+    printf("\n=== Evaluator Conventions ===\n");
+
+    ParserErrorInfo error;
+    ASTNode *f = parse_expression_ast("x / (y - 1) + sqrt(y - 1) + w", &error);
+    GradientProgram *gp = gradient_program_create(f, xyz, 2);
+    double at_pole[2] = {3.0, 1.0}, g[2];
+    double value = gradient_program_evaluate(gp, at_pole, g);
+    check(value == 0.0 && g[0] == 0.0 && g[1] == 0.0,
+          "division by zero gives zero value and derivative, unlisted W reads 0");
+    gradient_program_free(gp);
+    ast_free(f);
+
+    check(gradient_program_create(NULL, xyz, 1) == NULL &&
+          gradient_program_create(f = parse_expression_ast("x", &error), NULL, 2) == NULL,
+          "invalid arguments give NULL");
+    ast_free(f);
+}
+
+static void test_sharing() {
+    printf("\n=== Shared Subexpressions ===\n");
+
+    /* s appears many times: CSE computes it once and its adjoint sums every use */
+    ParserErrorInfo error;
+    ASTNode *f = parse_expression_ast(
+        "sin(x * y + z) * sin(x * y + z) + exp(sin(x * y + z)) - sin(x * y + z) / (1 + sin(x * y + z) ^ 2)",
+        &error);
+    GradientProgram *gp = gradient_program_create(f, xyz, 3);
+    double p[3] = {0.4, 1.1, -0.2}, g[3];
+    gradient_program_evaluate(gp, p, g);
+
+    double s = sin(p[0] * p[1] + p[2]), c = cos(p[0] * p[1] + p[2]);
+    double outer = 2 * s + exp(s) - (1 - s * s) / ((1 + s * s) * (1 + s * s));
+    check(close_to(g[0], outer * c * p[1], 1e-12) && close_to(g[1], outer * c * p[0], 1e-12) &&
+          close_to(g[2], outer * c, 1e-12), "shared subexpression accumulates its adjoint");
+    check(gradient_program_size(gp) < 25, "shared subexpression is taped once");
+    gradient_program_free(gp);
+    ast_free(f);
+
+    /* Hash-consed roots work directly */
+    ASTDag *dag = ast_dag_create();
+    f = parse_expression_ast("x * exp(x)", &error);
+    ASTNode *d2 = ast_dag_differentiate(dag, ast_dag_differentiate(dag, f, "X"), "X");
+    gp = gradient_program_create(d2, xyz, 1);
+    double x = 0.6, g3;
+    gradient_program_evaluate(gp, &x, &g3);
+    check(close_to(g3, (x + 3) * exp(x), 1e-12), "third derivative through a DAG root");
+    gradient_program_free(gp);
+    ast_free(f);
+    ast_dag_destroy(dag);
+}
+
+static void test_optimizers() {
+    printf("\n=== Optimizers ===\n");
+
+    ParserErrorInfo error;
+    ASTNode *f = parse_expression_ast("(x - 3)^2 + (y + 1)^2 + 0.5 * x * y", &error);
+    const char *vars[] = {"X", "Y"};
+    double start[2] = {0.0, 0.0};
+    /* Minimum where 2(x-3) + y/2 = 0 and 2(y+1) + x/2 = 0 */
+    double x_min = 52.0 / 15.0, y_min = -28.0 / 15.0;
+
+    static const OptimizerType types[] = {
+        OPTIMIZER_GRADIENT_DESCENT, OPTIMIZER_GRADIENT_DESCENT_MOMENTUM,
+        OPTIMIZER_ADAM,
+    };
+    bool converge = true, same = true;
+    for (size_t t = 0; t < sizeof(types) / sizeof(types[0]); t++) {
+        OptimizerConfig config = optimizer_config_default(types[t]);
+        config.max_iterations = 20000;
+        if (types[t] == OPTIMIZER_ADAM) config.learning_rate = 0.05;
+
+        OptimizationResult ad = ast_minimize(f, vars, 2, start, &config, types[t]);
+        config.symbolic_gradient = true;
+        OptimizationResult sym = ast_minimize(f, vars, 2, start, &config, types[t]);
+
+        converge = converge && fabs(ad.solution[0] - x_min) < 1e-3 && fabs(ad.solution[1] - y_min) < 1e-3;
+        same = same && ad.iterations == sym.iterations &&
+               close_to(ad.solution[0], sym.solution[0], 1e-9) && close_to(ad.solution[1], sym.solution[1], 1e-9);
+        optimization_result_free(&ad);
+        optimization_result_free(&sym);
+    }
+    check(converge, "gradient descent, momentum and Adam reach the minimum with reverse-mode gradients");
+    check(same, "same path as symbolic gradients");
+    check(!optimizer_config_default(OPTIMIZER_ADAM).symbolic_gradient, "reverse mode is the default");
+    ast_free(f);
+}
+
+int main() {
+    printf("=========================================\n");
+    printf("  FluxParser - Reverse-Mode AD Tests\n");
+    printf("=========================================\n");
+
+    test_agreement();
+    test_functions();
+    test_conventions();
+    test_sharing();
+    test_optimizers();
+
+    return test_report();
+}
@@ -0,0 +1,149 @@
+/*
+ * test_saved_tensors.c - Test the tape's saved-tensor version check:
+ * backward stops when an input it saved was modified in place after the
+ * forward pass, and never when updates follow backward
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include "autograd_v2.h"
+#include "test_common.h"
+
+typedef void (*Scenario)(void);
+
+/* Run a scenario in a child process (the check exits). Returns its exit
+ * status (-1 if it did not exit) and its stderr in message. */
+static int run_child(Scenario scenario, char *message, size_t size) {
+    int pipe_fds[2];
+    message[0] = '\0';
+    if (pipe(pipe_fds) != 0) return -1;
+
+    fflush(stdout);
+    pid_t pid = fork();
+    if (pid < 0) return -1;
+    if (pid == 0) {
+        close(pipe_fds[0]);
+        dup2(pipe_fds[1], STDERR_FILENO);
+        if (!freopen("/dev/null", "w", stdout)) _exit(2);
+        autograd_v2_init();     /* Here: worker threads do not survive fork() */
+        scenario();
+        exit(0);
+    }
+
+    close(pipe_fds[1]);
+    size_t length = 0;
+    ssize_t n;
+    while (length + 1 < size && (n = read(pipe_fds[0], message + length, size - 1 - length)) > 0) {
+        length += (size_t)n;
+    }
+    message[length] = '\0';
+    close(pipe_fds[0]);
+
+    int status;
+    if (waitpid(pid, &status, 0) != pid || !WIFEXITED(status)) return -1;
+    return WEXITSTATUS(status);
+}
+
+static VariableV2* random_parameter(int rows, int cols) {
+    int shape[] = {rows, cols};
+    return var_create_parameter(tensor_randn_persistent(shape, 2, 0.5));
+}
+
+static VariableV2* random_input(int rows, int cols) {
+    int shape[] = {rows, cols};
+    TensorV2 *t = tensor_create_temp(shape, 2);
+    for (int i = 0; i < t->size; i++) t->data[i] = (double)rand() / RAND_MAX - 0.5;
+    return var_create_temp(t, false);
+}
+
+static void seed_gradient(VariableV2 *y) {
+    for (int i = 0; i < y->grad->size; i++) y->grad->data[i] = 1.0;
+}
+
+/* optimizer_step() before tape_backward(): matmul saved W */
+static void step_before_backward(void) {
+    VariableV2 *w = random_parameter(4, 3);
+    OptimizerV2 *opt = optimizer_create(&w, 1, 0.1);
+    VariableV2 *y = ag_matmul(random_input(2, 4), w);
+    seed_gradient(y);
+    optimizer_step(opt);
+    tape_backward(g_tape);
+}
+
+/* W written while the tape holds a transposed view of it */
+static void modified_through_view(void) {
+    VariableV2 *w = random_parameter(3, 4);
+    VariableV2 *y = ag_matmul(random_input(2, 4), ag_transpose(w));
+    seed_gradient(y);
+    w->data->data[0] += 1.0;
+    tensor_mark_modified(w->data);
+    tape_backward(g_tape);
+}
+
+/* Elementwise multiply saves both operands */
+static void multiply_operand_modified(void) {
+    VariableV2 *w = random_parameter(2, 3);
+    VariableV2 *y = ag_multiply(random_input(2, 3), w);
+    seed_gradient(y);
+    tensor_mark_modified(w->data);
+    tape_backward(g_tape);
+}
+
+/* Training steps in the right order, plus writes to tensors the tape never saved */
+static void train_in_order(void) {
+    VariableV2 *params[] = {random_parameter(4, 8), random_parameter(8, 3)};
+    OptimizerV2 *opt = optimizer_create(params, 2, 0.05);
+    VariableV2 *unsaved = random_parameter(2, 2);
+
+    for (int iter = 0; iter < 20; iter++) {
+        optimizer_zero_grad(opt);
+        VariableV2 *h = ag_relu(ag_matmul(random_input(5, 4), params[0]));
+        VariableV2 *y = var_softmax_2d(ag_multiply(ag_matmul(h, params[1]), ag_matmul(h, params[1])));
+        seed_gradient(y);
+        tensor_mark_modified(unsaved->data);
+        tape_backward(g_tape);
+        optimizer_step(opt);
+        autograd_reset_iteration();
+    }
+}
+
+static void test_modified_inputs() {
+    printf("\n=== Modified Saved Inputs ===\n");
+
+    static const struct {
+        const char *name;
+        Scenario scenario;
+        const char *op;
+    } cases[] = {
+        {"optimizer_step before tape_backward stops backward", step_before_backward, "matmul backward"},
+        {"writes through a transposed view are detected", modified_through_view, "matmul backward"},
+        {"multiply checks its saved operands", multiply_operand_modified, "multiply backward"},
+    };
+
+    char message[512];
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        int status = run_child(cases[i].scenario, message, sizeof(message));
+        check(status == 1 && strstr(message, cases[i].op) && strstr(message, "modified in place"), cases[i].name);
+    }
+}
+
+static void test_no_false_positives() {
+    printf("\n=== Updates After Backward ===\n");
+
+    char message[512];
+    int status = run_child(train_in_order, message, sizeof(message));
+    check(status == 0 && !strstr(message, "modified in place"), "20 iterations of backward then step pass");
+}
+
+int main() {
+    printf("=========================================\n");
+    printf("  Autograd V2 - Saved Tensor Tests\n");
+    printf("=========================================\n");
+
+    test_modified_inputs();
+    test_no_false_positives();
+
+    return test_report();
+}
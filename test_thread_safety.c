@@ -6,6 +6,11 @@
  * 2. Use debug mode concurrently
  * 3. Use callbacks concurrently
  * 4. Change debug settings while parsing
+ * 5. Keep per-context debug levels and callbacks apart
+ *
+ * Then measures parse throughput against thread count.
+ *
+ * Usage: ./test_thread_safety [max_threads]
  */
 
 #include "parser.h"
@@ -14,6 +19,7 @@
 #include <unistd.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 
 #define NUM_THREADS 10
 #define ITERATIONS 1000
@@ -152,7 +158,161 @@ void* callback_changer_thread(void *arg) {
     return NULL;
 }
 
-int main() {
+/* Per-context test: each thread traces into its own context */
+typedef struct {
+    ParserContext *ctx;
+    int debug_messages;     /* Owned by the thread: no lock */
+    int errors_reported;
+    int wrong_results;
+} ContextJob;
+
+static bool context_error_callback(const ParserErrorInfo *error, const char *expr, void *user_data) {
+    (void)error;
+    (void)expr;
+    ((ContextJob*)user_data)->errors_reported++;
+    return false;
+}
+
+static void context_debug_callback(int level, const char *message, void *user_data) {
+    (void)level;
+    (void)message;
+    ((ContextJob*)user_data)->debug_messages++;
+}
+
+void* context_thread(void *arg) {
+    ContextJob *job = arg;
+    for (int i = 0; i < ITERATIONS; i++) {
+        ParseResult result = parser_context_evaluate(job->ctx, "2 + 3 * 4", NULL);
+        if (result.has_error || result.value != 14.0) job->wrong_results++;
+        result = parser_context_evaluate(job->ctx, "(2 + 3))", NULL);
+        if (!result.has_error) job->wrong_results++;
+    }
+    return NULL;
+}
+
+static int default_debug_messages = 0;
+
+static void default_debug_callback(int level, const char *message, void *user_data) {
+    (void)level;
+    (void)message;
+    (void)user_data;
+    __atomic_fetch_add(&default_debug_messages, 1, __ATOMIC_RELAXED);
+}
+
+static bool test_contexts(void) {
+    printf("\nPer-context debug levels and callbacks...\n");
+
+    /* The default context must stay silent while the others trace */
+    parser_set_debug_level(DEBUG_OFF);
+    parser_set_debug_callback(default_debug_callback, NULL);
+
+    pthread_t threads[NUM_THREADS];
+    ContextJob jobs[NUM_THREADS];
+    for (int i = 0; i < NUM_THREADS; i++) {
+        memset(&jobs[i], 0, sizeof(jobs[i]));
+        jobs[i].ctx = parser_context_create(NULL);
+        parser_context_set_error_callback(jobs[i].ctx, context_error_callback, &jobs[i]);
+        parser_context_set_debug_callback(jobs[i].ctx, context_debug_callback, &jobs[i]);
+        parser_context_set_debug_level(jobs[i].ctx, (i % 2) ? DEBUG_TOKENS : DEBUG_OFF);
+        pthread_create(&threads[i], NULL, context_thread, &jobs[i]);
+    }
+
+    bool ok = true;
+    for (int i = 0; i < NUM_THREADS; i++) {
+        pthread_join(threads[i], NULL);
+        bool traced = (i % 2) ? jobs[i].debug_messages > ITERATIONS : jobs[i].debug_messages == 0;
+        if (!traced || jobs[i].errors_reported != ITERATIONS || jobs[i].wrong_results != 0) {
+            printf("  context %d: %d debug messages, %d errors, %d wrong results\n", i,
+                   jobs[i].debug_messages, jobs[i].errors_reported, jobs[i].wrong_results);
+            ok = false;
+        }
+        parser_context_free(jobs[i].ctx);
+    }
+    parser_clear_debug_callback();
+
+    if (default_debug_messages != 0) {
+        printf("  default context received %d debug messages\n", default_debug_messages);
+        ok = false;
+    }
+    printf("%s\n", ok ? "✅ Contexts are independent" : "❌ Context settings leaked");
+    return ok;
+}
+
+/* Scaling benchmark: parses per second against thread count */
+#define SCALING_PARSES 200000
+
+typedef struct {
+    ParserContext *ctx;     /* NULL: uncached global API */
+    int parses;
+    double checksum;
+} ScalingJob;
+
+void* scaling_thread(void *arg) {
+    ScalingJob *job = arg;
+    static const char *exprs[] = {
+        "x * x + 2 * x * y + y * y",
+        "sin(x) * cos(y) + sqrt(x * x + y * y)",
+        "(x + 1) * (y - 2) / (x * y + 3)",
+        "max(x, y) + min(x, y) * 2 ^ 3",
+    };
+    VarMapping mappings[] = {{"X", 0}, {"Y", 1}};
+    double values[] = {1.5, 2.5};
+    VarContext vars = {.values = values, .count = 2, .mappings = mappings, .mapping_count = 2};
+
+    double sum = 0.0;
+    for (int i = 0; i < job->parses; i++) {
+        const char *expr = exprs[i & 3];
+        ParseResult r = job->ctx ? parser_context_evaluate(job->ctx, expr, &vars)
+                                 : parse_expression_ex(expr, &vars, NULL);
+        sum += r.value;
+    }
+    job->checksum = sum;
+    return NULL;
+}
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* Split SCALING_PARSES over the threads; returns parses per second */
+static double run_scaling(int thread_count, bool contexts) {
+    pthread_t threads[64];
+    ScalingJob jobs[64];
+    double start = now_seconds();
+    for (int t = 0; t < thread_count; t++) {
+        jobs[t].ctx = contexts ? parser_context_create(NULL) : NULL;
+        jobs[t].parses = SCALING_PARSES / thread_count;
+        pthread_create(&threads[t], NULL, scaling_thread, &jobs[t]);
+    }
+    for (int t = 0; t < thread_count; t++) pthread_join(threads[t], NULL);
+    double elapsed = now_seconds() - start;
+    for (int t = 0; t < thread_count; t++) parser_context_free(jobs[t].ctx);
+    return (SCALING_PARSES / thread_count) * thread_count / elapsed;
+}
+
+static void bench_scaling(int max_threads) {
+    printf("\nThroughput vs threads (%d parses, %ld CPUs online)\n", SCALING_PARSES,
+           sysconf(_SC_NPROCESSORS_ONLN));
+    printf("%8s %16s %9s %18s %9s\n", "threads", "parser parses/s", "scaling", "context+cache /s", "scaling");
+
+    double parser_base = 0.0, cached_base = 0.0;
+    for (int t = 1; t <= max_threads; t *= 2) {
+        double parser = run_scaling(t, false);
+        double cached = run_scaling(t, true);
+        if (t == 1) {
+            parser_base = parser;
+            cached_base = cached;
+        }
+        printf("%8d %16.0f %8.2fx %18.0f %8.2fx\n", t, parser, parser / parser_base, cached, cached / cached_base);
+    }
+}
+
+int main(int argc, char **argv) {
+    int max_threads = argc > 1 ? atoi(argv[1]) : 8;
+    if (max_threads < 1 || max_threads > 64) max_threads = 8;
+
     printf("╔═══════════════════════════════════════════════════════════════╗\n");
     printf("║           FluxParser Thread Safety Test                      ║\n");
     printf("╚═══════════════════════════════════════════════════════════════╝\n\n");
@@ -198,7 +358,14 @@ int main() {
     printf("Callback calls:     %d\n", callback_calls);
     printf("Expected parses:    %d\n", NUM_THREADS * ITERATIONS + NUM_THREADS * (ITERATIONS / 100));
 
+    bool contexts_ok = test_contexts();
+    bench_scaling(max_threads);
+
     int expected = NUM_THREADS * ITERATIONS + NUM_THREADS * (ITERATIONS / 100);
+    if (!contexts_ok) {
+        printf("\n❌ FAILURE: per-context settings are not independent\n\n");
+        return 1;
+    }
     if (total_parses == expected && total_errors == 0) {
         printf("\n✅ SUCCESS: All parses completed without errors!\n");
         printf("✅ Thread safety verified!\n\n");
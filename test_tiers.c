@@ -0,0 +1,266 @@
+/*
+ * FluxParser - Research-Grade C Math Parser
+ * Copyright (C) 2025 Eduardo Stern
+ *
+ * Dual Licensed:
+ * - GPL-3.0 for open-source/non-commercial use
+ * - Commercial license available - see LICENSE-COMMERCIAL.md
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * Tiered execution tests: parse_expression_ex() must return exactly what
+ * the parser returns on every tier, promote at the configured thresholds,
+ * and count calls per tier.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <pthread.h>
+#include "ast.h"
+#include "test_common.h"
+
+static bool same_result(const ParseResult *a, const ParseResult *b) {
+    if (a->has_error != b->has_error) return false;
+    if (a->error.code != b->error.code || a->error.position != b->error.position) return false;
+    if (strcmp(a->error.message, b->error.message) != 0) return false;
+    if (isnan(a->value) || isnan(b->value)) return isnan(a->value) && isnan(b->value);
+    return a->value == b->value;
+}
+
+static ParserConfig tiered(unsigned long compile_after, unsigned long jit_after) {
+    ParserConfig config = {.compile_after = compile_after, .jit_after = jit_after};
+    return config;
+}
+
+/* Every case the compiled tiers have to hand back to the parser */
+static const char *corpus[] = {
+    "2 + 3 * 4",
+    "x * x + 2 * x * y + y * y",
+    "sin(pi/4) * cos(x) + tan(y / 4) + atan2(x, y)",
+    "(x > 0 && y > 0) || !(x == y)",
+    "x / y",                    /* Division by zero when y = 0 */
+    "x / (y - y) + 1",
+    "sqrt(y) + log(x) + log10(y)",
+    "pow(y, 0.5) + mod(x, y)",  /* NaN results */
+    "e * 2",                    /* E shadowed by a variable */
+    "velocity * 2",             /* Unresolved identifier */
+    "foo(1)",                   /* Unknown function */
+    "sqrt(1, 2)",
+    "2 +",                      /* Syntax error */
+};
+
+static void test_matches_parser() {
+    printf("\n=== Tiered vs Parser ===\n");
+
+    double values[26] = {0};
+    VarContext ctx = {.values = values, .count = 26};
+    const double points[][2] = {{0.5, 2.0}, {1.25, -3.0}, {0.0, 0.0}, {-1.0, 4.0}};
+    ParserConfig plain = {0};
+    ParserConfig config = tiered(2, 4);
+
+    parser_cache_clear();
+    for (size_t i = 0; i < sizeof(corpus) / sizeof(corpus[0]); i++) {
+        bool ok = true;
+        for (int round = 0; round < 3; round++) {
+            for (size_t k = 0; k < sizeof(points) / sizeof(points[0]); k++) {
+                values['X' - 'A'] = points[k][0];
+                values['Y' - 'A'] = points[k][1];
+                values['E' - 'A'] = round == 2 ? 10.0 : 0.0;
+                ParseResult direct = parse_expression_ex(corpus[i], &ctx, &plain);
+                ParseResult tier = parse_expression_ex(corpus[i], &ctx, &config);
+                ok = ok && same_result(&direct, &tier);
+            }
+        }
+        check(ok, corpus[i]);
+    }
+
+    ParseResult r = parse_expression_ex("x * 2", NULL, &config);
+    ParseResult s = parse_expression_ex("x * 2", NULL, &config);
+    ParseResult t = parse_expression_ex("x * 2", NULL, &config);
+    check(same_result(&r, &s) && same_result(&r, &t) && parser_expression_tier("x * 2") == PARSER_TIER_PARSE,
+          "no VarContext");
+}
+
+static void test_promotion() {
+    printf("\n=== Promotion ===\n");
+
+    double values[26] = {0};
+    VarContext ctx = {.values = values, .count = 26};
+    ParserConfig config = tiered(3, 6);
+    const char *expr = "x * 3 + 1";
+
+    parser_cache_clear();
+    parser_tier_reset_stats();
+
+    bool tiers_ok = true;
+    for (int call = 1; call <= 10; call++) {
+        values['X' - 'A'] = call;
+        ParseResult r = parse_expression_ex(expr, &ctx, &config);
+        tiers_ok = tiers_ok && !r.has_error && r.value == call * 3 + 1;
+
+        ParserTier expected = call < 3 ? PARSER_TIER_PARSE
+                            : call < 6 || !jit_supported() ? PARSER_TIER_BYTECODE : PARSER_TIER_JIT;
+        tiers_ok = tiers_ok && parser_expression_tier(expr) == expected;
+    }
+    check(tiers_ok, "promoted after compile_after and jit_after calls");
+
+    ParserTierStats stats;
+    parser_tier_get_stats(&stats);
+    check(stats.parse_calls == 3, "first calls use the parser");
+    check(stats.bytecode_promotions == 1, "one bytecode promotion");
+    if (jit_supported()) {
+        check(stats.bytecode_calls == 3 && stats.jit_calls == 4, "later calls counted per tier");
+        check(stats.jit_promotions == 1, "one JIT promotion");
+    } else {
+        check(stats.bytecode_calls == 7 && stats.jit_calls == 0, "later calls counted per tier");
+        check(stats.jit_promotions == 0, "no JIT on this platform");
+    }
+    check(stats.deopts == 0, "no guard failures");
+
+    /* Thresholds of zero */
+    parser_tier_reset_stats();
+    ParserConfig off = tiered(0, 6);
+    for (int i = 0; i < 10; i++) parse_expression_ex("1 + 2", &ctx, &off);
+    parser_tier_get_stats(&stats);
+    check(stats.parse_calls == 0 && stats.bytecode_calls == 0, "compile_after 0 disables tiering");
+
+    ParserConfig no_jit = tiered(1, 0);
+    for (int i = 0; i < 10; i++) parse_expression_ex("2 + y", &ctx, &no_jit);
+    check(parser_expression_tier("2 + y") == PARSER_TIER_BYTECODE, "jit_after 0 stays on bytecode");
+}
+
+static void test_deopts() {
+    printf("\n=== Guards ===\n");
+
+    double values[26] = {0};
+    VarContext ctx = {.values = values, .count = 26};
+    ParserConfig config = tiered(1, 0);
+
+    parser_cache_clear();
+    values['X' - 'A'] = 6.0;
+    values['Y' - 'A'] = 3.0;
+    parse_expression_ex("x / y", &ctx, &config);
+
+    parser_tier_reset_stats();
+    values['Y' - 'A'] = 0.0;
+    ParseResult r = parse_expression_ex("x / y", &ctx, &config);
+    ParserTierStats stats;
+    parser_tier_get_stats(&stats);
+    check(r.value == 6.0 && stats.deopts == 1 && stats.parse_calls == 1,
+          "division by zero goes back to the parser");
+
+    values['Y' - 'A'] = 2.0;
+    r = parse_expression_ex("x / y", &ctx, &config);
+    parser_tier_get_stats(&stats);
+    check(r.value == 3.0 && stats.bytecode_calls == 1, "next call runs compiled again");
+
+    /* Compiled code is bound to the layout seen at promotion */
+    double ab[2] = {4.0, 0.5};
+    VarContext small = {.values = ab, .count = 2};
+    parse_expression_ex("a * b", &ctx, &config);
+    parser_tier_reset_stats();
+    r = parse_expression_ex("a * b", &small, &config);
+    parser_tier_get_stats(&stats);
+    check(r.value == 2.0 && stats.deopts == 1 && stats.parse_calls == 1,
+          "another layout uses the parser");
+
+    VarMapping mappings[] = {{"RATE", 0}, {"TIME", 1}};
+    VarContext named = {.values = ab, .count = 2, .mappings = mappings, .mapping_count = 2};
+    parse_expression_ex("rate * time", &named, &config);
+    ab[1] = 3.0;
+    r = parse_expression_ex("rate * time", &named, &config);
+    check(r.value == 12.0 && parser_expression_tier("rate * time") != PARSER_TIER_PARSE,
+          "named mappings run compiled");
+
+    /* Names are compared by contents: buffers may be reused or copied */
+    char n0[8] = "X", n1[8] = "Y";
+    double xy[2] = {10.0, 3.0};
+    VarMapping renamed[] = {{n0, 0}, {n1, 1}};
+    VarContext pair = {.values = xy, .count = 2, .mappings = renamed, .mapping_count = 2};
+    ParserConfig twice = tiered(2, 0);
+    for (int i = 0; i < 5; i++) r = parse_expression_ex("X-Y", &pair, &twice);
+    check(r.value == 7.0 && parser_expression_tier("X-Y") == PARSER_TIER_BYTECODE, "(X-Y runs compiled)");
+    strcpy(n0, "Y");
+    strcpy(n1, "X");
+    ParseResult expected = parse_expression_with_vars_safe("X-Y", &pair);
+    r = parse_expression_ex("X-Y", &pair, &twice);
+    check(expected.value == -7.0 && same_result(&r, &expected), "names renamed in place are seen");
+
+    VarMapping copies[] = {{"X", 0}, {"Y", 1}};
+    pair.mappings = copies;
+    parser_tier_reset_stats();
+    r = parse_expression_ex("X-Y", &pair, &twice);
+    parser_tier_get_stats(&stats);
+    check(r.value == 7.0 && stats.deopts == 0 && stats.bytecode_calls == 1,
+          "equal names at other addresses stay compiled");
+
+    parse_expression_ex("velocity + 1", &ctx, &config);
+    parse_expression_ex("velocity + 1", &ctx, &config);
+    check(parser_expression_tier("velocity + 1") == PARSER_TIER_PARSE, "unresolved names never promote");
+}
+
+#define NUM_THREADS 8
+#define ITERATIONS 20000
+
+static void *tier_thread(void *arg) {
+    int id = *(int *)arg;
+    double values[26] = {0};
+    VarContext ctx = {.values = values, .count = 26};
+    ParserConfig config = tiered(16, 256);
+    static const char *exprs[] = {"x * 2 + 1", "sqrt(x) + x^2", "(x + 1) * (x - 1)", "max(x, 3)"};
+    long errors = 0;
+
+    for (int i = 0; i < ITERATIONS; i++) {
+        double x = id * ITERATIONS + i;
+        values['X' - 'A'] = x;
+        int e = i % 4;
+        ParseResult r = parse_expression_ex(exprs[e], &ctx, &config);
+        double expected = e == 0 ? x * 2 + 1 : e == 1 ? sqrt(x) + pow(x, 2)
+                        : e == 2 ? (x + 1) * (x - 1) : fmax(x, 3);
+        if (r.has_error || r.value != expected) errors++;
+    }
+    return (void *)errors;
+}
+
+static void test_concurrent() {
+    printf("\n=== Concurrent Promotion ===\n");
+
+    parser_cache_clear();
+    parser_tier_reset_stats();
+
+    pthread_t threads[NUM_THREADS];
+    int ids[NUM_THREADS];
+    for (int t = 0; t < NUM_THREADS; t++) {
+        ids[t] = t;
+        pthread_create(&threads[t], NULL, tier_thread, &ids[t]);
+    }
+
+    long errors = 0;
+    for (int t = 0; t < NUM_THREADS; t++) {
+        void *ret;
+        pthread_join(threads[t], &ret);
+        errors += (long)ret;
+    }
+
+    ParserTierStats stats;
+    parser_tier_get_stats(&stats);
+    check(errors == 0, "all threads computed correct values");
+    check(stats.parse_calls + stats.bytecode_calls + stats.jit_calls ==
+          (unsigned long long)NUM_THREADS * ITERATIONS, "every call counted once");
+    check(stats.bytecode_promotions == 4, "each expression promoted once");
+}
+
+int main() {
+    printf("=========================================\n");
+    printf("  FluxParser - Tiered Execution Tests\n");
+    printf("=========================================\n");
+
+    test_matches_parser();
+    test_promotion();
+    test_deopts();
+    test_concurrent();
+
+    return test_report();
+}
@@ -0,0 +1,174 @@
+/*
+ * test_views.c - Test strided views: transpose and reshape share data,
+ * and gradients through chains of views match finite differences
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "autograd_v2.h"
+#include "test_common.h"
+
+#define MAX_OUT 64
+
+/* Fixed output weights: the loss is sum(y * weights) */
+static double weights[MAX_OUT];
+
+typedef VariableV2* (*Chain)(VariableV2 *a, VariableV2 *b);
+
+/* A^T B: transposed view as the left matmul operand */
+static VariableV2* transpose_matmul(VariableV2 *a, VariableV2 *b) {
+    return ag_matmul(ag_transpose(a), b);
+}
+
+/* (A^T)^T B: the second transpose is contiguous again */
+static VariableV2* transpose_transpose(VariableV2 *a, VariableV2 *b) {
+    return ag_matmul(ag_transpose(ag_transpose(a)), b);
+}
+
+/* reshape(A^T) B: reshaping a strided view copies it */
+static VariableV2* reshape_transpose(VariableV2 *a, VariableV2 *b) {
+    int shape[] = {6, 2};
+    return ag_matmul(var_reshape(ag_transpose(a), shape, 2), b);
+}
+
+/* (A B)^T A: transposed result reused as a matmul operand, A used twice */
+static VariableV2* transposed_result(VariableV2 *a, VariableV2 *b) {
+    return ag_matmul(ag_transpose(ag_matmul(a, b)), a);
+}
+
+/* A^T A + B: the transpose's gradient is added to A's other gradient */
+static VariableV2* gram(VariableV2 *a, VariableV2 *b) {
+    return ag_add(ag_matmul(ag_transpose(a), a), b);
+}
+
+/* relu(A^T) + B^T * B^T, reshaped: elementwise ops on views */
+static VariableV2* elementwise_views(VariableV2 *a, VariableV2 *b) {
+    int shape[] = {2, 6};
+    VariableV2 *bt = ag_transpose(b);
+    return var_reshape(ag_add(ag_relu(ag_transpose(a)), ag_multiply(bt, bt)), shape, 2);
+}
+
+static const struct {
+    const char *name;
+    Chain chain;
+    int b_rows, b_cols;         /* A is 3x4 */
+} chains[] = {
+    {"transpose -> matmul", transpose_matmul, 3, 5},
+    {"transpose of transpose -> matmul", transpose_transpose, 4, 5},
+    {"reshape of transpose -> matmul", reshape_transpose, 2, 3},
+    {"transposed matmul result -> matmul", transposed_result, 4, 5},
+    {"transpose and its input -> matmul", gram, 4, 4},
+    {"elementwise ops on views -> reshape", elementwise_views, 3, 4},
+};
+
+/* Loss of one forward pass; with backward, also accumulates gradients */
+static double run(Chain chain, VariableV2 *a, VariableV2 *b, bool backward) {
+    VariableV2 *y = chain(a, b);
+    const TensorV2 *values = tensor_contiguous(y->data);
+    double loss = 0.0;
+    for (int i = 0; i < values->size; i++) loss += values->data[i] * weights[i];
+    if (backward) {
+        for (int i = 0; i < y->grad->size; i++) y->grad->data[i] = weights[i];
+        tape_backward(g_tape);
+    }
+    autograd_reset_iteration();
+    return loss;
+}
+
+/* Largest difference between backward and central differences */
+static double gradient_error(Chain chain, VariableV2 *a, VariableV2 *b) {
+    var_zero_grad(a);
+    var_zero_grad(b);
+    run(chain, a, b, true);
+
+    const double h = 1e-6;
+    double worst = 0.0;
+    VariableV2 *params[] = {a, b};
+    for (int p = 0; p < 2; p++) {
+        TensorV2 *data = params[p]->data;
+        for (int i = 0; i < data->size; i++) {
+            double saved = data->data[i];
+            data->data[i] = saved + h;
+            double up = run(chain, a, b, false);
+            data->data[i] = saved - h;
+            double down = run(chain, a, b, false);
+            data->data[i] = saved;
+
+            double numeric = (up - down) / (2.0 * h);
+            double error = fabs(numeric - params[p]->grad->data[i]) / (1.0 + fabs(numeric));
+            if (error > worst) worst = error;
+        }
+    }
+    return worst;
+}
+
+static void test_layout() {
+    printf("\n=== View Layout ===\n");
+
+    int shape[] = {2, 3};
+    TensorV2 *t = tensor_randn_persistent(shape, 2, 1.0);
+
+    TensorV2 *tt = tensor_transpose(t);
+    check(tt->data == t->data && tt->base == t && !tensor_is_contiguous(tt), "transpose is a strided view");
+    check(tt->shape[0] == 3 && tt->shape[1] == 2 &&
+          tt->data[2 * tt->strides[0] + 1 * tt->strides[1]] == t->data[1 * 3 + 2], "transpose indexes by strides");
+
+    TensorV2 *back = tensor_transpose(tt);
+    check(back->data == t->data && tensor_is_contiguous(back), "transpose of transpose is row-major");
+    check(tensor_contiguous(t) == t, "contiguous tensors are not copied");
+
+    int flat[] = {6};
+    TensorV2 *r = tensor_reshape(t, flat, 1);
+    check(r->data == t->data && tensor_is_contiguous(r), "reshape of a row-major tensor shares data");
+
+    r = tensor_reshape(tt, flat, 1);
+    bool ok = r->data != t->data && tensor_is_contiguous(r);
+    for (int i = 0; ok && i < 3; i++) {
+        for (int j = 0; j < 2; j++) ok = ok && r->data[i * 2 + j] == t->data[j * 3 + i];
+    }
+    check(ok, "reshape of a transpose copies in transposed order");
+
+    VariableV2 *x = var_create_parameter(t);
+    VariableV2 *xr = var_reshape(x, flat, 1);
+    VariableV2 *xt = ag_transpose(x);
+    VariableV2 *xc = var_contiguous(xt);
+    check(xr->data->data == x->data->data && xr->grad->data == x->grad->data, "reshape aliases data and gradient");
+    check(var_contiguous(x) == x && xc != xt && xc->grad == xt->grad, "var_contiguous copies only strided views");
+
+    autograd_reset_iteration();
+    var_free_persistent(x);
+}
+
+static void test_gradients() {
+    printf("\n=== Gradients Through Views ===\n");
+
+    for (int i = 0; i < MAX_OUT; i++) weights[i] = sin(i + 1.0);
+
+    for (size_t c = 0; c < sizeof(chains) / sizeof(chains[0]); c++) {
+        int a_shape[] = {3, 4};
+        int b_shape[] = {chains[c].b_rows, chains[c].b_cols};
+        VariableV2 *a = var_create_parameter(tensor_randn_persistent(a_shape, 2, 1.0));
+        VariableV2 *b = var_create_parameter(tensor_randn_persistent(b_shape, 2, 1.0));
+
+        double error = gradient_error(chains[c].chain, a, b);
+        char what[96];
+        snprintf(what, sizeof(what), "%s (error %.1e)", chains[c].name, error);
+        check(error < 1e-6, what);
+
+        var_free_persistent(a);
+        var_free_persistent(b);
+    }
+}
+
+int main() {
+    printf("=========================================\n");
+    printf("  Autograd V2 - Strided View Tests\n");
+    printf("=========================================\n");
+
+    autograd_v2_init();
+    test_layout();
+    test_gradients();
+    autograd_v2_cleanup();
+
+    return test_report();
+}
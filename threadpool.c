@@ -0,0 +1,169 @@
+/*
+ * FluxParser - Research-Grade C Math Parser
+ * Copyright (C) 2025 Eduardo Stern
+ *
+ * Dual Licensed:
+ * - GPL-3.0 for open-source/non-commercial use
+ * - Commercial license available - see LICENSE-COMMERCIAL.md
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * Worker pool: a loop is published under the pool mutex with a new
+ * generation number, which wakes the workers. Every participant then
+ * claims indices from a shared atomic counter until they run out, and
+ * the last worker to finish signals the caller.
+ */
+
+#include "threadpool.h"
+#include <stdlib.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include <unistd.h>
+
+struct ThreadPool {
+    pthread_t *workers;
+    int worker_count;
+
+    pthread_mutex_t lock;
+    pthread_cond_t wake;            /* New loop or shutdown */
+    pthread_cond_t done;            /* Last worker left the loop */
+    pthread_mutex_t owner;          /* Held by the thread running a loop */
+
+    /* Current loop, published under lock */
+    ThreadPoolTask task;
+    void *arg;
+    size_t count;
+    size_t next;                    /* Next unclaimed index (atomic) */
+    int active;                     /* Workers still in the loop */
+    unsigned long generation;
+    bool shutdown;
+};
+
+static void pool_drain(ThreadPool *pool, ThreadPoolTask task, void *arg, size_t count) {
+    for (;;) {
+        size_t i = __atomic_fetch_add(&pool->next, 1, __ATOMIC_RELAXED);
+        if (i >= count) break;
+        task(arg, i);
+    }
+}
+
+static void* pool_worker(void *p) {
+    ThreadPool *pool = p;
+    unsigned long seen = 0;
+
+    pthread_mutex_lock(&pool->lock);
+    for (;;) {
+        while (!pool->shutdown && pool->generation == seen) {
+            pthread_cond_wait(&pool->wake, &pool->lock);
+        }
+        if (pool->shutdown) break;
+        seen = pool->generation;
+        ThreadPoolTask task = pool->task;
+        void *arg = pool->arg;
+        size_t count = pool->count;
+        pthread_mutex_unlock(&pool->lock);
+
+        pool_drain(pool, task, arg, count);
+
+        pthread_mutex_lock(&pool->lock);
+        if (--pool->active == 0) pthread_cond_signal(&pool->done);
+    }
+    pthread_mutex_unlock(&pool->lock);
+    return NULL;
+}
+
+static int online_cpus(void) {
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return n > 0 ? (int)n : 1;
+}
+
+ThreadPool* thread_pool_create(int thread_count) {
+    if (thread_count <= 0) thread_count = online_cpus();
+
+    ThreadPool *pool = calloc(1, sizeof(ThreadPool));
+    if (!pool) return NULL;
+    pool->workers = malloc(sizeof(pthread_t) * (thread_count > 1 ? thread_count - 1 : 1));
+    if (!pool->workers) {
+        free(pool);
+        return NULL;
+    }
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->wake, NULL);
+    pthread_cond_init(&pool->done, NULL);
+    pthread_mutex_init(&pool->owner, NULL);
+
+    for (int i = 0; i < thread_count - 1; i++) {
+        if (pthread_create(&pool->workers[pool->worker_count], NULL, pool_worker, pool) != 0) break;
+        pool->worker_count++;
+    }
+    if (thread_count > 1 && pool->worker_count == 0) {
+        thread_pool_destroy(pool);
+        return NULL;
+    }
+    return pool;
+}
+
+void thread_pool_destroy(ThreadPool *pool) {
+    if (!pool) return;
+
+    pthread_mutex_lock(&pool->lock);
+    pool->shutdown = true;
+    pthread_cond_broadcast(&pool->wake);
+    pthread_mutex_unlock(&pool->lock);
+    for (int i = 0; i < pool->worker_count; i++) {
+        pthread_join(pool->workers[i], NULL);
+    }
+
+    pthread_mutex_destroy(&pool->lock);
+    pthread_cond_destroy(&pool->wake);
+    pthread_cond_destroy(&pool->done);
+    pthread_mutex_destroy(&pool->owner);
+    free(pool->workers);
+    free(pool);
+}
+
+int thread_pool_size(const ThreadPool *pool) {
+    return pool ? pool->worker_count + 1 : 1;
+}
+
+void thread_pool_for(ThreadPool *pool, size_t count, ThreadPoolTask task, void *arg) {
+    if (count == 0 || !task) return;
+
+    /* Serial when there is nothing to share or the pool is taken */
+    if (!pool || pool->worker_count == 0 || count == 1 || pthread_mutex_trylock(&pool->owner) != 0) {
+        for (size_t i = 0; i < count; i++) task(arg, i);
+        return;
+    }
+
+    pthread_mutex_lock(&pool->lock);
+    pool->task = task;
+    pool->arg = arg;
+    pool->count = count;
+    pool->next = 0;
+    pool->active = pool->worker_count;
+    pool->generation++;
+    pthread_cond_broadcast(&pool->wake);
+    pthread_mutex_unlock(&pool->lock);
+
+    pool_drain(pool, task, arg, count);
+
+    pthread_mutex_lock(&pool->lock);
+    while (pool->active > 0) pthread_cond_wait(&pool->done, &pool->lock);
+    pthread_mutex_unlock(&pool->lock);
+
+    pthread_mutex_unlock(&pool->owner);
+}
+
+static ThreadPool *shared_pool = NULL;
+static pthread_once_t shared_once = PTHREAD_ONCE_INIT;
+
+static void shared_pool_init(void) {
+    const char *env = getenv("FLUXPARSER_THREADS");
+    int threads = env ? atoi(env) : 0;
+    shared_pool = thread_pool_create(threads);
+}
+
+ThreadPool* thread_pool_shared(void) {
+    pthread_once(&shared_once, shared_pool_init);
+    return shared_pool;
+}
@@ -0,0 +1,49 @@
+/*
+ * FluxParser - Research-Grade C Math Parser
+ * Copyright (C) 2025 Eduardo Stern
+ *
+ * Dual Licensed:
+ * - GPL-3.0 for open-source/non-commercial use
+ * - Commercial license available - see LICENSE-COMMERCIAL.md
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * Fixed-size worker pool for data-parallel loops. Workers are started once
+ * and sleep between loops; the calling thread works alongside them.
+ */
+
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <stddef.h>
+
+typedef struct ThreadPool ThreadPool;
+
+/* Called once per index; indices are handed out dynamically, in any order
+ * and on any thread, so task must only write state owned by its index.
+ */
+typedef void (*ThreadPoolTask)(void *arg, size_t index);
+
+/* A pool running loops on thread_count threads, the caller included
+ * (thread_count - 1 workers). thread_count <= 0 means one per online CPU.
+ * Returns NULL if no worker could be started and thread_count > 1.
+ */
+ThreadPool* thread_pool_create(int thread_count);
+void thread_pool_destroy(ThreadPool *pool);
+
+/* Threads a loop runs on, the caller included; 1 for a NULL pool */
+int thread_pool_size(const ThreadPool *pool);
+
+/* Run task(arg, i) for every i in [0, count) and return when all are done.
+ * Loops on one pool do not overlap: while the pool is busy (another
+ * thread's loop, or a call from inside a task) the loop runs on the
+ * calling thread alone. A NULL pool also runs it on the calling thread.
+ */
+void thread_pool_for(ThreadPool *pool, size_t count, ThreadPoolTask task, void *arg);
+
+/* Process-wide pool, started on first use and never destroyed. Its size
+ * is FLUXPARSER_THREADS from the environment if set, else one per CPU.
+ */
+ThreadPool* thread_pool_shared(void);
+
+#endif /* THREADPOOL_H */
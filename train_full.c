@@ -11,6 +11,7 @@
 #include "transformer_v2.h"
 #include "model_io_v2.h"
 #include "dataset.h"
+#include "arena.h"
 
 /* Training configuration */
 typedef struct {
@@ -450,7 +451,8 @@ int main(int argc, char *argv[]) {
     }
 
     printf("=====================================\n");
-    printf("Training complete!\n\n");
+    printf("Training complete!\n");
+    printf("Arena peak: %.2f MB per iteration\n\n", arena_get_peak(global_arena) / (1024.0 * 1024.0));
 
     /* Save final model */
     char final_model_path[512];
@@ -11,6 +11,54 @@
 
 /* ============ Layer Normalization ============ */
 
+typedef struct {
+    LayerNormV2 *ln;
+    const double *input;
+    double *output;
+    double *means;
+    double *vars;
+    int d_model;
+} LayerNormRows;
+
+/* Normalize positions [begin, end) */
+static void layer_norm_range(void *arg, int begin, int end) {
+    LayerNormRows *r = (LayerNormRows*)arg;
+    int d_model = r->d_model;
+
+    for (int pos_idx = begin; pos_idx < end; pos_idx++) {
+        /* Calculate mean and variance for this position */
+        double mean = 0.0;
+        double var = 0.0;
+
+        int offset = pos_idx * d_model;
+
+        /* Mean */
+        for (int i = 0; i < d_model; i++) {
+            mean += r->input[offset + i];
+        }
+        mean /= d_model;
+
+        /* Variance */
+        for (int i = 0; i < d_model; i++) {
+            double diff = r->input[offset + i] - mean;
+            var += diff * diff;
+        }
+        var /= d_model;
+
+        /* Store mean and variance */
+        r->means[pos_idx] = mean;
+        r->vars[pos_idx] = var;
+
+        /* Normalize and apply affine transform */
+        double std = sqrt(var + r->ln->eps);
+        for (int i = 0; i < d_model; i++) {
+            double normalized = (r->input[offset + i] - mean) / std;
+            r->output[offset + i] =
+                r->ln->gamma->data->data[i] * normalized + r->ln->beta->data->data[i];
+        }
+    }
+}
+
 LayerNormV2* layer_norm_create(int size) {
     LayerNormV2 *ln = calloc(1, sizeof(LayerNormV2));
     ln->size = size;
@@ -43,6 +91,7 @@ void layer_norm_free(LayerNormV2 *ln) {
 
 VariableV2* layer_norm_forward(LayerNormV2 *ln, VariableV2 *input) {
     /* Expect input shape: [seq_len, d_model] or [batch_size, seq_len, d_model] */
+    input = var_contiguous(input);
     int batch_dim = (input->data->rank == 3) ? input->data->shape[0] : 1;
     int seq_len = (input->data->rank == 3) ? input->data->shape[1] : input->data->shape[0];
     int d_model = (input->data->rank == 3) ? input->data->shape[2] : input->data->shape[1];
@@ -58,43 +107,8 @@ VariableV2* layer_norm_forward(LayerNormV2 *ln, VariableV2 *input) {
     double *all_means = (double*)malloc(n_positions * sizeof(double));
     double *all_vars = (double*)malloc(n_positions * sizeof(double));
 
-    int pos_idx = 0;
-    for (int b = 0; b < batch_dim; b++) {
-        for (int t = 0; t < seq_len; t++) {
-            /* Calculate mean and variance for this position */
-            double mean = 0.0;
-            double var = 0.0;
-
-            int offset = pos_idx * d_model;
-
-            /* Mean */
-            for (int i = 0; i < d_model; i++) {
-                mean += input->data->data[offset + i];
-            }
-            mean /= d_model;
-
-            /* Variance */
-            for (int i = 0; i < d_model; i++) {
-                double diff = input->data->data[offset + i] - mean;
-                var += diff * diff;
-            }
-            var /= d_model;
-
-            /* Store mean and variance */
-            all_means[pos_idx] = mean;
-            all_vars[pos_idx] = var;
-
-            /* Normalize and apply affine transform */
-            double std = sqrt(var + ln->eps);
-            for (int i = 0; i < d_model; i++) {
-                double normalized = (input->data->data[offset + i] - mean) / std;
-                output_tensor->data[offset + i] =
-                    ln->gamma->data->data[i] * normalized + ln->beta->data->data[i];
-            }
-
-            pos_idx++;
-        }
-    }
+    LayerNormRows rows = {ln, input->data->data, output_tensor->data, all_means, all_vars, d_model};
+    autograd_parallel_for(n_positions, d_model, layer_norm_range, &rows);
 
     /* Record operation for backward pass with all means and variances */
     tape_record_layer_norm_v2(output, input, ln->gamma, ln->beta, all_means, all_vars, n_positions);
@@ -108,6 +122,59 @@ VariableV2* layer_norm_forward(LayerNormV2 *ln, VariableV2 *input) {
 
 /* ============ Multi-Head Attention ============ */
 
+/* Per-head attention over [seq_len, n_heads, d_head] q, k, v; rows are
+ * (head, query position) pairs */
+typedef struct {
+    const MultiHeadAttention *mha;
+    int seq_len;
+    const double *q;
+    const double *k;
+    const double *v;
+    const double *weights;      /* [n_heads, seq_len, seq_len] */
+    double *out;
+} AttentionRows;
+
+static void attention_scores_range(void *arg, int begin, int end) {
+    AttentionRows *r = (AttentionRows*)arg;
+    const MultiHeadAttention *mha = r->mha;
+    int seq_len = r->seq_len;
+
+    for (int row = begin; row < end; row++) {
+        int h = row / seq_len;
+        int i = row % seq_len;
+        for (int j = 0; j < seq_len; j++) {
+            double score = 0.0;
+            for (int d = 0; d < mha->d_head; d++) {
+                int q_idx = i * mha->n_heads * mha->d_head + h * mha->d_head + d;
+                int k_idx = j * mha->n_heads * mha->d_head + h * mha->d_head + d;
+                score += r->q[q_idx] * r->k[k_idx];
+            }
+            r->out[h * seq_len * seq_len + i * seq_len + j] = score * mha->scale;
+        }
+    }
+}
+
+static void attention_values_range(void *arg, int begin, int end) {
+    AttentionRows *r = (AttentionRows*)arg;
+    const MultiHeadAttention *mha = r->mha;
+    int seq_len = r->seq_len;
+
+    for (int row = begin; row < end; row++) {
+        int h = row / seq_len;
+        int i = row % seq_len;
+        for (int d = 0; d < mha->d_head; d++) {
+            double sum = 0.0;
+            for (int j = 0; j < seq_len; j++) {
+                int w_idx = h * seq_len * seq_len + i * seq_len + j;
+                int v_idx = j * mha->n_heads * mha->d_head + h * mha->d_head + d;
+                sum += r->weights[w_idx] * r->v[v_idx];
+            }
+            int out_idx = i * mha->n_heads * mha->d_head + h * mha->d_head + d;
+            r->out[out_idx] = sum;
+        }
+    }
+}
+
 MultiHeadAttention* mha_create(int d_model, int n_heads) {
     assert(d_model % n_heads == 0);
 
@@ -148,7 +215,7 @@ VariableV2* mha_forward(MultiHeadAttention *mha, VariableV2 *x) {
     VariableV2 *k = linear_forward(mha->k_proj, x);
     VariableV2 *v = linear_forward(mha->v_proj, x);
 
-    /* Reshape for multi-head attention: [seq_len, n_heads, d_head] */
+    /* Reshape for multi-head attention: [seq_len, n_heads, d_head] (views) */
     int new_shape[] = {seq_len, mha->n_heads, mha->d_head};
     q = var_reshape(q, new_shape, 3);
     k = var_reshape(k, new_shape, 3);
@@ -159,20 +226,8 @@ VariableV2* mha_forward(MultiHeadAttention *mha, VariableV2 *x) {
     TensorV2 *scores_tensor = tensor_create_temp(scores_shape, 3);
     VariableV2 *scores = var_create_temp(scores_tensor, x->requires_grad);
 
-    for (int h = 0; h < mha->n_heads; h++) {
-        for (int i = 0; i < seq_len; i++) {
-            for (int j = 0; j < seq_len; j++) {
-                double score = 0.0;
-                for (int d = 0; d < mha->d_head; d++) {
-                    int q_idx = i * mha->n_heads * mha->d_head + h * mha->d_head + d;
-                    int k_idx = j * mha->n_heads * mha->d_head + h * mha->d_head + d;
-                    score += q->data->data[q_idx] * k->data->data[k_idx];
-                }
-                scores_tensor->data[h * seq_len * seq_len + i * seq_len + j] =
-                    score * mha->scale;
-            }
-        }
-    }
+    AttentionRows rows = {mha, seq_len, q->data->data, k->data->data, v->data->data, NULL, scores_tensor->data};
+    autograd_parallel_for(mha->n_heads * seq_len, seq_len * mha->d_head, attention_scores_range, &rows);
 
     /* Apply softmax to scores */
     VariableV2 *attn_weights = var_softmax_2d(scores);  /* softmax over last dim */
@@ -182,20 +237,9 @@ VariableV2* mha_forward(MultiHeadAttention *mha, VariableV2 *x) {
     TensorV2 *attn_output_tensor = tensor_create_temp(out_shape, 3);
     VariableV2 *attn_output = var_create_temp(attn_output_tensor, x->requires_grad);
 
-    for (int h = 0; h < mha->n_heads; h++) {
-        for (int i = 0; i < seq_len; i++) {
-            for (int d = 0; d < mha->d_head; d++) {
-                double sum = 0.0;
-                for (int j = 0; j < seq_len; j++) {
-                    int w_idx = h * seq_len * seq_len + i * seq_len + j;
-                    int v_idx = j * mha->n_heads * mha->d_head + h * mha->d_head + d;
-                    sum += attn_weights->data->data[w_idx] * v->data->data[v_idx];
-                }
-                int out_idx = i * mha->n_heads * mha->d_head + h * mha->d_head + d;
-                attn_output_tensor->data[out_idx] = sum;
-            }
-        }
-    }
+    rows.weights = attn_weights->data->data;
+    rows.out = attn_output_tensor->data;
+    autograd_parallel_for(mha->n_heads * seq_len, seq_len * mha->d_head, attention_values_range, &rows);
 
     /* Reshape back to [seq_len, d_model] */
     int final_shape[] = {seq_len, d_model};
@@ -373,6 +417,7 @@ VariableV2* compute_cross_entropy_loss(VariableV2 *logits, int *targets, int seq
     /* logits shape: [seq_len, vocab_size] */
     assert(logits->data->rank == 2);
     assert(logits->data->shape[0] == seq_len);
+    logits = var_contiguous(logits);
 
     int vocab_size = logits->data->shape[1];
     double total_loss = 0.0;
@@ -411,6 +456,19 @@ VariableV2* compute_cross_entropy_loss(VariableV2 *logits, int *targets, int seq
 
 /* ============ Optimizer ============ */
 
+typedef struct {
+    double *data;
+    const double *grad;
+    double learning_rate;
+} SgdUpdate;
+
+static void sgd_range(void *arg, int begin, int end) {
+    SgdUpdate *u = (SgdUpdate*)arg;
+    for (int j = begin; j < end; j++) {
+        u->data[j] -= u->learning_rate * u->grad[j];
+    }
+}
+
 AdamOptimizerV2* adam_create(double learning_rate) {
     AdamOptimizerV2 *opt = calloc(1, sizeof(AdamOptimizerV2));
     opt->learning_rate = learning_rate;
@@ -430,9 +488,9 @@ void adam_step(AdamOptimizerV2 *opt) {
     for (int i = 0; i < opt->n_params; i++) {
         VariableV2 *param = opt->params[i];
         if (param->grad) {
-            for (int j = 0; j < param->data->size; j++) {
-                param->data->data[j] -= opt->learning_rate * param->grad->data[j];
-            }
+            SgdUpdate update = {param->data->data, param->grad->data, opt->learning_rate};
+            autograd_parallel_for(param->data->size, 1, sgd_range, &update);
+            tensor_mark_modified(param->data);
         }
     }
 }